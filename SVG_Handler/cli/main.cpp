@@ -4,9 +4,24 @@
  * Executes the SVG processing pipeline or specific actions (view/validate).
  *
  * Usage:
- *   ./svg_handler_cli <input.svg> <output.csv>
+ *   ./svg_handler_cli <input.svg> <output.csv> [--bbox] [--bake] [--expand]
+ *                    [--shared]
+ *                    [--precision <n>] [--simplify <tol>] [--styles <name,...>]
+ *                    [--cache <dir>]
  *   ./svg_handler_cli --view <input.svg>
  *   ./svg_handler_cli --validate <input.svg>
+ *   ./svg_handler_cli --region <input.svg> <minX> <minY> <maxX> <maxY>
+ *                    <output.csv>
+ *   ./svg_handler_cli --query <input.svg> <selector> [output.csv]
+ *   ./svg_handler_cli --dedup <input.svg> [report.csv]
+ *   ./svg_handler_cli --write <input.svg> <output.svg> [--minify] [--sort]
+ *                    [--precision <n>] [--simplify <tol>] [--strip-defaults]
+ *                    [--strip-comments]
+ *   ./svg_handler_cli --snapshot <input.svg> <output.snap>
+ *   ./svg_handler_cli --load <input.snap> <output.csv>
+ *   ./svg_handler_cli --diff <before.svg> <after.svg> [output.csv|output.json]
+ *   ./svg_handler_cli --render <input.svg> <output.png|output.ppm>
+ *                    [--size <px>] [--background <color>]
  *
  * Description:
  *   1. Reads the input SVG file.
@@ -18,30 +33,128 @@
 
 #include "svg_core.hpp"
 #include "svg_handler.hpp"
+#include "csv_exporter.hpp" // CsvExporter::save and write
+#include "dag_utils.hpp" // DagUtils::build and report
+#include "diff_utils.hpp" // DiffUtils::diff, table and json
+#include "raster_utils.hpp" // RasterUtils::Options and save
+#include "snapshot_utils.hpp" // SnapshotUtils::write and Snapshot
+#include "spatial_index.hpp" // SpatialIndex::RTree
+#include "style_utils.hpp" // StyleUtils::parse_properties
+#include "svg_writer.hpp" // SvgWriter::save
 #include "tree_utils.hpp" // TreeUtils::view and validate
 
+#include <array>
+#include <charconv>
 #include <cstdlib>
 #include <filesystem>
+#include <fstream>
+#include <iostream>
 #include <print>
+#include <ranges>
 #include <string_view>
 
 namespace fs = std::filesystem;
 
 constexpr std::string_view USAGE = R"(
 Usage:
-  ./svg_handler_cli <input.svg> <output.csv>
+  ./svg_handler_cli <input.svg> <output.csv> [--bbox] [--bake] [--expand]
+                    [--shared] [--wide] [--columns <name,...>] [--content]
+                    [--format <format>]
+                    [--precision <n>] [--simplify <tol>] [--styles <name,...>]
+                    [--cache <dir>]
   ./svg_handler_cli --view <input.svg>
   ./svg_handler_cli --validate <input.svg>
+  ./svg_handler_cli --region <input.svg> <minX> <minY> <maxX> <maxY>
+                    <output.csv>
+  ./svg_handler_cli --query <input.svg> <selector> [output.csv]
+  ./svg_handler_cli --dedup <input.svg> [report.csv]
+  ./svg_handler_cli --write <input.svg> <output.svg> [--minify] [--sort]
+                    [--precision <n>] [--simplify <tol>] [--strip-defaults]
+                    [--strip-comments]
+  ./svg_handler_cli --snapshot <input.svg> <output.snap>
+  ./svg_handler_cli --load <input.snap> <output.csv>
+  ./svg_handler_cli --diff <before.svg> <after.svg> [output.csv|output.json]
+  ./svg_handler_cli --render <input.svg> <output.png|output.ppm> [--size <px>]
+                    [--background <color>]
 
 Description:
   Executes the SVG Handler pipeline or specific commands.
+  The output format follows the extension of the output path: '.arrow'
+  for an Arrow IPC file (typed columns), '.json' for the nested tree,
+  '.ndjson' or '.jsonl' for one JSON object per element, CSV otherwise.
+  --format csv|arrow|json|ndjson sets it whatever the extension.
+  --bbox adds the bounding box of each element (MinX, MinY, MaxX, MaxY).
+  --bake applies transforms to coordinates and drops 'transform' attributes.
+  --expand copies the content referenced by each <use> under it.
+  --shared writes repeated subtrees as one row whose 'Shared' column
+  holds the ID of the first identical subtree.
+  --wide writes one row per element with one column per attribute name
+  (CSV output only); --columns keeps only the listed attribute columns.
+  --content adds text, CDATA sections, comments and processing
+  instructions as '#text', '#cdata', '#comment' and '#instruction'
+  attributes of the element enclosing them (CSV and JSON output).
+  --precision rounds coordinates (x, y, width, d, points, ...) to <n>
+  decimals; --simplify drops the points of straight path runs and
+  polylines within <tol> user units of the simplified line (0: collinear
+  points only). Curves and transforms are kept.
+  --styles adds the computed value of each listed property (fill,
+  stroke-width, ...; 'default' for the common ones) after presentation
+  attributes, style="..." and <style> rules are cascaded and inherited
+  (CSV and JSON output).
+  --cache keeps results in <dir>, keyed by the SVG content and options;
+  unchanged files are served from it (oldest entries evicted past 256 MiB).
+  --region saves the elements whose bounding box intersects the region.
+  --query prints (or saves) the rows of the elements matching a CSS
+  selector (tag, #id, .class, [attr=value], 'a b', 'a > b') or an
+  XPath path (/svg/g, //rect[@fill='red']).
+  --dedup prints (or saves) the repeated subtrees and the elements a
+  shared representation saves.
+  --write saves the parsed tree as SVG: --minify drops indentation and
+  line breaks, --sort orders attributes by name, --precision rounds
+  numeric attributes to <n> decimals and --strip-defaults drops
+  attributes equal to their initial value and --strip-comments drops
+  comments; --simplify, --bake and --expand act as for the pipeline.
+  Text, <style> sheets, CDATA and comments are written back.
+  --snapshot saves the parsed tree in binary form; --load maps such a
+  snapshot back and saves its CSV without parsing the SVG again.
+  --diff prints (or saves, as CSV or JSON by extension) the elements
+  inserted, removed or moved and the attributes changed between two
+  versions of a document.
+  --render draws the document (shapes and paths, solid fills and strokes)
+  as a PNG or PPM image whose longest side is <px> pixels (default 256)
+  over <color> (default transparent). Text and images are not drawn.
 
 Examples:
   ./svg_handler_cli resources/sample.svg output/sample.csv
+  ./svg_handler_cli resources/sample.svg output/sample.csv --bbox
+  ./svg_handler_cli resources/sample.svg output/sample.arrow
+  ./svg_handler_cli resources/sample.svg output/sample.json
+  ./svg_handler_cli resources/sample.svg output/sample.log --format ndjson
+  ./svg_handler_cli resources/sample.svg output/sample.csv --bake
+  ./svg_handler_cli resources/sample.svg output/sample.csv --wide
+  ./svg_handler_cli resources/sample.svg output/sample.json --content
+  ./svg_handler_cli resources/sample.svg output/sample.csv --simplify 0.5
+  ./svg_handler_cli resources/sample.svg output/sample.csv --styles fill,stroke
+  ./svg_handler_cli resources/sample.svg output/sample.csv --expand
+  ./svg_handler_cli resources/sample.svg output/sample.csv --shared
+  ./svg_handler_cli resources/sample.svg output/sample.csv --cache .svg_cache
   ./svg_handler_cli --view resources/sample.svg
   ./svg_handler_cli --validate resources/sample.svg
+  ./svg_handler_cli --region resources/sample.svg 0 0 100 100 output/region.csv
+  ./svg_handler_cli --query resources/sample.svg "#shapes > rect"
+  ./svg_handler_cli --dedup resources/sample.svg output/dedup.csv
+  ./svg_handler_cli --write resources/sample.svg output/sample.min.svg --minify
+  ./svg_handler_cli --snapshot resources/sample.svg output/sample.snap
+  ./svg_handler_cli --load output/sample.snap output/sample.csv
+  ./svg_handler_cli --diff old.svg resources/sample.svg output/changes.json
+  ./svg_handler_cli --render resources/sample.svg output/sample.png --size 128
 )";
 
+// Rows printed instead of saved, quoted as in CSV files
+void print_csv(const svg_core::CsvTable &table) {
+  CsvExporter::write(std::cout, table);
+}
+
 auto main(int argc, char *argv[]) -> int {
   using namespace SVG_HANDLER;
   using namespace color;
@@ -57,6 +170,395 @@ auto main(int argc, char *argv[]) -> int {
 
   std::string_view arg1 = argv[1];
 
+  // Elements matching a selector
+  if (arg1 == "--query") {
+    if (argc != 4 && argc != 5) {
+      std::println("{}[ERROR]{} : '--query' expects <input.svg> <selector> "
+                   "[output.csv]",
+                   red, reset);
+      std::println("{}{}{}", green, USAGE, reset);
+      return EXIT_FAILURE;
+    }
+
+    std::string_view input_path = argv[2];
+    std::string_view output_path = argc == 5 ? argv[4] : "";
+
+    try {
+      SVG handler(input_path, output_path);
+      auto table = handler.query(argv[3]);
+      if (!table) {
+        std::println("{}[ERROR]{} : {}", red, reset,
+                     svg_core::describe(table.error()));
+        return EXIT_FAILURE;
+      }
+
+      if (output_path.empty()) {
+        print_csv(*table);
+        return EXIT_SUCCESS;
+      }
+
+      auto saved = handler.export_csv(*table, output_path);
+      if (!saved) {
+        std::println("{}[ERROR]{} : {}", red, reset,
+                     svg_core::describe(saved.error()));
+        return EXIT_FAILURE;
+      }
+      std::println("{}[INFO]{} : Matching elements saved to '{}'", green, reset,
+                   output_path);
+    } catch (const std::exception &e) {
+      std::println("{}[ERROR]{} : Exception: {}", red, reset, e.what());
+      return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+  }
+
+  // Tree written back as SVG
+  if (arg1 == "--write") {
+    // Text, CDATA and comments are written back
+    TreeUtils::TableOptions tree_options{.content = true};
+    SvgWriter::Options options;
+    bool valid_options = argc >= 4;
+    for (int i = 4; i < argc; ++i) {
+      std::string_view option = argv[i];
+      if (option == "--minify")
+        options.minify = true;
+      else if (option == "--sort")
+        options.sort_attributes = true;
+      else if (option == "--strip-defaults")
+        options.strip_defaults = true;
+      else if (option == "--strip-comments")
+        options.strip_comments = true;
+      else if (option == "--bake")
+        tree_options.bake = true;
+      else if (option == "--expand")
+        tree_options.expand = true;
+      else if (option == "--precision" && i + 1 < argc) {
+        std::string_view digits = argv[++i];
+        auto [end, ec] = std::from_chars(
+            digits.data(), digits.data() + digits.size(), options.precision);
+        valid_options = valid_options && ec == std::errc{} &&
+                        end == digits.data() + digits.size() &&
+                        options.precision >= 0;
+      } else if (option == "--simplify" && i + 1 < argc) {
+        std::string_view distance = argv[++i];
+        auto [end, ec] =
+            std::from_chars(distance.data(), distance.data() + distance.size(),
+                            tree_options.tolerance);
+        valid_options = valid_options && ec == std::errc{} &&
+                        end == distance.data() + distance.size() &&
+                        tree_options.tolerance >= 0.0;
+      } else
+        valid_options = false;
+    }
+    if (!valid_options) {
+      std::println("{}[ERROR]{} : '--write' expects <input.svg> <output.svg> "
+                   "[options]",
+                   red, reset);
+      std::println("{}{}{}", green, USAGE, reset);
+      return EXIT_FAILURE;
+    }
+
+    std::string_view input_path = argv[2];
+    std::string_view output_path = argv[3];
+
+    try {
+      SVG handler(input_path, output_path);
+      handler.set_table_options(tree_options);
+      auto tree = handler.parse();
+      if (!tree) {
+        std::println("{}[ERROR]{} : {}", red, reset,
+                     svg_core::describe(tree.error()));
+        return EXIT_FAILURE;
+      }
+
+      auto saved = SvgWriter::save(output_path, **tree, options);
+      if (!saved) {
+        std::println("{}[ERROR]{} : {}", red, reset,
+                     svg_core::describe(saved.error()));
+        return EXIT_FAILURE;
+      }
+      std::error_code ec;
+      std::println("{}[INFO]{} : SVG saved to '{}' ({} -> {} bytes)", green,
+                   reset, output_path, fs::file_size(input_path, ec),
+                   fs::file_size(output_path, ec));
+    } catch (const std::exception &e) {
+      std::println("{}[ERROR]{} : Exception: {}", red, reset, e.what());
+      return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+  }
+
+  // Thumbnail image
+  if (arg1 == "--render") {
+    RasterUtils::Options options;
+    bool valid_options = argc >= 4;
+    for (int i = 4; i < argc; ++i) {
+      std::string_view option = argv[i];
+      if (option == "--size" && i + 1 < argc) {
+        std::string_view pixels = argv[++i];
+        auto [end, ec] = std::from_chars(
+            pixels.data(), pixels.data() + pixels.size(), options.size);
+        valid_options = valid_options && ec == std::errc{} &&
+                        end == pixels.data() + pixels.size();
+      } else if (option == "--background" && i + 1 < argc)
+        options.background = argv[++i];
+      else
+        valid_options = false;
+    }
+    if (!valid_options) {
+      std::println("{}[ERROR]{} : '--render' expects <input.svg> "
+                   "<output.png|output.ppm> [options]",
+                   red, reset);
+      std::println("{}{}{}", green, USAGE, reset);
+      return EXIT_FAILURE;
+    }
+
+    std::string_view input_path = argv[2];
+    std::string_view output_path = argv[3];
+
+    try {
+      SVG handler(input_path, output_path);
+      auto image = handler.render(options);
+      if (!image) {
+        std::println("{}[ERROR]{} : {}", red, reset,
+                     svg_core::describe(image.error()));
+        return EXIT_FAILURE;
+      }
+
+      auto saved = RasterUtils::save(output_path, *image);
+      if (!saved) {
+        std::println("{}[ERROR]{} : {}", red, reset,
+                     svg_core::describe(saved.error()));
+        return EXIT_FAILURE;
+      }
+      std::println("{}[INFO]{} : Image saved to '{}' ({}x{})", green, reset,
+                   output_path, image->width, image->height);
+    } catch (const std::exception &e) {
+      std::println("{}[ERROR]{} : Exception: {}", red, reset, e.what());
+      return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+  }
+
+  // Repeated subtrees
+  if (arg1 == "--dedup") {
+    if (argc != 3 && argc != 4) {
+      std::println("{}[ERROR]{} : '--dedup' expects <input.svg> [report.csv]",
+                   red, reset);
+      std::println("{}{}{}", green, USAGE, reset);
+      return EXIT_FAILURE;
+    }
+
+    std::string_view input_path = argv[2];
+    std::string_view output_path = argc == 4 ? argv[3] : "";
+
+    try {
+      SVG handler(input_path, output_path);
+      auto tree = handler.parse();
+      if (!tree) {
+        std::println("{}[ERROR]{} : {}", red, reset,
+                     svg_core::describe(tree.error()));
+        return EXIT_FAILURE;
+      }
+
+      const auto dag = DagUtils::build(**tree);
+      const auto report = DagUtils::report(dag);
+      std::println("{}[INFO]{} : {} elements, {} distinct subtrees ({} "
+                   "repeated)",
+                   blue, reset, DagUtils::expanded_size(dag), dag.nodes.size(),
+                   report.size() - 1);
+
+      if (output_path.empty()) {
+        print_csv(report);
+        return EXIT_SUCCESS;
+      }
+
+      auto saved = handler.export_csv(report, output_path);
+      if (!saved) {
+        std::println("{}[ERROR]{} : {}", red, reset,
+                     svg_core::describe(saved.error()));
+        return EXIT_FAILURE;
+      }
+      std::println("{}[INFO]{} : Dedup report saved to '{}'", green, reset,
+                   output_path);
+    } catch (const std::exception &e) {
+      std::println("{}[ERROR]{} : Exception: {}", red, reset, e.what());
+      return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+  }
+
+  // Differences between two documents
+  if (arg1 == "--diff") {
+    if (argc != 4 && argc != 5) {
+      std::println("{}[ERROR]{} : '--diff' expects <before.svg> <after.svg> "
+                   "[output.csv|output.json]",
+                   red, reset);
+      std::println("{}{}{}", green, USAGE, reset);
+      return EXIT_FAILURE;
+    }
+
+    std::string_view output_path = argc == 5 ? argv[4] : "";
+
+    try {
+      SVG before(argv[2], output_path);
+      SVG after(argv[3], output_path);
+      auto old_tree = before.parse();
+      auto new_tree = old_tree ? after.parse() : old_tree;
+      if (!new_tree) {
+        std::println("{}[ERROR]{} : {}", red, reset,
+                     svg_core::describe(new_tree.error()));
+        return EXIT_FAILURE;
+      }
+
+      const auto diff = DiffUtils::diff(**old_tree, **new_tree);
+      std::println("{}[INFO]{} : {} difference(s)", blue, reset,
+                   diff.entries.size());
+
+      if (output_path.empty()) {
+        print_csv(DiffUtils::table(diff));
+        return EXIT_SUCCESS;
+      }
+
+      if (fs::path(output_path).extension() == ".json") {
+        std::ofstream file{fs::path(output_path)};
+        file << DiffUtils::json(diff) << '\n';
+        if (!file) {
+          std::println("{}[ERROR]{} : Failed to write '{}'", red, reset,
+                       output_path);
+          return EXIT_FAILURE;
+        }
+      } else {
+        auto saved = before.export_csv(DiffUtils::table(diff), output_path);
+        if (!saved) {
+          std::println("{}[ERROR]{} : {}", red, reset,
+                       svg_core::describe(saved.error()));
+          return EXIT_FAILURE;
+        }
+      }
+      std::println("{}[INFO]{} : Differences saved to '{}'", green, reset,
+                   output_path);
+    } catch (const std::exception &e) {
+      std::println("{}[ERROR]{} : Exception: {}", red, reset, e.what());
+      return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+  }
+
+  // Binary snapshot of the parsed tree
+  if (arg1 == "--snapshot" || arg1 == "--load") {
+    if (argc != 4) {
+      std::println("{}[ERROR]{} : '{}' expects <input> <output>", red, reset,
+                   arg1);
+      std::println("{}{}{}", green, USAGE, reset);
+      return EXIT_FAILURE;
+    }
+
+    std::string_view input_path = argv[2];
+    std::string_view output_path = argv[3];
+
+    try {
+      if (arg1 == "--snapshot") {
+        SVG handler(input_path, output_path);
+        auto tree = handler.parse();
+        if (!tree) {
+          std::println("{}[ERROR]{} : {}", red, reset,
+                       svg_core::describe(tree.error()));
+          return EXIT_FAILURE;
+        }
+        auto written = SnapshotUtils::write(**tree, output_path);
+        if (!written) {
+          std::println("{}[ERROR]{} : {}", red, reset,
+                       svg_core::describe(written.error()));
+          return EXIT_FAILURE;
+        }
+        std::println("{}[INFO]{} : Snapshot saved to '{}'", green, reset,
+                     output_path);
+        return EXIT_SUCCESS;
+      }
+
+      auto snapshot = SnapshotUtils::Snapshot::open(input_path);
+      if (!snapshot) {
+        std::println("{}[ERROR]{} : {}", red, reset,
+                     svg_core::describe(snapshot.error()));
+        return EXIT_FAILURE;
+      }
+      svg_core::CsvTable table;
+      SnapshotUtils::table(*snapshot, table);
+
+      auto saved = CsvExporter::save(output_path, table);
+      if (!saved) {
+        std::println("{}[ERROR]{} : {}", red, reset,
+                     svg_core::describe(saved.error()));
+        return EXIT_FAILURE;
+      }
+      std::println("{}[INFO]{} : {} elements loaded, CSV saved to '{}'", green,
+                   reset, snapshot->size(), output_path);
+    } catch (const std::exception &e) {
+      std::println("{}[ERROR]{} : Exception: {}", red, reset, e.what());
+      return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+  }
+
+  // Elements intersecting a region
+  if (arg1 == "--region") {
+    if (argc != 8) {
+      std::println("{}[ERROR]{} : '--region' expects <input.svg> <minX> <minY> "
+                   "<maxX> <maxY> <output.csv>",
+                   red, reset);
+      std::println("{}{}{}", green, USAGE, reset);
+      return EXIT_FAILURE;
+    }
+
+    std::array<double, 4> bounds{};
+    for (std::size_t i = 0; i < bounds.size(); ++i) {
+      std::string_view arg = argv[3 + i];
+      auto [ptr, ec] =
+          std::from_chars(arg.data(), arg.data() + arg.size(), bounds[i]);
+      if (ec != std::errc{} || ptr != arg.data() + arg.size()) {
+        std::println("{}[ERROR]{} : Invalid coordinate: '{}'", red, reset, arg);
+        return EXIT_FAILURE;
+      }
+    }
+
+    std::string_view input_path = argv[2];
+    std::string_view output_path = argv[7];
+
+    try {
+      SVG handler(input_path, output_path);
+      handler.set_table_options({.bbox = true});
+      auto tree = handler.parse();
+      if (!tree) {
+        std::println("{}[ERROR]{} : {}", red, reset,
+                     svg_core::describe(tree.error()));
+        return EXIT_FAILURE;
+      }
+
+      SpatialIndex::RTree index(**tree);
+      auto hits = index.query({bounds[0], bounds[1], bounds[2], bounds[3]});
+      auto saved = handler.export_csv(SpatialIndex::table(hits), output_path);
+      if (!saved) {
+        std::println("{}[ERROR]{} : {}", red, reset,
+                     svg_core::describe(saved.error()));
+        return EXIT_FAILURE;
+      }
+      std::println("{}[INFO]{} : {} of {} elements in region saved to '{}'",
+                   green, reset, hits.size(), index.size(), output_path);
+    } catch (const std::exception &e) {
+      std::println("{}[ERROR]{} : Exception: {}", red, reset, e.what());
+      return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+  }
+
   // Handle special flags (--view / --validate)
   if (arg1 == "--view" || arg1 == "--validate") {
     if (argc != 3) {
@@ -75,20 +577,34 @@ auto main(int argc, char *argv[]) -> int {
 
     try {
       SVG handler(input_path, "temp.csv");
-      auto content = handler.load();
-      auto prepared = handler.prepare(content);
-      auto tokens = handler.tokenize(prepared);
 
       if (arg1 == "--validate") {
-        auto status = TreeUtils::validate(tokens);
+        auto content = handler.load();
+        auto prepared = content ? handler.prepare(*content)
+                                : std::unexpected(content.error());
+        auto tokens = prepared ? handler.tokenize(*prepared)
+                               : std::unexpected(prepared.error());
+        if (!tokens) {
+          std::println("{}[ERROR]{} : {}", red, reset,
+                       svg_core::describe(tokens.error()));
+          std::println("{}[WARN]{} : SVG validation failed.", yellow, reset);
+          return EXIT_FAILURE;
+        }
+
+        auto status = TreeUtils::validate(*tokens);
         if (status == TreeUtils::Status::Success)
           std::println("{}[INFO]{} : SVG validation succeeded.", green, reset);
         else
           std::println("{}[WARN]{} : SVG validation failed.", yellow, reset);
       } else if (arg1 == "--view") {
-        auto tree = handler.build(tokens);
+        auto tree = handler.parse();
+        if (!tree) {
+          std::println("{}[ERROR]{} : {}", red, reset,
+                       svg_core::describe(tree.error()));
+          return EXIT_FAILURE;
+        }
         std::println("{}[INFO]{} : SVG structure", blue, reset);
-        TreeUtils::view(tree);
+        TreeUtils::view(**tree);
       }
 
     } catch (const std::exception &e) {
@@ -100,7 +616,65 @@ auto main(int argc, char *argv[]) -> int {
   }
 
   // Standard pipeline execution
-  if (argc != 3) {
+  TreeUtils::TableOptions options;
+  auto format = Format::Auto;
+  std::string_view cache_directory;
+  bool valid_options = argc >= 3;
+  for (int i = 3; i < argc; ++i) {
+    std::string_view option = argv[i];
+    if (option == "--bbox")
+      options.bbox = true;
+    else if (option == "--bake")
+      options.bake = true;
+    else if (option == "--expand")
+      options.expand = true;
+    else if (option == "--shared")
+      options.shared = true;
+    else if (option == "--wide")
+      options.wide = true;
+    else if (option == "--content")
+      options.content = true;
+    else if (option == "--columns" && i + 1 < argc) {
+      options.wide = true;
+      for (auto name : std::views::split(std::string_view{argv[++i]}, ',')) {
+        if (!name.empty())
+          options.columns.emplace_back(std::string_view{name});
+      }
+    } else if (option == "--styles" && i + 1 < argc) {
+      StyleUtils::parse_properties(argv[++i], options.styles);
+    } else if (option == "--format" && i + 1 < argc) {
+      const std::string_view name = argv[++i];
+      if (name == "csv")
+        format = Format::Csv;
+      else if (name == "arrow")
+        format = Format::Arrow;
+      else if (name == "json")
+        format = Format::Json;
+      else if (name == "ndjson")
+        format = Format::Ndjson;
+      else
+        valid_options = false;
+    } else if (option == "--precision" && i + 1 < argc) {
+      std::string_view digits = argv[++i];
+      auto [end, ec] = std::from_chars(
+          digits.data(), digits.data() + digits.size(), options.precision);
+      valid_options = valid_options && ec == std::errc{} &&
+                      end == digits.data() + digits.size() &&
+                      options.precision >= 0;
+    } else if (option == "--simplify" && i + 1 < argc) {
+      std::string_view distance = argv[++i];
+      auto [end, ec] =
+          std::from_chars(distance.data(), distance.data() + distance.size(),
+                          options.tolerance);
+      valid_options = valid_options && ec == std::errc{} &&
+                      end == distance.data() + distance.size() &&
+                      options.tolerance >= 0.0;
+    } else if (option == "--cache" && i + 1 < argc)
+      cache_directory = argv[++i];
+    else
+      valid_options = false;
+  }
+  if (!valid_options) {
     std::println("{}[ERROR]{} : Invalid arguments!", red, reset);
     std::println("{}{}{}", green, USAGE, reset);
     return EXIT_FAILURE;
@@ -120,7 +694,11 @@ auto main(int argc, char *argv[]) -> int {
     fs::create_directories(fs::path(output_path).parent_path());
 
     SVG handler(input_path, output_path);
-    handler.execute();
+    handler.set_table_options(options);
+    handler.set_format(format);
+    handler.set_cache(cache_directory);
+    if (!handler.execute())
+      return EXIT_FAILURE;
 
     auto abs_output = fs::absolute(output_path).string();
     std::println("{}[INFO]{} : Output successfully saved to '{}'", green, reset,
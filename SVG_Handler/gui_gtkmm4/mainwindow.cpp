@@ -60,12 +60,16 @@ void MainWindow::on_open_clicked() {
       svgHandler_ = std::make_unique<SVG_HANDLER::SVG>(path, "output.csv");
 
       try {
-        auto content = svgHandler_->load();
-        auto prepared = svgHandler_->prepare(content);
-        auto tokens = svgHandler_->tokenize(prepared);
-        auto tree = svgHandler_->build(tokens);
+        auto tree = svgHandler_->parse();
+        if (!tree) {
+          auto message = svg_core::describe(tree.error());
+          statusBar_.push("Error: " + message);
+          std::println("{}[ERROR]{} : {}", color::red, color::reset, message);
+          dialog->hide();
+          return;
+        }
 
-        load_svg_to_tree(tree);
+        load_svg_to_tree(**tree);
 
         std::println("{}[INFO]{} : Loaded SVG successfully: {}", color::blue,
                      color::reset, path);
@@ -100,9 +104,17 @@ void MainWindow::on_export_clicked() {
       auto path = file->get_path();
 
       try {
-        auto table = svgHandler_->to_csv(svgHandler_->build(
-            svgHandler_->tokenize(svgHandler_->prepare(svgHandler_->load()))));
-        svgHandler_->export_csv(table, path);
+        auto tree = svgHandler_->parse();
+        auto saved = tree ? svgHandler_->export_csv(
+                                svgHandler_->to_csv(**tree), path)
+                          : std::unexpected(tree.error());
+        if (!saved) {
+          auto message = svg_core::describe(saved.error());
+          statusBar_.push("Export failed: " + message);
+          std::println("{}[ERROR]{} : {}", color::red, color::reset, message);
+          dialog->hide();
+          return;
+        }
         std::println("{}[INFO]{} : Exported SVG successfully: {}", color::blue,
                      color::reset, path);
         statusBar_.push("Exported: " + path);
@@ -44,13 +44,17 @@ void MainWindow::openFile() {
     svg_handler_ =
         std::make_unique<SVG>(filePath.toStdString(), "temp_output.csv");
 
-    auto svgContent = svg_handler_->load();
-    auto prepared = svg_handler_->prepare(svgContent);
-    auto tokens = svg_handler_->tokenize(prepared);
-    auto tree = svg_handler_->build(tokens);
+    auto tree = svg_handler_->parse();
+    if (!tree) {
+      QMessageBox::critical(
+          this, "Error",
+          QString("Failed to load SVG:\n%1")
+              .arg(QString::fromStdString(svg_core::describe(tree.error()))));
+      return;
+    }
 
     clearTreeView();
-    loadSvgToTree(tree);
+    loadSvgToTree(**tree);
 
     std::println("{}[INFO]{} : Loaded SVG successfully: {}", color::blue,
                  color::reset, filePath.toStdString());
@@ -76,12 +80,18 @@ void MainWindow::exportCSV() {
     return;
 
   try {
-    auto svgContent = svg_handler_->load();
-    auto prepared = svg_handler_->prepare(svgContent);
-    auto tokens = svg_handler_->tokenize(prepared);
-    auto tree = svg_handler_->build(tokens);
-    auto table = svg_handler_->to_csv(tree);
-    svg_handler_->export_csv(table, csvPath.toStdString());
+    auto tree = svg_handler_->parse();
+    auto saved =
+        tree ? svg_handler_->export_csv(svg_handler_->to_csv(**tree),
+                                        csvPath.toStdString())
+             : std::unexpected(tree.error());
+    if (!saved) {
+      QMessageBox::critical(
+          this, "Error",
+          QString("Export failed:\n%1")
+              .arg(QString::fromStdString(svg_core::describe(saved.error()))));
+      return;
+    }
 
     currentCsvPath_ = csvPath;
     QMessageBox::information(this, "Success", "CSV exported successfully!");
@@ -0,0 +1,157 @@
+/*
+ * Exports the element table as typed columns in the Arrow IPC file format.
+ */
+
+#pragma once
+
+#include "svg_core.hpp"
+#include "tree_utils.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Arrow C Data Interface (ABI-stable, see the Arrow format documentation)
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+    // Array type description
+    const char *format;
+    const char *name;
+    const char *metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema **children;
+    struct ArrowSchema *dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowSchema *);
+    // Opaque producer-specific data
+    void *private_data;
+};
+
+struct ArrowArray {
+    // Array data description
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void **buffers;
+    struct ArrowArray **children;
+    struct ArrowArray *dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowArray *);
+    // Opaque producer-specific data
+    void *private_data;
+};
+
+#endif // ARROW_C_DATA_INTERFACE
+
+namespace ArrowExporter {
+
+    using svg_core::Expected; // {value, Error}
+
+    /**
+     * @brief Strings of a dictionary, in Arrow Utf8 layout.
+     */
+    struct Dictionary {
+        std::vector<std::int32_t> offsets{0}; // size() + 1 entries
+        std::string data;
+
+        auto size() const -> std::size_t { return offsets.size() - 1; }
+    };
+
+    /**
+     * @brief Rows of TreeUtils::table as typed columns, one entry per row:
+     *
+     *   ID, ParentID (-1 for the root), Depth   int32
+     *   Tag, Attribute                          int32 (tags/attributes index)
+     *   Value                                   Utf8
+     *   MinX, MinY, MaxX, MaxY                  float64 (with options.bbox)
+     *
+     * Attribute and Value are null on the row of an element without
+     * attributes; the box columns are null where an element has no box.
+     * Validity bitmaps are LSB first, one bit per row.
+     */
+    struct Columns {
+        std::size_t rows{0};
+        bool bbox{false};
+
+        std::vector<std::int32_t> id;
+        std::vector<std::int32_t> parent;
+        std::vector<std::int32_t> depth;
+        std::vector<std::int32_t> tag;
+        std::vector<std::int32_t> attribute;
+        std::vector<std::uint8_t> attribute_valid; // also the Value validity
+        std::size_t attribute_nulls{0};
+        std::vector<std::int32_t> value_offsets{0};
+        std::string value_data;
+
+        std::vector<double> min_x, min_y, max_x, max_y;
+        std::vector<std::uint8_t> bbox_valid;
+        std::size_t bbox_nulls{0};
+
+        Dictionary tags;
+        Dictionary attributes;
+    };
+
+    /**
+     * @brief Typed columns of a tree (same rows as TreeUtils::table).
+     *
+     * @param tree Tree with its index
+     * @param options Only bbox is used
+     * @return Columns (no rows for an empty tree)
+     */
+    auto columns(const TreeUtils::Tree &tree,
+                 const TreeUtils::TableOptions &options = {}) -> Columns;
+
+    /**
+     * @brief Arrow IPC file (format version V5, native byte order): the
+     * schema, one dictionary batch per dictionary and one record batch.
+     * Depth and the dictionary indices are stored as int8 or int16 when
+     * their values fit.
+     *
+     * @param columns
+     * @param bytes Receives the file (capacity is reused)
+     */
+    void encode(const Columns &columns, std::string &bytes);
+
+    /**
+     * @brief Export columns through the Arrow C Data Interface: a struct
+     * array with one child per column (int32 integers and dictionary
+     * indices, Utf8 strings, float64 boxes). The buffers are the ones of
+     * columns, kept until the array and every child moved out of it are
+     * released; the schema is released separately.
+     *
+     * @param columns Moved into the exported array
+     * @param array Receives the array (consumer calls array->release)
+     * @param schema Receives the schema (consumer calls schema->release)
+     */
+    void export_c(Columns columns, ArrowArray *array, ArrowSchema *schema);
+
+    /**
+     * @brief Save the columns of a tree as an Arrow IPC file.
+     *
+     * @param path e.g. "out.arrow"
+     * @param tree
+     * @param options Only bbox is used
+     * @return Nothing or Error {InvalidPath, FileError}
+     */
+    auto save(std::string_view path, const TreeUtils::Tree &tree,
+              const TreeUtils::TableOptions &options = {}) -> Expected<void>;
+
+} // namespace ArrowExporter
+
+/**
+ * @brief Basic test.
+ */
+void test_arrow_exporter();
@@ -0,0 +1,128 @@
+/*
+ * Content-addressed on-disk cache of parse results.
+ */
+
+#pragma once
+
+#include "svg_core.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace CacheUtils {
+
+    using svg_core::Expected; // {value, Error}
+
+    /**
+     * @brief XXH64 hash.
+     *
+     * @param data
+     * @param seed
+     * @return 64-bit hash (same values as the reference implementation)
+     */
+    auto xxh64(std::string_view data, std::uint64_t seed = 0) -> std::uint64_t;
+
+    /**
+     * @brief Cache key of a document: hash of its content, seeded with the
+     * library version and the settings that change the result.
+     *
+     * @param content Document bytes
+     * @param settings e.g. the enabled table options
+     * @return 16 hex digits
+     */
+    auto key(std::string_view content, std::string_view settings = {})
+        -> std::string;
+
+    /**
+     * @brief Directory of entries named <key><extension>, evicted least
+     * recently used first once their total size exceeds the budget.
+     * Entries are written to a temporary file and renamed, so concurrent
+     * jobs never read a partial entry.
+     */
+    class Cache {
+    public:
+        // 256 MiB
+        static constexpr std::uintmax_t default_budget = 256ULL << 20;
+
+        explicit Cache(std::filesystem::path directory,
+                       std::uintmax_t budget = default_budget);
+
+        /**
+         * @brief Path of an entry, marked as recently used.
+         *
+         * @param key
+         * @param extension e.g. ".csv"
+         * @return Path or nullopt on a miss
+         */
+        auto lookup(std::string_view key, std::string_view extension)
+            -> std::optional<std::filesystem::path>;
+
+        /**
+         * @brief Add (or replace) an entry, then evict once the running
+         * total exceeds the budget.
+         *
+         * @param key
+         * @param extension
+         * @param bytes
+         * @return Nothing or Error {FileError}
+         */
+        auto store(std::string_view key, std::string_view extension,
+                   std::string_view bytes) -> Expected<void>;
+
+        /**
+         * @brief Add (or replace) an entry with the content of a file, then
+         * evict.
+         *
+         * @return Nothing or Error {FileError}
+         */
+        auto store_file(std::string_view key, std::string_view extension,
+                        const std::filesystem::path &source) -> Expected<void>;
+
+        /**
+         * @brief Remove least recently used entries until the total size
+         * fits the budget.
+         *
+         * @return Bytes in the cache afterwards
+         */
+        auto evict() -> std::uintmax_t;
+
+        /**
+         * @brief Bytes in the cache as counted by this object: listed on the
+         * first store or evict(), then kept up to date by its own stores.
+         *
+         * @return Size, 0 before the first store
+         */
+        auto size() const -> std::uintmax_t { return size_.value_or(0); }
+
+        auto directory() const -> const std::filesystem::path & {
+            return directory_;
+        }
+        auto budget() const -> std::uintmax_t { return budget_; }
+        auto hits() const -> std::size_t { return hits_; }
+        auto misses() const -> std::size_t { return misses_; }
+
+    private:
+        auto path(std::string_view key, std::string_view extension) const
+            -> std::filesystem::path;
+        auto commit(const std::filesystem::path &temporary,
+                    std::string_view key, std::string_view extension)
+            -> Expected<void>;
+        auto trim(std::uintmax_t target) -> std::uintmax_t;
+
+        std::filesystem::path directory_;
+        std::uintmax_t budget_;
+        std::optional<std::uintmax_t> size_; // unknown until listed
+        std::size_t hits_{0};
+        std::size_t misses_{0};
+    };
+
+} // namespace CacheUtils
+
+/**
+ * @brief Basic test.
+ */
+void test_cache_utils();
@@ -10,6 +10,7 @@
 #include <filesystem>
 #include <fstream>
 #include <memory>
+#include <ostream>
 #include <vector>
 
 namespace CsvExporter {
@@ -18,6 +19,7 @@ namespace CsvExporter {
     using ExpectedFile = std::expected<FileHandle, std::error_code>;
 
     using svg_core::CsvTable;
+    using svg_core::Expected;
 
     /**
     * @brief Checks the existence of an CSV file.
@@ -27,14 +29,26 @@ namespace CsvExporter {
     */
     auto check(const std::filesystem::path &path) -> ExpectedFile;
 
+    /**
+    * @brief Write a table as CSV; fields holding the delimiter, quotes or
+    * line breaks are quoted.
+    *
+    * @param out e.g. a file or std::cout
+    * @param table
+    * @param delimiter char
+    */
+    void write(std::ostream &out, const CsvTable &table, char delimiter = ',');
+
     /**
     * @brief Save CSV file.
     *
     * @param path
     * @param vector 2D of text
     * @param delimiter char
+    * @return Nothing or Error {InvalidPath, FileError}
     */
-    void save(std::string_view path, const CsvTable &table, char delimiter = ',');
+    auto save(std::string_view path, const CsvTable &table,
+              char delimiter = ',') -> Expected<void>;
 } // namespace CsvExporter
 
 /**
@@ -0,0 +1,83 @@
+/*
+ * Shared (DAG) representation of a tree: identical subtrees stored once.
+ */
+
+#pragma once
+
+#include "svg_core.hpp"
+#include "tree_utils.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace DagUtils {
+
+    using svg_core::Attributes; // vector {"name", "value"}
+    using svg_core::CsvTable;
+
+    /**
+     * @brief One distinct subtree.
+     */
+    struct DagNode {
+        std::string tag;
+        Attributes attributes;
+        std::vector<std::size_t> children; // indices into Dag::nodes
+
+        std::uint64_t hash{0}; // TreeIndex::hashes of its copies
+        std::size_t size{1};   // elements once expanded
+        std::size_t count{0};  // copies in the tree
+        std::size_t first{0};  // pre-order position of the first copy
+    };
+
+    /**
+     * @brief Hash-consed tree. Children come before their parents in
+     * nodes; the tree does not need to be kept alive.
+     */
+    struct Dag {
+        std::vector<DagNode> nodes;
+        std::vector<std::size_t> classes; // DagNode of each pre-order position
+        std::size_t root{std::string_view::npos};
+    };
+
+    /**
+     * @brief Build the shared representation (see TreeUtils::first_copies).
+     *
+     * @param tree Tree with its index
+     * @return Dag (empty for an empty tree)
+     */
+    auto build(const TreeUtils::Tree &tree) -> Dag;
+
+    /**
+     * @brief Rebuild a full tree, one Node per copy.
+     *
+     * @param dag
+     * @return Tree with its index
+     */
+    auto expand(const Dag &dag) -> TreeUtils::Tree;
+
+    /**
+     * @brief Elements of the expanded tree.
+     */
+    auto expanded_size(const Dag &dag) -> std::size_t;
+
+    /**
+     * @brief Repeated subtrees that are not only part of a larger repeated
+     * subtree, by saved elements (descending).
+     *
+     * Columns: Subtree (ID of the first copy), Tag, Hash (hex), Nodes,
+     * Copies, Saved ((Copies - 1) * Nodes).
+     *
+     * @param dag
+     * @return CSV table (header only if nothing repeats)
+     */
+    auto report(const Dag &dag) -> CsvTable;
+
+} // namespace DagUtils
+
+/**
+ * @brief Basic test.
+ */
+void test_dag_utils();
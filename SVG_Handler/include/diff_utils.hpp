@@ -0,0 +1,101 @@
+/*
+ * Structural diff between two parsed trees.
+ */
+
+#pragma once
+
+#include "svg_core.hpp"
+#include "tree_utils.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace DiffUtils {
+
+    using svg_core::CsvTable;
+
+    enum class Change {
+        Inserted, /// < element only in the new tree
+        Removed,  /// < element only in the old tree
+        Moved,    /// < matched element under another parent
+        Changed   /// < attribute added, removed or given another value
+    };
+
+    /**
+     * @brief Lower-case name of a Change ("inserted", ...).
+     */
+    constexpr auto to_string(Change change) -> std::string_view {
+        switch (change) {
+        case Change::Inserted: return "inserted";
+        case Change::Removed: return "removed";
+        case Change::Moved: return "moved";
+        case Change::Changed: return "changed";
+        }
+        return "unknown";
+    }
+
+    /**
+     * @brief One difference. Positions are pre-order (the CSV IDs);
+     * npos where the element does not exist.
+     */
+    struct Entry {
+        Change change{Change::Changed};
+        std::size_t before{std::string_view::npos}; // position in the old tree
+        std::size_t after{std::string_view::npos};  // position in the new tree
+        std::string tag;
+        std::string attribute;                      // Changed only
+        std::optional<std::string> old_value;       // parent ID if Moved
+        std::optional<std::string> new_value;
+    };
+
+    struct Diff {
+        // Removed (old pre-order), then the rest (new pre-order)
+        std::vector<Entry> entries;
+        // New position of each old position (npos if removed)
+        std::vector<std::size_t> matches;
+    };
+
+    /**
+     * @brief Match the elements of two trees and list their differences.
+     *
+     * Elements are matched by unique id (same tag), then by subtree hash
+     * (hashes unique in both trees; the whole subtrees are paired), then
+     * by position: unmatched children of matched elements are paired in
+     * order among those with the same tag. Runs in O(n log n) at worst.
+     *
+     * @param before Old tree with its index
+     * @param after New tree with its index
+     * @return Diff
+     */
+    auto diff(const TreeUtils::Tree &before, const TreeUtils::Tree &after)
+        -> Diff;
+
+    /**
+     * @brief Differences as CSV.
+     *
+     * Columns: Change, Before, After (IDs, -1 if absent), Tag, Attribute,
+     * Old, New.
+     *
+     * @param diff
+     * @return CSV table (header only if the trees are equal)
+     */
+    auto table(const Diff &diff) -> CsvTable;
+
+    /**
+     * @brief Differences as a JSON array of objects with the keys change,
+     * before, after, tag, attribute, old and new (null if absent).
+     *
+     * @param diff
+     * @return JSON text
+     */
+    auto json(const Diff &diff) -> std::string;
+
+} // namespace DiffUtils
+
+/**
+ * @brief Basic test.
+ */
+void test_diff_utils();
@@ -0,0 +1,126 @@
+/*
+ * Geometry of SVG elements: transforms and bounding boxes.
+ */
+
+#pragma once
+
+#include "svg_core.hpp"
+#include "path_utils.hpp"
+#include "tree_utils.hpp"
+
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace GeometryUtils {
+
+    using svg_core::BBox; // {min_x, min_y, max_x, max_y}
+    using svg_core::Expected; // {value, Error}
+    using svg_core::Matrix; // {a, b, c, d, e, f}
+
+    /**
+     * @brief Parse a transform list (e.g. "translate(20,20) rotate(45)").
+     * Supports matrix, translate, scale, rotate, skewX and skewY.
+     *
+     * @param str Value of the 'transform' attribute
+     * @return Matrix or Error {InvalidTransform} with offset into str.
+     */
+    auto parse_transform(std::string_view str) -> Expected<Matrix>;
+
+    /**
+     * @brief Compute Node::ctm for every element: the product of the
+     * 'transform' attributes from the root down (invalid ones count as
+     * identity).
+     * Children of <use> (expanded references) are also offset by its x/y.
+     *
+     * @param tree
+     */
+    void flatten(TreeUtils::Tree &tree);
+
+    /**
+     * @brief Apply a transform to an absolute path (see PathUtils::absolute).
+     * Arcs stay arcs under translation and axis-aligned scaling, otherwise
+     * they are converted to cubics.
+     *
+     * @param path Absolute path data
+     * @param m
+     * @return Absolute path data
+     */
+    auto transform_path(const PathUtils::PathData &path, const Matrix &m)
+        -> PathUtils::PathData;
+
+    /**
+     * @brief Bake transforms into coordinates and drop 'transform' attributes.
+     * line, polyline, polygon and path are rewritten; rect, circle and ellipse
+     * keep their form under axis-aligned transforms and become path otherwise.
+     * Other elements get their accumulated transform as matrix(...).
+     * Content of defs-like elements is left as is, and presentation values
+     * such as stroke-width are not scaled. The tree index is rebuilt.
+     *
+     * @param tree
+     */
+    void bake(TreeUtils::Tree &tree);
+
+    /**
+     * @brief Bounding box of coordinate arrays (SIMD min/max).
+     *
+     * @param xs
+     * @param ys Same size as xs
+     * @return BBox (empty if there are no points)
+     */
+    auto bounds(std::span<const double> xs, std::span<const double> ys) -> BBox;
+
+    /**
+     * @brief Bounding box of an absolute path (see PathUtils::absolute)
+     * after applying ctm, including bezier and arc extrema.
+     *
+     * @param path Absolute path data
+     * @param ctm Transform to apply
+     * @return BBox
+     */
+    auto path_bbox(const PathUtils::PathData &path, const Matrix &ctm = {})
+        -> BBox;
+
+    /**
+     * @brief Bounding box of a single element, children excluded.
+     * Supports rect, circle, ellipse, line, polyline, polygon and path.
+     *
+     * @param node
+     * @param ctm Transform from the element to root coordinates
+     * @param viewport Width and height used to resolve percentages
+     * @return BBox or nullopt if the element has no geometry.
+     */
+    auto element_bbox(const TreeUtils::Node &node, const Matrix &ctm = {},
+                      std::pair<double, double> viewport = {0.0, 0.0})
+        -> std::optional<BBox>;
+
+    /**
+     * @brief Compute Node::bbox for every element of the tree.
+     * Uses Node::ctm, filled in where missing (see flatten); containers
+     * (svg, g, a, switch, use) get the union of their children. Content of
+     * defs, symbol, clipPath, mask, pattern and marker is not rendered and
+     * gets none.
+     *
+     * @param tree
+     */
+    void compute(TreeUtils::Tree &tree);
+
+    /**
+     * @brief Update Node::ctm (and Node::bbox if bbox) after the attributes
+     * of one element changed: its subtree and, for boxes, its ancestors.
+     * Everything is recomputed when the element is the root.
+     *
+     * @param tree Tree with its index, flattened (and computed) before the
+     *             change
+     * @param position Pre-order position of the changed element
+     * @param bbox Also update bounding boxes
+     */
+    void refresh(TreeUtils::Tree &tree, std::size_t position, bool bbox);
+
+} // namespace GeometryUtils
+
+/**
+ * @brief Basic test.
+ */
+void test_geometry_utils();
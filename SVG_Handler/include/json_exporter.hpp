@@ -0,0 +1,72 @@
+/*
+ * Exports the parsed tree as JSON (nested) or NDJSON (one element per line).
+ */
+
+#pragma once
+
+#include "svg_core.hpp"
+#include "tree_utils.hpp"
+
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace JsonExporter {
+
+    using svg_core::Expected; // {value, Error}
+
+    enum class Format {
+        Tree, /// < one nested object, children in "children"
+        Lines /// < NDJSON: one object per element, in pre-order
+    };
+
+    /**
+     * @brief Append text as the contents of a JSON string: quotes,
+     * backslashes and control characters are escaped, other bytes
+     * (UTF-8 included) are copied.
+     *
+     * @param text
+     * @param out Receives the escaped text (without the enclosing quotes)
+     */
+    void escape(std::string_view text, std::string &out);
+
+    /**
+     * @brief Write a tree as JSON, straight from its index.
+     *
+     * Each element is an object with "id" (pre-order, the CSV ID), "tag",
+     * "attributes" (name -> value, in document order), with
+     * options.content "content" (objects {"kind", "after", "text"}, see
+     * TreeUtils::attach), with options.styles "style" (property -> computed
+     * value, see StyleUtils::compute) and with options.bbox "bbox" ([minX,
+     * minY, maxX, maxY] or null).
+     * Format::Lines adds "parent" (-1 for the root) and "depth"; Format::Tree
+     * nests the children of an element in "children" instead.
+     * Output goes through a fixed-size buffer, so memory does not grow
+     * with the tree.
+     *
+     * @param out
+     * @param tree Tree with its index ("null" or no lines if empty)
+     * @param format
+     * @param options Only bbox, content and styles are used
+     */
+    void write(std::ostream &out, const TreeUtils::Tree &tree, Format format,
+               const TreeUtils::TableOptions &options = {});
+
+    /**
+     * @brief Save a tree as a JSON or NDJSON file (see write).
+     *
+     * @param path e.g. "out.json"
+     * @param tree
+     * @param format
+     * @param options Only bbox, content and styles are used
+     * @return Nothing or Error {InvalidPath, FileError}
+     */
+    auto save(std::string_view path, const TreeUtils::Tree &tree, Format format,
+              const TreeUtils::TableOptions &options = {}) -> Expected<void>;
+
+} // namespace JsonExporter
+
+/**
+ * @brief Basic test.
+ */
+void test_json_exporter();
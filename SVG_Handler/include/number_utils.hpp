@@ -0,0 +1,70 @@
+/*
+ * Parses numeric attribute values (numbers, lengths, percentages).
+ */
+
+#pragma once
+
+#include "svg_core.hpp"
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace NumberUtils {
+
+    using svg_core::Length; // {value, unit}
+    using svg_core::Unit; // {None, Px, Pt, Pc, Mm, Cm, In, Em, Ex, Percent}
+
+    /**
+     * @brief Parse a plain number (e.g. "25", "-1.5e2").
+     * Surrounding whitespace is allowed.
+     *
+     * @param str
+     * @return Number or nullopt if str is not a number.
+     */
+    auto parse_number(std::string_view str) -> std::optional<double>;
+
+    /**
+     * @brief Parse a length or percentage (e.g. "10", "2mm", "50%").
+     * Units are case-insensitive.
+     *
+     * @param str
+     * @return Length or nullopt if str is not a length.
+     */
+    auto parse_length(std::string_view str) -> std::optional<Length>;
+
+    /**
+     * @brief Convert a length to user units (96 px per inch).
+     *
+     * @param length
+     * @param reference Value of 100% (e.g. viewport width)
+     * @param font_size Value of 1em
+     * @return Length in px
+     */
+    auto to_px(const Length &length, double reference = 0.0,
+               double font_size = 16.0) -> double;
+
+    /**
+     * @brief Unit suffix ("", "px", "mm", "%", ...).
+     */
+    auto unit_name(Unit unit) -> std::string_view;
+
+    /**
+     * @brief Round the numbers of a numeric value (path data, points,
+     * transform, viewBox, lengths) to some decimals, e.g. "M10.1234,5L.0001 3"
+     * -> "M10.12,5L0 3". Integers are copied as written (they may be packed
+     * arc flags) and a space is added where a shortened number would merge
+     * with the one before it. Other text is copied.
+     *
+     * @param text
+     * @param decimals Digits kept after the point (>= 0)
+     * @param out Receives the value (cleared first)
+     */
+    void round_numbers(std::string_view text, int decimals, std::string &out);
+
+} // namespace NumberUtils
+
+/**
+ * @brief Basic test.
+ */
+void test_number_utils();
@@ -0,0 +1,98 @@
+/*
+ * Parses SVG path data (the 'd' attribute of <path>).
+ */
+
+#pragma once
+
+#include "svg_core.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace PathUtils {
+
+    using svg_core::Expected; // {value, Error}
+
+    /**
+     * @brief Path as structure of arrays.
+     *
+     * commands holds one letter per segment (implicit repeats expanded,
+     * lowercase = relative). args holds the arguments of every segment
+     * in order; arity(command) of them belong to each command.
+     *
+     * "M10 10 20 20z" -> commands {M, L, z}, args {10, 10, 20, 20}
+     */
+    struct PathData {
+        std::vector<char> commands;
+        std::vector<double> args;
+
+        auto operator==(const PathData &) const -> bool = default;
+    };
+
+    /**
+     * @brief Number of arguments of a path command.
+     *
+     * @param command Path letter (M, l, C, a, Z, ...)
+     * @return Arguments per segment, -1 if command is not a path command.
+     */
+    auto arity(char command) -> int;
+
+    /**
+     * @brief Parse an SVG number at the start of str.
+     * Fast path for up to 19 significant digits (8 digits per step),
+     * std::from_chars otherwise.
+     *
+     * @param str
+     * @param value Receives the number
+     * @return Characters consumed, 0 if str does not start with a number.
+     */
+    auto parse_number(std::string_view str, double &value) -> std::size_t;
+
+    /**
+     * @brief Parse path data.
+     *
+     * @param d Value of the 'd' attribute
+     * @return PathData or Error {InvalidPathData} with offset into d.
+     */
+    auto parse(std::string_view d) -> Expected<PathData>;
+
+    /**
+     * @brief Parse path data into an existing buffer (capacity is reused).
+     *
+     * @param d Value of the 'd' attribute
+     * @param path Receives the commands and arguments
+     * @return Nothing or Error {InvalidPathData} with offset into d.
+     */
+    auto parse(std::string_view d, PathData &path) -> Expected<void>;
+
+    /**
+     * @brief Convert to absolute M, L, C, Q, A and Z segments.
+     * H/V become L, S becomes C and T becomes Q (control points reflected).
+     *
+     * @param path
+     * @return Absolute path
+     */
+    auto absolute(const PathData &path) -> PathData;
+
+    /**
+     * @brief Path data text, e.g. "M10,10L20,20Z" (shortest round-trip
+     * numbers).
+     *
+     * @param path
+     * @return Value for the 'd' attribute
+     */
+    auto serialize(const PathData &path) -> std::string;
+
+    /**
+     * @brief Serialize into an existing string (cleared first, capacity
+     * reused).
+     */
+    void serialize(const PathData &path, std::string &d);
+
+} // namespace PathUtils
+
+/**
+ * @brief Basic test.
+ */
+void test_path_utils();
@@ -0,0 +1,111 @@
+/*
+ * Element queries: CSS selectors and a subset of XPath.
+ */
+
+#pragma once
+
+#include "svg_core.hpp"
+#include "tree_utils.hpp"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace QueryUtils {
+
+    using svg_core::Expected; // {value, Error}
+
+    /**
+     * @brief Test on one element: #id, .class or an attribute.
+     */
+    struct Condition {
+        enum class Kind : unsigned char {
+            Id,       // #id
+            Class,    // .class
+            Has,      // [name]
+            Equals,   // [name=value]
+            Prefix,   // [name^=value]
+            Suffix,   // [name$=value]
+            Contains  // [name*=value]
+        };
+
+        Kind kind{Kind::Has};
+        std::string name;
+        std::string value;
+
+        auto operator==(const Condition &) const -> bool = default;
+    };
+
+    /**
+     * @brief Compound selector and its relation to the previous step.
+     */
+    struct Step {
+        enum class Axis : unsigned char {
+            Descendant, // "a b", "//b"
+            Child       // "a > b", "/b"
+        };
+
+        Axis axis{Axis::Descendant};
+        std::string tag; // empty = any element
+        std::vector<Condition> conditions;
+
+        auto operator==(const Step &) const -> bool = default;
+    };
+
+    /**
+     * @brief Steps from left to right. If rooted, the first step must
+     * match the root element (XPath "/svg/...").
+     */
+    struct Selector {
+        std::vector<Step> steps;
+        bool rooted{false};
+
+        auto operator==(const Selector &) const -> bool = default;
+    };
+
+    /**
+     * @brief Comma separated selectors (or XPath '|' alternatives).
+     */
+    using Query = std::vector<Selector>;
+
+    /**
+     * @brief Parse a query.
+     *
+     * CSS: tag, *, #id, .class, [attr], [attr=value] (also ^=, $=, *=),
+     *      descendant (space) and child (>) combinators, ',' lists.
+     * XPath (starts with '/'): /a/b, //b, *, [@attr], [@attr='value'],
+     *      '|' lists.
+     *
+     * @param query
+     * @return Query or Error {InvalidQuery} with offset into query.
+     */
+    auto parse(std::string_view query) -> Expected<Query>;
+
+    /**
+     * @brief Elements matching the query, in document order without duplicates.
+     * Candidates come from the tree index (id, class or tag tables).
+     *
+     * @param tree Tree with its index (see TreeUtils::reindex)
+     * @param query
+     * @param positions Receives pre-order positions (see TreeUtils::TreeIndex)
+     */
+    void select(const TreeUtils::Tree &tree, const Query &query,
+                std::vector<std::size_t> &positions);
+
+    /**
+     * @brief Parse and run a query.
+     *
+     * @param tree
+     * @param query
+     * @return Pre-order positions or Error {InvalidQuery}
+     */
+    auto select(const TreeUtils::Tree &tree, std::string_view query)
+        -> Expected<std::vector<std::size_t>>;
+
+} // namespace QueryUtils
+
+/**
+ * @brief Basic test.
+ */
+void test_query_utils();
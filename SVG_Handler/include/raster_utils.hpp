@@ -0,0 +1,110 @@
+/*
+ * Software rasterizer: renders a parsed tree to pixels (PNG, PPM).
+ */
+
+#pragma once
+
+#include "svg_core.hpp"
+#include "tree_utils.hpp"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace RasterUtils {
+
+    using svg_core::Expected; // {value, Error}
+
+    using Color = std::array<std::uint8_t, 4>; // RGBA, not premultiplied
+
+    /**
+     * @brief RGBA pixels, 8 bits per channel, rows top to bottom, not
+     * premultiplied.
+     */
+    struct Image {
+        int width{0};
+        int height{0};
+        std::vector<std::uint8_t> pixels; // width * height * 4
+
+        auto pixel(int x, int y) const -> Color {
+            const auto *p =
+                &pixels[(static_cast<std::size_t>(y) * width + x) * 4];
+            return {p[0], p[1], p[2], p[3]};
+        }
+    };
+
+    struct Options {
+        int size{256};          // longest side in pixels (aspect ratio kept)
+        std::string background; // CSS color under it (empty: transparent)
+        unsigned threads{0};    // worker threads (0: one per hardware thread)
+    };
+
+    /**
+     * @brief Parse a CSS color: keyword (red, cornflowerblue, transparent),
+     * #rgb, #rgba, #rrggbb, #rrggbbaa, rgb() and rgba() with numbers or
+     * percentages.
+     *
+     * @param text
+     * @return Color or nullopt ("none", paint servers, invalid)
+     */
+    auto parse_color(std::string_view text) -> std::optional<Color>;
+
+    /**
+     * @brief Render a tree.
+     *
+     * The document box (viewBox, else width and height, else the bounds
+     * of the content) is scaled so that its longest side is options.size
+     * pixels. rect (rx, ry), circle, ellipse, line, polyline, polygon and
+     * path are filled and stroked with solid colors after the cascade
+     * (StyleUtils::compute, which fills Node::style): fill, stroke,
+     * fill-rule, stroke-width, stroke-linecap, stroke-linejoin,
+     * stroke-miterlimit, opacities, display, visibility and currentColor.
+     * Group opacity is applied to each shape; a gradient paints the
+     * average of its stops. Text, images, dashes, clipping, masks and
+     * filters are not rendered; <use> is drawn once expanded (see
+     * ReferenceUtils::expand).
+     *
+     * Curves are flattened in device space and strokes turned into
+     * polygons; coverage is computed per pixel on 4 sub-scanlines with
+     * exact horizontal coverage. The image is cut into 64 pixel tiles
+     * rendered in parallel, each drawing the shapes over it in document order.
+     *
+     * @param tree Tree with its index; Node::ctm is computed if missing
+     * @param options
+     * @return Image or Error {EmptyInput (nothing to size the image),
+     *         InvalidOption (size, background)}
+     */
+    auto render(TreeUtils::Tree &tree, const Options &options = {})
+        -> Expected<Image>;
+
+    /**
+     * @brief Write an image as PNG (8-bit RGBA, deflate with fixed Huffman
+     * codes).
+     */
+    void write_png(std::ostream &out, const Image &image);
+
+    /**
+     * @brief Write an image as binary PPM (P6); transparent pixels are
+     * composited over white.
+     */
+    void write_ppm(std::ostream &out, const Image &image);
+
+    /**
+     * @brief Save an image, as PNG or PPM by extension.
+     *
+     * @param path e.g. "thumb.png", "thumb.ppm"
+     * @param image
+     * @return Nothing or Error {InvalidPath, InvalidExtension, FileError}
+     */
+    auto save(std::string_view path, const Image &image) -> Expected<void>;
+
+} // namespace RasterUtils
+
+/**
+ * @brief Basic test.
+ */
+void test_raster_utils();
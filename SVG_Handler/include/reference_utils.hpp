@@ -0,0 +1,114 @@
+/*
+ * References between elements: href="#id" and url(#id).
+ */
+
+#pragma once
+
+#include "svg_core.hpp"
+#include "tree_utils.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace ReferenceUtils {
+
+    /**
+     * @brief One reference of the document (positions as in
+     * TreeUtils::TreeIndex).
+     */
+    struct Link {
+        std::size_t source{0};
+        std::string_view attribute; // href, xlink:href, fill, clip-path, ...
+        std::string_view id;
+        std::size_t target{0}; // npos if no element has the id
+    };
+
+    /**
+     * @brief Id referenced by an attribute value: "#id" or "url(#id)".
+     *
+     * @param value
+     * @return Id (without '#') or nullopt for anything else.
+     */
+    auto parse_reference(std::string_view value)
+        -> std::optional<std::string_view>;
+
+    /**
+     * @brief Reference lookups over one tree, memoized per element.
+     * Valid while the tree and its index are unchanged.
+     */
+    class Resolver {
+    public:
+        explicit Resolver(const TreeUtils::Tree &tree);
+
+        /**
+         * @brief Element referenced by href / xlink:href of the element.
+         *
+         * @param position
+         * @return Position or npos
+         */
+        auto target(std::size_t position) -> std::size_t;
+
+        /**
+         * @brief Last element of the href chain starting at position
+         * (e.g. the gradient that provides the stops).
+         *
+         * @param position
+         * @return Position (itself without href), npos if the chain is
+         *         broken or cyclic.
+         */
+        auto base(std::size_t position) -> std::size_t;
+
+        /**
+         * @brief Every reference of the document: href, xlink:href and
+         * url(#id) in fill, stroke, clip-path, mask, filter and markers.
+         *
+         * @return Links in document order
+         */
+        auto links() -> std::vector<Link>;
+
+    private:
+        enum class State : unsigned char { Unknown, Visiting, Done };
+
+        const TreeUtils::Tree &tree_;
+        std::vector<std::size_t> targets_;
+        std::vector<State> target_state_;
+        std::vector<std::size_t> bases_;
+        std::vector<State> base_state_;
+    };
+
+    /**
+     * @brief Result of expand.
+     */
+    struct Expansion {
+        std::size_t expanded{0};   // <use> elements given their content
+        std::size_t unresolved{0}; // <use> pointing to a missing id
+        std::size_t cycles{0};     // <use> left empty, refers to itself
+        std::size_t limited{0};    // <use> left empty, limit reached
+    };
+
+    /// Elements expand may copy in total (nested <use> multiply quickly)
+    constexpr std::size_t default_expansion_limit = 1 << 20;
+
+    /**
+     * @brief Copy the content referenced by each <use> under it, as in its
+     * shadow tree. Nested <use> are expanded too; each referenced element
+     * is expanded once and copied for every use. Copies lose their id
+     * (ids stay unique) and symbol becomes svg. The index is rebuilt.
+     * Copying stops once limit elements were copied; the remaining <use>
+     * stay empty and are counted in Expansion::limited.
+     *
+     * @param tree
+     * @param limit Elements copied at most, stored copies included
+     * @return Counters
+     */
+    auto expand(TreeUtils::Tree &tree,
+                std::size_t limit = default_expansion_limit) -> Expansion;
+
+} // namespace ReferenceUtils
+
+/**
+ * @brief Basic test.
+ */
+void test_reference_utils();
@@ -0,0 +1,65 @@
+/*
+ * Reduces geometry: coordinate rounding and polyline simplification.
+ */
+
+#pragma once
+
+#include "svg_core.hpp"
+#include "tree_utils.hpp"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace SimplifyUtils {
+
+    struct Options {
+        int precision{-1};      // decimals kept in coordinates (-1: as written)
+        double tolerance{-1.0}; // Douglas-Peucker distance (0: collinear
+                                // points only, < 0: off)
+        unsigned threads{0};    // worker threads (0: one per hardware thread)
+    };
+
+    struct Stats {
+        std::size_t elements{0}; // elements rewritten
+        std::size_t before{0};   // polyline points seen
+        std::size_t after{0};    // ... and kept
+    };
+
+    /**
+     * @brief Douglas-Peucker simplification of a polyline (iterative, no
+     * recursion). A point is dropped when it lies within tolerance of the
+     * simplified line; with tolerance 0 only points on it (collinear or
+     * repeated) are dropped.
+     *
+     * @param xs
+     * @param ys Same size as xs
+     * @param tolerance Distance in user units (>= 0)
+     * @param kept Receives the positions of the kept points, first and last
+     *             included
+     */
+    void simplify_line(std::span<const double> xs, std::span<const double> ys,
+                       double tolerance, std::vector<std::size_t> &kept);
+
+    /**
+     * @brief Reduce the geometry of a tree in place.
+     *
+     * Straight runs of 'd' (consecutive lines, after PathUtils::absolute)
+     * and the 'points' of polyline and polygon are simplified; curves are
+     * kept. Paths with no point dropped keep their form. With a precision,
+     * the numbers of d, points and the coordinate attributes (x, y, cx, r,
+     * width, ...) are rounded (see NumberUtils::round_numbers); transforms
+     * are not. Elements are split between threads; the index is rebuilt.
+     *
+     * @param tree
+     * @param options
+     * @return Stats
+     */
+    auto simplify(TreeUtils::Tree &tree, const Options &options) -> Stats;
+
+} // namespace SimplifyUtils
+
+/**
+ * @brief Basic test.
+ */
+void test_simplify_utils();
@@ -0,0 +1,163 @@
+/*
+ * Binary snapshot of a parsed tree, loaded back by memory mapping.
+ */
+
+#pragma once
+
+#include "svg_core.hpp"
+#include "tree_utils.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace SnapshotUtils {
+
+    using svg_core::CsvTable;
+    using svg_core::Expected; // {value, Error}
+
+    /*
+     * Layout (native byte order, sections 8-byte aligned):
+     *
+     *   Header
+     *   NodeRecord      [node_count]       pre-order
+     *   AttributeRecord [attribute_count]  grouped by node
+     *   uint32_t        [string_count + 1] offsets into the bytes
+     *   char            [string_bytes]     distinct strings, not terminated
+     */
+
+    constexpr std::uint32_t magic = 0x53475653; // "SVGS"
+    constexpr std::uint32_t version = 1;        // bumped on any layout change
+
+    struct Header {
+        std::uint32_t magic{SnapshotUtils::magic};
+        std::uint32_t version{SnapshotUtils::version};
+        std::uint32_t node_count{0};
+        std::uint32_t attribute_count{0};
+        std::uint32_t string_count{0};
+        std::uint32_t reserved{0};
+        std::uint64_t string_bytes{0};
+    };
+
+    struct NodeRecord {
+        std::uint32_t tag{0};             // string index
+        std::uint32_t parent{0};          // position, UINT32_MAX for the root
+        std::uint32_t depth{0};
+        std::uint32_t size{0};            // elements in the subtree
+        std::uint32_t first_attribute{0}; // index into the attribute records
+        std::uint32_t attribute_count{0};
+    };
+
+    struct AttributeRecord {
+        std::uint32_t name{0};  // string index
+        std::uint32_t value{0}; // string index
+    };
+
+    /**
+     * @brief Serialize a tree (strings are stored once).
+     *
+     * @param tree
+     * @param bytes Receives the snapshot (capacity is reused)
+     */
+    void encode(const TreeUtils::Tree &tree, std::string &bytes);
+
+    /**
+     * @brief Serialize a tree to a file.
+     *
+     * @param tree
+     * @param path
+     * @return Nothing or Error {InvalidPath, FileError}
+     */
+    auto write(const TreeUtils::Tree &tree, std::string_view path)
+        -> Expected<void>;
+
+    /**
+     * @brief Read-only view of a snapshot. Accessors read the mapped bytes
+     * directly: nothing is deserialized. Copies share the mapping.
+     */
+    class Snapshot {
+    public:
+        Snapshot() = default;
+
+        /**
+         * @brief Memory-map a snapshot file.
+         *
+         * @param path
+         * @return Snapshot or Error {InvalidPath, FileError, InvalidSnapshot}
+         */
+        static auto open(std::string_view path) -> Expected<Snapshot>;
+
+        /**
+         * @brief Snapshot held in memory (e.g. from encode).
+         *
+         * @param bytes
+         * @return Snapshot or Error {InvalidSnapshot}
+         */
+        static auto from_bytes(std::string bytes) -> Expected<Snapshot>;
+
+        auto size() const -> std::size_t {
+            return header_ ? header_->node_count : 0;
+        }
+        auto empty() const -> bool { return size() == 0; }
+
+        auto tag(std::size_t position) const -> std::string_view;
+        // npos for the root
+        auto parent(std::size_t position) const -> std::size_t;
+        auto depth(std::size_t position) const -> int;
+        auto subtree_size(std::size_t position) const -> std::size_t;
+        auto attribute_count(std::size_t position) const -> std::size_t;
+
+        /**
+         * @brief k-th attribute of an element.
+         *
+         * @return {name, value} pointing into the snapshot
+         */
+        auto attribute(std::size_t position, std::size_t k) const
+            -> std::pair<std::string_view, std::string_view>;
+
+        /**
+         * @brief Rebuild the tree (with its index).
+         */
+        auto tree() const -> TreeUtils::Tree;
+
+        /**
+         * @brief Rebuild into tree, reusing its nodes and those of pool
+         * (as TreeUtils::process).
+         *
+         * @param tree
+         * @param pool Node storage kept between calls
+         */
+        void tree(TreeUtils::Tree &tree, TreeUtils::NodePool &pool) const;
+
+    private:
+        auto string(std::uint32_t index) const -> std::string_view;
+
+        std::shared_ptr<const void> storage_; // mapping or buffer
+        const Header *header_{nullptr};
+        const NodeRecord *nodes_{nullptr};
+        const AttributeRecord *attributes_{nullptr};
+        const std::uint32_t *offsets_{nullptr};
+        const char *strings_{nullptr};
+
+        static auto bind(std::shared_ptr<const void> storage,
+                         const std::byte *data, std::size_t size)
+            -> Expected<Snapshot>;
+    };
+
+    /**
+     * @brief CSV table straight from a snapshot, same rows as TreeUtils::table.
+     *
+     * @param snapshot
+     * @param csvTable Receives the CSV table
+     */
+    void table(const Snapshot &snapshot, CsvTable &csvTable);
+
+} // namespace SnapshotUtils
+
+/**
+ * @brief Basic test.
+ */
+void test_snapshot_utils();
@@ -0,0 +1,118 @@
+/*
+ * Spatial index (packed R-tree) over the bounding boxes of a tree.
+ */
+
+#pragma once
+
+#include "svg_core.hpp"
+#include "tree_utils.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace SpatialIndex {
+
+    using svg_core::BBox; // {min_x, min_y, max_x, max_y}
+    using svg_core::CsvTable;
+
+    /**
+     * @brief Indexed element.
+     */
+    struct Entry {
+        BBox box;
+        const TreeUtils::Node *node{nullptr};
+        long long id{0}; // Same numbering as the ID column of TreeUtils::table
+    };
+
+    /**
+     * @brief Static R-tree bulk loaded with Sort-Tile-Recursive packing.
+     * Nodes are stored level by level in flat arrays; rebuild after the
+     * tree changes.
+     */
+    class RTree {
+    public:
+        static constexpr std::size_t fanout = 16;
+
+        RTree() = default;
+
+        /**
+         * @brief Index the elements with geometry of tree (see build).
+         */
+        explicit RTree(const TreeUtils::Tree &tree);
+
+        /**
+         * @brief Index every element whose bbox is known and that draws
+         * geometry itself (no child has a bbox, so groups are left out).
+         * Node::bbox must be computed first (GeometryUtils::compute).
+         *
+         * @param tree
+         */
+        void build(const TreeUtils::Tree &tree);
+
+        /**
+         * @brief Index arbitrary entries (empty boxes are dropped).
+         *
+         * @param entries
+         */
+        void build(std::vector<Entry> entries);
+
+        /**
+         * @brief Entries whose box intersects region (edges included).
+         *
+         * @param region
+         * @return Entries in index order
+         */
+        auto query(const BBox &region) const -> std::vector<const Entry *>;
+
+        /**
+         * @brief Same as query(region), into a reused buffer (cleared first).
+         */
+        void query(const BBox &region, std::vector<const Entry *> &hits) const;
+
+        /**
+         * @brief The count entries closest to (x, y), nearest first.
+         * Distance is measured to the box (0 inside it).
+         *
+         * @param x
+         * @param y
+         * @param count
+         * @return Up to count entries
+         */
+        auto nearest(double x, double y, std::size_t count = 1) const
+            -> std::vector<const Entry *>;
+
+        auto size() const -> std::size_t { return entries_.size(); }
+        auto empty() const -> bool { return entries_.empty(); }
+
+        /**
+         * @brief Union of all boxes.
+         */
+        auto bounds() const -> BBox;
+
+    private:
+        struct Branch {
+            BBox box;
+            std::size_t first{0}; // into entries_ (leaf) or nodes_
+            std::size_t count{0};
+            bool leaf{false};
+        };
+
+        std::vector<Entry> entries_; // in leaf order
+        std::vector<Branch> nodes_;  // level by level, root last
+    };
+
+    /**
+     * @brief CSV table of entries: ID, Tag, MinX, MinY, MaxX, MaxY (sorted by
+     * ID).
+     *
+     * @param entries
+     * @return CSV table with header
+     */
+    auto table(const std::vector<const Entry *> &entries) -> CsvTable;
+
+} // namespace SpatialIndex
+
+/**
+ * @brief Basic test.
+ */
+void test_spatial_index();
@@ -7,6 +7,8 @@
 
 #include "svg_core.hpp"
 
+#include <string>
+#include <utility>
 #include <string_view>
 #include <vector>
 
@@ -15,6 +17,9 @@ namespace StringUtils {
     using svg_core::TagTuple; // {tag, attrs, tag type}
     using svg_core::TagType; // {Unknown, Open, Close, SelfClose}
     using svg_core::Attributes; // vector {"name", "value"}
+    using svg_core::Content; // {kind, begin, end, element, after}
+
+    using svg_core::Expected; // {value, Error}
 
     /**
      * @brief Sanitize string SVG.
@@ -28,27 +33,102 @@ namespace StringUtils {
      * @brief Validate SVG
      *
      * @param svg
-     * @return True if SVG can be processed in this algorithm.
+     * @return True if SVG can be processed in this algorithm (every tag
+     * closed, quotes and comments taken into account).
      */
     auto validate(std::string_view svg) -> bool;
 
     /**
     * @brief Prepare SVG text.
-    * This function separates the possible tags from the SVG text.
+    * This function separates the possible tags from the SVG text. '<' and
+    * '>' inside quoted values, comments and CDATA sections do not split
+    * tags; line breaks and tabs become spaces.
     *
     * @param svg SVG text
-    * @return Vector of rows '<content>'.
+    * @return Vector of rows '<content>' or Error {EmptyInput, MalformedTag}.
+     */
+    auto prepare(std::string_view svg) -> Expected<std::vector<std::string>>;
+
+    /**
+     * @brief Prepare SVG text into existing rows (string capacity is reused).
+     *
+     * @param svg SVG text
+     * @param tags Receives the rows '<content>'
+     * @return Nothing or Error {EmptyInput, MalformedTag}.
+     */
+    auto prepare(std::string_view svg, std::vector<std::string> &tags)
+        -> Expected<void>;
+
+    using Span = std::pair<std::size_t, std::size_t>; // [begin, end) in bytes
+
+    /**
+     * @brief Prepare SVG text and record where each tag lies in it.
+     *
+     * @param svg SVG text
+     * @param tags Receives the rows '<content>'
+     * @param spans Receives the span of each row in svg ('<' to '>' included)
+     * @return Nothing or Error {EmptyInput, MalformedTag}.
+     */
+    auto prepare(std::string_view svg, std::vector<std::string> &tags,
+                 std::vector<Span> &spans) -> Expected<void>;
+
+    /**
+     * @brief Character data around the tags found by prepare(): text
+     * that is not only whitespace, CDATA sections, comments and processing
+     * instructions, in document order. Each one records the pre-order
+     * position of the element enclosing it (as TreeUtils::process numbers
+     * them) and how many child elements of it come before. Other
+     * declarations (<!DOCTYPE ...>) are skipped.
+     *
+     * @param svg SVG text given to prepare()
+     * @param spans Spans filled by prepare()
+     * @param contents Receives the contents (cleared first, capacity reused)
      */
-    auto prepare(std::string_view svg) -> std::vector<std::string>;
+    void contents(std::string_view svg, const std::vector<Span> &spans,
+                  std::vector<Content> &contents);
 
     /**
      * @brief Processes SVG.
      * This function reads an SVG and separates the tag and attributes.
+     * Values may be in single or double quotes (spaces, '=' and '>'
+     * included) or unquoted; spaces around '=' are allowed. Values holding
+     * a '&' are decoded (see decode); the others are copied as they are.
+     * Declarations, comments and CDATA sections are ignored (empty tuple).
      *
      * @param svg
-     * @return Tuple with {tag name, attribute array, tag type}.
+     * @return Tuple with {tag name, attribute array, tag type} or
+     *         Error {MalformedTag}.
+     */
+    auto process(std::string_view svg) -> Expected<TagTuple>;
+
+    /**
+     * @brief Processes SVG into an existing tuple (string capacity is reused).
+     *
+     * @param svg
+     * @param token Receives {tag name, attribute array, tag type}
+     * @return Nothing or Error {MalformedTag}.
+     */
+    auto process(std::string_view svg, TagTuple &token) -> Expected<void>;
+
+    /**
+     * @brief Replace character references (&#38;, &#x26;) and the XML
+     * entities (&amp; &lt; &gt; &quot; &apos;) with the characters they
+     * stand for, in UTF-8. Other references (DTD entities, invalid code
+     * points, missing ';') are kept as written.
+     *
+     * @param text e.g. "a &amp; b"
+     * @param out Receives the decoded text (cleared first, capacity reused)
+     */
+    void decode(std::string_view text, std::string &out);
+
+    /**
+     * @brief Byte offset of a prepared tag.
+     *
+     * @param svg SVG text given to prepare()
+     * @param index Position of the tag in the prepared vector
+     * @return Offset of its '<' in svg, npos if out of range.
      */
-    auto process(std::string_view svg) -> TagTuple;
+    auto tag_offset(std::string_view svg, std::size_t index) -> std::size_t;
 
 } // namespace StringUtils
 
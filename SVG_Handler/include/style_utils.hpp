@@ -0,0 +1,127 @@
+/*
+ * Computed styles: presentation attributes, style="..." and <style> sheets.
+ */
+
+#pragma once
+
+#include "query_utils.hpp"
+#include "svg_core.hpp"
+#include "tree_utils.hpp"
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace StyleUtils {
+
+    /**
+     * @brief One "property: value" of a style attribute or rule block.
+     */
+    struct Declaration {
+        std::string property;
+        std::string value;
+        bool important{false}; // "!important"
+
+        auto operator==(const Declaration &) const -> bool = default;
+    };
+
+    /**
+     * @brief Style rule with a single selector (lists are split).
+     */
+    struct Rule {
+        QueryUtils::Selector selector;
+        // Ids, classes and attributes, tags: one byte each
+        unsigned specificity{0};
+        std::vector<Declaration> declarations;
+    };
+
+    struct Stats {
+        std::size_t elements{0}; // elements styled
+        std::size_t rules{0};    // rules of the <style> sheets
+        std::size_t styles{0};   // distinct computed styles
+        std::size_t hits{0};     // elements that reused a computed style
+    };
+
+    /**
+     * @brief Parse declarations ("fill: red; stroke: blue !important").
+     * Empty and malformed declarations (no ':') are skipped; ';' inside
+     * quotes or parentheses does not end a value. Property names are
+     * lowercased.
+     *
+     * @param text Style attribute value or rule block
+     * @param declarations Receives the declarations (appended)
+     */
+    void parse_declarations(std::string_view text,
+                            std::vector<Declaration> &declarations);
+
+    /**
+     * @brief Parse a style sheet. Comments are ignored; at-rules (@media,
+     * @import, ...) and rules whose selector QueryUtils cannot parse (e.g.
+     * '+', '~', :not()) are skipped. Rules are appended in document order.
+     *
+     * @param css
+     * @param rules
+     */
+    void parse_sheet(std::string_view css, std::vector<Rule> &rules);
+
+    /**
+     * @brief Specificity of a selector: #ids, then .classes and [attributes],
+     * then tags, compared as one number.
+     */
+    auto specificity(const QueryUtils::Selector &selector) -> unsigned;
+
+    /**
+     * @brief Properties computed when none are requested (fill, stroke, ...).
+     */
+    auto default_properties() -> std::span<const std::string_view>;
+
+    /**
+     * @brief Append the properties of a comma-separated list ("fill,stroke");
+     * "default" stands for default_properties(), empty names are skipped.
+     *
+     * @param list
+     * @param properties Receives the names, after those it holds
+     */
+    void parse_properties(std::string_view list,
+                          std::vector<std::string> &properties);
+
+    /**
+     * @brief Whether a property is inherited by default (fill, font-size, ...).
+     * Unknown properties are not.
+     */
+    auto inherited(std::string_view property) -> bool;
+
+    /**
+     * @brief Initial value of a property (empty if unknown).
+     */
+    auto initial(std::string_view property) -> std::string_view;
+
+    /**
+     * @brief Compute the value of each property for every element
+     * (Node::style, parallel to properties), top-down.
+     *
+     * Cascade, lowest to highest: presentation attribute, sheet rules by
+     * specificity then order, style attribute, then !important rules and
+     * !important style declarations. A property not set, or set to
+     * "inherit", takes the parent's value if inherited (or "inherit"),
+     * else its initial value. Sheets are the text and CDATA of <style>
+     * elements, so contents must be attached (see TreeUtils::attach).
+     *
+     * Elements with the same parent style, style attribute, presentation
+     * attributes and matching rules share one computed style.
+     *
+     * @param tree Tree with its index
+     * @param properties Property names (e.g. "fill", "stroke-width")
+     * @return Stats
+     */
+    auto compute(TreeUtils::Tree &tree,
+                 const std::vector<std::string> &properties) -> Stats;
+
+} // namespace StyleUtils
+
+/**
+ * @brief Basic test.
+ */
+void test_style_utils();
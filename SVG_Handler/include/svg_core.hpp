@@ -1,12 +1,22 @@
 #pragma once
 
+#include <cstddef>
 #include <expected>
+#include <format>
+#include <limits>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <utility>
 
 namespace svg_core {
 
+    /**
+     * @brief Library version. Part of the cache keys (see CacheUtils), so
+     * bump it whenever parsing or CSV output changes.
+     */
+    constexpr std::string_view version = "1.3.0";
+
     /**
      * @brief Represents the type of an SVG tag.
      */
@@ -24,9 +34,105 @@ namespace svg_core {
         Success = 0,
         EmptyInput,
         InvalidRoot,
-        UnbalancedTags
+        UnbalancedTags,
+        InvalidPath,
+        InvalidExtension,
+        FileError,
+        MalformedTag,
+        InvalidPathData,
+        InvalidTransform,
+        InvalidOption,
+        InvalidQuery,
+        InvalidSnapshot,
+        InvalidEdit
+    };
+
+    /**
+     * @brief Textual name of a Status value.
+     */
+    constexpr auto to_string(Status status) -> std::string_view {
+        switch (status) {
+        case Status::Success: return "Success";
+        case Status::EmptyInput: return "EmptyInput";
+        case Status::InvalidRoot: return "InvalidRoot";
+        case Status::UnbalancedTags: return "UnbalancedTags";
+        case Status::InvalidPath: return "InvalidPath";
+        case Status::InvalidExtension: return "InvalidExtension";
+        case Status::FileError: return "FileError";
+        case Status::MalformedTag: return "MalformedTag";
+        case Status::InvalidPathData: return "InvalidPathData";
+        case Status::InvalidTransform: return "InvalidTransform";
+        case Status::InvalidOption: return "InvalidOption";
+        case Status::InvalidQuery: return "InvalidQuery";
+        case Status::InvalidSnapshot: return "InvalidSnapshot";
+        case Status::InvalidEdit: return "InvalidEdit";
+        }
+        return "Unknown";
+    }
+
+    /**
+     * @brief Failure reported by any pipeline stage.
+     *
+     * offset is the byte offset in the SVG text (npos if unknown).
+     * line and column are 1-based (0 if unknown).
+     */
+    struct Error {
+        Status status{Status::Success};
+        std::size_t offset{std::string_view::npos};
+        std::size_t line{0};
+        std::size_t column{0};
+        std::string message{};
     };
 
+    /**
+     * @brief Result of a pipeline stage: value or Error.
+     */
+    template <typename T>
+    using Expected = std::expected<T, Error>;
+
+    /**
+     * @brief Build an Error, resolving line/column of offset in source.
+     *
+     * @param status
+     * @param message
+     * @param source SVG text the offset refers to (may be empty)
+     * @param offset byte offset in source
+     * @return Error
+     */
+    inline auto make_error(Status status, std::string message,
+                           std::string_view source = {},
+                           std::size_t offset = std::string_view::npos)
+        -> Error {
+        Error error{status, offset, 0, 0, std::move(message)};
+        if (offset == std::string_view::npos || offset > source.size())
+            return error;
+
+        error.line = 1;
+        std::size_t line_start = 0;
+        for (std::size_t i = 0; i < offset; ++i) {
+            if (source[i] == '\n') {
+                ++error.line;
+                line_start = i + 1;
+            }
+        }
+        error.column = offset - line_start + 1;
+        return error;
+    }
+
+    /**
+     * @brief Human readable description of an Error.
+     */
+    inline auto describe(const Error &error) -> std::string {
+        if (error.line > 0)
+            return std::format("{} at {}:{} (offset {}) : {}",
+                               to_string(error.status), error.line,
+                               error.column, error.offset, error.message);
+        if (error.offset != std::string_view::npos)
+            return std::format("{} at offset {} : {}", to_string(error.status),
+                               error.offset, error.message);
+        return std::format("{} : {}", to_string(error.status), error.message);
+    }
+
     /**
      * @brief Represents an attribute of an SVG tag (e.g. width="200").
      */
@@ -42,6 +148,135 @@ namespace svg_core {
      */
     using TagTuple = std::tuple<std::string, Attributes, TagType>;
 
+    /**
+     * @brief Character data of a document: text between tags, a CDATA
+     * section, a comment or a processing instruction. Refers to the
+     * source text by offsets, so capturing it copies nothing.
+     */
+    struct Content {
+        enum class Kind : unsigned char {
+            Text = 0,   /// < text between tags (entities as written)
+            CData,      /// < <![CDATA[ ... ]]>
+            Comment,    /// < <!-- ... -->
+            Instruction /// < <? ... ?> (e.g. the XML declaration)
+        };
+
+        Kind kind{Kind::Text};
+        std::size_t begin{0};   // span in the source text, delimiters excluded
+        std::size_t end{0};
+        // Pre-order position of the enclosing element (npos outside the root)
+        std::size_t element{0};
+        // Child elements of that element before it (npos after the root)
+        std::size_t after{0};
+
+        auto operator==(const Content &) const -> bool = default;
+    };
+
+    /**
+     * @brief Name of a Content kind, as used for CSV and JSON output
+     * ("#text", "#cdata", "#comment", "#instruction").
+     */
+    constexpr auto to_string(Content::Kind kind) -> std::string_view {
+        switch (kind) {
+        case Content::Kind::Text: return "#text";
+        case Content::Kind::CData: return "#cdata";
+        case Content::Kind::Comment: return "#comment";
+        case Content::Kind::Instruction: return "#instruction";
+        }
+        return "#text";
+    }
+
+    /**
+     * @brief Unit of a numeric attribute value (e.g. width="10mm").
+     */
+    enum class Unit {
+        None = 0,   /// < user units
+        Px,
+        Pt,
+        Pc,
+        Mm,
+        Cm,
+        In,
+        Em,
+        Ex,
+        Percent
+    };
+
+    /**
+     * @brief Numeric attribute value with its unit.
+     */
+    struct Length {
+        double value{0.0};
+        Unit unit{Unit::None};
+
+        auto operator==(const Length &) const -> bool = default;
+    };
+
+    /**
+     * @brief 2D affine transform, SVG order: [a c e; b d f; 0 0 1].
+     */
+    struct Matrix {
+        double a{1.0}, b{0.0}, c{0.0}, d{1.0}, e{0.0}, f{0.0};
+
+        /**
+         * @brief this * other (other is applied first).
+         */
+        constexpr auto operator*(const Matrix &o) const -> Matrix {
+            return {a * o.a + c * o.b,     b * o.a + d * o.b,
+                    a * o.c + c * o.d,     b * o.c + d * o.d,
+                    a * o.e + c * o.f + e, b * o.e + d * o.f + f};
+        }
+
+        constexpr auto x(double px, double py) const -> double {
+            return a * px + c * py + e;
+        }
+        constexpr auto y(double px, double py) const -> double {
+            return b * px + d * py + f;
+        }
+
+        constexpr auto identity() const -> bool {
+            return a == 1.0 && b == 0.0 && c == 0.0 && d == 1.0 && e == 0.0 &&
+                   f == 0.0;
+        }
+
+        auto operator==(const Matrix &) const -> bool = default;
+    };
+
+    /**
+     * @brief Axis-aligned bounding box (empty while min > max).
+     */
+    struct BBox {
+        double min_x{std::numeric_limits<double>::infinity()};
+        double min_y{std::numeric_limits<double>::infinity()};
+        double max_x{-std::numeric_limits<double>::infinity()};
+        double max_y{-std::numeric_limits<double>::infinity()};
+
+        constexpr auto empty() const -> bool {
+            return min_x > max_x || min_y > max_y;
+        }
+
+        constexpr void expand(double x, double y) {
+            min_x = x < min_x ? x : min_x;
+            min_y = y < min_y ? y : min_y;
+            max_x = x > max_x ? x : max_x;
+            max_y = y > max_y ? y : max_y;
+        }
+
+        constexpr void expand(const BBox &o) {
+            if (o.empty())
+                return;
+            expand(o.min_x, o.min_y);
+            expand(o.max_x, o.max_y);
+        }
+
+        constexpr auto intersects(const BBox &o) const -> bool {
+            return min_x <= o.max_x && o.min_x <= max_x && min_y <= o.max_y &&
+                   o.min_y <= max_y;
+        }
+
+        auto operator==(const BBox &) const -> bool = default;
+    };
+
     /**
      * @brief Auxiliary structures for integration with CSV.
      */
@@ -5,22 +5,69 @@
  *  1. Load SVG file (svg_reader)
  *  2. Process SVG strings and extract tags (string_utils)
  *  3. Build the tree hierarchy (tree_utils)
- *  4. Export to CSV (csv_exporter)
+ *  4. Optionally expand <use> references (reference_utils)
+ *  5. Compose transforms, optionally bake them and compute bounding boxes
+ *     (geometry_utils)
+ *  6. Optionally round coordinates and simplify polylines (simplify_utils)
+ *  7. Export to CSV (csv_exporter)
  *
  */
 
 #pragma once
 
 #include "svg_core.hpp"
+#include "arrow_exporter.hpp"
+#include "cache_utils.hpp"
 #include "csv_exporter.hpp"
+#include "dag_utils.hpp"
+#include "diff_utils.hpp"
+#include "geometry_utils.hpp"
+#include "json_exporter.hpp"
+#include "number_utils.hpp"
+#include "path_utils.hpp"
+#include "query_utils.hpp"
+#include "raster_utils.hpp"
+#include "reference_utils.hpp"
+#include "simplify_utils.hpp"
+#include "snapshot_utils.hpp"
+#include "spatial_index.hpp"
 #include "string_utils.hpp"
+#include "style_utils.hpp"
 #include "svg_reader.hpp"
+#include "svg_writer.hpp"
 #include "tree_utils.hpp"
 
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <string>
 
 namespace SVG_HANDLER {
 
+    using svg_core::Error;
+    using svg_core::Expected;
+
+    /**
+     * @brief Outcome of SVG::edit.
+     */
+    struct Edit {
+        const TreeUtils::Tree *tree{nullptr}; // owned by the handler
+        bool rebuilt{false};                  // full rebuild instead of a patch
+        std::size_t retokenized{0};           // tags lexed again
+    };
+
+    /**
+     * @brief Output format of SVG::execute.
+     */
+    enum class Format {
+        Auto,  /// < from the output extension (.arrow, .json, .ndjson or
+               ///   .jsonl, else CSV)
+        Csv,
+        Arrow, /// < Arrow IPC file (arrow_exporter)
+        Json,  /// < nested tree (json_exporter)
+        Ndjson /// < one JSON object per element (json_exporter)
+    };
+
     class SVG {
     public:
 
@@ -31,19 +78,108 @@ namespace SVG_HANDLER {
          */
         explicit SVG(std::string_view file_path_svg, std::string_view file_path_csv);
 
+        /**
+         * @brief reset
+         * Point the handler at a new document. Internal buffers (text, tags,
+         * tokens, tree nodes and CSV rows) keep their capacity, so processing
+         * many similar documents with one handler does not reallocate.
+         *
+         * @param file_path_svg
+         * @param file_path_csv
+         */
+        void reset(std::string_view file_path_svg,
+                   std::string_view file_path_csv);
+
+        /**
+         * @brief set_table_options
+         * Extra CSV columns and output form. parse() always fills Node::ctm;
+         * with options.expand it copies referenced content under <use>
+         * (reference_utils), with options.bake it bakes transforms into
+         * coordinates, with options.precision or options.tolerance it rounds
+         * and simplifies geometry (simplify_utils) and with options.bbox it
+         * computes Node::bbox (geometry_utils). With options.content, text,
+         * CDATA, comments and instructions are attached to the tree as
+         * spans of the loaded text (TreeUtils::attach); such trees bypass
+         * the snapshot cache. With options.styles, the listed properties are
+         * computed for every element (StyleUtils::compute, <style> sheets
+         * included); such trees bypass the snapshot cache too.
+         *
+         * @param options
+         */
+        void set_table_options(const TreeUtils::TableOptions& options);
+        auto table_options() const -> const TreeUtils::TableOptions& {
+            return table_options_;
+        }
+
+        /**
+         * @brief set_cache
+         * Keep results in an on-disk cache keyed by the SVG content, the
+         * library version and the table options (see CacheUtils::Cache).
+         * execute() copies a cached CSV instead of processing the document;
+         * parse() maps a cached snapshot instead of tokenizing it.
+         *
+         * @param directory Cache directory (empty disables the cache)
+         * @param budget Size in bytes above which old entries are evicted
+         */
+        void set_cache(
+            std::string_view directory,
+            std::uintmax_t budget = CacheUtils::Cache::default_budget);
+        auto cache() const -> const CacheUtils::Cache* {
+            return cache_ ? &*cache_ : nullptr;
+        }
+
+        /**
+         * @brief set_format
+         * Output format of execute() (Format::Auto by default).
+         *
+         * @param format
+         */
+        void set_format(Format format) { format_ = format; }
+        auto format() const -> Format;
+
         /**
          * @brief execute
-         * Main pipeline
+         * Main pipeline. Stops at the first failing stage. Writes the
+         * output in format() (CSV, Arrow IPC, JSON or NDJSON).
+         *
+         * @return Nothing or Error of the failing stage
+         */
+        auto execute() -> Expected<void>;
+
+        /**
+         * @brief parse
+         * load -> prepare -> tokenize -> build, stopping at the first
+         * failing stage.
+         *
+         * @return Tree owned by the handler (valid until the next
+         *         parse/reset) or Error
+         */
+        auto parse() -> Expected<const TreeUtils::Tree *>;
+
+        /**
+         * @brief edit
+         * Replace a byte range of the parsed text and update the tree. Only
+         * the tags overlapping the range are lexed again; when they keep
+         * their names and types the elements are patched in place
+         * (TreeUtils::update, GeometryUtils::refresh), otherwise the tree is
+         * rebuilt. Trees from the snapshot cache or built with expand/bake
+         * are always rebuilt. Call parse() first.
+         *
+         * @param offset Start of the range in the text returned by load()
+         * @param length Bytes replaced
+         * @param text Replacement
+         * @return Edit or Error {InvalidEdit, or the error of the rebuild}
          */
-        void execute();
+        auto edit(std::size_t offset, std::size_t length, std::string_view text)
+            -> Expected<Edit>;
 
         /**
          * @brief load
          * Load SVG file (svg_reader)
          *
-         * @return SVG text
+         * @return SVG text (owned by the handler, valid until the next load)
          */
-        auto load() -> std::string;
+        auto load() -> Expected<std::string_view>;
 
         /**
          * @brief prepare
@@ -52,24 +188,30 @@ namespace SVG_HANDLER {
          * @param svg
          * @return Vector of rows '<content>'.
          */
-        auto prepare(std::string_view svg) -> std::vector<std::string>;
+        auto prepare(std::string_view svg)
+            -> Expected<std::vector<std::string>>;
 
         /**
          * @brief tokenize
          * Process SVG prepared and separates tag and attributes (string_utils)
+         * Error positions refer to the text returned by load().
          *
          * @param Vector svg tags
          * @return Tuple with {tag name, attribute array}.
          */
-        auto tokenize(const std::vector<std::string>& tags) -> std::vector<StringUtils::TagTuple>;
+        auto tokenize(const std::vector<std::string>& tags)
+            -> Expected<std::vector<StringUtils::TagTuple>>;
 
         /**
          * @brief build
+         * Validates and builds the tree (tree_utils)
+         * Error positions refer to the text returned by load().
          *
          * @param svg Tag Tuple
          * @return Tree
          */
-        auto build(const std::vector<StringUtils::TagTuple>& svg_tagTuple) -> TreeUtils::Tree;
+        auto build(const std::vector<StringUtils::TagTuple>& svg_tagTuple)
+            -> Expected<TreeUtils::Tree>;
 
         /**
          * @brief to_csv
@@ -80,18 +222,80 @@ namespace SVG_HANDLER {
          */
         auto to_csv(const TreeUtils::Tree& tree) -> TreeUtils::CsvTable;
 
+        /**
+         * @brief query
+         * Rows of the elements matching a CSS selector or XPath (query_utils).
+         * Same columns as to_csv; children of matches are not included.
+         *
+         * @param query e.g. "g#shapes > rect" or "//rect[@fill='red']"
+         * @return CSV table or Error
+         */
+        auto query(std::string_view query) -> Expected<TreeUtils::CsvTable>;
+
+        /**
+         * @brief render
+         * Image of the document (raster_utils), <use> expanded and <style>
+         * sheets applied. The table options are left as they were.
+         *
+         * @param options Size, background and threads
+         * @return Image or Error
+         */
+        auto render(const RasterUtils::Options& options = {})
+            -> Expected<RasterUtils::Image>;
+
         /**
          * @brief export_csv
          *
          * @param CSV table
          * @param path
+         * @return Nothing or Error
          */
-        void export_csv(const TreeUtils::CsvTable& csvTable, std::string_view path);
+        auto export_csv(const TreeUtils::CsvTable& csvTable,
+                        std::string_view path) -> Expected<void>;
 
     private:
         std::string file_path_svg_;
         std::string file_path_csv_;
 
+        // Recycled between documents
+        std::string source_;
+        std::vector<std::string> tags_;
+        std::vector<StringUtils::TagTuple> tokens_;
+        std::vector<svg_core::Content> contents_;
+        TreeUtils::Tree tree_;
+        TreeUtils::NodePool pool_;
+        TreeUtils::CsvTable table_;
+        TreeUtils::TableOptions table_options_;
+        Format format_{Format::Auto};
+        std::optional<CacheUtils::Cache> cache_;
+
+        // Incremental edits: where each tag lies in source_ and the element
+        // it opened (npos for closing tags and comments)
+        std::vector<StringUtils::Span> spans_;
+        std::vector<std::size_t> token_nodes_;
+        bool editable_{false};
+        std::vector<std::string> edit_tags_;
+        std::vector<StringUtils::Span> edit_spans_;
+        std::vector<StringUtils::TagTuple> edit_tokens_;
+
+        // Tree of the loaded source_ (cached snapshot or full processing)
+        auto build() -> Expected<const TreeUtils::Tree *>;
+        // Relex edit_tokens_ over [begin, end) of source_: false if the
+        // tags differ in number, names or types from tokens_[first, last)
+        auto relex(std::size_t begin, std::size_t end, std::size_t first,
+                   std::size_t last) -> bool;
+        // Cache key of source_: with the CSV columns or tree options only
+        auto cache_key(bool columns) const -> std::string;
+
+        auto tokenize(const std::vector<std::string>& tags,
+                      std::vector<StringUtils::TagTuple>& tokens)
+            -> Expected<void>;
+        auto verify(const std::vector<StringUtils::TagTuple>& svg_tagTuple)
+            -> Expected<void>;
+
+        // Moves an error reported for the tag at tag_index onto source_.
+        auto locate(const Error& error, std::size_t tag_index) const -> Error;
+
     }; // class SVG
 
 } // namespace SVG_HANDLER
@@ -107,13 +311,52 @@ typedef void *SvgHandlerPtr;
 
 // Lifecycle
 SvgHandlerPtr svg_handler_create(const char *input_svg, const char *output_csv);
-void svg_handler_execute(SvgHandlerPtr handler);
+// Returns svg_core::Status as int (0 = Success)
+int svg_handler_execute(SvgHandlerPtr handler);
+// Reuse the handler (and its buffers) for another document; returns Status
+// as int
+int svg_handler_reset(SvgHandlerPtr handler, const char *input_svg,
+                      const char *output_csv);
 void svg_handler_destroy(SvgHandlerPtr handler);
+// Cache results in directory (NULL or "" disables it); budget in bytes,
+// 0 = default
+int svg_handler_set_cache(SvgHandlerPtr handler, const char *directory,
+                          unsigned long long budget);
+// Enable (1) or disable (0) an option by name ("bbox", "bake", "expand",
+// "shared", "wide", "content"); returns Status as int
+int svg_handler_set_option(SvgHandlerPtr handler, const char *name,
+                           int enabled);
+// Decimals kept in coordinates and polyline simplification distance (< 0
+// disables them); returns Status as int
+int svg_handler_set_simplify(SvgHandlerPtr handler, int precision,
+                             double tolerance);
+// Computed style columns: comma separated properties ("fill,stroke",
+// "default"; NULL or "" for none); returns Status as int
+int svg_handler_set_styles(SvgHandlerPtr handler, const char *properties);
 
 // Export CSV as a 2D array of strings
 // Returns: pointer to contiguous string data
 // Caller must free() the returned memory with svg_handler_free_csv()
+// Returns nullptr (rows = cols = 0) if the SVG cannot be parsed
 char ***svg_handler_to_csv(SvgHandlerPtr handler, int *rows, int *cols);
 void svg_handler_free_csv(char ***data, int rows, int cols);
 
+// Rows of the elements matching a CSS selector or XPath, same layout as
+// svg_handler_to_csv
+// Returns nullptr (rows = cols = 0) if the SVG or the query cannot be parsed
+char ***svg_handler_query(SvgHandlerPtr handler, const char *query, int *rows,
+                          int *cols);
+
+// Export the rows through the Arrow C Data Interface (zero-copy, see
+// ArrowExporter::export_c); the consumer calls array->release and
+// schema->release. Option "shared" is ignored.
+// Returns Status as int; array and schema are untouched on failure
+int svg_handler_to_arrow(SvgHandlerPtr handler, struct ArrowArray *array,
+                         struct ArrowSchema *schema);
+
+// Render the document to a PNG or PPM file (by extension), longest side size
+// pixels (0 = 256)
+// Returns Status as int
+int svg_handler_render(SvgHandlerPtr handler, const char *output, int size);
+
 }
@@ -15,6 +15,8 @@ namespace SvgReader {
     using FileHandle = std::unique_ptr<std::ifstream>;
     using ExpectedFile = std::expected<FileHandle, std::error_code>;
 
+    using svg_core::Expected;
+
     /**
      * @brief Checks the existence of an SVG file.
      *
@@ -27,9 +29,20 @@ namespace SvgReader {
      * @brief Load SVG file.
      *
      * @param path
-     * @return SVG text
+     * @return SVG text or Error {InvalidPath, InvalidExtension, FileError,
+     *         EmptyInput}
+     */
+    auto load(std::string_view path) -> Expected<std::string>;
+
+    /**
+     * @brief Load SVG file into an existing buffer (capacity is reused).
+     *
+     * @param path
+     * @param content Receives the SVG text
+     * @return Nothing or Error {InvalidPath, InvalidExtension, FileError,
+     *         EmptyInput}
      */
-    auto load(std::string_view path) -> std::string;
+    auto load(std::string_view path, std::string &content) -> Expected<void>;
 
 } // namespace SvgReader
 
@@ -0,0 +1,73 @@
+/*
+ * Writes a parsed tree back out as SVG (normalized or minified).
+ */
+
+#pragma once
+
+#include "svg_core.hpp"
+#include "tree_utils.hpp"
+
+#include <ostream>
+#include <string_view>
+
+namespace SvgWriter {
+
+    using svg_core::Expected; // {value, Error}
+
+    /**
+     * @brief Output form. The defaults rewrite the tree as parsed, one
+     * element per line.
+     */
+    struct Options {
+        bool minify{false};          // no indentation or line breaks
+        bool sort_attributes{false}; // by name instead of document order
+        int precision{-1};           // decimals in numbers (-1: as written)
+        bool strip_defaults{false};  // drop attributes at their initial value
+        bool strip_comments{false};  // drop comments (Content::Kind::Comment)
+    };
+
+    /**
+     * @brief Whether an attribute holds numbers only (coordinates, lengths,
+     * transforms, opacities), i.e. may be rounded.
+     */
+    auto numeric(std::string_view attribute) -> bool;
+
+    /**
+     * @brief Write a tree as SVG, straight from its index.
+     *
+     * Attribute values are stored decoded (see StringUtils::decode) and
+     * written with '&', '<' and the quote encoded, in double quotes unless
+     * the value contains one. Contents (Node::contents, see
+     * TreeUtils::attach) are written between the child elements: text
+     * with '&' and '<' encoded, CDATA, comments and processing
+     * instructions as they were; those before the root come first.
+     * Elements holding text or CDATA are written on one line, whatever
+     * minify, so that no whitespace is added to their text.
+     * With strip_defaults, inherited properties (fill, stroke, ...)
+     * are only dropped where no ancestor sets them and the document has no
+     * <style> or <use>. Output goes through a fixed-size buffer.
+     *
+     * @param out
+     * @param tree Tree with its index (nothing is written if empty)
+     * @param options
+     */
+    void write(std::ostream &out, const TreeUtils::Tree &tree,
+               const Options &options = {});
+
+    /**
+     * @brief Save a tree as an SVG file (see write).
+     *
+     * @param path e.g. "out.svg"
+     * @param tree
+     * @param options
+     * @return Nothing or Error {InvalidPath, FileError}
+     */
+    auto save(std::string_view path, const TreeUtils::Tree &tree,
+              const Options &options = {}) -> Expected<void>;
+
+} // namespace SvgWriter
+
+/**
+ * @brief Basic test.
+ */
+void test_svg_writer();
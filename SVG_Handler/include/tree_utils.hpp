@@ -7,10 +7,14 @@
 #include "svg_core.hpp"
 
 #include <array>
+#include <cstdint>
 #include <expected>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
 namespace TreeUtils {
@@ -19,24 +23,175 @@ namespace TreeUtils {
     using svg_core::TagType; // {Unknown, Open, Close, SelfClose}
     using svg_core::Attributes; // vector {"name", "value"}
 
-    using svg_core::Status; // {Success, EmptyInput, InvalidRoot, UnbalancedTags}
+    using svg_core::Status; // {Success, EmptyInput, InvalidRoot, ...}
+    using svg_core::Error;
+    using svg_core::Expected;
 
     using svg_core::CsvRow;
     using svg_core::CsvTable;
 
+    using svg_core::Length; // {value, unit}
+    using svg_core::BBox; // {min_x, min_y, max_x, max_y}
+    using svg_core::Matrix; // {a, b, c, d, e, f}
+    using svg_core::Content; // {kind, begin, end, element, after}
+
+    /**
+     * @brief Cached numeric form of an attribute value.
+     */
+    struct TypedValue {
+        enum class State : unsigned char { Unparsed = 0, Invalid, Valid };
+
+        State state{State::Unparsed};
+        Length length{};
+    };
+
     struct Node {
         std::string tag;
         Attributes attributes;
         std::vector<std::unique_ptr<Node>> children;
 
+        // Parallel to attributes, filled lazily by number()/length()
+        mutable std::vector<TypedValue> typed;
+
+        // Accumulated transform to root coordinates (GeometryUtils::flatten)
+        std::optional<Matrix> ctm;
+
+        // Bounding box in root coordinates (GeometryUtils::compute)
+        std::optional<BBox> bbox;
+
+        // Text, CDATA, comments and instructions inside the element (attach)
+        std::vector<Content> contents;
+
+        // Computed values of the styled properties (StyleUtils::compute),
+        // shared
+        std::shared_ptr<const std::vector<std::string>> style;
+
         Node(std::string t, Attributes a = {})
             : tag(std::move(t)), attributes(std::move(a)) {}
+
+        /**
+         * @brief Raw attribute value.
+         *
+         * @param name
+         * @return Value or nullptr if the attribute is absent.
+         */
+        auto attribute(std::string_view name) const -> const std::string *;
+
+        /**
+         * @brief Attribute as a length (e.g. x="10", width="50%").
+         * Parsed on first access and cached on the node.
+         *
+         * @param name
+         * @return Length or nullopt if absent or not numeric.
+         */
+        auto length(std::string_view name) const -> std::optional<Length>;
+
+        /**
+         * @brief Attribute as a plain number (no unit).
+         *
+         * @param name
+         * @return Number or nullopt if absent, not numeric or with unit.
+         */
+        auto number(std::string_view name) const -> std::optional<double>;
+
+        /**
+         * @brief Attribute in user units (see NumberUtils::to_px).
+         *
+         * @param name
+         * @param reference Value of 100%
+         * @return Number or nullopt if absent or not numeric.
+         */
+        auto px(std::string_view name, double reference = 0.0) const
+            -> std::optional<double>;
+
+        /**
+         * @brief Drop values derived from attributes (required after editing
+         * them).
+         */
+        void invalidate() {
+            typed.clear();
+            ctm.reset();
+            bbox.reset();
+            style.reset();
+        }
+    };
+
+    /**
+     * @brief Lookup tables of a tree (filled by process and reindex).
+     * Elements are referred to by pre-order position, which is also their
+     * ID in the CSV table. Keys point into the nodes: call reindex after
+     * editing tags or attributes.
+     */
+    struct TreeIndex {
+        std::vector<Node *> nodes;        // pre-order
+        std::vector<std::size_t> parents; // parent position (npos for the root)
+        std::vector<int> depths;
+        std::vector<std::size_t> sizes;    // elements in subtree (with itself)
+        // Structural hash of the subtree (tag, attributes, contents, children)
+        std::vector<std::uint64_t> hashes;
+
+        using Table =
+            std::unordered_map<std::string_view, std::vector<std::size_t>>;
+        Table tags;
+        Table ids;
+        Table classes;
+
+        // Entries taken out of the tables by reindex, reused (with their
+        // vectors' capacity) for the next document's keys
+        std::vector<Table::node_type> spare;
     };
 
     struct Tree {
         std::unique_ptr<Node> root;
+        TreeIndex index;
+        std::string_view source; // text Node::contents refer to (see attach)
+    };
+
+    /**
+     * @brief Options of the CSV table.
+     */
+    struct TableOptions {
+        bool bbox{false}; // MinX, MinY, MaxX, MaxY (see GeometryUtils::compute)
+        bool bake{false}; // Transforms baked in (see GeometryUtils::bake)
+        // Referenced content copied under <use> (see ReferenceUtils::expand)
+        bool expand{false};
+        // Shared column; repeated subtrees as one row (see first_copies)
+        bool shared{false};
+        bool wide{false}; // One row per element, one column per attribute name
+        // Text, CDATA, comments and instructions as "#text", ... rows (see
+        // attach)
+        bool content{false};
+        // Attribute columns of the wide layout (empty: all, in order of
+        // appearance)
+        std::vector<std::string> columns;
+        // Decimals kept in coordinates (see SimplifyUtils::simplify; -1: as
+        // written)
+        int precision{-1};
+        // Polyline simplification distance (0: collinear points only, < 0: off)
+        double tolerance{-1.0};
+        // Computed style columns after Shared, one per property (see
+        // StyleUtils::compute)
+        std::vector<std::string> styles;
+    };
+
+    /**
+     * @brief Released nodes kept for reuse by the next tree.
+     */
+    struct NodePool {
+        std::vector<std::unique_ptr<Node>> nodes;
+        std::vector<Node *> stack; // scratch used by process()
     };
 
+    /**
+     * @brief verify
+     * Syntax check without console output.
+     * Error offset is the index of the offending tag in svg_tagTuple.
+     *
+     * @param svg_tagTuple
+     * @return Nothing or Error {EmptyInput, InvalidRoot, UnbalancedTags}
+     */
+    auto verify(const std::vector<TagTuple>& svg_tagTuple) -> Expected<void>;
+
     /**
      * @brief validate
      * Syntax check
@@ -55,14 +210,140 @@ namespace TreeUtils {
      */
     auto process(const std::vector<TagTuple>& svg_tagTuple) -> Tree;
 
+    /**
+     * @brief process
+     * Build the hierarchical tree reusing the nodes of tree and pool.
+     *
+     * @param svg_tagTuple
+     * @param tree Previous tree, replaced by the new one
+     * @param pool Node storage kept between calls
+     */
+    void process(const std::vector<TagTuple>& svg_tagTuple, Tree& tree,
+                 NodePool& pool);
+
+    /**
+     * @brief release
+     * Move all nodes of tree into pool (tree becomes empty).
+     *
+     * @param tree
+     * @param pool
+     */
+    void release(Tree& tree, NodePool& pool);
+
+    /**
+     * @brief reindex
+     * Rebuild tree.index (tag, id and class tables, pre-order positions,
+     * subtree sizes and hashes). Vectors keep their capacity and table
+     * entries are recycled through TreeIndex::spare, so rebuilding for a
+     * document no larger than earlier ones allocates nothing.
+     *
+     * @param tree
+     */
+    void reindex(Tree& tree);
+
+    /**
+     * @brief attach
+     * Store character data on the elements enclosing it (Node::contents,
+     * in document order) and keep source as the text it refers to; the
+     * caller keeps source alive. Contents outside the root element go to
+     * the root: those before it keep element npos, those after it follow
+     * its last child. Contents already attached are replaced and the
+     * subtree hashes (TreeIndex::hashes) updated to cover them.
+     *
+     * @param tree Tree numbered as the contents (see StringUtils::contents)
+     * @param source SVG text
+     * @param contents
+     */
+    void attach(Tree& tree, std::string_view source,
+                const std::vector<Content>& contents);
+
+    /**
+     * @brief text
+     * Text of a content, as written in tree.source (no copy).
+     *
+     * @param tree
+     * @param content
+     * @return View into tree.source (empty if out of range)
+     */
+    auto text(const Tree& tree, const Content& content) -> std::string_view;
+
+    /**
+     * @brief update
+     * Replace the attributes of one element and patch tree.index in place
+     * (id and class tables, hashes of the element and its ancestors).
+     * Derived values of the element are dropped (see Node::invalidate).
+     *
+     * @param tree
+     * @param position Pre-order position
+     * @param attributes New attributes
+     */
+    void update(Tree& tree, std::size_t position, Attributes attributes);
+
+    /**
+     * @brief find_id
+     * Element with the given id (the first one if repeated), via tree.index.
+     *
+     * @param tree
+     * @param id Without '#'
+     * @return Pre-order position or npos
+     */
+    auto find_id(const Tree& tree, std::string_view id) -> std::size_t;
+
+    /**
+     * @brief same
+     * Structural equality of two subtrees (tags, attributes in order,
+     * children).
+     *
+     * @param a
+     * @param b
+     * @return true if identical
+     */
+    auto same(const Node& a, const Node& b) -> bool;
+
+    /**
+     * @brief first_copies
+     * Hash-consing of the subtrees: for each element, the first element
+     * (pre-order) whose subtree is identical to its own, itself if none.
+     * Hashes come from tree.index; equal hashes are confirmed structurally,
+     * attached contents (text, comments, ...) included.
+     *
+     * @param tree
+     * @return Pre-order position per pre-order position
+     */
+    auto first_copies(const Tree& tree) -> std::vector<std::size_t>;
+
     /**
      * @brief table
      * Convert Tree -> CSV table
      *
      * @param tree
+     * @param options Optional columns
      * @return CSV table
      */
-    auto table(const Tree& tree) -> CsvTable;
+    auto table(const Tree& tree, const TableOptions& options = {}) -> CsvTable;
+
+    /**
+     * @brief table
+     * Convert Tree -> CSV table reusing the rows of csvTable
+     *
+     * @param tree
+     * @param csvTable Receives the CSV table
+     * @param options Optional columns
+     */
+    void table(const Tree& tree, CsvTable& csvTable,
+               const TableOptions& options = {});
+
+    /**
+     * @brief table
+     * CSV table of some elements only (their attributes, not their children)
+     *
+     * @param tree
+     * @param positions Pre-order positions (see TreeIndex)
+     * @param csvTable Receives the CSV table
+     * @param options Optional columns
+     */
+    void table(const Tree& tree, const std::vector<std::size_t>& positions,
+               CsvTable& csvTable, const TableOptions& options = {});
 
     /**
      * @brief hierarchy
@@ -77,7 +358,7 @@ namespace TreeUtils {
      * @param tree
      * @return hierarchy string
      */
-    auto hierarchy(Tree &tree) -> std::string;
+    auto hierarchy(const Tree &tree) -> std::string;
 
     /**
      * @brief view
@@ -85,7 +366,7 @@ namespace TreeUtils {
      *
      * @param tree Tree structure containing the parsed SVG hierarchy.
      */
-    void view(Tree& tree);
+    void view(const Tree& tree);
 
 } // namespace TreeUtils
 
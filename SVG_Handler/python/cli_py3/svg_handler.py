@@ -12,7 +12,46 @@ import os
 import sys
 import argparse
 
-from ctypes import cdll, c_void_p, c_char_p, POINTER, c_int
+from ctypes import (cdll, c_void_p, c_char_p, POINTER, c_int, c_ulonglong,
+                    c_int64, c_double, CFUNCTYPE, Structure, addressof)
+
+
+# ------------------------------------------------
+# Arrow C Data Interface (see ArrowExporter::export_c)
+# ------------------------------------------------
+class ArrowSchema(Structure):
+    pass
+
+
+ArrowSchema._fields_ = [
+    ("format", c_char_p),
+    ("name", c_char_p),
+    ("metadata", c_char_p),
+    ("flags", c_int64),
+    ("n_children", c_int64),
+    ("children", POINTER(POINTER(ArrowSchema))),
+    ("dictionary", POINTER(ArrowSchema)),
+    ("release", CFUNCTYPE(None, POINTER(ArrowSchema))),
+    ("private_data", c_void_p),
+]
+
+
+class ArrowArray(Structure):
+    pass
+
+
+ArrowArray._fields_ = [
+    ("length", c_int64),
+    ("null_count", c_int64),
+    ("offset", c_int64),
+    ("n_buffers", c_int64),
+    ("n_children", c_int64),
+    ("buffers", POINTER(c_void_p)),
+    ("children", POINTER(POINTER(ArrowArray))),
+    ("dictionary", POINTER(ArrowArray)),
+    ("release", CFUNCTYPE(None, POINTER(ArrowArray))),
+    ("private_data", c_void_p),
+]
 
 
 # --------------------------------
@@ -40,9 +79,27 @@ class SvgHandlerAdapter:
         self.lib.svg_handler_create.restype = c_void_p
         self.lib.svg_handler_create.argtypes = [c_char_p, c_char_p]
 
+        self.lib.svg_handler_execute.restype = c_int
         self.lib.svg_handler_execute.argtypes = [c_void_p]
         self.lib.svg_handler_destroy.argtypes = [c_void_p]
 
+        self.lib.svg_handler_reset.restype = c_int
+        self.lib.svg_handler_reset.argtypes = [c_void_p, c_char_p, c_char_p]
+
+        self.lib.svg_handler_set_option.restype = c_int
+        self.lib.svg_handler_set_option.argtypes = [c_void_p, c_char_p, c_int]
+
+        self.lib.svg_handler_set_simplify.restype = c_int
+        self.lib.svg_handler_set_simplify.argtypes = [c_void_p, c_int,
+                                                      c_double]
+
+        self.lib.svg_handler_set_styles.restype = c_int
+        self.lib.svg_handler_set_styles.argtypes = [c_void_p, c_char_p]
+
+        self.lib.svg_handler_set_cache.restype = c_int
+        self.lib.svg_handler_set_cache.argtypes = [c_void_p, c_char_p,
+                                                   c_ulonglong]
+
         # Table export API
         self.lib.svg_handler_to_csv.restype = POINTER(POINTER(c_char_p))
         self.lib.svg_handler_to_csv.argtypes = [c_void_p,
@@ -51,12 +108,65 @@ class SvgHandlerAdapter:
         self.lib.svg_handler_free_csv.argtypes = [POINTER(POINTER(c_char_p)),
                                                   c_int, c_int]
 
+        # Query API (same layout as svg_handler_to_csv)
+        self.lib.svg_handler_query.restype = POINTER(POINTER(c_char_p))
+        self.lib.svg_handler_query.argtypes = [c_void_p, c_char_p,
+                                               POINTER(c_int),
+                                               POINTER(c_int)]
+
+        # Arrow export API (zero-copy)
+        self.lib.svg_handler_to_arrow.restype = c_int
+        self.lib.svg_handler_to_arrow.argtypes = [c_void_p,
+                                                  POINTER(ArrowArray),
+                                                  POINTER(ArrowSchema)]
+
+        # Thumbnail API (PNG or PPM by extension)
+        self.lib.svg_handler_render.restype = c_int
+        self.lib.svg_handler_render.argtypes = [c_void_p, c_char_p, c_int]
+
     def create(self, svg_path: str, csv_path: str = "output.csv") -> c_void_p:
         return self.lib.svg_handler_create(svg_path.encode("utf-8"),
                                            csv_path.encode("utf-8"))
 
-    def execute(self, handler: c_void_p):
-        self.lib.svg_handler_execute(handler)
+    def execute(self, handler: c_void_p) -> int:
+        # svg_core::Status (0 = Success)
+        return self.lib.svg_handler_execute(handler)
+
+    def reset(self, handler: c_void_p, svg_path: str,
+              csv_path: str = "output.csv") -> int:
+        # Reuses the handler buffers for another document
+        return self.lib.svg_handler_reset(handler, svg_path.encode("utf-8"),
+                                          csv_path.encode("utf-8"))
+
+    def set_option(self, handler: c_void_p, name: str,
+                   enabled: bool = True) -> int:
+        # "bbox": adds MinX/MinY/MaxX/MaxY columns
+        # "bake": applies transforms to coordinates
+        # "expand": copies the content referenced by <use> under it
+        # "shared": repeated subtrees as one row ("Shared" column)
+        # "wide": one row per element, one column per attribute name
+        # "content": text, CDATA and comments as "#text", ... attributes
+        return self.lib.svg_handler_set_option(handler, name.encode("utf-8"),
+                                               int(enabled))
+
+    def set_simplify(self, handler: c_void_p, precision: int = -1,
+                     tolerance: float = -1.0) -> int:
+        # Decimals kept in coordinates and polyline simplification
+        # distance (0: collinear points only); negative values disable them
+        return self.lib.svg_handler_set_simplify(handler, precision, tolerance)
+
+    def set_styles(self, handler: c_void_p,
+                   properties: list[str] | None = None) -> int:
+        # Computed style columns, one per property (["fill", "stroke"],
+        # ["default"] for the common ones); None or [] for none
+        names = ",".join(properties) if properties else ""
+        return self.lib.svg_handler_set_styles(handler, names.encode("utf-8"))
+
+    def set_cache(self, handler: c_void_p, directory: str | None,
+                  budget: int = 0) -> int:
+        # Results keyed by SVG content and options; budget in bytes (0 = default)
+        return self.lib.svg_handler_set_cache(
+            handler, directory.encode("utf-8") if directory else None, budget)
 
     def destroy(self, handler: c_void_p):
         if handler:
@@ -65,6 +175,8 @@ class SvgHandlerAdapter:
     def to_csv_table(self, handler: c_void_p):
         rows, cols = c_int(), c_int()
         data = self.lib.svg_handler_to_csv(handler, rows, cols)
+        if not data:
+            return []
         table = [
             [data[i][j].decode("utf-8") for j in range(cols.value)]
             for i in range(rows.value)
@@ -72,18 +184,103 @@ class SvgHandlerAdapter:
         self.lib.svg_handler_free_csv(data, rows, cols)
         return table
 
-    def process_svg(self, svg_path: str, csv_path: str = "output.csv"):
+    def query_table(self, handler: c_void_p, query: str):
+        # CSS selector ("g > rect") or XPath ("//rect[@fill='red']")
+        rows, cols = c_int(), c_int()
+        data = self.lib.svg_handler_query(handler, query.encode("utf-8"),
+                                          rows, cols)
+        if not data:
+            return []
+        table = [
+            [data[i][j].decode("utf-8") for j in range(cols.value)]
+            for i in range(rows.value)
+        ]
+        self.lib.svg_handler_free_csv(data, rows, cols)
+        return table
+
+    def to_arrow(self, handler: c_void_p):
+        # pyarrow.RecordBatch over the library's buffers (no copy, no
+        # strings); None if the SVG cannot be parsed
+        import pyarrow as pa
+
+        array, schema = ArrowArray(), ArrowSchema()
+        if self.lib.svg_handler_to_arrow(handler, array, schema) != 0:
+            return None
+        # pyarrow takes ownership and calls the release callbacks
+        return pa.RecordBatch._import_from_c(addressof(array),
+                                             addressof(schema))
+
+    def render(self, svg_path: str, image_path: str = "thumbnail.png",
+               size: int = 256) -> bool:
+        # Image of the document, longest side size pixels
+        handler = self.create(svg_path)
+        status = self.lib.svg_handler_render(handler,
+                                             image_path.encode("utf-8"), size)
+        self.destroy(handler)
+        if status != 0:
+            print(f"{Color.RED}[ERROR]{Color.RESET} Rendering failed "
+                  f"(status {status}): {svg_path}")
+            return False
+        print(f"{Color.GREEN}[INFO]{Color.RESET} Rendered → {image_path}")
+        return True
+
+    def process_svg(self, svg_path: str, csv_path: str = "output.csv",
+                    bbox: bool = False, bake: bool = False,
+                    expand: bool = False, shared: bool = False,
+                    cache: str | None = None, wide: bool = False,
+                    precision: int = -1, tolerance: float = -1.0,
+                    content: bool = False, styles: list[str] | None = None):
         handler = self.create(svg_path, csv_path)
-        self.execute(handler)
+        self.set_option(handler, "bbox", bbox)
+        self.set_option(handler, "bake", bake)
+        self.set_option(handler, "expand", expand)
+        self.set_option(handler, "shared", shared)
+        self.set_option(handler, "wide", wide)
+        self.set_option(handler, "content", content)
+        self.set_simplify(handler, precision, tolerance)
+        self.set_styles(handler, styles)
+        self.set_cache(handler, cache)
+        status = self.execute(handler)
         self.destroy(handler)
+        if status != 0:
+            print(f"{Color.RED}[ERROR]{Color.RESET} Processing failed "
+                  f"(status {status}): {svg_path}")
+            return False
         print(f"{Color.GREEN}[INFO]{Color.RESET} Processed → {csv_path}")
-
-    def extract_table(self, svg_path: str):
+        return True
+
+    def extract_table(self, svg_path: str, bbox: bool = False,
+                      bake: bool = False, query: str | None = None,
+                      expand: bool = False, shared: bool = False,
+                      wide: bool = False, precision: int = -1,
+                      tolerance: float = -1.0, content: bool = False,
+                      styles: list[str] | None = None):
         handler = self.create(svg_path)
-        table = self.to_csv_table(handler)
+        self.set_option(handler, "bbox", bbox)
+        self.set_option(handler, "bake", bake)
+        self.set_option(handler, "expand", expand)
+        self.set_option(handler, "shared", shared)
+        self.set_option(handler, "wide", wide)
+        self.set_option(handler, "content", content)
+        self.set_simplify(handler, precision, tolerance)
+        self.set_styles(handler, styles)
+        table = (self.query_table(handler, query) if query
+                 else self.to_csv_table(handler))
         self.destroy(handler)
         return table
 
+    def extract_arrow(self, svg_path: str, bbox: bool = False,
+                      bake: bool = False, expand: bool = False):
+        # Same rows as extract_table, as a pyarrow.RecordBatch
+        # (batch.to_pandas() for a DataFrame)
+        handler = self.create(svg_path)
+        self.set_option(handler, "bbox", bbox)
+        self.set_option(handler, "bake", bake)
+        self.set_option(handler, "expand", expand)
+        batch = self.to_arrow(handler)
+        self.destroy(handler)
+        return batch
+
 
 # --------------------------------------
 # Utility: Table viewer (pretty-print)
@@ -123,8 +320,17 @@ def view_hierarchy(table: list[list[str]]):
 
     # nodes: id -> { tag, parent, attrs: [(name,value), ...] }
     nodes: dict[str, dict] = {}
-    for row in table[1:]:  # skip header
-        node_id, parent_id, *_rest, tag, attr, value = row
+    header = table[0]
+    if "Attribute" not in header:
+        # Wide layout: one row per element, one column per attribute name
+        columns = [(j, name) for j, name in enumerate(header[4:], 4)
+                   if name not in ("MinX", "MinY", "MaxX", "MaxY", "Shared")]
+        for row in table[1:]:
+            nodes[row[0]] = {"tag": row[3], "parent": row[1],
+                             "attrs": [(name, row[j]) for j, name in columns
+                                       if row[j]]}
+    for row in (table[1:] if "Attribute" in header else []):  # skip header
+        node_id, parent_id, _depth, tag, attr, value = row[:6]
         # Ensure node exists
         if node_id not in nodes:
             nodes[node_id] = {"tag": tag, "parent": parent_id, "attrs": []}
@@ -179,6 +385,15 @@ def cli():
             "  python3 svg_handler.py input.svg output.csv\n"
             "  python3 svg_handler.py input.svg --table\n"
             "  python3 svg_handler.py input.svg --view\n"
+            "  python3 svg_handler.py input.svg output.csv --bbox\n"
+            "  python3 svg_handler.py input.svg output.csv --bake\n"
+            "  python3 svg_handler.py input.svg output.csv --expand\n"
+            "  python3 svg_handler.py input.svg output.csv --shared\n"
+            "  python3 svg_handler.py input.svg output.csv --wide\n"
+            "  python3 svg_handler.py input.svg output.csv --simplify 0.5\n"
+            "  python3 svg_handler.py input.svg output.csv --cache .svg_cache\n"
+            "  python3 svg_handler.py input.svg --table --query '#shapes > rect'\n"
+            "  python3 svg_handler.py input.svg --render thumb.png --size 128\n"
         )
     )
 
@@ -189,6 +404,30 @@ def cli():
                         help="Displays the SVG structure as a formatted table.")
     parser.add_argument("--view", action="store_true",
                         help="Displays the SVG hierarchy in tree format.")
+    parser.add_argument("--bbox", action="store_true",
+                        help="Adds bounding box columns (MinX, MinY, MaxX, MaxY).")
+    parser.add_argument("--bake", action="store_true",
+                        help="Applies transforms to coordinates.")
+    parser.add_argument("--expand", action="store_true",
+                        help="Copies the content referenced by <use> under it.")
+    parser.add_argument("--shared", action="store_true",
+                        help="Writes repeated subtrees as one row (Shared column).")
+    parser.add_argument("--wide", action="store_true",
+                        help="One row per element, one column per attribute.")
+    parser.add_argument("--content", action="store_true",
+                        help="Adds text, CDATA and comments (#text, ...).")
+    parser.add_argument("--precision", metavar="N", type=int, default=-1,
+                        help="Rounds coordinates to N decimals.")
+    parser.add_argument("--simplify", metavar="TOL", type=float, default=-1.0,
+                        help="Drops polyline points within TOL of the line.")
+    parser.add_argument("--cache", metavar="DIR",
+                        help="Reuses results of unchanged files kept in DIR.")
+    parser.add_argument("--query", metavar="SELECTOR",
+                        help="Only elements matching a CSS selector or XPath.")
+    parser.add_argument("--render", metavar="IMAGE",
+                        help="Saves a PNG or PPM thumbnail instead of the table.")
+    parser.add_argument("--size", metavar="PX", type=int, default=256,
+                        help="Longest side of the --render image in pixels.")
     parser.add_argument("--example", action="store_true",
                         help="Runs the built-in example (sample.svg).")
 
@@ -203,15 +442,23 @@ def cli():
         parser.print_help(sys.stderr)
         return
 
-    if args.table or args.view:
-        table = adapter.extract_table(args.svg)
+    if args.render:
+        adapter.render(args.svg, args.render, args.size)
+    elif args.table or args.view:
+        table = adapter.extract_table(args.svg, args.bbox, args.bake,
+                                      args.query, args.expand, args.shared,
+                                      args.wide, args.precision,
+                                      args.simplify, args.content)
         if args.table:
             view_table(table)
         if args.view:
             print()
             view_hierarchy(table)
     else:
-        adapter.process_svg(args.svg, args.csv)
+        adapter.process_svg(args.svg, args.csv, args.bbox, args.bake,
+                            args.expand, args.shared, args.cache,
+                            args.wide, args.precision, args.simplify,
+                            args.content)
 
 
 # ----------------
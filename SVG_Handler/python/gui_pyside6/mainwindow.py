@@ -134,7 +134,9 @@ class MainWindow(QMainWindow):
             return
 
         try:
-            self.adapter.process_svg(self.current_svg, path)
+            if not self.adapter.process_svg(self.current_svg, path):
+                QMessageBox.critical(self, "Error", "Failed to export CSV.")
+                return
             self.status.showMessage(f"Exported CSV → {path}")
             QMessageBox.information(self, "Exported", f"CSV exported to:\n{path}")
         except Exception as e:
@@ -0,0 +1,825 @@
+#include "arrow_exporter.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cassert>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <print>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
+
+using ArrowExporter::Columns;
+using ArrowExporter::Dictionary;
+using svg_core::make_error;
+using svg_core::Status;
+
+namespace {
+
+// Little-endian bytes of a scalar (flatbuffers are little-endian everywhere)
+template <typename T> auto little(T value) -> T {
+  if constexpr (std::endian::native == std::endian::big && sizeof(T) > 1) {
+    if constexpr (std::is_floating_point_v<T>) {
+      using Bits =
+          std::conditional_t<sizeof(T) == 8, std::uint64_t, std::uint32_t>;
+      return std::bit_cast<T>(std::byteswap(std::bit_cast<Bits>(value)));
+    } else {
+      return std::byteswap(value);
+    }
+  }
+  return value;
+}
+
+// Minimal flatbuffer builder. The buffer grows towards the front, so
+// objects must be built before the tables that refer to them. A Ref is
+// the distance of an object from the end of the buffer.
+class Builder {
+public:
+  using Ref = std::uint32_t;
+
+  auto size() const -> Ref {
+    return static_cast<Ref>(bytes_.size() - head_);
+  }
+
+  // Pad so that the size is aligned once `additional` bytes are added
+  void prep(std::size_t alignment, std::size_t additional) {
+    max_align_ = std::max(max_align_, alignment);
+    const auto padding = (~(size() + additional) + 1) & (alignment - 1);
+    for (std::size_t i = 0; i < padding; ++i)
+      push<std::uint8_t>(0);
+  }
+
+  template <typename T> void push(T value) {
+    value = little(value);
+    prepend(&value, sizeof(T));
+  }
+
+  void prepend(const void *data, std::size_t size) {
+    if (head_ < size) {
+      const auto used = bytes_.size() - head_;
+      const auto capacity =
+          std::max<std::size_t>(bytes_.size() * 2, used + size + 64);
+      std::vector<std::uint8_t> grown(capacity);
+      if (used)
+        std::memcpy(grown.data() + capacity - used, bytes_.data() + head_,
+                    used);
+      bytes_.swap(grown);
+      head_ = capacity - used;
+    }
+    head_ -= size;
+    if (size)
+      std::memcpy(bytes_.data() + head_, data, size);
+  }
+
+  void offset(Ref target) {
+    prep(sizeof(Ref), 0);
+    push<Ref>(size() + sizeof(Ref) - target);
+  }
+
+  auto string(std::string_view text) -> Ref {
+    prep(sizeof(Ref), text.size() + 1);
+    push<std::uint8_t>(0);
+    prepend(text.data(), text.size());
+    push<Ref>(static_cast<Ref>(text.size()));
+    return size();
+  }
+
+  auto offsets(std::span<const Ref> targets) -> Ref {
+    prep(sizeof(Ref), targets.size() * sizeof(Ref));
+    for (auto it = targets.rbegin(); it != targets.rend(); ++it)
+      push<Ref>(size() + sizeof(Ref) - *it);
+    push<Ref>(static_cast<Ref>(targets.size()));
+    return size();
+  }
+
+  // Vector of structs made of int64 fields (pushed last field first)
+  auto structs(std::span<const std::int64_t> fields, std::size_t count) -> Ref {
+    prep(sizeof(Ref), fields.size() * sizeof(std::int64_t));
+    prep(sizeof(std::int64_t), fields.size() * sizeof(std::int64_t));
+    for (auto it = fields.rbegin(); it != fields.rend(); ++it)
+      push<std::int64_t>(*it);
+    push<Ref>(static_cast<Ref>(count));
+    return size();
+  }
+
+  void start_table() {
+    fields_.clear();
+    table_start_ = size();
+  }
+
+  template <typename T> void field(std::uint16_t slot, T value) {
+    prep(sizeof(T), 0);
+    push<T>(value);
+    fields_.push_back({slot, size()});
+  }
+
+  void field_offset(std::uint16_t slot, Ref target) {
+    offset(target);
+    fields_.push_back({slot, size()});
+  }
+
+  auto end_table() -> Ref {
+    prep(sizeof(std::int32_t), 0);
+    push<std::int32_t>(0); // vtable offset, patched below
+    const auto table = size();
+
+    std::uint16_t slots = 0;
+    for (const auto &[slot, ref] : fields_)
+      slots = std::max<std::uint16_t>(slots, slot + 1);
+    for (auto slot = slots; slot-- > 0;) {
+      std::uint16_t at = 0;
+      for (const auto &[field_slot, ref] : fields_) {
+        if (field_slot == slot)
+          at = static_cast<std::uint16_t>(table - ref);
+      }
+      push<std::uint16_t>(at);
+    }
+    push<std::uint16_t>(static_cast<std::uint16_t>(table - table_start_));
+    push<std::uint16_t>(static_cast<std::uint16_t>((slots + 2) * 2));
+
+    // The vtable precedes the table
+    const auto vtable_offset =
+        little(static_cast<std::int32_t>(size() - table));
+    std::memcpy(bytes_.data() + bytes_.size() - table, &vtable_offset,
+                sizeof(vtable_offset));
+    return table;
+  }
+
+  auto finish(Ref root) -> std::span<const std::uint8_t> {
+    prep(max_align_, sizeof(Ref));
+    offset(root);
+    return {bytes_.data() + head_, bytes_.size() - head_};
+  }
+
+private:
+  struct Slot {
+    std::uint16_t slot;
+    Ref ref;
+  };
+
+  std::vector<std::uint8_t> bytes_;
+  std::size_t head_{0};
+  std::size_t max_align_{1};
+  std::size_t table_start_{0};
+  std::vector<Slot> fields_;
+};
+
+using Ref = Builder::Ref;
+
+// Schema.fbs / Message.fbs / File.fbs identifiers
+constexpr std::int16_t metadata_v5 = 4;
+constexpr std::uint8_t type_int = 2;
+constexpr std::uint8_t type_floating_point = 3;
+constexpr std::uint8_t type_utf8 = 5;
+constexpr std::int16_t precision_double = 2;
+constexpr std::uint8_t header_schema = 1;
+constexpr std::uint8_t header_dictionary_batch = 2;
+constexpr std::uint8_t header_record_batch = 3;
+constexpr std::int16_t endianness =
+    std::endian::native == std::endian::big ? 1 : 0;
+
+constexpr std::int64_t tag_dictionary = 0;
+constexpr std::int64_t attribute_dictionary = 1;
+
+auto int_type(Builder &b, int bits) -> Ref {
+  b.start_table();
+  b.field<std::int32_t>(0, bits); // bitWidth
+  b.field<std::uint8_t>(1, 1);    // is_signed
+  return b.end_table();
+}
+
+// Signed integer width of a column: 8, 16 or 32 bits
+struct Widths {
+  int depth{32};
+  int tag{32};
+  int attribute{32};
+};
+
+auto width(std::int64_t max) -> int {
+  return max <= INT8_MAX ? 8 : max <= INT16_MAX ? 16 : 32;
+}
+
+auto widths(const Columns &columns) -> Widths {
+  const auto depth =
+      columns.depth.empty() ? 0 : std::ranges::max(columns.depth);
+  return {width(depth), width(static_cast<std::int64_t>(columns.tags.size())),
+          width(static_cast<std::int64_t>(columns.attributes.size()))};
+}
+
+// bits: width of an Int field, or of the indices of a dictionary field
+auto field(Builder &b, std::string_view name, bool nullable,
+           std::uint8_t type_type, int bits = 32,
+           std::int64_t dictionary = -1) -> Ref {
+  const auto name_ref = b.string(name);
+  Ref type{0};
+  if (type_type == type_int) {
+    type = int_type(b, bits);
+  } else {
+    b.start_table();
+    if (type_type == type_floating_point)
+      b.field<std::int16_t>(0, precision_double);
+    type = b.end_table(); // Utf8 has no fields
+  }
+
+  Ref encoding{0};
+  if (dictionary >= 0) {
+    const auto index_type = int_type(b, bits);
+    b.start_table();
+    b.field<std::int64_t>(0, dictionary); // id
+    b.field_offset(1, index_type);        // indexType
+    encoding = b.end_table();
+  }
+  const auto children = b.offsets({});
+
+  b.start_table();
+  b.field_offset(0, name_ref);
+  b.field<std::uint8_t>(1, nullable ? 1 : 0);
+  b.field<std::uint8_t>(2, type_type);
+  b.field_offset(3, type);
+  if (dictionary >= 0)
+    b.field_offset(4, encoding);
+  b.field_offset(5, children);
+  return b.end_table();
+}
+
+auto schema(Builder &b, bool bbox, const Widths &widths) -> Ref {
+  std::vector<Ref> fields{
+      field(b, "ID", false, type_int),
+      field(b, "ParentID", false, type_int),
+      field(b, "Depth", false, type_int, widths.depth),
+      field(b, "Tag", false, type_utf8, widths.tag, tag_dictionary),
+      field(b, "Attribute", true, type_utf8, widths.attribute,
+            attribute_dictionary),
+      field(b, "Value", true, type_utf8)};
+  if (bbox) {
+    for (auto name : {"MinX", "MinY", "MaxX", "MaxY"})
+      fields.push_back(field(b, name, true, type_floating_point));
+  }
+  const auto vector = b.offsets(fields);
+
+  b.start_table();
+  b.field<std::int16_t>(0, endianness);
+  b.field_offset(1, vector);
+  return b.end_table();
+}
+
+// Buffers of a record batch, each 8-byte aligned in the body
+struct Body {
+  std::string bytes;
+  std::vector<std::int64_t> buffers; // {offset, length} pairs
+  std::vector<std::int64_t> nodes;   // {length, null_count} pairs
+
+  void add(const void *data, std::size_t size) {
+    buffers.push_back(static_cast<std::int64_t>(bytes.size()));
+    buffers.push_back(static_cast<std::int64_t>(size));
+    if (size)
+      bytes.append(static_cast<const char *>(data), size);
+    bytes.resize((bytes.size() + 7) & ~std::size_t{7}, '\0');
+  }
+
+  template <typename T> void add(const std::vector<T> &values) {
+    add(values.data(), values.size() * sizeof(T));
+  }
+
+  // int32 values stored with the given width
+  void add(const std::vector<std::int32_t> &values, int bits) {
+    if (bits == 32)
+      return add(values);
+    if (bits == 16)
+      return add(std::vector<std::int16_t>(values.begin(), values.end()));
+    add(std::vector<std::int8_t>(values.begin(), values.end()));
+  }
+
+  // Validity bitmap, omitted when nothing is null
+  void validity(const std::vector<std::uint8_t> &bits, std::size_t nulls) {
+    if (nulls == 0)
+      add(nullptr, 0);
+    else
+      add(bits);
+  }
+
+  void node(std::size_t length, std::size_t nulls) {
+    nodes.push_back(static_cast<std::int64_t>(length));
+    nodes.push_back(static_cast<std::int64_t>(nulls));
+  }
+};
+
+auto record_batch(Builder &b, std::size_t rows, const Body &body) -> Ref {
+  const auto nodes = b.structs(body.nodes, body.nodes.size() / 2);
+  const auto buffers = b.structs(body.buffers, body.buffers.size() / 2);
+  b.start_table();
+  b.field<std::int64_t>(0, static_cast<std::int64_t>(rows));
+  b.field_offset(1, nodes);
+  b.field_offset(2, buffers);
+  return b.end_table();
+}
+
+auto message(Builder &b, std::uint8_t type, Ref header, std::size_t body)
+    -> std::span<const std::uint8_t> {
+  b.start_table();
+  b.field<std::int64_t>(3, static_cast<std::int64_t>(body)); // bodyLength
+  b.field_offset(2, header);
+  b.field<std::int16_t>(0, metadata_v5);
+  b.field<std::uint8_t>(1, type);
+  return b.finish(b.end_table());
+}
+
+template <typename T> void append(std::string &bytes, T value) {
+  value = little(value);
+  bytes.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+// Encapsulated message: continuation marker, metadata size, flatbuffer
+// (padded to 8 bytes), body. Returns its footer Block.
+auto write_message(std::string &bytes, std::span<const std::uint8_t> metadata,
+                   const std::string &body) -> std::array<std::int64_t, 3> {
+  const auto offset = bytes.size();
+  const auto padded = (8 + metadata.size() + 7) & ~std::size_t{7};
+  append<std::uint32_t>(bytes, 0xFFFFFFFF);
+  append<std::int32_t>(bytes, static_cast<std::int32_t>(padded - 8));
+  bytes.append(reinterpret_cast<const char *>(metadata.data()),
+               metadata.size());
+  bytes.resize(offset + padded, '\0');
+  bytes += body;
+  return {static_cast<std::int64_t>(offset), static_cast<std::int64_t>(padded),
+          static_cast<std::int64_t>(body.size())};
+}
+
+// Block {offset: long, metaDataLength: int, (padding), bodyLength: long}
+auto blocks(Builder &b, const std::vector<std::array<std::int64_t, 3>> &list)
+    -> Ref {
+  b.prep(sizeof(Ref), list.size() * 24);
+  b.prep(8, list.size() * 24);
+  for (auto it = list.rbegin(); it != list.rend(); ++it) {
+    b.push<std::int64_t>((*it)[2]);
+    b.push<std::int32_t>(0);
+    b.push<std::int32_t>(static_cast<std::int32_t>((*it)[1]));
+    b.push<std::int64_t>((*it)[0]);
+  }
+  b.push<Ref>(static_cast<Ref>(list.size()));
+  return b.size();
+}
+
+void set_bit(std::vector<std::uint8_t> &bits, std::size_t row, bool valid) {
+  if (row / 8 >= bits.size())
+    bits.push_back(0);
+  if (valid)
+    bits[row / 8] |= static_cast<std::uint8_t>(1u << (row % 8));
+}
+
+auto intern(std::unordered_map<std::string_view, std::int32_t> &ids,
+            Dictionary &dictionary, std::string_view text) -> std::int32_t {
+  auto [it, inserted] =
+      ids.try_emplace(text, static_cast<std::int32_t>(dictionary.size()));
+  if (inserted) {
+    dictionary.data += text;
+    dictionary.offsets.push_back(
+        static_cast<std::int32_t>(dictionary.data.size()));
+  }
+  return it->second;
+}
+
+} // namespace
+
+auto ArrowExporter::columns(const TreeUtils::Tree &tree,
+                            const TreeUtils::TableOptions &options)
+    -> Columns {
+  Columns result;
+  result.bbox = options.bbox;
+  const auto &index = tree.index;
+
+  std::size_t rows = 0;
+  for (const auto *node : index.nodes)
+    rows += std::max<std::size_t>(node->attributes.size(), 1);
+  for (auto *column : {&result.id, &result.parent, &result.depth, &result.tag,
+                       &result.attribute})
+    column->reserve(rows);
+  result.value_offsets.reserve(rows + 1);
+
+  std::unordered_map<std::string_view, std::int32_t> tag_ids, attribute_ids;
+  auto add_row = [&](std::size_t position, const TreeUtils::Node &node,
+                     const svg_core::Attribute *attribute) {
+    const auto row = result.rows++;
+    const auto parent = index.parents[position];
+    result.id.push_back(static_cast<std::int32_t>(position));
+    result.parent.push_back(parent == std::string_view::npos
+                                ? -1
+                                : static_cast<std::int32_t>(parent));
+    result.depth.push_back(static_cast<std::int32_t>(index.depths[position]));
+    result.tag.push_back(intern(tag_ids, result.tags, node.tag));
+
+    set_bit(result.attribute_valid, row, attribute != nullptr);
+    if (attribute) {
+      result.attribute.push_back(
+          intern(attribute_ids, result.attributes, attribute->first));
+      result.value_data += attribute->second;
+    } else {
+      result.attribute.push_back(0);
+      ++result.attribute_nulls;
+    }
+    result.value_offsets.push_back(
+        static_cast<std::int32_t>(result.value_data.size()));
+
+    if (options.bbox) {
+      const bool known = node.bbox && !node.bbox->empty();
+      set_bit(result.bbox_valid, row, known);
+      result.bbox_nulls += known ? 0 : 1;
+      result.min_x.push_back(known ? node.bbox->min_x : 0.0);
+      result.min_y.push_back(known ? node.bbox->min_y : 0.0);
+      result.max_x.push_back(known ? node.bbox->max_x : 0.0);
+      result.max_y.push_back(known ? node.bbox->max_y : 0.0);
+    }
+  };
+
+  for (std::size_t position = 0; position < index.nodes.size(); ++position) {
+    const auto &node = *index.nodes[position];
+    if (node.attributes.empty())
+      add_row(position, node, nullptr);
+    for (const auto &attribute : node.attributes)
+      add_row(position, node, &attribute);
+  }
+  return result;
+}
+
+void ArrowExporter::encode(const Columns &columns, std::string &bytes) {
+  bytes.assign("ARROW1\0\0", 8);
+  const auto narrow = widths(columns);
+
+  Builder schema_builder;
+  write_message(bytes,
+                message(schema_builder, header_schema,
+                        schema(schema_builder, columns.bbox, narrow), 0),
+                {});
+
+  // Dictionaries: one Utf8 column each
+  std::vector<std::array<std::int64_t, 3>> dictionary_blocks;
+  for (auto [id, dictionary] :
+       {std::pair{tag_dictionary, &columns.tags},
+        std::pair{attribute_dictionary, &columns.attributes}}) {
+    Body body;
+    body.node(dictionary->size(), 0);
+    body.validity({}, 0);
+    body.add(dictionary->offsets);
+    body.add(dictionary->data.data(), dictionary->data.size());
+
+    Builder b;
+    const auto data = record_batch(b, dictionary->size(), body);
+    b.start_table();
+    b.field<std::int64_t>(0, id);
+    b.field_offset(1, data);
+    const auto batch = b.end_table();
+    dictionary_blocks.push_back(write_message(
+        bytes, message(b, header_dictionary_batch, batch, body.bytes.size()),
+        body.bytes));
+  }
+
+  // Record batch
+  const auto rows = columns.rows;
+  Body body;
+  for (auto [column, bits] : {std::pair{&columns.id, 32},
+                              std::pair{&columns.parent, 32},
+                              std::pair{&columns.depth, narrow.depth},
+                              std::pair{&columns.tag, narrow.tag}}) {
+    body.node(rows, 0);
+    body.validity({}, 0);
+    body.add(*column, bits);
+  }
+  body.node(rows, columns.attribute_nulls);
+  body.validity(columns.attribute_valid, columns.attribute_nulls);
+  body.add(columns.attribute, narrow.attribute);
+  body.node(rows, columns.attribute_nulls);
+  body.validity(columns.attribute_valid, columns.attribute_nulls);
+  body.add(columns.value_offsets);
+  body.add(columns.value_data.data(), columns.value_data.size());
+  if (columns.bbox) {
+    for (const auto *column :
+         {&columns.min_x, &columns.min_y, &columns.max_x, &columns.max_y}) {
+      body.node(rows, columns.bbox_nulls);
+      body.validity(columns.bbox_valid, columns.bbox_nulls);
+      body.add(*column);
+    }
+  }
+
+  Builder b;
+  const auto batch = record_batch(b, rows, body);
+  const std::vector record_blocks{write_message(
+      bytes, message(b, header_record_batch, batch, body.bytes.size()),
+      body.bytes)};
+
+  // End of stream, then the footer
+  append<std::uint32_t>(bytes, 0xFFFFFFFF);
+  append<std::int32_t>(bytes, 0);
+
+  Builder footer;
+  const auto footer_schema = schema(footer, columns.bbox, narrow);
+  const auto dictionaries = blocks(footer, dictionary_blocks);
+  const auto batches = blocks(footer, record_blocks);
+  footer.start_table();
+  footer.field<std::int16_t>(0, metadata_v5);
+  footer.field_offset(1, footer_schema);
+  footer.field_offset(2, dictionaries);
+  footer.field_offset(3, batches);
+  const auto flat = footer.finish(footer.end_table());
+  bytes.append(reinterpret_cast<const char *>(flat.data()), flat.size());
+  append<std::int32_t>(bytes, static_cast<std::int32_t>(flat.size()));
+  bytes.append("ARROW1", 6);
+}
+
+namespace {
+
+// Schema tree of an export: children and dictionaries live here
+struct ExportedSchema {
+  std::vector<ArrowSchema> children;
+  std::vector<ArrowSchema> dictionaries;
+  std::vector<ArrowSchema *> pointers;
+};
+
+// Array tree of an export, with the columns its buffers point into
+struct ExportedArray {
+  Columns columns;
+  std::vector<ArrowArray> children;
+  std::vector<ArrowArray> dictionaries;
+  std::vector<ArrowArray *> pointers;
+  std::vector<std::array<const void *, 3>> buffers;
+};
+
+// private_data of every struct of an export (root, children and
+// dictionaries): a child moved out by the consumer keeps the export alive
+// after its parent is released.
+template <typename Exported>
+auto share(const std::shared_ptr<Exported> &exported) -> void * {
+  return new std::shared_ptr<Exported>(exported);
+}
+
+template <typename Exported, typename Struct> void release(Struct *object) {
+  for (std::int64_t k = 0; k < object->n_children; ++k) {
+    auto *child = object->children[k];
+    if (child->release)
+      child->release(child);
+  }
+  if (object->dictionary && object->dictionary->release)
+    object->dictionary->release(object->dictionary);
+  delete static_cast<std::shared_ptr<Exported> *>(object->private_data);
+  object->release = nullptr;
+}
+
+constexpr auto release_schema = release<ExportedSchema, ArrowSchema>;
+constexpr auto release_array = release<ExportedArray, ArrowArray>;
+
+// Column names and formats ("i" int32, "u" utf8, "g" float64)
+struct ColumnFormat {
+  const char *name;
+  const char *format;
+  bool nullable;
+  bool dictionary;
+};
+
+constexpr std::array formats{
+    ColumnFormat{"ID", "i", false, false},
+    ColumnFormat{"ParentID", "i", false, false},
+    ColumnFormat{"Depth", "i", false, false},
+    ColumnFormat{"Tag", "i", false, true},
+    ColumnFormat{"Attribute", "i", true, true},
+    ColumnFormat{"Value", "u", true, false},
+    ColumnFormat{"MinX", "g", true, false},
+    ColumnFormat{"MinY", "g", true, false},
+    ColumnFormat{"MaxX", "g", true, false},
+    ColumnFormat{"MaxY", "g", true, false}};
+
+} // namespace
+
+void ArrowExporter::export_c(Columns columns, ArrowArray *array,
+                             ArrowSchema *schema) {
+  const std::size_t count = columns.bbox ? formats.size() : 6;
+  const auto rows = static_cast<std::int64_t>(columns.rows);
+
+  // Schema
+  auto types = std::make_shared<ExportedSchema>();
+  types->children.resize(count);
+  types->dictionaries.resize(2);
+  for (auto &dictionary : types->dictionaries) {
+    dictionary = {"u",     "",      nullptr,        0, 0,
+                  nullptr, nullptr, release_schema, share(types)};
+  }
+  for (std::size_t k = 0; k < count; ++k) {
+    const auto &format = formats[k];
+    types->children[k] = {
+        format.format, format.name, nullptr,
+        format.nullable ? ARROW_FLAG_NULLABLE : 0, 0, nullptr,
+        format.dictionary ? &types->dictionaries[k == 3 ? 0 : 1] : nullptr,
+        release_schema, share(types)};
+    types->pointers.push_back(&types->children[k]);
+  }
+  *schema = {"+s",
+             "",
+             nullptr,
+             0,
+             static_cast<std::int64_t>(count),
+             types->pointers.data(),
+             nullptr,
+             release_schema,
+             share(types)};
+
+  // Array
+  auto data = std::make_shared<ExportedArray>(std::move(columns));
+  const auto &c = data->columns;
+  auto valid = [](const std::vector<std::uint8_t> &bits, std::size_t nulls) {
+    return nulls ? static_cast<const void *>(bits.data()) : nullptr;
+  };
+  data->buffers = {
+      {nullptr, c.id.data()},
+      {nullptr, c.parent.data()},
+      {nullptr, c.depth.data()},
+      {nullptr, c.tag.data()},
+      {valid(c.attribute_valid, c.attribute_nulls), c.attribute.data()},
+      {valid(c.attribute_valid, c.attribute_nulls), c.value_offsets.data(),
+       c.value_data.data()}};
+  if (c.bbox) {
+    for (const auto *column : {&c.min_x, &c.min_y, &c.max_x, &c.max_y})
+      data->buffers.push_back(
+          {valid(c.bbox_valid, c.bbox_nulls), column->data()});
+  }
+  data->buffers.push_back({nullptr, c.tags.offsets.data(), c.tags.data.data()});
+  data->buffers.push_back(
+      {nullptr, c.attributes.offsets.data(), c.attributes.data.data()});
+
+  data->dictionaries.resize(2);
+  for (std::size_t k = 0; k < 2; ++k) {
+    const auto &dictionary = k == 0 ? c.tags : c.attributes;
+    data->dictionaries[k] = {static_cast<std::int64_t>(dictionary.size()),
+                             0,
+                             0,
+                             3,
+                             0,
+                             data->buffers[count + k].data(),
+                             nullptr,
+                             nullptr,
+                             release_array,
+                             share(data)};
+  }
+  data->children.resize(count);
+  for (std::size_t k = 0; k < count; ++k) {
+    const auto nulls = k == 4 || k == 5 ? c.attribute_nulls
+                       : k >= 6        ? c.bbox_nulls
+                                       : 0;
+    data->children[k] = {
+        rows,
+        static_cast<std::int64_t>(nulls),
+        0,
+        k == 5 ? 3 : 2,
+        0,
+        data->buffers[k].data(),
+        nullptr,
+        formats[k].dictionary ? &data->dictionaries[k == 3 ? 0 : 1] : nullptr,
+        release_array,
+        share(data)};
+    data->pointers.push_back(&data->children[k]);
+  }
+
+  static const void *no_validity[1] = {nullptr};
+  *array = {rows,
+            0,
+            0,
+            1,
+            static_cast<std::int64_t>(count),
+            no_validity,
+            data->pointers.data(),
+            nullptr,
+            release_array,
+            share(data)};
+}
+
+auto ArrowExporter::save(std::string_view path, const TreeUtils::Tree &tree,
+                         const TreeUtils::TableOptions &options)
+    -> Expected<void> {
+  if (path.empty()) {
+    return std::unexpected(
+        make_error(Status::InvalidPath, "Invalid Arrow path (empty)."));
+  }
+
+  std::string bytes;
+  ArrowExporter::encode(ArrowExporter::columns(tree, options), bytes);
+
+  std::ofstream file(std::string{path}, std::ios::binary | std::ios::trunc);
+  if (!file.is_open() ||
+      !file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()))) {
+    return std::unexpected(
+        make_error(Status::FileError,
+                   std::format("Failed to write Arrow file '{}'.", path)));
+  }
+  return {};
+}
+
+void test_arrow_exporter() {
+
+  using TreeUtils::TagTuple;
+  using TreeUtils::TagType;
+
+  auto tree = TreeUtils::process(std::vector<TagTuple>{
+      {"svg", {{"width", "10"}}, TagType::Open},
+      {"g", {}, TagType::Open},
+      {"rect", {{"width", "4"}, {"fill", "red"}}, TagType::SelfClose},
+      {"g", {}, TagType::Close},
+      {"svg", {}, TagType::Close}});
+  tree.root->children[0]->children[0]->bbox = svg_core::BBox{0, 0, 4, 2};
+
+  // Same rows as the CSV table, typed
+  auto columns = ArrowExporter::columns(tree, {.bbox = true});
+  assert(columns.rows == 4);
+  assert((columns.id == std::vector<std::int32_t>{0, 1, 2, 2}));
+  assert((columns.parent == std::vector<std::int32_t>{-1, 0, 1, 1}));
+  assert((columns.depth == std::vector<std::int32_t>{0, 1, 2, 2}));
+  assert((columns.tag == std::vector<std::int32_t>{0, 1, 2, 2}));
+  assert(columns.tags.data == "svggrect");
+  assert((columns.tags.offsets == std::vector<std::int32_t>{0, 3, 4, 8}));
+  assert((columns.attribute == std::vector<std::int32_t>{0, 0, 0, 1}));
+  assert(columns.attributes.data == "widthfill");
+  assert(columns.attribute_nulls == 1 && columns.attribute_valid[0] == 0b1101);
+  assert(columns.value_data == "104red");
+  assert((columns.value_offsets == std::vector<std::int32_t>{0, 2, 2, 3, 6}));
+  assert(columns.bbox_nulls == 2 && columns.bbox_valid[0] == 0b1100);
+  assert(columns.max_x[2] == 4 && columns.max_y[3] == 2);
+
+  // File framing
+  std::string bytes;
+  ArrowExporter::encode(columns, bytes);
+  assert(bytes.starts_with(std::string_view("ARROW1\0\0", 8)));
+  assert(bytes.ends_with("ARROW1"));
+  std::int32_t footer_size = 0;
+  std::memcpy(&footer_size, bytes.data() + bytes.size() - 10, 4);
+  assert(footer_size > 0 &&
+         static_cast<std::size_t>(footer_size) + 8 + 10 < bytes.size());
+  const auto eos =
+      bytes.size() - 10 - static_cast<std::size_t>(footer_size) - 8;
+  assert(bytes.compare(eos, 8,
+                       std::string_view("\xff\xff\xff\xff\0\0\0\0", 8)) == 0);
+  assert(eos % 8 == 0);
+  // Schema message right after the magic
+  assert(bytes.compare(8, 4, "\xff\xff\xff\xff") == 0);
+  assert(bytes.find("ParentID") != std::string::npos);
+  assert(bytes.find("104red") != std::string::npos);
+
+  // Without the box columns
+  std::string plain;
+  ArrowExporter::encode(ArrowExporter::columns(tree), plain);
+  assert(plain.size() < bytes.size() &&
+         plain.find("MinX") == std::string::npos);
+
+  // C Data Interface: buffers are the columns' own
+  ArrowArray array;
+  ArrowSchema schema;
+  const auto *ids = columns.id.data();
+  const auto *tag_indices = columns.tag.data();
+  ArrowExporter::export_c(std::move(columns), &array, &schema);
+  assert(std::string_view{schema.format} == "+s" && schema.n_children == 10);
+  assert(std::string_view{schema.children[3]->name} == "Tag");
+  assert(std::string_view{schema.children[3]->dictionary->format} == "u");
+  assert(schema.children[4]->flags == ARROW_FLAG_NULLABLE);
+  assert(array.length == 4 && array.n_children == 10);
+  const auto *attribute = array.children[4];
+  assert(attribute->null_count == 1 && attribute->dictionary->length == 2);
+  assert(static_cast<const std::uint8_t *>(attribute->buffers[0])[0] == 0b1101);
+  assert(array.children[0]->buffers[1] == ids);
+  assert(std::memcmp(array.children[5]->buffers[2], "104red", 6) == 0);
+  assert(static_cast<const std::int32_t *>(array.children[1]->buffers[1])[0] ==
+         -1);
+  assert(array.children[0]->buffers[0] == nullptr);
+
+  // A child moved out by the consumer outlives its parent
+  ArrowArray tags = *array.children[3];
+  array.children[3]->release = nullptr;
+  ArrowSchema tag_type = *schema.children[3];
+  schema.children[3]->release = nullptr;
+  array.release(&array);
+  schema.release(&schema);
+  assert(!array.release && !schema.release);
+  assert(std::string_view{tag_type.name} == "Tag");
+  assert(std::string_view{tag_type.dictionary->format} == "u");
+  assert(tags.length == 4 && tags.buffers[1] == tag_indices);
+  assert(static_cast<const std::int32_t *>(tags.buffers[1])[2] == 2);
+  assert(std::memcmp(tags.dictionary->buffers[2], "svggrect", 8) == 0);
+  tags.release(&tags);
+  tag_type.release(&tag_type);
+  assert(!tags.release && !tag_type.release);
+
+  // Empty tree
+  ArrowExporter::encode(ArrowExporter::columns({}), plain);
+  assert(plain.ends_with("ARROW1"));
+
+  std::println("{}[TEST]{} : {} : test completed", color::green, color::reset,
+               __PRETTY_FUNCTION__);
+}
+
+#ifdef BUILD_TEST_EXE
+auto main() -> int {
+
+  test_arrow_exporter();
+
+  return 0;
+}
+#endif
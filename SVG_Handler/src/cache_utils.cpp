@@ -0,0 +1,306 @@
+#include "cache_utils.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <print>
+#include <vector>
+
+using CacheUtils::Cache;
+using svg_core::make_error;
+using svg_core::Status;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr std::uint64_t prime1 = 11400714785074694791ULL;
+constexpr std::uint64_t prime2 = 14029467366897019727ULL;
+constexpr std::uint64_t prime3 = 1609587929392839161ULL;
+constexpr std::uint64_t prime4 = 9650029242287828579ULL;
+constexpr std::uint64_t prime5 = 2870177450012600261ULL;
+
+template <typename T> auto read(const char *data) -> T {
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  if constexpr (std::endian::native == std::endian::big)
+    value = std::byteswap(value);
+  return value;
+}
+
+auto xxh_round(std::uint64_t accumulator, std::uint64_t input)
+    -> std::uint64_t {
+  accumulator += input * prime2;
+  return std::rotl(accumulator, 31) * prime1;
+}
+
+auto merge(std::uint64_t hash, std::uint64_t accumulator) -> std::uint64_t {
+  hash ^= xxh_round(0, accumulator);
+  return hash * prime1 + prime4;
+}
+
+auto file_error(const fs::path &path, std::string_view action)
+    -> svg_core::Error {
+  return make_error(Status::FileError,
+                    std::format("Failed to {} cache entry '{}'.", action,
+                                path.string()));
+}
+
+} // namespace
+
+auto CacheUtils::xxh64(std::string_view data, std::uint64_t seed)
+    -> std::uint64_t {
+  const char *p = data.data();
+  const char *const end = p + data.size();
+  std::uint64_t hash;
+
+  if (data.size() >= 32) {
+    std::uint64_t v1 = seed + prime1 + prime2;
+    std::uint64_t v2 = seed + prime2;
+    std::uint64_t v3 = seed;
+    std::uint64_t v4 = seed - prime1;
+    for (; end - p >= 32; p += 32) {
+      v1 = xxh_round(v1, read<std::uint64_t>(p));
+      v2 = xxh_round(v2, read<std::uint64_t>(p + 8));
+      v3 = xxh_round(v3, read<std::uint64_t>(p + 16));
+      v4 = xxh_round(v4, read<std::uint64_t>(p + 24));
+    }
+    hash = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) +
+           std::rotl(v4, 18);
+    hash = merge(hash, v1);
+    hash = merge(hash, v2);
+    hash = merge(hash, v3);
+    hash = merge(hash, v4);
+  } else {
+    hash = seed + prime5;
+  }
+
+  hash += data.size();
+  for (; end - p >= 8; p += 8) {
+    hash ^= xxh_round(0, read<std::uint64_t>(p));
+    hash = std::rotl(hash, 27) * prime1 + prime4;
+  }
+  if (end - p >= 4) {
+    hash ^= std::uint64_t{read<std::uint32_t>(p)} * prime1;
+    hash = std::rotl(hash, 23) * prime2 + prime3;
+    p += 4;
+  }
+  for (; p < end; ++p) {
+    hash ^= static_cast<unsigned char>(*p) * prime5;
+    hash = std::rotl(hash, 11) * prime1;
+  }
+
+  hash ^= hash >> 33;
+  hash *= prime2;
+  hash ^= hash >> 29;
+  hash *= prime3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+auto CacheUtils::key(std::string_view content, std::string_view settings)
+    -> std::string {
+  const auto seed =
+      xxh64(std::format("{}|{}", svg_core::version, settings));
+  return std::format("{:016x}", xxh64(content, seed));
+}
+
+Cache::Cache(fs::path directory, std::uintmax_t budget)
+    : directory_(std::move(directory)), budget_(budget) {}
+
+auto Cache::path(std::string_view key, std::string_view extension) const
+    -> fs::path {
+  return directory_ / std::format("{}{}", key, extension);
+}
+
+auto Cache::lookup(std::string_view key, std::string_view extension)
+    -> std::optional<fs::path> {
+  auto entry = path(key, extension);
+  std::error_code ec;
+  if (!fs::is_regular_file(entry, ec)) {
+    ++misses_;
+    return std::nullopt;
+  }
+
+  // The modification time orders entries for eviction
+  fs::last_write_time(entry, fs::file_time_type::clock::now(), ec);
+  ++hits_;
+  return entry;
+}
+
+auto Cache::commit(const fs::path &temporary, std::string_view key,
+                   std::string_view extension) -> Expected<void> {
+  std::error_code ec;
+  const auto entry = path(key, extension);
+  const auto added = fs::file_size(temporary, ec);
+  if (ec)
+    return std::unexpected(file_error(temporary, "write"));
+  const auto replaced = fs::file_size(entry, ec);
+  const bool existed = !ec;
+  fs::rename(temporary, entry, ec);
+  if (ec) {
+    fs::remove(temporary, ec);
+    return std::unexpected(file_error(entry, "write"));
+  }
+
+  // The directory is only listed on the first store and when the budget is
+  // exceeded; entries then go down to a margin below it so that the next
+  // stores do not list it again.
+  if (!size_)
+    size_ = trim(budget_);
+  else
+    *size_ = *size_ + added - (existed ? std::min(replaced, *size_) : 0);
+  if (*size_ > budget_)
+    size_ = trim(budget_ - budget_ / 8);
+  return {};
+}
+
+auto Cache::store(std::string_view key, std::string_view extension,
+                  std::string_view bytes) -> Expected<void> {
+  std::error_code ec;
+  fs::create_directories(directory_, ec);
+
+  const auto stamp =
+      fs::file_time_type::clock::now().time_since_epoch().count();
+  const auto temporary =
+      directory_ / std::format("{}{}.{:x}.tmp", key, extension, stamp);
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file.is_open() ||
+        !file.write(bytes.data(), static_cast<std::streamsize>(bytes.size())))
+      return std::unexpected(file_error(temporary, "write"));
+  }
+  return commit(temporary, key, extension);
+}
+
+auto Cache::store_file(std::string_view key, std::string_view extension,
+                       const fs::path &source) -> Expected<void> {
+  std::error_code ec;
+  fs::create_directories(directory_, ec);
+
+  const auto stamp =
+      fs::file_time_type::clock::now().time_since_epoch().count();
+  const auto temporary =
+      directory_ / std::format("{}{}.{:x}.tmp", key, extension, stamp);
+  fs::copy_file(source, temporary, fs::copy_options::overwrite_existing, ec);
+  if (ec)
+    return std::unexpected(file_error(temporary, "write"));
+  return commit(temporary, key, extension);
+}
+
+auto Cache::evict() -> std::uintmax_t {
+  size_ = trim(budget_);
+  return *size_;
+}
+
+auto Cache::trim(std::uintmax_t target) -> std::uintmax_t {
+  struct Entry {
+    fs::path path;
+    std::uintmax_t size;
+    fs::file_time_type used;
+  };
+
+  std::vector<Entry> entries;
+  std::uintmax_t total = 0;
+  std::error_code ec;
+  for (const auto &item : fs::directory_iterator(directory_, ec)) {
+    if (!item.is_regular_file(ec) || item.path().extension() == ".tmp")
+      continue; // entries being written by another job
+    const auto size = item.file_size(ec);
+    const auto used = item.last_write_time(ec);
+    if (ec)
+      continue;
+    entries.push_back({item.path(), size, used});
+    total += size;
+  }
+  if (total <= target)
+    return total;
+
+  std::ranges::sort(entries, {}, &Entry::used);
+  for (const auto &entry : entries) {
+    if (total <= target)
+      break;
+    if (fs::remove(entry.path, ec))
+      total -= entry.size;
+  }
+  return total;
+}
+
+void test_cache_utils() {
+
+  using CacheUtils::xxh64;
+
+  // Reference values
+  assert(xxh64("") == 0xef46db3751d8e999ULL);
+  assert(xxh64("a") == 0xd24ec4f1a98c6e5bULL);
+  assert(xxh64("abc") == 0x44bc2cf5ad770999ULL);
+  // 39 bytes: one 32-byte stripe, then the 4-byte and 1-byte tails
+  assert(xxh64("Nobody inspects the spammish repetition") ==
+         0xfbcea83c8a378bf1ULL);
+  const std::string long_input(100, 'x');
+  assert(xxh64(long_input) == xxh64(long_input));
+  assert(xxh64(long_input) != xxh64(long_input, 1));
+
+  // Keys depend on content and settings
+  const auto key = CacheUtils::key("<svg/>");
+  assert(key.size() == 16);
+  assert(key == CacheUtils::key("<svg/>"));
+  assert(key != CacheUtils::key("<svg />"));
+  assert(key != CacheUtils::key("<svg/>", "bbox"));
+
+  // Store, hit, miss
+  const fs::path directory = "resources/cache_test";
+  fs::remove_all(directory);
+  Cache cache(directory, 10);
+  assert(!cache.lookup(key, ".csv") && cache.misses() == 1);
+  assert(cache.store(key, ".csv", "1,2,3"));
+  auto hit = cache.lookup(key, ".csv");
+  assert(hit && cache.hits() == 1);
+  {
+    std::ifstream file(*hit);
+    std::string line;
+    std::getline(file, line);
+    assert(line == "1,2,3");
+  }
+
+  // LRU eviction by size: b is the oldest once the first entry is used again
+  const auto old = fs::file_time_type::clock::now() - std::chrono::hours(1);
+  assert(cache.store("b", ".csv", "4567"));
+  fs::last_write_time(directory / "b.csv", old);
+  fs::last_write_time(directory / (key + ".csv"), old - std::chrono::hours(1));
+  assert(cache.lookup(key, ".csv")); // now the most recent
+  assert(cache.store("c", ".csv", "89"));
+  assert(fs::exists(directory / (key + ".csv")) &&
+         fs::exists(directory / "c.csv"));
+  assert(!fs::exists(directory / "b.csv"));
+  assert(cache.size() == 7 && cache.evict() == 7);
+
+  // Running total: replaced entries are counted once, the directory is
+  // listed again only past the budget (down to 7/8 of it)
+  assert(cache.store("c", ".csv", "8"));
+  assert(cache.size() == 6);
+  assert(cache.store("d", ".csv", "0123"));
+  assert(cache.size() == 10 && fs::exists(directory / "d.csv"));
+  fs::last_write_time(directory / "d.csv", old);
+  assert(cache.store("e", ".csv", "5"));
+  assert(!fs::exists(directory / "d.csv") && fs::exists(directory / "c.csv"));
+  assert(cache.size() == 7);
+  assert(cache.size() == cache.evict());
+
+  fs::remove_all(directory);
+
+  std::println("{}[TEST]{} : {} : test completed", color::green, color::reset,
+               __PRETTY_FUNCTION__);
+}
+
+#ifdef BUILD_TEST_EXE
+auto main() -> int {
+
+  test_cache_utils();
+
+  return 0;
+}
+#endif
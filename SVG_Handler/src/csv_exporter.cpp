@@ -1,7 +1,9 @@
 #include "csv_exporter.hpp"
 
+#include <array>
 #include <cassert>
 #include <print>
+#include <sstream>
 
 auto CsvExporter::check(const std::filesystem::path &path) -> ExpectedFile {
   std::error_code ec;
@@ -24,13 +26,46 @@ auto CsvExporter::check(const std::filesystem::path &path) -> ExpectedFile {
   return std::unexpected(std::make_error_code(std::errc::permission_denied));
 }
 
-void CsvExporter::save(std::string_view path, const CsvTable &table,
-                       char delimiter) {
+void CsvExporter::write(std::ostream &out, const CsvTable &table,
+                        char delimiter) {
+  // Write a field, quoting it only when needed (no temporary strings)
+  const std::array<char, 4> special{'"', delimiter, '\n', '\r'};
+  const std::string_view special_chars{special.data(), special.size()};
+
+  auto write_csv_field = [&out, special_chars](const std::string &field) {
+    if (field.find_first_of(special_chars) == std::string::npos) {
+      out << field;
+      return;
+    }
+    out << '"';
+    for (char ch : field) {
+      if (ch == '"')
+        out << '"';
+      out << ch;
+    }
+    out << '"';
+  };
+
+  // Write each line and field.
+  for (const auto &row : table) {
+    for (size_t i = 0; i < row.size(); ++i) {
+      write_csv_field(row[i]);
+      if (i < row.size() - 1)
+        out << delimiter;
+    }
+    out << '\n';
+  }
+}
+
+auto CsvExporter::save(std::string_view path, const CsvTable &table,
+                       char delimiter) -> Expected<void> {
+
+  using svg_core::make_error;
+  using svg_core::Status;
 
   if (path.empty()) {
-    std::println("{}[ERROR]{} : Invalid CSV path (empty).", color::red,
-                 color::reset);
-    return;
+    return std::unexpected(
+        make_error(Status::InvalidPath, "Invalid CSV path (empty)."));
   }
 
   std::filesystem::path fpath(path);
@@ -38,54 +73,24 @@ void CsvExporter::save(std::string_view path, const CsvTable &table,
   auto file_expected = CsvExporter::check(fpath);
   if (!file_expected.has_value()) {
     std::error_code ec = file_expected.error();
-    std::println("{}[ERROR]{} : Failed to open CSV file '{}' : {} ({})",
-                 color::red, color::reset, path, ec.message(), ec.value());
-    return;
+    return std::unexpected(make_error(
+        Status::FileError, std::format("Failed to open CSV file '{}' : {} ({})",
+                                       path, ec.message(), ec.value())));
   }
 
   std::ofstream &file = *file_expected.value();
 
-  // function to handle fields
-  auto escape_csv_field = [](const std::string &field, char delimiter) {
-    bool quotes = false;
-    std::string result;
-    result.reserve(field.size() + 2);
-
-    for (char ch : field) {
-      if (ch == '"' || ch == delimiter || ch == '\n' || ch == '\r') {
-        quotes = true;
-      }
-      if (ch == '"') {
-        result += "\"\"";
-      } else {
-        result.push_back(ch);
-      }
-    }
-
-    if (quotes) {
-      return "\"" + result + "\"";
-    }
-
-    return result;
-  };
+  CsvExporter::write(file, table, delimiter);
 
-  // Write each line and field.
-  for (const auto &row : table) {
-    for (size_t i = 0; i < row.size(); ++i) {
-      file << escape_csv_field(row[i], delimiter);
-      if (i < row.size() - 1)
-        file << delimiter;
-    }
-    file << '\n';
+  if (!file.good()) {
+    return std::unexpected(make_error(
+        Status::FileError,
+        std::format("Writing error occurred for '{}'.", path)));
   }
 
-  if (file.good()) {
-    std::println("{}[INFO]{} : CSV file saved successfully at '{}'.",
-                 color::blue, color::reset, path);
-  } else {
-    std::println("{}[ERROR]{} : Writing error occurred for '{}'.", color::red,
-                 color::reset, path);
-  }
+  std::println("{}[INFO]{} : CSV file saved successfully at '{}'.",
+               color::blue, color::reset, path);
+  return {};
 }
 
 void test_csv_exporter() {
@@ -96,7 +101,15 @@ void test_csv_exporter() {
                               {"Line 3", "Value 3", "Description A,3"}};
 
   std::string output = "resources/test_output.csv";
-  CsvExporter::save(output, table, ',');
+  auto saved = CsvExporter::save(output, table, ',');
+  assert(saved);
+  assert(CsvExporter::save("", table).error().status ==
+         svg_core::Status::InvalidPath);
+
+  // Fields holding the delimiter or quotes are quoted
+  std::ostringstream text;
+  CsvExporter::write(text, {{"d", "M0,0L1,1"}, {"say \"hi\"", "1"}});
+  assert(text.str() == "d,\"M0,0L1,1\"\n\"say \"\"hi\"\"\",1\n");
 
   // Validates created file.
   std::error_code ec;
@@ -0,0 +1,188 @@
+#include "dag_utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <format>
+#include <memory>
+#include <print>
+
+using DagUtils::Dag;
+using TreeUtils::Node;
+
+auto DagUtils::build(const TreeUtils::Tree &tree) -> Dag {
+  Dag dag;
+  const auto &index = tree.index;
+  const auto count = index.nodes.size();
+  if (count == 0)
+    return dag;
+
+  const auto copies = TreeUtils::first_copies(tree);
+  dag.classes.assign(count, std::string_view::npos);
+
+  // Reverse pre-order: children get their DagNode before the parent.
+  // A class is created at its last copy and recorded at its first one.
+  for (std::size_t position = count; position-- > 0;) {
+    const auto first = copies[position];
+    if (dag.classes[first] != std::string_view::npos)
+      continue;
+
+    const Node &node = *index.nodes[position];
+    auto &shared = dag.nodes.emplace_back();
+    shared.tag = node.tag;
+    shared.attributes = node.attributes;
+    shared.hash = index.hashes[position];
+    shared.size = index.sizes[position];
+    shared.first = first;
+    shared.children.reserve(node.children.size());
+    for (std::size_t child = position + 1; child < position + shared.size;
+         child += index.sizes[child])
+      shared.children.push_back(dag.classes[copies[child]]);
+    dag.classes[first] = dag.nodes.size() - 1;
+  }
+
+  for (std::size_t position = 0; position < count; ++position) {
+    dag.classes[position] = dag.classes[copies[position]];
+    ++dag.nodes[dag.classes[position]].count;
+  }
+  dag.root = dag.classes[0];
+  return dag;
+}
+
+auto DagUtils::expand(const Dag &dag) -> TreeUtils::Tree {
+  TreeUtils::Tree tree;
+  if (dag.root == std::string_view::npos)
+    return tree;
+
+  auto instantiate = [&dag](auto &self,
+                            std::size_t id) -> std::unique_ptr<Node> {
+    const auto &shared = dag.nodes[id];
+    auto node = std::make_unique<Node>(shared.tag, shared.attributes);
+    node->children.reserve(shared.children.size());
+    for (auto child : shared.children)
+      node->children.push_back(self(self, child));
+    return node;
+  };
+
+  tree.root = instantiate(instantiate, dag.root);
+  TreeUtils::reindex(tree);
+  return tree;
+}
+
+auto DagUtils::expanded_size(const Dag &dag) -> std::size_t {
+  return dag.root == std::string_view::npos ? 0 : dag.nodes[dag.root].size;
+}
+
+auto DagUtils::report(const Dag &dag) -> CsvTable {
+  // A repeated subtree is reported if one of its copies sits in a unique
+  // parent; otherwise all its copies come with a larger repeated subtree.
+  std::vector<bool> top(dag.nodes.size(), false);
+  for (const auto &shared : dag.nodes) {
+    if (shared.count == 1) {
+      for (auto child : shared.children)
+        top[child] = true;
+    }
+  }
+
+  std::vector<std::size_t> repeated;
+  for (std::size_t id = 0; id < dag.nodes.size(); ++id) {
+    if (top[id] && dag.nodes[id].count > 1)
+      repeated.push_back(id);
+  }
+
+  auto saved = [&dag](std::size_t id) {
+    return (dag.nodes[id].count - 1) * dag.nodes[id].size;
+  };
+  std::ranges::sort(repeated, [&](std::size_t a, std::size_t b) {
+    if (saved(a) != saved(b))
+      return saved(a) > saved(b);
+    return dag.nodes[a].first < dag.nodes[b].first;
+  });
+
+  CsvTable csvTable{{"Subtree", "Tag", "Hash", "Nodes", "Copies", "Saved"}};
+  csvTable.reserve(repeated.size() + 1);
+  for (auto id : repeated) {
+    const auto &shared = dag.nodes[id];
+    csvTable.push_back({std::to_string(shared.first), shared.tag,
+                        std::format("{:016x}", shared.hash),
+                        std::to_string(shared.size),
+                        std::to_string(shared.count),
+                        std::to_string(saved(id))});
+  }
+  return csvTable;
+}
+
+void test_dag_utils() {
+
+  using TreeUtils::TagTuple;
+  using TreeUtils::TagType;
+
+  assert(DagUtils::build({}).nodes.empty());
+  assert(!DagUtils::expand({}).root);
+
+  // Three identical icons (one in a group with two more circles), another group
+  auto tree = TreeUtils::process(std::vector<TagTuple>{
+      {"svg", {}, TagType::Open},                                  // 0
+      {"g", {{"class", "icon"}}, TagType::Open},                   // 1
+      {"rect", {{"width", "4"}}, TagType::SelfClose},              // 2
+      {"circle", {{"r", "1"}}, TagType::SelfClose},                // 3
+      {"g", {}, TagType::Close},                                   //
+      {"g", {{"class", "icon"}}, TagType::Open},                   // 4
+      {"rect", {{"width", "4"}}, TagType::SelfClose},              // 5
+      {"circle", {{"r", "1"}}, TagType::SelfClose},                // 6
+      {"g", {}, TagType::Close},                                   //
+      {"g", {}, TagType::Open},                                    // 7
+      {"g", {{"class", "icon"}}, TagType::Open},                   // 8
+      {"rect", {{"width", "4"}}, TagType::SelfClose},              // 9
+      {"circle", {{"r", "1"}}, TagType::SelfClose},                // 10
+      {"g", {}, TagType::Close},                                   //
+      {"circle", {{"r", "1"}}, TagType::SelfClose},                // 11
+      {"circle", {{"r", "1"}}, TagType::SelfClose},                // 12
+      {"g", {}, TagType::Close},                                   //
+      {"g", {{"class", "other"}}, TagType::Open},                  // 13
+      {"rect", {{"width", "4"}}, TagType::SelfClose},              // 14
+      {"g", {}, TagType::Close},                                   //
+      {"svg", {}, TagType::Close}});
+
+  auto dag = DagUtils::build(tree);
+  assert(dag.nodes.size() == 6); // svg, icon, rect, circle, outer g, other g
+  assert(DagUtils::expanded_size(dag) == tree.index.nodes.size());
+  assert(dag.classes[1] == dag.classes[4] && dag.classes[4] == dag.classes[8]);
+  assert(dag.classes[3] == dag.classes[12] &&
+         dag.classes[2] == dag.classes[14]);
+
+  const auto &icon = dag.nodes[dag.classes[1]];
+  assert(icon.count == 3 && icon.size == 3 && icon.first == 1);
+  assert(dag.nodes[dag.classes[3]].count == 5);
+  assert(dag.nodes[dag.root].tag == "svg" && dag.nodes[dag.root].count == 1);
+
+  // Children before parents
+  for (std::size_t id = 0; id < dag.nodes.size(); ++id)
+    for (auto child : dag.nodes[id].children)
+      assert(child < id);
+
+  // Round trip
+  auto copy = DagUtils::expand(dag);
+  assert(TreeUtils::same(*copy.root, *tree.root));
+  assert(copy.index.hashes == tree.index.hashes);
+
+  // Report: icons, then circles and rects also found outside icons
+  auto csvTable = DagUtils::report(dag);
+  assert(csvTable.size() == 4);
+  assert((csvTable[1] == svg_core::CsvRow{"1", "g",
+                                          std::format("{:016x}", icon.hash),
+                                          "3", "3", "6"}));
+  assert(csvTable[2][0] == "3" && csvTable[2][4] == "5"); // circle
+  assert(csvTable[3][0] == "2" && csvTable[3][4] == "4"); // rect
+
+  std::println("{}[TEST]{} : {} : test completed", color::green, color::reset,
+               __PRETTY_FUNCTION__);
+}
+
+#ifdef BUILD_TEST_EXE
+auto main() -> int {
+
+  test_dag_utils();
+
+  return 0;
+}
+#endif
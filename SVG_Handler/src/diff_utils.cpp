@@ -0,0 +1,381 @@
+#include "diff_utils.hpp"
+#include "json_exporter.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <format>
+#include <print>
+#include <unordered_map>
+#include <utility>
+
+using DiffUtils::Change;
+using DiffUtils::Diff;
+using DiffUtils::Entry;
+using TreeUtils::Tree;
+
+namespace {
+
+constexpr auto npos = std::string_view::npos;
+
+// Both directions of the matching
+struct Matching {
+  std::vector<std::size_t> forward;  // old -> new
+  std::vector<std::size_t> backward; // new -> old
+
+  auto free(std::size_t old_position, std::size_t new_position) const -> bool {
+    return forward[old_position] == npos && backward[new_position] == npos;
+  }
+
+  void pair(std::size_t old_position, std::size_t new_position) {
+    forward[old_position] = new_position;
+    backward[new_position] = old_position;
+  }
+
+  // Identical subtrees: descendants are paired position by position
+  void pair_subtrees(std::size_t old_position, std::size_t new_position,
+                     std::size_t size) {
+    for (std::size_t k = 0; k < size; ++k) {
+      if (free(old_position + k, new_position + k))
+        pair(old_position + k, new_position + k);
+    }
+  }
+};
+
+void match_ids(const Tree &before, const Tree &after, Matching &matching) {
+  for (const auto &[id, positions] : before.index.ids) {
+    if (positions.size() != 1)
+      continue;
+    auto it = after.index.ids.find(id);
+    if (it == after.index.ids.end() || it->second.size() != 1)
+      continue;
+    const auto a = positions.front();
+    const auto b = it->second.front();
+    if (before.index.nodes[a]->tag == after.index.nodes[b]->tag)
+      matching.pair(a, b);
+  }
+}
+
+void match_hashes(const Tree &before, const Tree &after, Matching &matching) {
+  const auto &a = before.index;
+  const auto &b = after.index;
+
+  struct Bucket {
+    std::size_t old_count{0};
+    std::size_t new_count{0};
+    std::size_t new_position{npos};
+  };
+  std::unordered_map<std::uint64_t, Bucket> buckets;
+  buckets.reserve(b.hashes.size());
+  for (std::size_t j = 0; j < b.hashes.size(); ++j) {
+    auto &bucket = buckets[b.hashes[j]];
+    ++bucket.new_count;
+    bucket.new_position = j;
+  }
+  for (auto hash : a.hashes) {
+    if (auto it = buckets.find(hash); it != buckets.end())
+      ++it->second.old_count;
+  }
+
+  // Pre-order: a matched subtree is skipped as a whole
+  for (std::size_t i = 0; i < a.hashes.size();) {
+    auto j = matching.forward[i];
+    if (j == npos) {
+      auto it = buckets.find(a.hashes[i]);
+      if (it != buckets.end() && it->second.old_count == 1 &&
+          it->second.new_count == 1 &&
+          matching.free(i, it->second.new_position))
+        j = it->second.new_position;
+    }
+    // Equal hashes may still collide: check what pair_subtrees relies on
+    if (j != npos && a.hashes[i] == b.hashes[j] && a.sizes[i] == b.sizes[j] &&
+        a.nodes[i]->tag == b.nodes[j]->tag &&
+        a.nodes[i]->attributes == b.nodes[j]->attributes) {
+      matching.pair_subtrees(i, j, a.sizes[i]);
+      i += a.sizes[i];
+    } else {
+      ++i;
+    }
+  }
+}
+
+void match_positions(const Tree &before, const Tree &after,
+                     Matching &matching) {
+  const auto &a = before.index;
+  const auto &b = after.index;
+  if (a.nodes.empty() || b.nodes.empty())
+    return;
+  if (matching.free(0, 0) && a.nodes[0]->tag == b.nodes[0]->tag)
+    matching.pair(0, 0);
+
+  // Unmatched children, by tag then document order
+  using Children = std::vector<std::pair<std::string_view, std::size_t>>;
+  auto unmatched = [](const TreeUtils::TreeIndex &index,
+                      const std::vector<std::size_t> &matches,
+                      std::size_t parent, Children &children) {
+    children.clear();
+    for (auto child = parent + 1; child < parent + index.sizes[parent];
+         child += index.sizes[child]) {
+      if (matches[child] == npos)
+        children.emplace_back(index.nodes[child]->tag, child);
+    }
+    std::ranges::sort(children);
+  };
+
+  // Pairs found here are visited later in the same pass (pre-order)
+  Children old_children, new_children;
+  for (std::size_t i = 0; i < a.nodes.size(); ++i) {
+    const auto j = matching.forward[i];
+    if (j == npos)
+      continue;
+    unmatched(a, matching.forward, i, old_children);
+    if (old_children.empty())
+      continue;
+    unmatched(b, matching.backward, j, new_children);
+
+    auto old_it = old_children.begin();
+    auto new_it = new_children.begin();
+    while (old_it != old_children.end() && new_it != new_children.end()) {
+      if (old_it->first < new_it->first) {
+        ++old_it;
+      } else if (new_it->first < old_it->first) {
+        ++new_it;
+      } else {
+        matching.pair(old_it++->second, new_it++->second);
+      }
+    }
+  }
+}
+
+auto parent_id(const TreeUtils::TreeIndex &index, std::size_t position)
+    -> std::string {
+  const auto parent = index.parents[position];
+  return parent == npos ? "-1" : std::to_string(parent);
+}
+
+// Attributes added, removed or changed between two matched elements
+void compare_attributes(const TreeUtils::Node &old_node,
+                        const TreeUtils::Node &new_node, Entry entry,
+                        std::vector<Entry> &entries) {
+  if (old_node.attributes == new_node.attributes)
+    return;
+  for (const auto &[name, value] : old_node.attributes) {
+    const auto *current = new_node.attribute(name);
+    if (current && *current == value)
+      continue;
+    entry.attribute = name;
+    entry.old_value = value;
+    entry.new_value =
+        current ? std::optional<std::string>{*current} : std::nullopt;
+    entries.push_back(entry);
+  }
+  for (const auto &[name, value] : new_node.attributes) {
+    if (old_node.attribute(name))
+      continue;
+    entry.attribute = name;
+    entry.old_value.reset();
+    entry.new_value = value;
+    entries.push_back(entry);
+  }
+}
+
+void append_quoted(std::string &out, std::string_view text) {
+  out += '"';
+  JsonExporter::escape(text, out);
+  out += '"';
+}
+
+auto id_cell(std::size_t position) -> std::string {
+  return position == npos ? "-1" : std::to_string(position);
+}
+
+} // namespace
+
+auto DiffUtils::diff(const Tree &before, const Tree &after) -> Diff {
+  const auto &a = before.index;
+  const auto &b = after.index;
+
+  Matching matching{std::vector<std::size_t>(a.nodes.size(), npos),
+                    std::vector<std::size_t>(b.nodes.size(), npos)};
+  match_ids(before, after, matching);
+  match_hashes(before, after, matching);
+  match_positions(before, after, matching);
+
+  Diff result;
+  auto &entries = result.entries;
+  for (std::size_t i = 0; i < a.nodes.size(); ++i) {
+    if (matching.forward[i] == npos)
+      entries.push_back({Change::Removed, i, npos, a.nodes[i]->tag});
+  }
+
+  for (std::size_t j = 0; j < b.nodes.size(); ++j) {
+    const auto &node = *b.nodes[j];
+    const auto i = matching.backward[j];
+    if (i == npos) {
+      entries.push_back({Change::Inserted, npos, j, node.tag});
+      continue;
+    }
+
+    const auto old_parent = a.parents[i];
+    const auto new_parent = b.parents[j];
+    const bool moved = old_parent == npos
+                           ? new_parent != npos
+                           : matching.forward[old_parent] != new_parent;
+    if (moved) {
+      entries.push_back({Change::Moved, i, j, node.tag, {}, parent_id(a, i),
+                         parent_id(b, j)});
+    }
+    if (a.hashes[i] != b.hashes[j])
+      compare_attributes(*a.nodes[i], node, {Change::Changed, i, j, node.tag},
+                         entries);
+  }
+
+  result.matches = std::move(matching.forward);
+  return result;
+}
+
+auto DiffUtils::table(const Diff &diff) -> CsvTable {
+  CsvTable csvTable{
+      {"Change", "Before", "After", "Tag", "Attribute", "Old", "New"}};
+  csvTable.reserve(diff.entries.size() + 1);
+  for (const auto &entry : diff.entries) {
+    csvTable.push_back({std::string{to_string(entry.change)},
+                        id_cell(entry.before), id_cell(entry.after), entry.tag,
+                        entry.attribute, entry.old_value.value_or(""),
+                        entry.new_value.value_or("")});
+  }
+  return csvTable;
+}
+
+auto DiffUtils::json(const Diff &diff) -> std::string {
+  auto position = [](std::size_t value) {
+    return value == npos ? std::string{"null"} : std::to_string(value);
+  };
+  auto optional = [](std::string &out,
+                     const std::optional<std::string> &value) {
+    if (value)
+      append_quoted(out, *value);
+    else
+      out += "null";
+  };
+
+  std::string out{"["};
+  for (std::size_t k = 0; k < diff.entries.size(); ++k) {
+    const auto &entry = diff.entries[k];
+    out += k ? ",\n  " : "\n  ";
+    out += std::format(
+        R"({{"change": "{}", "before": {}, "after": {}, "tag": )",
+        to_string(entry.change), position(entry.before),
+        position(entry.after));
+    append_quoted(out, entry.tag);
+    out += ", \"attribute\": ";
+    if (entry.attribute.empty())
+      out += "null";
+    else
+      append_quoted(out, entry.attribute);
+    out += ", \"old\": ";
+    optional(out, entry.old_value);
+    out += ", \"new\": ";
+    optional(out, entry.new_value);
+    out += '}';
+  }
+  out += diff.entries.empty() ? "]" : "\n]";
+  return out;
+}
+
+void test_diff_utils() {
+
+  using TreeUtils::TagTuple;
+  using TreeUtils::TagType;
+
+  auto before = TreeUtils::process(std::vector<TagTuple>{
+      {"svg", {}, TagType::Open},                                   // 0
+      {"g", {{"id", "a"}}, TagType::Open},                          // 1
+      {"rect", {{"fill", "red"}}, TagType::SelfClose},              // 2
+      {"g", {}, TagType::Close},                                    //
+      {"circle", {{"r", "1"}}, TagType::SelfClose},                 // 3
+      {"g", {}, TagType::Open},                                     // 4
+      {"line", {{"x2", "5"}}, TagType::SelfClose},                  // 5
+      {"line", {{"x2", "6"}}, TagType::SelfClose},                  // 6
+      {"g", {}, TagType::Close},                                    //
+      {"text", {}, TagType::SelfClose},                             // 7
+      {"svg", {}, TagType::Close}});
+  auto after = TreeUtils::process(std::vector<TagTuple>{
+      {"svg", {}, TagType::Open},                                   // 0
+      {"g", {}, TagType::Open},                                     // 1
+      {"line", {{"x2", "5"}}, TagType::SelfClose},                  // 2
+      {"line", {{"x2", "6"}, {"y2", "1"}}, TagType::SelfClose},     // 3
+      {"circle", {{"r", "1"}}, TagType::SelfClose},                 // 4
+      {"g", {}, TagType::Close},                                    //
+      {"g", {{"id", "a"}}, TagType::Open},                          // 5
+      {"rect", {{"fill", "blue"}}, TagType::SelfClose},             // 6
+      {"path", {}, TagType::SelfClose},                             // 7
+      {"g", {}, TagType::Close},                                    //
+      {"svg", {}, TagType::Close}});
+
+  // Equal trees
+  auto same = DiffUtils::diff(before, before);
+  assert(same.entries.empty());
+  assert((same.matches == std::vector<std::size_t>{0, 1, 2, 3, 4, 5, 6, 7}));
+  assert(DiffUtils::json(same) == "[]");
+
+  // id, then unique hashes (the circle), then position
+  auto diff = DiffUtils::diff(before, after);
+  assert((diff.matches == std::vector<std::size_t>{0, 5, 6, 4, 1, 2, 3, npos}));
+
+  const auto csvTable = DiffUtils::table(diff);
+  assert((csvTable == DiffUtils::CsvTable{
+      {"Change", "Before", "After", "Tag", "Attribute", "Old", "New"},
+      {"removed", "7", "-1", "text", "", "", ""},
+      {"changed", "6", "3", "line", "y2", "", "1"},
+      {"moved", "3", "4", "circle", "", "0", "1"},
+      {"changed", "2", "6", "rect", "fill", "red", "blue"},
+      {"inserted", "-1", "7", "path", "", "", ""}}));
+
+  const auto text = DiffUtils::json(diff);
+  assert(text.starts_with("[\n  {\"change\": \"removed\", \"before\": 7, "
+                          "\"after\": null, \"tag\": \"text\", "
+                          "\"attribute\": null, \"old\": null, "
+                          "\"new\": null},"));
+  assert(text.find(R"("attribute": "y2", "old": null, "new": "1")") !=
+         std::string::npos);
+  assert(text.ends_with("}\n]"));
+
+  // Escaped strings
+  DiffUtils::Diff quoted;
+  quoted.entries.push_back({Change::Changed, 0, 0, "a", "b", "\"x\"\n", "\\"});
+  assert(DiffUtils::json(quoted).find(R"("old": "\"x\"\n", "new": "\\")") !=
+         std::string::npos);
+
+  // A hash collision between subtrees of different sizes pairs nothing
+  auto small = TreeUtils::process(std::vector<TagTuple>{
+      {"svg", {}, TagType::Open},
+      {"circle", {}, TagType::SelfClose},
+      {"svg", {}, TagType::Close}});
+  auto large = TreeUtils::process(std::vector<TagTuple>{
+      {"svg", {}, TagType::Open},
+      {"g", {}, TagType::Open},
+      {"rect", {}, TagType::SelfClose},
+      {"path", {}, TagType::SelfClose},
+      {"g", {}, TagType::Close},
+      {"svg", {}, TagType::Close}});
+  small.index.hashes[1] = large.index.hashes[1];
+  auto collided = DiffUtils::diff(large, small);
+  assert((collided.matches == std::vector<std::size_t>{0, npos, npos, npos}));
+
+  // Empty trees
+  assert(DiffUtils::diff({}, {}).entries.empty());
+  assert(DiffUtils::diff({}, before).entries.size() == 8);
+
+  std::println("{}[TEST]{} : {} : test completed", color::green, color::reset,
+               __PRETTY_FUNCTION__);
+}
+
+#ifdef BUILD_TEST_EXE
+auto main() -> int {
+
+  test_diff_utils();
+
+  return 0;
+}
+#endif
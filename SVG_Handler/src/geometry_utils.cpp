@@ -0,0 +1,1061 @@
+#include "geometry_utils.hpp"
+
+#include <array>
+#include <cassert>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <numbers>
+#include <print>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using svg_core::make_error;
+using svg_core::Status;
+
+namespace {
+
+// Transformed points of one element, as coordinate arrays.
+struct Points {
+  std::vector<double> xs;
+  std::vector<double> ys;
+
+  void clear() {
+    xs.clear();
+    ys.clear();
+  }
+
+  void push(const svg_core::Matrix &m, double x, double y) {
+    xs.push_back(m.x(x, y));
+    ys.push_back(m.y(x, y));
+  }
+};
+
+struct Point {
+  double x;
+  double y;
+};
+
+// Points where a cubic bezier reaches an extreme in x or y.
+void cubic_extrema(const std::array<Point, 4> &p, Points &out) {
+  auto roots = [&p, &out](double p0, double p1, double p2, double p3) {
+    // B'(t) / 3 = a t^2 + b t + c
+    const double a = -p0 + 3 * p1 - 3 * p2 + p3;
+    const double b = 2 * (p0 - 2 * p1 + p2);
+    const double c = p1 - p0;
+
+    std::array<double, 2> ts{-1.0, -1.0};
+    constexpr double eps = 1e-12;
+    if (std::abs(a) < eps) {
+      if (std::abs(b) > eps)
+        ts[0] = -c / b;
+    } else {
+      const double disc = b * b - 4 * a * c;
+      if (disc >= 0) {
+        const double sq = std::sqrt(disc);
+        ts[0] = (-b + sq) / (2 * a);
+        ts[1] = (-b - sq) / (2 * a);
+      }
+    }
+
+    for (double t : ts) {
+      if (t <= 0.0 || t >= 1.0)
+        continue;
+      const double u = 1.0 - t;
+      const double w0 = u * u * u, w1 = 3 * u * u * t, w2 = 3 * u * t * t,
+                   w3 = t * t * t;
+      out.xs.push_back(w0 * p[0].x + w1 * p[1].x + w2 * p[2].x + w3 * p[3].x);
+      out.ys.push_back(w0 * p[0].y + w1 * p[1].y + w2 * p[2].y + w3 * p[3].y);
+    }
+  };
+
+  roots(p[0].x, p[1].x, p[2].x, p[3].x);
+  roots(p[0].y, p[1].y, p[2].y, p[3].y);
+}
+
+// Points where a quadratic bezier reaches an extreme in x or y.
+void quad_extrema(const std::array<Point, 3> &p, Points &out) {
+  auto root = [&p, &out](double p0, double p1, double p2) {
+    const double den = p0 - 2 * p1 + p2;
+    if (std::abs(den) < 1e-12)
+      return;
+    const double t = (p0 - p1) / den;
+    if (t <= 0.0 || t >= 1.0)
+      return;
+    const double u = 1.0 - t;
+    out.xs.push_back(u * u * p[0].x + 2 * u * t * p[1].x + t * t * p[2].x);
+    out.ys.push_back(u * u * p[0].y + 2 * u * t * p[1].y + t * t * p[2].y);
+  };
+
+  root(p[0].x, p[1].x, p[2].x);
+  root(p[0].y, p[1].y, p[2].y);
+}
+
+// Elliptical arc (SVG endpoint parameterization) as cubic beziers,
+// at most 90 degrees each. Calls cubic(p0, p1, p2, p3) in local space.
+template <typename Cubic>
+void arc_to_cubics(Point from, double rx, double ry, double angle,
+                   bool large_arc, bool sweep, Point to, Cubic &&cubic) {
+  if (from.x == to.x && from.y == to.y)
+    return;
+
+  rx = std::abs(rx);
+  ry = std::abs(ry);
+  if (rx == 0.0 || ry == 0.0) {
+    cubic(from, from, to, to); // straight line
+    return;
+  }
+
+  const double phi = angle * std::numbers::pi / 180.0;
+  const double cos_phi = std::cos(phi), sin_phi = std::sin(phi);
+
+  // Step 1: (x1', y1')
+  const double dx2 = (from.x - to.x) / 2, dy2 = (from.y - to.y) / 2;
+  const double x1p = cos_phi * dx2 + sin_phi * dy2;
+  const double y1p = -sin_phi * dx2 + cos_phi * dy2;
+
+  // Scale up radii that are too small
+  const double lambda = (x1p * x1p) / (rx * rx) + (y1p * y1p) / (ry * ry);
+  if (lambda > 1.0) {
+    rx *= std::sqrt(lambda);
+    ry *= std::sqrt(lambda);
+  }
+
+  // Step 2: (cx', cy')
+  const double num =
+      rx * rx * ry * ry - rx * rx * y1p * y1p - ry * ry * x1p * x1p;
+  const double den = rx * rx * y1p * y1p + ry * ry * x1p * x1p;
+  double coef = (den == 0.0) ? 0.0 : std::sqrt(std::max(0.0, num / den));
+  if (large_arc == sweep)
+    coef = -coef;
+  const double cxp = coef * rx * y1p / ry;
+  const double cyp = -coef * ry * x1p / rx;
+
+  // Step 3: center
+  const double cx = cos_phi * cxp - sin_phi * cyp + (from.x + to.x) / 2;
+  const double cy = sin_phi * cxp + cos_phi * cyp + (from.y + to.y) / 2;
+
+  // Step 4: angles
+  auto vec_angle = [](double ux, double uy, double vx, double vy) {
+    return std::atan2(ux * vy - uy * vx, ux * vx + uy * vy);
+  };
+  const double ux = (x1p - cxp) / rx, uy = (y1p - cyp) / ry;
+  const double vx = (-x1p - cxp) / rx, vy = (-y1p - cyp) / ry;
+  const double theta1 = vec_angle(1.0, 0.0, ux, uy);
+  double dtheta = vec_angle(ux, uy, vx, vy);
+  if (!sweep && dtheta > 0)
+    dtheta -= 2 * std::numbers::pi;
+  else if (sweep && dtheta < 0)
+    dtheta += 2 * std::numbers::pi;
+
+  const int segments =
+      std::max(1, static_cast<int>(std::ceil(std::abs(dtheta) /
+                                             (std::numbers::pi / 2) - 1e-9)));
+  const double delta = dtheta / segments;
+  const double k = 4.0 / 3.0 * std::tan(delta / 4);
+
+  auto point = [&](double t) {
+    return Point{cx + rx * std::cos(t) * cos_phi - ry * std::sin(t) * sin_phi,
+                 cy + rx * std::cos(t) * sin_phi + ry * std::sin(t) * cos_phi};
+  };
+  auto tangent = [&](double t) {
+    return Point{-rx * std::sin(t) * cos_phi - ry * std::cos(t) * sin_phi,
+                 -rx * std::sin(t) * sin_phi + ry * std::cos(t) * cos_phi};
+  };
+
+  Point p0 = from;
+  for (int i = 0; i < segments; ++i) {
+    const double t1 = theta1 + i * delta;
+    const double t2 = t1 + delta;
+    const Point d1 = tangent(t1), d2 = tangent(t2);
+    const Point p3 = (i == segments - 1) ? to : point(t2);
+    cubic(p0, Point{p0.x + k * d1.x, p0.y + k * d1.y},
+          Point{p3.x - k * d2.x, p3.y - k * d2.y}, p3);
+    p0 = p3;
+  }
+}
+
+// Transformed points (vertices and curve extrema) of an absolute path.
+void path_points(const PathUtils::PathData &path, const svg_core::Matrix &ctm,
+                 Points &out) {
+  auto global = [&ctm](double x, double y) {
+    return Point{ctm.x(x, y), ctm.y(x, y)};
+  };
+
+  auto push_cubic = [&](Point p0, Point p1, Point p2, Point p3) {
+    std::array<Point, 4> g{global(p0.x, p0.y), global(p1.x, p1.y),
+                           global(p2.x, p2.y), global(p3.x, p3.y)};
+    out.xs.push_back(g[3].x);
+    out.ys.push_back(g[3].y);
+    cubic_extrema(g, out);
+  };
+
+  Point current{0.0, 0.0};
+  Point start{0.0, 0.0};
+  std::size_t a{0};
+  for (char command : path.commands) {
+    const double *v = path.args.data() + a;
+    a += static_cast<std::size_t>(PathUtils::arity(command));
+
+    switch (command) {
+    case 'M':
+      current = start = {v[0], v[1]};
+      out.push(ctm, v[0], v[1]);
+      break;
+    case 'L':
+      current = {v[0], v[1]};
+      out.push(ctm, v[0], v[1]);
+      break;
+    case 'C':
+      push_cubic(current, {v[0], v[1]}, {v[2], v[3]}, {v[4], v[5]});
+      current = {v[4], v[5]};
+      break;
+    case 'Q': {
+      std::array<Point, 3> g{global(current.x, current.y), global(v[0], v[1]),
+                             global(v[2], v[3])};
+      out.xs.push_back(g[2].x);
+      out.ys.push_back(g[2].y);
+      quad_extrema(g, out);
+      current = {v[2], v[3]};
+      break;
+    }
+    case 'A':
+      arc_to_cubics(current, v[0], v[1], v[2], v[3] != 0.0, v[4] != 0.0,
+                    {v[5], v[6]}, push_cubic);
+      current = {v[5], v[6]};
+      break;
+    case 'Z':
+      current = start;
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+// Coordinates of a 'points' attribute (polyline, polygon).
+void parse_points(std::string_view str, const svg_core::Matrix &ctm,
+                  Points &out) {
+  std::size_t pos{0};
+  auto skip = [&]() {
+    while (pos < str.size() &&
+           (std::isspace(static_cast<unsigned char>(str[pos])) ||
+            str[pos] == ','))
+      ++pos;
+  };
+
+  skip();
+  while (pos < str.size()) {
+    double x{0.0}, y{0.0};
+    auto used = PathUtils::parse_number(str.substr(pos), x);
+    if (used == 0)
+      return;
+    pos += used;
+    skip();
+    used = PathUtils::parse_number(str.substr(pos), y);
+    if (used == 0)
+      return; // odd number of coordinates: last one is ignored
+    pos += used;
+    skip();
+    out.push(ctm, x, y);
+  }
+}
+
+auto element_bbox(const TreeUtils::Node &node, const svg_core::Matrix &ctm,
+                  std::pair<double, double> viewport, Points &points,
+                  PathUtils::PathData &path) -> std::optional<svg_core::BBox> {
+  const auto [vw, vh] = viewport;
+  const double vd = std::sqrt((vw * vw + vh * vh) / 2);
+  auto get = [&node](std::string_view name, double reference) {
+    return node.px(name, reference).value_or(0.0);
+  };
+
+  points.clear();
+  const auto &tag = node.tag;
+
+  if (tag == "rect") {
+    const double x = get("x", vw), y = get("y", vh);
+    const double w = get("width", vw), h = get("height", vh);
+    if (w <= 0.0 || h <= 0.0)
+      return std::nullopt;
+    points.push(ctm, x, y);
+    points.push(ctm, x + w, y);
+    points.push(ctm, x + w, y + h);
+    points.push(ctm, x, y + h);
+  } else if (tag == "circle" || tag == "ellipse") {
+    const double cx = get("cx", vw), cy = get("cy", vh);
+    double rx{0.0}, ry{0.0};
+    if (tag == "circle") {
+      rx = ry = get("r", vd);
+    } else {
+      auto rx_attr = node.px("rx", vw), ry_attr = node.px("ry", vh);
+      rx = rx_attr.value_or(ry_attr.value_or(0.0));
+      ry = ry_attr.value_or(rx_attr.value_or(0.0));
+    }
+    if (rx <= 0.0 || ry <= 0.0)
+      return std::nullopt;
+    // Exact bounds of the transformed ellipse
+    const double hx = std::hypot(ctm.a * rx, ctm.c * ry);
+    const double hy = std::hypot(ctm.b * rx, ctm.d * ry);
+    const double x = ctm.x(cx, cy), y = ctm.y(cx, cy);
+    return svg_core::BBox{x - hx, y - hy, x + hx, y + hy};
+  } else if (tag == "line") {
+    points.push(ctm, get("x1", vw), get("y1", vh));
+    points.push(ctm, get("x2", vw), get("y2", vh));
+  } else if (tag == "polyline" || tag == "polygon") {
+    if (const auto *value = node.attribute("points"))
+      parse_points(*value, ctm, points);
+  } else if (tag == "path") {
+    const auto *value = node.attribute("d");
+    if (!value || !PathUtils::parse(*value, path))
+      return std::nullopt;
+    path_points(PathUtils::absolute(path), ctm, points);
+  } else {
+    return std::nullopt;
+  }
+
+  if (points.xs.empty())
+    return std::nullopt;
+  return GeometryUtils::bounds(points.xs, points.ys);
+}
+
+auto is_container(std::string_view tag) -> bool {
+  return tag == "svg" || tag == "g" || tag == "a" || tag == "switch";
+}
+
+auto is_not_rendered(std::string_view tag) -> bool {
+  return tag == "defs" || tag == "symbol" || tag == "clipPath" ||
+         tag == "mask" || tag == "pattern" || tag == "marker" ||
+         tag == "linearGradient" || tag == "radialGradient" ||
+         tag == "filter";
+}
+
+
+// Value of the element's own 'transform' attribute (identity if absent or
+// invalid).
+auto local_transform(const TreeUtils::Node &node) -> svg_core::Matrix {
+  if (const auto *value = node.attribute("transform")) {
+    if (auto m = GeometryUtils::parse_transform(*value))
+      return *m;
+  }
+  return {};
+}
+
+// Extra transform between an element and its children: the x/y offset of
+// <use> applies to the referenced content (see ReferenceUtils::expand).
+auto content_transform(const TreeUtils::Node &node) -> svg_core::Matrix {
+  if (node.tag != "use")
+    return {};
+  return {1.0, 0.0, 0.0, 1.0, node.px("x").value_or(0.0),
+          node.px("y").value_or(0.0)};
+}
+
+// Width and height used to resolve percentages.
+auto viewport_of(const TreeUtils::Node &root) -> std::pair<double, double> {
+  std::pair<double, double> viewport{root.px("width").value_or(0.0),
+                                     root.px("height").value_or(0.0)};
+  if (const auto *view_box = root.attribute("viewBox")) {
+    Points numbers;
+    parse_points(*view_box, svg_core::Matrix{}, numbers);
+    if (numbers.xs.size() == 2) {
+      if (viewport.first <= 0.0)
+        viewport.first = numbers.xs[1];
+      if (viewport.second <= 0.0)
+        viewport.second = numbers.ys[1];
+    }
+  }
+  return viewport;
+}
+
+auto format_number(double value) -> std::string {
+  std::array<char, 32> buffer{};
+  auto [end, ec] =
+      std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+  return std::string(buffer.data(), end);
+}
+
+auto matrix_string(const svg_core::Matrix &m) -> std::string {
+  return std::format("matrix({} {} {} {} {} {})", format_number(m.a),
+                     format_number(m.b), format_number(m.c),
+                     format_number(m.d), format_number(m.e),
+                     format_number(m.f));
+}
+
+void set_attribute(TreeUtils::Node &node, std::string_view name,
+                   std::string value) {
+  for (auto &[key, old] : node.attributes) {
+    if (key == name) {
+      old = std::move(value);
+      return;
+    }
+  }
+  node.attributes.emplace_back(std::string(name), std::move(value));
+}
+
+void erase_attribute(TreeUtils::Node &node, std::string_view name) {
+  std::erase_if(node.attributes, [name](const auto &attribute) {
+    return attribute.first == name;
+  });
+}
+
+// Rectangle (rounded if rx, ry > 0) as absolute path data.
+void rect_path(double x, double y, double w, double h, double rx, double ry,
+               PathUtils::PathData &path) {
+  path.commands.clear();
+  path.args.clear();
+  auto emit = [&path](char command, std::initializer_list<double> args) {
+    path.commands.push_back(command);
+    path.args.insert(path.args.end(), args);
+  };
+
+  if (rx <= 0.0 || ry <= 0.0) {
+    emit('M', {x, y});
+    emit('L', {x + w, y});
+    emit('L', {x + w, y + h});
+    emit('L', {x, y + h});
+    emit('Z', {});
+    return;
+  }
+
+  emit('M', {x + rx, y});
+  emit('L', {x + w - rx, y});
+  emit('A', {rx, ry, 0, 0, 1, x + w, y + ry});
+  emit('L', {x + w, y + h - ry});
+  emit('A', {rx, ry, 0, 0, 1, x + w - rx, y + h});
+  emit('L', {x + rx, y + h});
+  emit('A', {rx, ry, 0, 0, 1, x, y + h - ry});
+  emit('L', {x, y + ry});
+  emit('A', {rx, ry, 0, 0, 1, x + rx, y});
+  emit('Z', {});
+}
+
+// Ellipse as two half arcs in absolute path data.
+void ellipse_path(double cx, double cy, double rx, double ry,
+                  PathUtils::PathData &path) {
+  path.commands = {'M', 'A', 'A', 'Z'};
+  path.args = {cx + rx, cy, rx, ry, 0, 0, 1, cx - rx, cy,
+               rx,      ry, 0, 0, 1, cx + rx, cy};
+}
+
+// Replace a shape by an equivalent <path> in root coordinates.
+void to_path(TreeUtils::Node &node, const PathUtils::PathData &local,
+             const svg_core::Matrix &ctm,
+             std::initializer_list<std::string_view> geometry) {
+  for (auto name : geometry)
+    erase_attribute(node, name);
+  node.tag = "path";
+  set_attribute(
+      node, "d",
+      PathUtils::serialize(GeometryUtils::transform_path(local, ctm)));
+}
+
+// Rewrite the geometry attributes of a shape in root coordinates.
+// Returns false if the element is not a shape (or its data is invalid).
+auto bake_shape(TreeUtils::Node &node, const svg_core::Matrix &ctm,
+                std::pair<double, double> viewport, PathUtils::PathData &path)
+    -> bool {
+  const auto [vw, vh] = viewport;
+  const double vd = std::sqrt((vw * vw + vh * vh) / 2);
+  auto get = [&node](std::string_view name, double reference) {
+    return node.px(name, reference).value_or(0.0);
+  };
+  auto set = [&node](std::string_view name, double value) {
+    set_attribute(node, name, format_number(value));
+  };
+
+  const std::string_view tag = node.tag;
+  const bool shape = tag == "rect" || tag == "circle" || tag == "ellipse" ||
+                     tag == "line" || tag == "polyline" || tag == "polygon" ||
+                     tag == "path";
+  if (!shape)
+    return false;
+  if (ctm.identity())
+    return true;
+
+  const bool aligned = ctm.b == 0.0 && ctm.c == 0.0;
+  const double sx = std::abs(ctm.a), sy = std::abs(ctm.d);
+
+  if (tag == "rect") {
+    const double x = get("x", vw), y = get("y", vh);
+    const double w = get("width", vw), h = get("height", vh);
+    auto rx_attr = node.px("rx", vw), ry_attr = node.px("ry", vh);
+    double rx = std::min(rx_attr.value_or(ry_attr.value_or(0.0)), w / 2);
+    double ry = std::min(ry_attr.value_or(rx_attr.value_or(0.0)), h / 2);
+
+    if (aligned) {
+      const double x0 = ctm.x(x, y), x1 = ctm.x(x + w, y + h);
+      const double y0 = ctm.y(x, y), y1 = ctm.y(x + w, y + h);
+      set("x", std::min(x0, x1));
+      set("y", std::min(y0, y1));
+      set("width", std::abs(x1 - x0));
+      set("height", std::abs(y1 - y0));
+      if (rx > 0.0 && ry > 0.0) {
+        set("rx", rx * sx);
+        set("ry", ry * sy);
+      }
+    } else {
+      rect_path(x, y, w, h, rx, ry, path);
+      to_path(node, path, ctm, {"x", "y", "width", "height", "rx", "ry"});
+    }
+  } else if (tag == "circle" || tag == "ellipse") {
+    const double cx = get("cx", vw), cy = get("cy", vh);
+    double rx{0.0}, ry{0.0};
+    if (tag == "circle") {
+      rx = ry = get("r", vd);
+    } else {
+      auto rx_attr = node.px("rx", vw), ry_attr = node.px("ry", vh);
+      rx = rx_attr.value_or(ry_attr.value_or(0.0));
+      ry = ry_attr.value_or(rx_attr.value_or(0.0));
+    }
+
+    if (aligned) {
+      set("cx", ctm.x(cx, cy));
+      set("cy", ctm.y(cx, cy));
+      if (tag == "circle" && sx == sy) {
+        set("r", rx * sx);
+      } else {
+        erase_attribute(node, "r");
+        node.tag = "ellipse";
+        set("rx", rx * sx);
+        set("ry", ry * sy);
+      }
+    } else {
+      ellipse_path(cx, cy, rx, ry, path);
+      to_path(node, path, ctm, {"cx", "cy", "r", "rx", "ry"});
+    }
+  } else if (tag == "line") {
+    const double x1 = get("x1", vw), y1 = get("y1", vh);
+    const double x2 = get("x2", vw), y2 = get("y2", vh);
+    set("x1", ctm.x(x1, y1));
+    set("y1", ctm.y(x1, y1));
+    set("x2", ctm.x(x2, y2));
+    set("y2", ctm.y(x2, y2));
+  } else if (tag == "polyline" || tag == "polygon") {
+    Points points;
+    if (const auto *value = node.attribute("points"))
+      parse_points(*value, ctm, points);
+    std::string text;
+    for (std::size_t i = 0; i < points.xs.size(); ++i) {
+      if (i > 0)
+        text.push_back(' ');
+      text += format_number(points.xs[i]);
+      text.push_back(',');
+      text += format_number(points.ys[i]);
+    }
+    set_attribute(node, "points", std::move(text));
+  } else {
+    const auto *value = node.attribute("d");
+    if (!value || !PathUtils::parse(*value, path))
+      return false;
+    set_attribute(node, "d",
+                  PathUtils::serialize(GeometryUtils::transform_path(
+                      PathUtils::absolute(path), ctm)));
+  }
+
+  return true;
+}
+
+} // namespace
+
+auto GeometryUtils::parse_transform(std::string_view str) -> Expected<Matrix> {
+  Matrix result;
+  std::size_t pos{0};
+
+  auto fail = [&str](std::string message, std::size_t offset) {
+    return std::unexpected(
+        make_error(Status::InvalidTransform, std::move(message), str, offset));
+  };
+
+  auto skip = [&](bool comma) {
+    while (pos < str.size() &&
+           (std::isspace(static_cast<unsigned char>(str[pos])) ||
+            (comma && str[pos] == ',')))
+      ++pos;
+  };
+
+  skip(true);
+  while (pos < str.size()) {
+    const std::size_t start = pos;
+    while (pos < str.size() &&
+           std::isalpha(static_cast<unsigned char>(str[pos])))
+      ++pos;
+    const auto name = str.substr(start, pos - start);
+
+    skip(false);
+    if (pos >= str.size() || str[pos] != '(')
+      return fail("Expected '(' after transform name.", pos);
+    ++pos;
+
+    std::array<double, 6> v{};
+    std::size_t n{0};
+    skip(true);
+    while (pos < str.size() && str[pos] != ')') {
+      if (n == v.size())
+        return fail("Too many transform arguments.", pos);
+      auto used = PathUtils::parse_number(str.substr(pos), v[n]);
+      if (used == 0)
+        return fail("Invalid transform argument.", pos);
+      pos += used;
+      ++n;
+      skip(true);
+    }
+    if (pos >= str.size())
+      return fail("Missing ')'.", start);
+    ++pos;
+
+    constexpr double deg = std::numbers::pi / 180.0;
+    Matrix m;
+    if (name == "matrix" && n == 6) {
+      m = {v[0], v[1], v[2], v[3], v[4], v[5]};
+    } else if (name == "translate" && (n == 1 || n == 2)) {
+      m.e = v[0];
+      m.f = (n == 2) ? v[1] : 0.0;
+    } else if (name == "scale" && (n == 1 || n == 2)) {
+      m.a = v[0];
+      m.d = (n == 2) ? v[1] : v[0];
+    } else if (name == "rotate" && (n == 1 || n == 3)) {
+      const double c = std::cos(v[0] * deg), s = std::sin(v[0] * deg);
+      m = {c, s, -s, c, 0.0, 0.0};
+      if (n == 3) {
+        m = Matrix{1, 0, 0, 1, v[1], v[2]} * m *
+            Matrix{1, 0, 0, 1, -v[1], -v[2]};
+      }
+    } else if (name == "skewX" && n == 1) {
+      m.c = std::tan(v[0] * deg);
+    } else if (name == "skewY" && n == 1) {
+      m.b = std::tan(v[0] * deg);
+    } else {
+      return fail(std::format("Unknown transform '{}' or wrong argument count.",
+                              name),
+                  start);
+    }
+
+    result = result * m;
+    skip(true);
+  }
+
+  return result;
+}
+
+auto GeometryUtils::bounds(std::span<const double> xs,
+                           std::span<const double> ys) -> BBox {
+  BBox box;
+  const std::size_t n = std::min(xs.size(), ys.size());
+  std::size_t i{0};
+
+#if defined(__SSE2__)
+  // Two points per step, four running min/max registers
+  if (n >= 2) {
+    __m128d min_x = _mm_loadu_pd(xs.data());
+    __m128d max_x = min_x;
+    __m128d min_y = _mm_loadu_pd(ys.data());
+    __m128d max_y = min_y;
+    for (i = 2; i + 2 <= n; i += 2) {
+      const __m128d x = _mm_loadu_pd(xs.data() + i);
+      const __m128d y = _mm_loadu_pd(ys.data() + i);
+      min_x = _mm_min_pd(min_x, x);
+      max_x = _mm_max_pd(max_x, x);
+      min_y = _mm_min_pd(min_y, y);
+      max_y = _mm_max_pd(max_y, y);
+    }
+    std::array<double, 2> lo_x{}, hi_x{}, lo_y{}, hi_y{};
+    _mm_storeu_pd(lo_x.data(), min_x);
+    _mm_storeu_pd(hi_x.data(), max_x);
+    _mm_storeu_pd(lo_y.data(), min_y);
+    _mm_storeu_pd(hi_y.data(), max_y);
+    box.expand(lo_x[0], lo_y[0]);
+    box.expand(lo_x[1], lo_y[1]);
+    box.expand(hi_x[0], hi_y[0]);
+    box.expand(hi_x[1], hi_y[1]);
+  }
+#endif
+
+  for (; i < n; ++i)
+    box.expand(xs[i], ys[i]);
+
+  return box;
+}
+
+auto GeometryUtils::path_bbox(const PathUtils::PathData &path,
+                              const Matrix &ctm) -> BBox {
+  Points points;
+  path_points(path, ctm, points);
+  return GeometryUtils::bounds(points.xs, points.ys);
+}
+
+auto GeometryUtils::element_bbox(const TreeUtils::Node &node,
+                                 const Matrix &ctm,
+                                 std::pair<double, double> viewport)
+    -> std::optional<BBox> {
+  Points points;
+  PathUtils::PathData path;
+  return ::element_bbox(node, ctm, viewport, points, path);
+}
+
+namespace {
+
+// Bounding boxes in root coordinates, with scratch reused for every element
+struct BoxWriter {
+  std::pair<double, double> viewport;
+  Points points;
+  PathUtils::PathData path;
+
+  // Own geometry plus, for groups, the children's boxes (already computed)
+  void assign(TreeUtils::Node &node) {
+    std::optional<svg_core::BBox> box =
+        ::element_bbox(node, *node.ctm, viewport, points, path);
+    if (is_container(node.tag) || node.tag == "use") {
+      for (auto &child : node.children) {
+        if (!child->bbox)
+          continue;
+        if (!box)
+          box = svg_core::BBox{};
+        box->expand(*child->bbox);
+      }
+    }
+    node.bbox.reset();
+    if (box && !box->empty())
+      node.bbox = box;
+  }
+
+  void subtree(TreeUtils::Node &node, const svg_core::Matrix &parent,
+               bool rendered) {
+    node.bbox.reset();
+    if (!node.ctm)
+      node.ctm = parent * local_transform(node);
+    const svg_core::Matrix content = *node.ctm * content_transform(node);
+
+    rendered = rendered && !is_not_rendered(node.tag);
+    for (auto &child : node.children)
+      subtree(*child, content, rendered);
+    if (rendered)
+      assign(node);
+  }
+};
+
+void flatten_subtree(TreeUtils::Node &node, const svg_core::Matrix &parent) {
+  node.ctm = parent * local_transform(node);
+  const svg_core::Matrix content = *node.ctm * content_transform(node);
+  for (auto &child : node.children)
+    flatten_subtree(*child, content);
+}
+
+} // namespace
+
+void GeometryUtils::compute(TreeUtils::Tree &tree) {
+  if (!tree.root)
+    return;
+
+  BoxWriter writer{viewport_of(*tree.root), {}, {}};
+  writer.subtree(*tree.root, Matrix{}, true);
+}
+
+void GeometryUtils::flatten(TreeUtils::Tree &tree) {
+  if (tree.root)
+    flatten_subtree(*tree.root, Matrix{});
+}
+
+void GeometryUtils::refresh(TreeUtils::Tree &tree, std::size_t position,
+                            bool bbox) {
+  const auto &index = tree.index;
+  if (position >= index.nodes.size())
+    return;
+
+  // The root sets the viewport of every percentage: start over
+  if (position == 0) {
+    flatten(tree);
+    if (bbox)
+      compute(tree);
+    return;
+  }
+
+  const auto parent = index.parents[position];
+  const auto &parent_node = *index.nodes[parent];
+  const Matrix content =
+      parent_node.ctm.value_or(Matrix{}) * content_transform(parent_node);
+  auto &node = *index.nodes[position];
+  flatten_subtree(node, content);
+  if (!bbox)
+    return;
+
+  bool rendered = true;
+  for (auto ancestor = parent; ancestor != std::string_view::npos;
+       ancestor = index.parents[ancestor])
+    rendered = rendered && !is_not_rendered(index.nodes[ancestor]->tag);
+
+  BoxWriter writer{viewport_of(*tree.root), {}, {}};
+  writer.subtree(node, content, rendered);
+  if (!rendered)
+    return;
+  for (auto ancestor = parent; ancestor != std::string_view::npos;
+       ancestor = index.parents[ancestor])
+    writer.assign(*index.nodes[ancestor]);
+}
+
+auto GeometryUtils::transform_path(const PathUtils::PathData &path,
+                                   const Matrix &m) -> PathUtils::PathData {
+  PathUtils::PathData out;
+  out.commands.reserve(path.commands.size());
+  out.args.reserve(path.args.size());
+
+  auto emit = [&out, &m](char command, std::initializer_list<Point> points) {
+    out.commands.push_back(command);
+    for (const auto &p : points) {
+      out.args.push_back(m.x(p.x, p.y));
+      out.args.push_back(m.y(p.x, p.y));
+    }
+  };
+
+  const bool aligned = m.b == 0.0 && m.c == 0.0;
+  const bool mirrored = m.a * m.d - m.b * m.c < 0.0;
+
+  Point current{0.0, 0.0};
+  Point start{0.0, 0.0};
+  std::size_t a{0};
+  for (char command : path.commands) {
+    const double *v = path.args.data() + a;
+    a += static_cast<std::size_t>(PathUtils::arity(command));
+
+    switch (command) {
+    case 'M':
+      emit('M', {{v[0], v[1]}});
+      current = start = {v[0], v[1]};
+      break;
+    case 'L':
+      emit('L', {{v[0], v[1]}});
+      current = {v[0], v[1]};
+      break;
+    case 'C':
+      emit('C', {{v[0], v[1]}, {v[2], v[3]}, {v[4], v[5]}});
+      current = {v[4], v[5]};
+      break;
+    case 'Q':
+      emit('Q', {{v[0], v[1]}, {v[2], v[3]}});
+      current = {v[2], v[3]};
+      break;
+    case 'A': {
+      const bool uniform = std::abs(m.a) == std::abs(m.d);
+      if (aligned && (uniform || std::fmod(v[2], 180.0) == 0.0)) {
+        const Point end{m.x(v[5], v[6]), m.y(v[5], v[6])};
+        out.commands.push_back('A');
+        out.args.insert(out.args.end(),
+                        {v[0] * std::abs(m.a), v[1] * std::abs(m.d),
+                         (m.a * m.d < 0.0) ? 0.0 - v[2] : v[2], v[3],
+                         mirrored ? 1.0 - v[4] : v[4], end.x, end.y});
+      } else {
+        arc_to_cubics(current, v[0], v[1], v[2], v[3] != 0.0, v[4] != 0.0,
+                      {v[5], v[6]},
+                      [&emit](Point, Point p1, Point p2, Point p3) {
+                        emit('C', {p1, p2, p3});
+                      });
+      }
+      current = {v[5], v[6]};
+      break;
+    }
+    case 'Z':
+      out.commands.push_back('Z');
+      current = start;
+      break;
+    default:
+      break;
+    }
+  }
+
+  return out;
+}
+
+void GeometryUtils::bake(TreeUtils::Tree &tree) {
+  if (!tree.root)
+    return;
+
+  flatten(tree);
+  const auto viewport = viewport_of(*tree.root);
+  PathUtils::PathData path;
+
+  auto traverse = [&](auto &self, TreeUtils::Node &node) -> void {
+    // Referenced content is drawn in the coordinates of its user
+    if (is_not_rendered(node.tag))
+      return;
+
+    const Matrix ctm = node.ctm.value_or(Matrix{});
+    const bool baked = is_container(node.tag) ||
+                       bake_shape(node, ctm, viewport, path);
+
+    erase_attribute(node, "transform");
+    if (!baked && !ctm.identity())
+      set_attribute(node, "transform", matrix_string(ctm));
+    node.invalidate();
+
+    // Children of other elements stay relative to them
+    if (is_container(node.tag)) {
+      for (auto &child : node.children)
+        self(self, *child);
+    }
+  };
+
+  traverse(traverse, *tree.root);
+  flatten(tree);
+  TreeUtils::reindex(tree);
+}
+
+void test_geometry_utils() {
+
+  using GeometryUtils::BBox;
+  using GeometryUtils::bounds;
+  using GeometryUtils::Matrix;
+  using GeometryUtils::parse_transform;
+  using TreeUtils::Node;
+
+  auto near = [](double a, double b) { return std::abs(a - b) < 1e-9; };
+  auto near_box = [&near](const BBox &a, const BBox &b) {
+    return near(a.min_x, b.min_x) && near(a.min_y, b.min_y) &&
+           near(a.max_x, b.max_x) && near(a.max_y, b.max_y);
+  };
+
+  // Transforms
+  assert(parse_transform("translate(20,20)") == (Matrix{1, 0, 0, 1, 20, 20}));
+  assert(parse_transform(" scale(2) translate(5)") ==
+         (Matrix{2, 0, 0, 2, 10, 0}));
+  auto r = parse_transform("rotate(90 10 10)");
+  assert(r && near(r->x(20, 10), 10) && near(r->y(20, 10), 20));
+  assert(parse_transform("").value().identity());
+  assert(parse_transform("translate(1,2").error().status ==
+         Status::InvalidTransform);
+  assert(!parse_transform("rotate(1,2)"));
+  assert(!parse_transform("spin(45)"));
+
+  // SIMD bounds (odd count exercises the scalar tail)
+  std::vector<double> xs{3, -1, 4, 1, 5}, ys{9, 2, -6, 5, 3};
+  assert(bounds(xs, ys) == (BBox{-1, -6, 5, 9}));
+  assert(bounds({}, {}).empty());
+
+  // Shapes
+  Node rect("rect",
+            {{"x", "10"}, {"y", "10"}, {"width", "80"}, {"height", "50"}});
+  assert(GeometryUtils::element_bbox(rect) == (BBox{10, 10, 90, 60}));
+  const auto quarter = *parse_transform("rotate(90)");
+  assert(near_box(*GeometryUtils::element_bbox(rect, quarter),
+                  BBox{-60, 10, -10, 90}));
+
+  Node circle("circle", {{"cx", "150"}, {"cy", "35"}, {"r", "25"}});
+  assert(GeometryUtils::element_bbox(circle) == (BBox{125, 10, 175, 60}));
+
+  Node ellipse("ellipse", {{"rx", "10"}, {"ry", "5"}});
+  assert(near_box(*GeometryUtils::element_bbox(ellipse, quarter),
+                  BBox{-5, -10, 5, 10}));
+
+  Node polygon("polygon", {{"points", "0,0 10,5 -3 8 7"}});
+  assert(GeometryUtils::element_bbox(polygon) == (BBox{-3, 0, 10, 8}));
+
+  Node percent("rect", {{"width", "50%"}, {"height", "10"}});
+  assert(GeometryUtils::element_bbox(percent, {}, {300, 200}) ==
+         (BBox{0, 0, 150, 10}));
+
+  assert(!GeometryUtils::element_bbox(Node("g")));
+  assert(!GeometryUtils::element_bbox(Node("rect", {{"width", "0"}})));
+
+  // Curves: extrema beyond the end points
+  Node cubic("path", {{"d", "M0,0C0,10,10,10,10,0"}});
+  assert(near_box(*GeometryUtils::element_bbox(cubic), BBox{0, 0, 10, 7.5}));
+
+  Node quad("path", {{"d", "M0,0Q5,10,10,0"}});
+  assert(near_box(*GeometryUtils::element_bbox(quad), BBox{0, 0, 10, 5}));
+
+  Node arc("path", {{"d", "M0,0A10,10,0,0,1,20,0"}});
+  auto arc_box = *GeometryUtils::element_bbox(arc);
+  assert(near(arc_box.min_x, 0) && near(arc_box.max_x, 20));
+  assert(std::abs(arc_box.min_y + 10) < 1e-2 && near(arc_box.max_y, 0));
+
+  // Tree: transform propagation and group unions
+  auto tree = TreeUtils::process(std::vector<TreeUtils::TagTuple>{
+      {"svg", {{"width", "300"}, {"height", "200"}}, TreeUtils::TagType::Open},
+      {"g", {{"transform", "translate(20,20)"}}, TreeUtils::TagType::Open},
+      {"rect", {{"x", "10"}, {"y", "10"}, {"width", "80"}, {"height", "50"}},
+       TreeUtils::TagType::SelfClose},
+      {"line", {{"x1", "10"}, {"y1", "120"}, {"x2", "200"}, {"y2", "120"}},
+       TreeUtils::TagType::SelfClose},
+      {"g", {}, TreeUtils::TagType::Close},
+      {"defs", {}, TreeUtils::TagType::Open},
+      {"rect", {{"width", "1000"}, {"height", "1000"}},
+       TreeUtils::TagType::SelfClose},
+      {"defs", {}, TreeUtils::TagType::Close},
+      {"svg", {}, TreeUtils::TagType::Close}});
+
+  GeometryUtils::compute(tree);
+  const auto &g = *tree.root->children[0];
+  assert(g.children[0]->bbox == (BBox{30, 30, 110, 80}));
+  assert(g.children[1]->bbox == (BBox{30, 140, 220, 140}));
+  assert(g.bbox == (BBox{30, 30, 220, 140}));
+  assert(!tree.root->children[1]->children[0]->bbox);
+  assert(tree.root->bbox == g.bbox);
+  assert(g.ctm == (Matrix{1, 0, 0, 1, 20, 20}) && g.children[0]->ctm == g.ctm);
+
+  // Local refresh after an attribute change
+  TreeUtils::update(tree, 1, {{"transform", "translate(0,0)"}});
+  GeometryUtils::refresh(tree, 1, true);
+  assert(g.children[0]->ctm.value().identity());
+  assert(g.children[0]->bbox == (BBox{10, 10, 90, 60}));
+  assert(g.bbox == (BBox{10, 10, 200, 120}) && tree.root->bbox == g.bbox);
+
+  // Accumulated matrices
+  auto nested = TreeUtils::process(std::vector<TreeUtils::TagTuple>{
+      {"svg", {}, TreeUtils::TagType::Open},
+      {"g", {{"transform", "translate(10,0)"}}, TreeUtils::TagType::Open},
+      {"g", {{"transform", "scale(2)"}}, TreeUtils::TagType::Open},
+      {"circle",
+       {{"cx", "5"}, {"cy", "5"}, {"r", "1"}},
+       TreeUtils::TagType::SelfClose},
+      {"rect", {{"width", "4"}, {"height", "2"}, {"transform", "rotate(90)"}},
+       TreeUtils::TagType::SelfClose},
+      {"text", {{"x", "1"}}, TreeUtils::TagType::SelfClose},
+      {"g", {}, TreeUtils::TagType::Close},
+      {"g", {}, TreeUtils::TagType::Close},
+      {"svg", {}, TreeUtils::TagType::Close}});
+  GeometryUtils::flatten(nested);
+  auto &inner = *nested.root->children[0]->children[0];
+  assert(inner.ctm == (Matrix{2, 0, 0, 2, 10, 0}));
+  const auto rotated = inner.children[1]->ctm.value();
+  assert(near(rotated.x(1, 0), 10) && near(rotated.y(1, 0), 2));
+
+  // Paths
+  auto moved = GeometryUtils::transform_path(
+      PathUtils::absolute(*PathUtils::parse("M0,0L1,0A1,1,0,0,1,2,0Z")),
+      Matrix{2, 0, 0, -2, 1, 1});
+  assert(PathUtils::serialize(moved) == "M1,1L3,1A2,2,0,0,0,5,1Z");
+  auto turned = GeometryUtils::transform_path(
+      *PathUtils::parse("M0,0A1,1,0,0,1,2,0"), *parse_transform("skewX(30)"));
+  assert(turned.commands == (std::vector<char>{'M', 'C', 'C'}));
+
+  // Baking keeps the geometry and drops the transforms
+  GeometryUtils::compute(nested);
+  const auto before_circle = *inner.children[0]->bbox;
+  const auto before_rect = *inner.children[1]->bbox;
+
+  GeometryUtils::bake(nested);
+  auto &circle_node = *inner.children[0];
+  assert(circle_node.tag == "circle" && *circle_node.attribute("cx") == "20" &&
+         *circle_node.attribute("cy") == "10" &&
+         *circle_node.attribute("r") == "2");
+  assert(inner.children[1]->tag == "path" &&
+         !inner.children[1]->attribute("width"));
+  assert(*inner.children[2]->attribute("transform") == "matrix(2 0 0 2 10 0)");
+  assert(!inner.attribute("transform") && inner.ctm.value().identity());
+
+  GeometryUtils::compute(nested);
+  assert(near_box(*circle_node.bbox, before_circle));
+  assert(near_box(*inner.children[1]->bbox, before_rect));
+
+  std::println("{}[TEST]{} : {} : test completed", color::green, color::reset,
+               __PRETTY_FUNCTION__);
+}
+
+#ifdef BUILD_TEST_EXE
+auto main() -> int {
+
+  test_geometry_utils();
+
+  return 0;
+}
+#endif
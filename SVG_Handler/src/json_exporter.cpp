@@ -0,0 +1,311 @@
+#include "json_exporter.hpp"
+
+#include <array>
+#include <cassert>
+#include <charconv>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <print>
+#include <sstream>
+
+using JsonExporter::Format;
+using svg_core::make_error;
+using svg_core::Status;
+
+namespace {
+
+// Bytes gathered before each write to the stream
+constexpr std::size_t buffer_size = 1 << 16;
+
+void append_number(std::string &out, long long number) {
+  std::array<char, 24> buffer{};
+  auto [end, ec] =
+      std::to_chars(buffer.data(), buffer.data() + buffer.size(), number);
+  out.append(buffer.data(), end);
+}
+
+void append_real(std::string &out, double number) {
+  if (!std::isfinite(number)) {
+    out += "null";
+    return;
+  }
+  std::array<char, 32> buffer{};
+  auto [end, ec] =
+      std::to_chars(buffer.data(), buffer.data() + buffer.size(), number);
+  out.append(buffer.data(), end);
+}
+
+void append_string(std::string &out, std::string_view text) {
+  out += '"';
+  JsonExporter::escape(text, out);
+  out += '"';
+}
+
+// Members of an element, without the closing brace
+void append_element(std::string &out, const TreeUtils::Tree &tree,
+                    std::size_t position, Format format,
+                    const TreeUtils::TableOptions &options) {
+  const auto &index = tree.index;
+  const auto &node = *index.nodes[position];
+
+  out += "{\"id\":";
+  append_number(out, static_cast<long long>(position));
+  if (format == Format::Lines) {
+    const auto parent = index.parents[position];
+    out += ",\"parent\":";
+    append_number(out, parent == std::string_view::npos
+                           ? -1
+                           : static_cast<long long>(parent));
+    out += ",\"depth\":";
+    append_number(out, index.depths[position]);
+  }
+  out += ",\"tag\":";
+  append_string(out, node.tag);
+
+  out += ",\"attributes\":{";
+  bool first = true;
+  for (const auto &[name, value] : node.attributes) {
+    if (!first)
+      out += ',';
+    first = false;
+    append_string(out, name);
+    out += ':';
+    append_string(out, value);
+  }
+  out += '}';
+
+  if (options.content && !node.contents.empty()) {
+    // "after": child elements before the content, to interleave them
+    out += ",\"content\":[";
+    first = true;
+    for (const auto &content : node.contents) {
+      if (!first)
+        out += ',';
+      first = false;
+      out += "{\"kind\":";
+      append_string(out, svg_core::to_string(content.kind));
+      out += ",\"after\":";
+      append_number(out, static_cast<long long>(content.after));
+      out += ",\"text\":";
+      append_string(out, TreeUtils::text(tree, content));
+      out += '}';
+    }
+    out += ']';
+  }
+
+  if (!options.styles.empty() && node.style) {
+    out += ",\"style\":{";
+    for (std::size_t i = 0; i < options.styles.size(); ++i) {
+      if (i > 0)
+        out += ',';
+      append_string(out, options.styles[i]);
+      out += ':';
+      append_string(out, i < node.style->size() ? (*node.style)[i] : "");
+    }
+    out += '}';
+  }
+
+  if (options.bbox) {
+    out += ",\"bbox\":";
+    if (!node.bbox || node.bbox->empty()) {
+      out += "null";
+    } else {
+      out += '[';
+      append_real(out, node.bbox->min_x);
+      out += ',';
+      append_real(out, node.bbox->min_y);
+      out += ',';
+      append_real(out, node.bbox->max_x);
+      out += ',';
+      append_real(out, node.bbox->max_y);
+      out += ']';
+    }
+  }
+}
+
+} // namespace
+
+void JsonExporter::escape(std::string_view text, std::string &out) {
+  static constexpr std::string_view hex = "0123456789abcdef";
+
+  std::size_t start = 0;
+  for (std::size_t i = 0; i < text.size(); ++i) {
+    const auto ch = static_cast<unsigned char>(text[i]);
+    if (ch >= 0x20 && ch != '"' && ch != '\\')
+      continue;
+
+    out.append(text.data() + start, i - start);
+    switch (ch) {
+    case '"': out += "\\\""; break;
+    case '\\': out += "\\\\"; break;
+    case '\n': out += "\\n"; break;
+    case '\r': out += "\\r"; break;
+    case '\t': out += "\\t"; break;
+    case '\b': out += "\\b"; break;
+    case '\f': out += "\\f"; break;
+    default:
+      out += "\\u00";
+      out += hex[ch >> 4];
+      out += hex[ch & 0xf];
+    }
+    start = i + 1;
+  }
+  out.append(text.data() + start, text.size() - start);
+}
+
+void JsonExporter::write(std::ostream &out, const TreeUtils::Tree &tree,
+                         Format format,
+                         const TreeUtils::TableOptions &options) {
+  const auto &index = tree.index;
+
+  std::string buffer;
+  buffer.reserve(buffer_size);
+  auto flush = [&] {
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    buffer.clear();
+  };
+
+  if (index.nodes.empty()) {
+    if (format == Format::Tree)
+      out << "null\n";
+    return;
+  }
+
+  // Tree: the depths of consecutive pre-order elements tell which
+  // "children" arrays end, so no stack is needed
+  for (std::size_t position = 0; position < index.nodes.size(); ++position) {
+    if (format == Format::Lines) {
+      append_element(buffer, tree, position, format, options);
+      buffer += "}\n";
+    } else {
+      const auto depth = index.depths[position];
+      if (position > 0) {
+        const auto previous = index.depths[position - 1];
+        for (auto level = depth; level < previous; ++level)
+          buffer += "]}";
+        if (depth <= previous)
+          buffer += ',';
+      }
+      append_element(buffer, tree, position, format, options);
+      buffer += index.sizes[position] > 1 ? ",\"children\":[" : "}";
+    }
+
+    if (buffer.size() >= buffer_size)
+      flush();
+  }
+
+  if (format == Format::Tree) {
+    for (auto level = 0; level < index.depths.back(); ++level)
+      buffer += "]}";
+    buffer += '\n';
+  }
+  flush();
+}
+
+auto JsonExporter::save(std::string_view path, const TreeUtils::Tree &tree,
+                        Format format, const TreeUtils::TableOptions &options)
+    -> Expected<void> {
+  if (path.empty()) {
+    return std::unexpected(
+        make_error(Status::InvalidPath, "Invalid JSON path (empty)."));
+  }
+
+  std::ofstream file(std::string{path}, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    return std::unexpected(
+        make_error(Status::FileError,
+                   std::format("Failed to open JSON file '{}'.", path)));
+  }
+
+  JsonExporter::write(file, tree, format, options);
+  if (!file.good()) {
+    return std::unexpected(make_error(
+        Status::FileError,
+        std::format("Writing error occurred for '{}'.", path)));
+  }
+  return {};
+}
+
+void test_json_exporter() {
+
+  using TreeUtils::TagTuple;
+  using TreeUtils::TagType;
+
+  // Escaping
+  std::string escaped;
+  JsonExporter::escape("a\"b\\c\nd\x01 é", escaped);
+  assert(escaped == "a\\\"b\\\\c\\nd\\u0001 é");
+
+  auto tree = TreeUtils::process(std::vector<TagTuple>{
+      {"svg", {{"width", "10"}}, TagType::Open},
+      {"g", {}, TagType::Open},
+      {"g", {}, TagType::Open},
+      {"rect", {{"fill", "red"}, {"title", "say \"hi\""}}, TagType::SelfClose},
+      {"g", {}, TagType::Close},
+      {"g", {}, TagType::Close},
+      {"circle", {}, TagType::SelfClose},
+      {"svg", {}, TagType::Close}});
+
+  // Nested: subtrees closed from the depths alone
+  std::ostringstream nested;
+  JsonExporter::write(nested, tree, Format::Tree);
+  assert(nested.str() ==
+         R"({"id":0,"tag":"svg","attributes":{"width":"10"},"children":[)"
+         R"({"id":1,"tag":"g","attributes":{},"children":[)"
+         R"({"id":2,"tag":"g","attributes":{},"children":[)"
+         R"({"id":3,"tag":"rect",)"
+         R"("attributes":{"fill":"red","title":"say \"hi\""}}]}]},)"
+         R"({"id":4,"tag":"circle","attributes":{}}]})"
+         "\n");
+
+  // One line per element
+  tree.root->children[1]->bbox = svg_core::BBox{0, 0, 2.5, 3};
+  std::ostringstream lines;
+  JsonExporter::write(lines, tree, Format::Lines, {.bbox = true});
+  std::istringstream read{lines.str()};
+  std::string line;
+  std::vector<std::string> got;
+  while (std::getline(read, line))
+    got.push_back(line);
+  assert(got.size() == 5);
+  assert(got[0] == R"({"id":0,"parent":-1,"depth":0,"tag":"svg",)"
+                   R"("attributes":{"width":"10"},"bbox":null})");
+  assert(got[4] == R"({"id":4,"parent":0,"depth":1,"tag":"circle",)"
+                   R"("attributes":{},"bbox":[0,0,2.5,3]})");
+
+  // Contents, with the option only
+  std::string_view source{"<circle><!--x-->\"a\"</circle>"};
+  auto *circle = tree.index.nodes[4];
+  circle->contents = {{svg_core::Content::Kind::Comment, 12, 13, 4, 0},
+                      {svg_core::Content::Kind::Text, 16, 19, 4, 0}};
+  tree.source = source;
+  std::ostringstream texts;
+  JsonExporter::write(texts, tree, Format::Lines, {.content = true});
+  assert(texts.str().ends_with(
+      R"("attributes":{},"content":[{"kind":"#comment","after":0,"text":"x"},)"
+      R"({"kind":"#text","after":0,"text":"\"a\""}]})"
+      "\n"));
+  std::ostringstream plain;
+  JsonExporter::write(plain, tree, Format::Lines);
+  assert(plain.str().find("content") == std::string::npos);
+
+  // Empty tree
+  std::ostringstream empty;
+  JsonExporter::write(empty, {}, Format::Tree);
+  assert(empty.str() == "null\n");
+  assert(JsonExporter::save("", tree, Format::Lines).error().status ==
+         Status::InvalidPath);
+
+  std::println("{}[TEST]{} : {} : test completed", color::green, color::reset,
+               __PRETTY_FUNCTION__);
+}
+
+#ifdef BUILD_TEST_EXE
+auto main() -> int {
+
+  test_json_exporter();
+
+  return 0;
+}
+#endif
@@ -0,0 +1,283 @@
+#include "number_utils.hpp"
+
+#include <array>
+#include <cassert>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <print>
+#include <utility>
+
+namespace {
+
+constexpr std::array<std::pair<std::string_view, svg_core::Unit>, 9> units{{
+    {"px", svg_core::Unit::Px},
+    {"pt", svg_core::Unit::Pt},
+    {"pc", svg_core::Unit::Pc},
+    {"mm", svg_core::Unit::Mm},
+    {"cm", svg_core::Unit::Cm},
+    {"in", svg_core::Unit::In},
+    {"em", svg_core::Unit::Em},
+    {"ex", svg_core::Unit::Ex},
+    {"%", svg_core::Unit::Percent},
+}};
+
+auto trim(std::string_view str) -> std::string_view {
+  auto is_space = [](char ch) {
+    return std::isspace(static_cast<unsigned char>(ch)) != 0;
+  };
+  while (!str.empty() && is_space(str.front()))
+    str.remove_prefix(1);
+  while (!str.empty() && is_space(str.back()))
+    str.remove_suffix(1);
+  return str;
+}
+
+auto iequals(std::string_view a, std::string_view b) -> bool {
+  if (a.size() != b.size())
+    return false;
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    if (std::tolower(static_cast<unsigned char>(a[i])) != b[i])
+      return false;
+  }
+  return true;
+}
+
+// Number at the start of str; rest receives what follows it.
+auto leading_number(std::string_view str, std::string_view &rest)
+    -> std::optional<double> {
+  // from_chars does not accept an explicit '+'
+  if (str.starts_with('+')) {
+    str.remove_prefix(1);
+    if (str.starts_with('+') || str.starts_with('-'))
+      return std::nullopt;
+  }
+
+  double value{0.0};
+  auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value,
+                                   std::chars_format::general);
+  if (ec != std::errc{} || !std::isfinite(value))
+    return std::nullopt;
+
+  rest = str.substr(static_cast<std::size_t>(ptr - str.data()));
+  return value;
+}
+
+// Length of the number at the start of str (0 if none); fraction tells
+// whether it has a point or an exponent
+auto number_length(std::string_view str, bool &fraction) -> std::size_t {
+  auto digits = [&str](std::size_t i) {
+    while (i < str.size() && str[i] >= '0' && str[i] <= '9')
+      ++i;
+    return i;
+  };
+
+  std::size_t i = 0;
+  if (i < str.size() && (str[i] == '+' || str[i] == '-'))
+    ++i;
+  const auto begin = i;
+  i = digits(i);
+  bool any = i > begin;
+  fraction = false;
+  if (i < str.size() && str[i] == '.') {
+    const auto point = i;
+    i = digits(i + 1);
+    any = any || i > point + 1;
+    fraction = true;
+  }
+  if (!any)
+    return 0;
+
+  // Exponent only if followed by digits (not the 'e' of "em")
+  if (i < str.size() && (str[i] == 'e' || str[i] == 'E')) {
+    auto j = i + 1;
+    if (j < str.size() && (str[j] == '+' || str[j] == '-'))
+      ++j;
+    const auto end = digits(j);
+    if (end > j) {
+      i = end;
+      fraction = true;
+    }
+  }
+  return i;
+}
+
+} // namespace
+
+auto NumberUtils::parse_number(std::string_view str) -> std::optional<double> {
+  std::string_view rest;
+  auto value = leading_number(trim(str), rest);
+  if (!value || !rest.empty())
+    return std::nullopt;
+  return value;
+}
+
+auto NumberUtils::parse_length(std::string_view str) -> std::optional<Length> {
+  std::string_view rest;
+  auto value = leading_number(trim(str), rest);
+  if (!value)
+    return std::nullopt;
+
+  if (rest.empty())
+    return Length{*value, Unit::None};
+
+  for (const auto &[name, unit] : units) {
+    if (iequals(rest, name))
+      return Length{*value, unit};
+  }
+
+  return std::nullopt;
+}
+
+auto NumberUtils::to_px(const Length &length, double reference,
+                        double font_size) -> double {
+  switch (length.unit) {
+  case Unit::None:
+  case Unit::Px:
+    return length.value;
+  case Unit::Pt:
+    return length.value * 96.0 / 72.0;
+  case Unit::Pc:
+    return length.value * 16.0;
+  case Unit::Mm:
+    return length.value * 96.0 / 25.4;
+  case Unit::Cm:
+    return length.value * 96.0 / 2.54;
+  case Unit::In:
+    return length.value * 96.0;
+  case Unit::Em:
+    return length.value * font_size;
+  case Unit::Ex:
+    return length.value * font_size / 2.0;
+  case Unit::Percent:
+    return length.value * reference / 100.0;
+  }
+  return length.value;
+}
+
+auto NumberUtils::unit_name(Unit unit) -> std::string_view {
+  for (const auto &[name, value] : units) {
+    if (value == unit)
+      return name;
+  }
+  return {};
+}
+
+void NumberUtils::round_numbers(std::string_view text, int decimals,
+                                std::string &out) {
+  out.clear();
+  std::array<char, 352> buffer{}; // fixed notation of any double
+  bool previous_number{false};     // out ends with a number
+  bool previous_point{false};      // ... that has a point
+
+  std::size_t i = 0;
+  while (i < text.size()) {
+    bool fraction{false};
+    const auto length = number_length(text.substr(i), fraction);
+    if (length == 0) {
+      out += text[i++];
+      previous_number = false;
+      continue;
+    }
+
+    const auto token = text.substr(i, length);
+    std::string_view written = token;
+    if (fraction) {
+      // from_chars does not accept an explicit '+'
+      const auto digits = token.starts_with('+') ? token.substr(1) : token;
+      double value{0.0};
+      std::from_chars(digits.data(), digits.data() + digits.size(), value);
+      auto [end, ec] =
+          std::to_chars(buffer.data(), buffer.data() + buffer.size(), value,
+                        std::chars_format::fixed, decimals);
+      std::string_view rounded{buffer.data(),
+                               static_cast<std::size_t>(end - buffer.data())};
+      if (rounded.find('.') != std::string_view::npos) {
+        while (rounded.ends_with('0'))
+          rounded.remove_suffix(1);
+        if (rounded.ends_with('.'))
+          rounded.remove_suffix(1);
+      }
+      if (rounded == "-0")
+        rounded = "0";
+
+      double exact{0.0};
+      std::from_chars(rounded.data(), rounded.data() + rounded.size(), exact);
+      // Same value written shorter (e.g. "1e5"): keep it
+      if (ec != std::errc{} ||
+          (exact == value && token.size() <= rounded.size()))
+        rounded = token;
+      written = rounded;
+    }
+
+    // "1" then "0.5" must not become "10.5"
+    const bool digit_first = written.front() >= '0' && written.front() <= '9';
+    if (previous_number &&
+        (digit_first || (written.front() == '.' && !previous_point)))
+      out += ' ';
+    out += written;
+    previous_number = true;
+    previous_point = written.find_first_of(".eE") != std::string_view::npos;
+    i += length;
+  }
+}
+
+void test_number_utils() {
+
+  using NumberUtils::Length;
+  using NumberUtils::parse_length;
+  using NumberUtils::parse_number;
+  using NumberUtils::to_px;
+  using NumberUtils::Unit;
+
+  // Numbers
+  assert(parse_number("25") == 25.0);
+  assert(parse_number(" -1.5e2 ") == -150.0);
+  assert(parse_number("+.5") == 0.5);
+  assert(!parse_number(""));
+  assert(!parse_number("abc"));
+  assert(!parse_number("10px"));
+  assert(!parse_number("++1"));
+  assert(!parse_number("inf"));
+
+  // Lengths
+  assert(parse_length("10") == (Length{10.0, Unit::None}));
+  assert(parse_length("2mm") == (Length{2.0, Unit::Mm}));
+  assert(parse_length("50%") == (Length{50.0, Unit::Percent}));
+  assert(parse_length("1.5PX") == (Length{1.5, Unit::Px}));
+  assert(!parse_length("10 px"));
+  assert(!parse_length("10furlongs"));
+  assert(!parse_length("lightblue"));
+
+  // Conversion
+  assert(to_px({1.0, Unit::In}) == 96.0);
+  assert(to_px({50.0, Unit::Percent}, 300.0) == 150.0);
+  assert(to_px({2.0, Unit::Em}, 0.0, 10.0) == 20.0);
+  assert(NumberUtils::unit_name(Unit::Percent) == "%");
+
+  // Rounded numeric values
+  std::string rounded;
+  auto round = [&rounded](std::string_view text, int decimals) {
+    NumberUtils::round_numbers(text, decimals, rounded);
+    return rounded;
+  };
+  assert(round("M10.1234,5L.0001 3", 2) == "M10.12,5L0 3");
+  assert(round("translate(0.333333 -1.999999)", 3) == "translate(0.333 -2)");
+  assert(round("1.0001.5", 2) == "1 .5"); // would read 1.5
+  assert(round("1.26-0.0001", 1) == "1.3 0"); // would read 1.30
+  assert(round("a1 1 0 011 2.6e0", 0) == "a1 1 0 011 3");
+  assert(round("1.5e5 2em 10.56px", 1) == "1.5e5 2em 10.6px");
+  assert(round("", 3).empty());
+
+  std::println("{}[TEST]{} : {} : test completed", color::green, color::reset,
+               __PRETTY_FUNCTION__);
+}
+
+#ifdef BUILD_TEST_EXE
+auto main() -> int {
+
+  test_number_utils();
+
+  return 0;
+}
+#endif
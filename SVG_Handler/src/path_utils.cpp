@@ -0,0 +1,478 @@
+#include "path_utils.hpp"
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <print>
+
+using svg_core::make_error;
+using svg_core::Status;
+
+namespace {
+
+constexpr std::array<double, 23> pow10{
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+constexpr std::uint64_t max_exact = std::uint64_t{1} << 53;
+
+auto is_digit(char ch) -> bool { return ch >= '0' && ch <= '9'; }
+
+auto is_separator(char ch) -> bool {
+  return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '\f' ||
+         ch == ',';
+}
+
+// True if the 8 bytes are all ASCII digits.
+auto all_digits(std::uint64_t chunk) -> bool {
+  return ((chunk & 0xF0F0F0F0F0F0F0F0) |
+          (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) ==
+         0x3333333333333333;
+}
+
+// Value of 8 ASCII digits loaded little-endian (SWAR).
+auto eight_digits(std::uint64_t chunk) -> std::uint64_t {
+  chunk -= 0x3030303030303030;
+  chunk = (chunk * 10) + (chunk >> 8);
+  chunk = (((chunk & 0x000000FF000000FF) * 0x000F424000000064) +
+           (((chunk >> 16) & 0x000000FF000000FF) * 0x0000271000000001)) >>
+          32;
+  return chunk;
+}
+
+// Accumulate a run of digits into mantissa (at most 19 significant digits).
+// Returns the position after the run; dropped counts digits that did not fit.
+auto read_digits(const char *p, const char *last, std::uint64_t &mantissa,
+                 int &digits, int &dropped) -> const char * {
+  if constexpr (std::endian::native == std::endian::little) {
+    while (last - p >= 8 && digits + 8 <= 19) {
+      std::uint64_t chunk;
+      std::memcpy(&chunk, p, sizeof(chunk));
+      if (!all_digits(chunk))
+        break;
+      mantissa = mantissa * 100000000 + eight_digits(chunk);
+      digits += (mantissa == 0) ? 0 : 8;
+      p += 8;
+    }
+  }
+
+  for (; p < last && is_digit(*p); ++p) {
+    if (digits < 19) {
+      mantissa = mantissa * 10 + static_cast<std::uint64_t>(*p - '0');
+      digits += (mantissa == 0) ? 0 : 1;
+    } else {
+      ++dropped;
+    }
+  }
+  return p;
+}
+
+} // namespace
+
+auto PathUtils::arity(char command) -> int {
+  switch (command) {
+  case 'M':
+  case 'm':
+  case 'L':
+  case 'l':
+  case 'T':
+  case 't':
+    return 2;
+  case 'H':
+  case 'h':
+  case 'V':
+  case 'v':
+    return 1;
+  case 'C':
+  case 'c':
+    return 6;
+  case 'S':
+  case 's':
+  case 'Q':
+  case 'q':
+    return 4;
+  case 'A':
+  case 'a':
+    return 7;
+  case 'Z':
+  case 'z':
+    return 0;
+  default:
+    return -1;
+  }
+}
+
+auto PathUtils::parse_number(std::string_view str, double &value)
+    -> std::size_t {
+  const char *first = str.data();
+  const char *last = str.data() + str.size();
+  const char *p = first;
+
+  bool negative{false};
+  if (p < last && (*p == '+' || *p == '-')) {
+    negative = (*p == '-');
+    ++p;
+  }
+
+  std::uint64_t mantissa{0};
+  int digits{0};
+  int dropped{0};
+
+  // Integer part
+  const char *int_begin = p;
+  p = read_digits(p, last, mantissa, digits, dropped);
+  bool has_digits = (p != int_begin);
+  int exponent = dropped;
+
+  // Fraction part
+  if (p < last && *p == '.') {
+    const char *frac_begin = ++p;
+    int dropped_frac{0};
+    p = read_digits(p, last, mantissa, digits, dropped_frac);
+    if (p != frac_begin)
+      has_digits = true;
+    exponent -= static_cast<int>(p - frac_begin) - dropped_frac;
+    dropped += dropped_frac;
+  }
+
+  if (!has_digits)
+    return 0;
+
+  // Exponent (only if followed by digits, e.g. not the 'e' of a unit)
+  if (p < last && (*p == 'e' || *p == 'E')) {
+    const char *q = p + 1;
+    bool exp_negative{false};
+    if (q < last && (*q == '+' || *q == '-')) {
+      exp_negative = (*q == '-');
+      ++q;
+    }
+    if (q < last && is_digit(*q)) {
+      int exp_value{0};
+      for (; q < last && is_digit(*q); ++q) {
+        if (exp_value < 10000)
+          exp_value = exp_value * 10 + (*q - '0');
+      }
+      exponent += exp_negative ? -exp_value : exp_value;
+      p = q;
+    }
+  }
+
+  // Exact when mantissa and power of ten are both exact doubles
+  if (dropped == 0 && mantissa <= max_exact && exponent >= -22 &&
+      exponent <= 22) {
+    auto result = static_cast<double>(mantissa);
+    result = (exponent < 0)
+                 ? result / pow10[static_cast<std::size_t>(-exponent)]
+                 : result * pow10[static_cast<std::size_t>(exponent)];
+    value = negative ? -result : result;
+    return static_cast<std::size_t>(p - first);
+  }
+
+  // Slow path
+  const char *from = (first < last && *first == '+') ? first + 1 : first;
+  double result{0.0};
+  auto [ptr, ec] = std::from_chars(from, p, result, std::chars_format::general);
+  if (ec != std::errc{} || ptr != p)
+    return 0;
+  value = result;
+  return static_cast<std::size_t>(p - first);
+}
+
+auto PathUtils::parse(std::string_view d) -> Expected<PathData> {
+  PathData path;
+  auto parsed = PathUtils::parse(d, path);
+  if (!parsed)
+    return std::unexpected(parsed.error());
+  return path;
+}
+
+auto PathUtils::parse(std::string_view d, PathData &path) -> Expected<void> {
+  path.commands.clear();
+  path.args.clear();
+
+  std::size_t pos{0};
+  auto skip = [&]() {
+    while (pos < d.size() && is_separator(d[pos]))
+      ++pos;
+  };
+
+  auto fail = [&d](std::string message, std::size_t offset) {
+    return std::unexpected(
+        make_error(Status::InvalidPathData, std::move(message), d, offset));
+  };
+
+  char current{0};
+  skip();
+  while (pos < d.size()) {
+    const char ch = d[pos];
+    const bool is_command = PathUtils::arity(ch) >= 0;
+
+    if (is_command) {
+      if (current == 0 && ch != 'M' && ch != 'm')
+        return fail("Path data must start with a moveto.", pos);
+      current = ch;
+      ++pos;
+      skip();
+    } else if (current == 0 || current == 'Z' || current == 'z') {
+      return fail(std::format("Expected a path command, got '{}'.", ch), pos);
+    }
+
+    path.commands.push_back(current);
+
+    const int count = PathUtils::arity(current);
+    for (int i = 0; i < count; ++i) {
+      if (pos >= d.size())
+        return fail(std::format("Missing argument for '{}'.", current), pos);
+
+      double value{0.0};
+      const bool is_flag =
+          (current == 'A' || current == 'a') && (i == 3 || i == 4);
+      if (is_flag) {
+        // Flags are a single '0' or '1' and need no separator
+        if (d[pos] != '0' && d[pos] != '1')
+          return fail("Arc flag must be 0 or 1.", pos);
+        value = (d[pos] == '1') ? 1.0 : 0.0;
+        ++pos;
+      } else {
+        auto used = PathUtils::parse_number(d.substr(pos), value);
+        if (used == 0)
+          return fail(std::format("Invalid number for '{}'.", current), pos);
+        pos += used;
+      }
+      path.args.push_back(value);
+      skip();
+    }
+
+    // Implicit repeats of a moveto are linetos
+    if (current == 'M')
+      current = 'L';
+    else if (current == 'm')
+      current = 'l';
+  }
+
+  return {};
+}
+
+auto PathUtils::absolute(const PathData &path) -> PathData {
+  PathData out;
+  out.commands.reserve(path.commands.size());
+  out.args.reserve(path.args.size());
+
+  double cx{0.0}, cy{0.0}; // current point
+  double sx{0.0}, sy{0.0}; // subpath start
+  double qx{0.0}, qy{0.0}; // last control point (C/S or Q/T)
+  char previous{0};        // last absolute command written
+
+  auto emit = [&out](char command, std::initializer_list<double> args) {
+    out.commands.push_back(command);
+    out.args.insert(out.args.end(), args);
+  };
+
+  std::size_t a{0};
+  for (char command : path.commands) {
+    const double *v = path.args.data() + a;
+    a += static_cast<std::size_t>(PathUtils::arity(command));
+
+    const bool rel = (command >= 'a' && command <= 'z');
+    const double ox = rel ? cx : 0.0;
+    const double oy = rel ? cy : 0.0;
+
+    switch (command) {
+    case 'M':
+    case 'm':
+      cx = sx = v[0] + ox;
+      cy = sy = v[1] + oy;
+      emit('M', {cx, cy});
+      break;
+    case 'L':
+    case 'l':
+      cx = v[0] + ox;
+      cy = v[1] + oy;
+      emit('L', {cx, cy});
+      break;
+    case 'H':
+    case 'h':
+      cx = v[0] + ox;
+      emit('L', {cx, cy});
+      break;
+    case 'V':
+    case 'v':
+      cy = v[0] + (rel ? cy : 0.0);
+      emit('L', {cx, cy});
+      break;
+    case 'C':
+    case 'c':
+      qx = v[2] + ox;
+      qy = v[3] + oy;
+      emit('C', {v[0] + ox, v[1] + oy, qx, qy, v[4] + ox, v[5] + oy});
+      cx = v[4] + ox;
+      cy = v[5] + oy;
+      break;
+    case 'S':
+    case 's': {
+      double x1 = (previous == 'C') ? 2 * cx - qx : cx;
+      double y1 = (previous == 'C') ? 2 * cy - qy : cy;
+      qx = v[0] + ox;
+      qy = v[1] + oy;
+      emit('C', {x1, y1, qx, qy, v[2] + ox, v[3] + oy});
+      cx = v[2] + ox;
+      cy = v[3] + oy;
+      break;
+    }
+    case 'Q':
+    case 'q':
+      qx = v[0] + ox;
+      qy = v[1] + oy;
+      emit('Q', {qx, qy, v[2] + ox, v[3] + oy});
+      cx = v[2] + ox;
+      cy = v[3] + oy;
+      break;
+    case 'T':
+    case 't':
+      qx = (previous == 'Q') ? 2 * cx - qx : cx;
+      qy = (previous == 'Q') ? 2 * cy - qy : cy;
+      emit('Q', {qx, qy, v[0] + ox, v[1] + oy});
+      cx = v[0] + ox;
+      cy = v[1] + oy;
+      break;
+    case 'A':
+    case 'a':
+      emit('A', {v[0], v[1], v[2], v[3], v[4], v[5] + ox, v[6] + oy});
+      cx = v[5] + ox;
+      cy = v[6] + oy;
+      break;
+    case 'Z':
+    case 'z':
+      emit('Z', {});
+      cx = sx;
+      cy = sy;
+      break;
+    default:
+      break;
+    }
+    previous = out.commands.back();
+  }
+
+  return out;
+}
+
+auto PathUtils::serialize(const PathData &path) -> std::string {
+  std::string d;
+  serialize(path, d);
+  return d;
+}
+
+void PathUtils::serialize(const PathData &path, std::string &d) {
+  d.clear();
+  std::array<char, 32> buffer{};
+
+  std::size_t a{0};
+  for (char command : path.commands) {
+    d.push_back(command);
+    const auto count = static_cast<std::size_t>(PathUtils::arity(command));
+    for (std::size_t i = 0; i < count; ++i) {
+      if (i > 0)
+        d.push_back(',');
+      auto [end, ec] = std::to_chars(buffer.data(),
+                                     buffer.data() + buffer.size(),
+                                     path.args[a + i]);
+      d.append(buffer.data(), end);
+    }
+    a += count;
+  }
+}
+
+void test_path_utils() {
+
+  using PathUtils::absolute;
+  using PathUtils::parse;
+  using PathUtils::parse_number;
+  using PathUtils::PathData;
+
+  // Numbers
+  auto number = [](std::string_view str) {
+    double value{0.0};
+    auto used = parse_number(str, value);
+    return std::pair{used, value};
+  };
+  assert(number("10") == std::pair(std::size_t{2}, 10.0));
+  assert(number("-2.5,") == std::pair(std::size_t{4}, -2.5));
+  assert(number(".5.5") == std::pair(std::size_t{2}, 0.5));
+  assert(number("1e2") == std::pair(std::size_t{3}, 100.0));
+  assert(number("1E-2x") == std::pair(std::size_t{4}, 0.01));
+  assert(number("3em") == std::pair(std::size_t{1}, 3.0));
+  assert(number("+0.000123") == std::pair(std::size_t{9}, 0.000123));
+  assert(number("123456789012.5") ==
+         std::pair(std::size_t{14}, 123456789012.5));
+  assert(number("3.14159265358979323846").second == 3.14159265358979323846);
+  assert(number("0.1").second == 0.1);
+  assert(number("1e300").second == 1e300);
+  assert(number("-").first == 0);
+  assert(number(".").first == 0);
+  assert(number("x").first == 0);
+
+  // Commands and implicit repeats
+  auto p1 = parse("M10 10 L20 20");
+  assert(p1 && *p1 == (PathData{{'M', 'L'}, {10, 10, 20, 20}}));
+
+  auto p2 = parse("M0,0 10,10 20,0z");
+  assert(p2 && *p2 == (PathData{{'M', 'L', 'L', 'z'}, {0, 0, 10, 10, 20, 0}}));
+
+  auto p3 = parse("m1-2.5.5.5");
+  assert(p3 && *p3 == (PathData{{'m', 'l'}, {1, -2.5, 0.5, 0.5}}));
+
+  auto p4 = parse("M0 0a25 25 0 1050 0");
+  assert(p4 && p4->commands == (std::vector<char>{'M', 'a'}));
+  assert(p4->args == (std::vector<double>{0, 0, 25, 25, 0, 1, 0, 50, 0}));
+
+  auto p5 = parse("M 1 1 C 1 2 3 4 5 6 S 7 8 9 10 Q 1 1 2 2 T 3 3 H 4 V 5 Z");
+  assert(p5 && p5->commands.size() == 8 && p5->args.size() == 20);
+
+  // Errors
+  assert(parse("").value().commands.empty());
+  assert(parse("L10 10").error().status == Status::InvalidPathData);
+  assert(parse("M10").error().offset == 3);
+  assert(parse("M10 10 X").error().offset == 7);
+  assert(parse("M0 0 A1 1 0 2 0 5 5").error().offset == 12);
+  assert(!parse("M0 0 z 1 1"));
+
+  // Absolute form
+  auto a1 = absolute(*parse("m10 10 h5 v5 l-5 0 z m1 1 l1 1"));
+  assert(a1 == (PathData{{'M', 'L', 'L', 'L', 'Z', 'M', 'L'},
+                         {10, 10, 15, 10, 15, 15, 10, 15, 11, 11, 12, 12}}));
+
+  auto a2 = absolute(*parse("M0 0 C0 10 10 10 10 0 s10 -10 10 0"));
+  assert(a2.commands == (std::vector<char>{'M', 'C', 'C'}));
+  assert(a2.args == (std::vector<double>{0, 0, 0, 10, 10, 10, 10, 0, 10, -10,
+                                         20, -10, 20, 0}));
+
+  auto a3 = absolute(*parse("M0 0 Q5 5 10 0 t10 0"));
+  assert(a3.args == (std::vector<double>{0, 0, 5, 5, 10, 0, 15, -5, 20, 0}));
+
+  // Reused buffer
+  PathData buffer;
+  assert(parse("M1 2 3 4", buffer) && buffer.args.size() == 4);
+  assert(parse("M5 6", buffer) && buffer == (PathData{{'M'}, {5, 6}}));
+
+  // Serialization round trip
+  auto d = PathUtils::serialize(a1);
+  assert(d == "M10,10L15,10L15,15L10,15ZM11,11L12,12");
+  assert(parse(d) == a1);
+  assert(PathUtils::serialize(*parse("M0.1 -2e-7")) == "M0.1,-2e-07");
+
+  std::println("{}[TEST]{} : {} : test completed", color::green, color::reset,
+               __PRETTY_FUNCTION__);
+}
+
+#ifdef BUILD_TEST_EXE
+auto main() -> int {
+
+  test_path_utils();
+
+  return 0;
+}
+#endif
@@ -0,0 +1,495 @@
+#include "query_utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <print>
+
+using QueryUtils::Condition;
+using QueryUtils::Query;
+using QueryUtils::Selector;
+using QueryUtils::Step;
+using svg_core::make_error;
+using svg_core::Status;
+
+namespace {
+
+auto is_space(char ch) -> bool {
+  return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '\f';
+}
+
+auto is_name(char ch) -> bool {
+  return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+         (ch >= '0' && ch <= '9') || ch == '-' || ch == '_' || ch == ':';
+}
+
+// Cursor over the query text, shared by the CSS and XPath parsers.
+class Parser {
+public:
+  explicit Parser(std::string_view query) : query_(query) {}
+
+  auto css() -> svg_core::Expected<Query> {
+    Query result;
+    while (true) {
+      skip_spaces();
+      auto selector = css_selector();
+      if (!selector)
+        return std::unexpected(selector.error());
+      result.push_back(std::move(*selector));
+      if (done())
+        return result;
+      ++pos_; // ','
+    }
+  }
+
+  auto xpath() -> svg_core::Expected<Query> {
+    Query result;
+    while (true) {
+      skip_spaces();
+      auto selector = xpath_selector();
+      if (!selector)
+        return std::unexpected(selector.error());
+      result.push_back(std::move(*selector));
+      if (done())
+        return result;
+      ++pos_; // '|'
+    }
+  }
+
+private:
+  std::string_view query_;
+  std::size_t pos_{0};
+
+  auto fail(std::string message) const -> std::unexpected<svg_core::Error> {
+    return std::unexpected(
+        make_error(Status::InvalidQuery, std::move(message), query_, pos_));
+  }
+
+  auto done() const -> bool { return pos_ >= query_.size(); }
+  auto peek() const -> char { return done() ? '\0' : query_[pos_]; }
+
+  auto skip_spaces() -> bool {
+    const auto start = pos_;
+    while (!done() && is_space(query_[pos_]))
+      ++pos_;
+    return pos_ != start;
+  }
+
+  auto name() -> std::string_view {
+    const auto start = pos_;
+    while (!done() && is_name(query_[pos_]))
+      ++pos_;
+    return query_.substr(start, pos_ - start);
+  }
+
+  // Quoted string or bare name
+  auto value() -> svg_core::Expected<std::string> {
+    const char quote = peek();
+    if (quote != '"' && quote != '\'')
+      return std::string(name());
+
+    const auto start = ++pos_;
+    const auto end = query_.find(quote, start);
+    if (end == std::string_view::npos)
+      return fail("Unterminated string.");
+    pos_ = end + 1;
+    return std::string(query_.substr(start, end - start));
+  }
+
+  auto css_selector() -> svg_core::Expected<Selector> {
+    Selector selector;
+    auto axis = Step::Axis::Descendant;
+
+    while (true) {
+      Step step{.axis = axis, .tag = {}, .conditions = {}};
+      auto compound = css_compound(step);
+      if (!compound)
+        return std::unexpected(compound.error());
+      selector.steps.push_back(std::move(step));
+
+      const bool spaced = skip_spaces();
+      if (done() || peek() == ',')
+        return selector;
+
+      if (peek() == '>') {
+        ++pos_;
+        skip_spaces();
+        axis = Step::Axis::Child;
+      } else if (spaced) {
+        axis = Step::Axis::Descendant;
+      } else {
+        return fail(std::format("Unexpected '{}'.", peek()));
+      }
+    }
+  }
+
+  auto css_compound(Step &step) -> svg_core::Expected<void> {
+    const auto start = pos_;
+
+    if (peek() == '*')
+      ++pos_;
+    else
+      step.tag = name();
+
+    while (!done()) {
+      const char ch = peek();
+      if (ch == '#' || ch == '.') {
+        ++pos_;
+        auto id = name();
+        if (id.empty())
+          return fail("Expected a name.");
+        step.conditions.push_back(
+            {ch == '#' ? Condition::Kind::Id : Condition::Kind::Class,
+             std::string(id), {}});
+      } else if (ch == '[') {
+        ++pos_;
+        auto condition = attribute(false);
+        if (!condition)
+          return std::unexpected(condition.error());
+        step.conditions.push_back(std::move(*condition));
+      } else {
+        break;
+      }
+    }
+
+    if (pos_ == start)
+      return fail("Expected a selector.");
+    return {};
+  }
+
+  // Inside '[...]', after '['. XPath requires '@' and only supports '='.
+  auto attribute(bool xpath) -> svg_core::Expected<Condition> {
+    skip_spaces();
+    if (xpath) {
+      if (peek() != '@')
+        return fail("Expected '@attribute' (positions are not supported).");
+      ++pos_;
+    }
+
+    Condition condition{.kind = Condition::Kind::Has,
+                        .name = std::string(name()),
+                        .value = {}};
+    if (condition.name.empty())
+      return fail("Expected an attribute name.");
+    skip_spaces();
+
+    if (peek() != ']') {
+      switch (peek()) {
+      case '=':
+        condition.kind = Condition::Kind::Equals;
+        break;
+      case '^':
+        condition.kind = Condition::Kind::Prefix;
+        break;
+      case '$':
+        condition.kind = Condition::Kind::Suffix;
+        break;
+      case '*':
+        condition.kind = Condition::Kind::Contains;
+        break;
+      default:
+        return fail("Expected '=' or ']'.");
+      }
+      if (condition.kind != Condition::Kind::Equals) {
+        if (xpath)
+          return fail("Only '=' is supported in XPath predicates.");
+        ++pos_;
+        if (peek() != '=')
+          return fail("Expected '='.");
+      }
+      ++pos_;
+      skip_spaces();
+
+      auto text = value();
+      if (!text)
+        return std::unexpected(text.error());
+      condition.value = std::move(*text);
+      skip_spaces();
+    }
+
+    if (peek() != ']')
+      return fail("Expected ']'.");
+    ++pos_;
+    return condition;
+  }
+
+  auto xpath_selector() -> svg_core::Expected<Selector> {
+    Selector selector;
+
+    while (true) {
+      if (peek() != '/')
+        return fail("Expected '/' or '//'.");
+      ++pos_;
+
+      Step step;
+      if (peek() == '/') {
+        ++pos_;
+        step.axis = Step::Axis::Descendant;
+      } else {
+        step.axis = Step::Axis::Child;
+        selector.rooted = selector.rooted || selector.steps.empty();
+      }
+
+      if (peek() == '*')
+        ++pos_;
+      else if (step.tag = name(); step.tag.empty())
+        return fail("Expected a name or '*'.");
+
+      while (peek() == '[') {
+        ++pos_;
+        auto condition = attribute(true);
+        if (!condition)
+          return std::unexpected(condition.error());
+        step.conditions.push_back(std::move(*condition));
+      }
+      selector.steps.push_back(std::move(step));
+
+      skip_spaces();
+      if (done() || peek() == '|')
+        return selector;
+    }
+  }
+};
+
+auto has_class(std::string_view classes, std::string_view name) -> bool {
+  std::size_t pos{0};
+  while ((pos = classes.find(name, pos)) != std::string_view::npos) {
+    const auto end = pos + name.size();
+    if ((pos == 0 || is_space(classes[pos - 1])) &&
+        (end == classes.size() || is_space(classes[end])))
+      return true;
+    pos = end;
+  }
+  return false;
+}
+
+auto matches(const Step &step, const TreeUtils::Node &node) -> bool {
+  if (!step.tag.empty() && step.tag != node.tag)
+    return false;
+
+  for (const auto &condition : step.conditions) {
+    using Kind = Condition::Kind;
+    const std::string_view name =
+        condition.kind == Kind::Id      ? "id"
+        : condition.kind == Kind::Class ? "class"
+                                        : std::string_view{condition.name};
+    const auto *value = node.attribute(name);
+    if (!value)
+      return false;
+
+    const std::string_view text{*value};
+    switch (condition.kind) {
+    case Kind::Id:
+      if (text != condition.name)
+        return false;
+      break;
+    case Kind::Class:
+      if (!has_class(text, condition.name))
+        return false;
+      break;
+    case Kind::Has:
+      break;
+    case Kind::Equals:
+      if (text != condition.value)
+        return false;
+      break;
+    case Kind::Prefix:
+      if (condition.value.empty() || !text.starts_with(condition.value))
+        return false;
+      break;
+    case Kind::Suffix:
+      if (condition.value.empty() || !text.ends_with(condition.value))
+        return false;
+      break;
+    case Kind::Contains:
+      if (condition.value.empty() ||
+          text.find(condition.value) == std::string_view::npos)
+        return false;
+      break;
+    }
+  }
+  return true;
+}
+
+// Does the element at position match steps[0..=i] (right to left)?
+auto matches(const Selector &selector, std::size_t i, std::size_t position,
+             const TreeUtils::TreeIndex &index) -> bool {
+  constexpr auto none = std::string_view::npos;
+  const auto &step = selector.steps[i];
+  if (!matches(step, *index.nodes[position]))
+    return false;
+
+  const auto parent = index.parents[position];
+  if (i == 0)
+    return !selector.rooted || parent == none;
+
+  if (step.axis == Step::Axis::Child)
+    return parent != none && matches(selector, i - 1, parent, index);
+
+  for (auto ancestor = parent; ancestor != none;
+       ancestor = index.parents[ancestor]) {
+    if (matches(selector, i - 1, ancestor, index))
+      return true;
+  }
+  return false;
+}
+
+} // namespace
+
+auto QueryUtils::parse(std::string_view query) -> Expected<Query> {
+  const auto first = query.find_first_not_of(" \t\n\r\f");
+  if (first == std::string_view::npos)
+    return std::unexpected(
+        make_error(Status::InvalidQuery, "Empty query.", query, 0));
+
+  Parser parser(query);
+  return query[first] == '/' ? parser.xpath() : parser.css();
+}
+
+void QueryUtils::select(const TreeUtils::Tree &tree, const Query &query,
+                        std::vector<std::size_t> &positions) {
+  positions.clear();
+  const auto &index = tree.index;
+
+  for (const auto &selector : query) {
+    if (selector.steps.empty())
+      continue;
+    const auto &last = selector.steps.back();
+
+    // Smallest table that holds every candidate
+    const std::vector<std::size_t> *candidates = nullptr;
+    bool found = true;
+    auto lookup = [&](const auto &table, std::string_view key) {
+      auto it = table.find(key);
+      found = it != table.end();
+      candidates = found ? &it->second : nullptr;
+    };
+
+    auto id = std::ranges::find(last.conditions, Condition::Kind::Id,
+                                &Condition::kind);
+    auto cls = std::ranges::find(last.conditions, Condition::Kind::Class,
+                                 &Condition::kind);
+    if (id != last.conditions.end())
+      lookup(index.ids, id->name);
+    else if (cls != last.conditions.end())
+      lookup(index.classes, cls->name);
+    else if (!last.tag.empty())
+      lookup(index.tags, last.tag);
+
+    if (!found)
+      continue;
+
+    const auto last_step = selector.steps.size() - 1;
+    if (candidates) {
+      for (auto position : *candidates)
+        if (matches(selector, last_step, position, index))
+          positions.push_back(position);
+    } else {
+      for (std::size_t position = 0; position < index.nodes.size(); ++position)
+        if (matches(selector, last_step, position, index))
+          positions.push_back(position);
+    }
+  }
+
+  if (query.size() > 1) {
+    std::ranges::sort(positions);
+    auto [first, last] = std::ranges::unique(positions);
+    positions.erase(first, last);
+  }
+}
+
+auto QueryUtils::select(const TreeUtils::Tree &tree, std::string_view query)
+    -> Expected<std::vector<std::size_t>> {
+  auto parsed = parse(query);
+  if (!parsed)
+    return std::unexpected(parsed.error());
+
+  std::vector<std::size_t> positions;
+  select(tree, *parsed, positions);
+  return positions;
+}
+
+void test_query_utils() {
+
+  using QueryUtils::parse;
+  using QueryUtils::select;
+  using TreeUtils::TagType;
+  using Positions = std::vector<std::size_t>;
+
+  // Parsing
+  auto css = parse("g#shapes > rect.big[fill='red'], circle");
+  assert(css && css->size() == 2);
+  assert((*css)[0].steps.size() == 2);
+  assert((*css)[0].steps[1] ==
+         (Step{Step::Axis::Child,
+               "rect",
+               {{Condition::Kind::Class, "big", ""},
+                {Condition::Kind::Equals, "fill", "red"}}}));
+
+  auto xpath = parse("/svg//g[@id=\"shapes\"]/*");
+  assert(xpath && xpath->size() == 1 && (*xpath)[0].rooted);
+  assert((*xpath)[0].steps[1].axis == Step::Axis::Descendant);
+  assert((*xpath)[0].steps[2].tag.empty());
+
+  assert(parse("").error().status == Status::InvalidQuery);
+  assert(parse("rect[x").error().offset == 6);
+  assert(!parse("rect,"));
+  assert(!parse("a > > b"));
+  assert(!parse("//rect[1]"));
+  assert(!parse("[x='1]"));
+
+  // Selection (positions are pre-order)
+  auto tree = TreeUtils::process(std::vector<TreeUtils::TagTuple>{
+      {"svg", {}, TagType::Open},                                      // 0
+      {"g", {{"id", "background"}}, TagType::Open},                    // 1
+      {"rect", {{"class", "big"}}, TagType::SelfClose},                // 2
+      {"g", {}, TagType::Close},                                       //
+      {"g", {{"id", "shapes"}}, TagType::Open},                        // 3
+      {"rect",                                                         // 4
+       {{"class", "big red"}, {"fill", "red"}},
+       TagType::SelfClose},
+      {"g", {}, TagType::Open},                                        // 5
+      {"circle", {{"fill", "lightred"}}, TagType::SelfClose},          // 6
+      {"g", {}, TagType::Close},                                       //
+      {"g", {}, TagType::Close},                                       //
+      {"svg", {}, TagType::Close}});
+
+  auto run = [&tree](std::string_view query) {
+    auto result = select(tree, query);
+    assert(result);
+    return *result;
+  };
+
+  assert(run("rect") == (Positions{2, 4}));
+  assert(run("#shapes") == (Positions{3}));
+  assert(run(".big") == (Positions{2, 4}));
+  assert(run(".red.big") == (Positions{4}));
+  assert(run(".bi").empty());
+  assert(run("g > rect") == (Positions{2, 4}));
+  assert(run("#shapes circle") == (Positions{6}));
+  assert(run("#shapes > circle").empty());
+  assert(run("svg > g > g > circle") == (Positions{6}));
+  assert(run("[fill]") == (Positions{4, 6}));
+  assert(run("[fill^=light]") == (Positions{6}));
+  assert(run("[fill$=red]") == (Positions{4, 6}));
+  assert(run("*[fill*=ght]") == (Positions{6}));
+  assert(run("circle, #background, rect") == (Positions{1, 2, 4, 6}));
+  assert(run("#missing").empty());
+
+  assert(run("/svg") == (Positions{0}));
+  assert(run("/g").empty());
+  assert(run("//g[@id='shapes']//*") == (Positions{4, 5, 6}));
+  assert(run("/svg/g/rect[@fill]") == (Positions{4}));
+  assert(run("//rect | //circle") == (Positions{2, 4, 6}));
+
+  std::println("{}[TEST]{} : {} : test completed", color::green, color::reset,
+               __PRETTY_FUNCTION__);
+}
+
+#ifdef BUILD_TEST_EXE
+auto main() -> int {
+
+  test_query_utils();
+
+  return 0;
+}
+#endif
@@ -0,0 +1,1585 @@
+#include "raster_utils.hpp"
+#include "geometry_utils.hpp"
+#include "number_utils.hpp"
+#include "path_utils.hpp"
+#include "style_utils.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <numbers>
+#include <print>
+#include <span>
+#include <sstream>
+#include <thread>
+
+using RasterUtils::Color;
+using RasterUtils::Image;
+using svg_core::make_error;
+using svg_core::Matrix;
+using svg_core::Status;
+
+namespace {
+
+// Pixels per side of the tiles rendered in parallel
+constexpr int tile_size = 64;
+
+// Sub-scanlines per pixel row
+constexpr int samples = 4;
+
+// Largest distance between a curve and its flattened form, in pixels
+constexpr double flatness = 0.2;
+
+// Largest image side accepted
+constexpr int max_size = 16384;
+
+// Properties read from Node::style, in this order
+enum Slot : std::size_t {
+  Fill,
+  FillOpacity,
+  FillRule,
+  Stroke,
+  StrokeWidth,
+  StrokeOpacity,
+  StrokeLinecap,
+  StrokeLinejoin,
+  StrokeMiterlimit,
+  Opacity,
+  Display,
+  Visibility,
+  CurrentColor,
+  StopColor,
+  StopOpacity
+};
+
+constexpr std::array<std::string_view, 15> style_properties{
+    "fill",           "fill-opacity",      "fill-rule",
+    "stroke",         "stroke-width",      "stroke-opacity",
+    "stroke-linecap", "stroke-linejoin",   "stroke-miterlimit",
+    "opacity",        "display",           "visibility",
+    "color",          "stop-color",        "stop-opacity"};
+
+struct NamedColor {
+  std::string_view name;
+  std::uint32_t rgb;
+};
+
+// CSS color keywords, sorted by name for binary search
+constexpr auto named_colors = std::to_array<NamedColor>({
+    {"aliceblue", 0xf0f8ff},      {"antiquewhite", 0xfaebd7},
+    {"aqua", 0x00ffff},           {"aquamarine", 0x7fffd4},
+    {"azure", 0xf0ffff},          {"beige", 0xf5f5dc},
+    {"bisque", 0xffe4c4},         {"black", 0x000000},
+    {"blanchedalmond", 0xffebcd}, {"blue", 0x0000ff},
+    {"blueviolet", 0x8a2be2},     {"brown", 0xa52a2a},
+    {"burlywood", 0xdeb887},      {"cadetblue", 0x5f9ea0},
+    {"chartreuse", 0x7fff00},     {"chocolate", 0xd2691e},
+    {"coral", 0xff7f50},          {"cornflowerblue", 0x6495ed},
+    {"cornsilk", 0xfff8dc},       {"crimson", 0xdc143c},
+    {"cyan", 0x00ffff},           {"darkblue", 0x00008b},
+    {"darkcyan", 0x008b8b},       {"darkgoldenrod", 0xb8860b},
+    {"darkgray", 0xa9a9a9},       {"darkgreen", 0x006400},
+    {"darkgrey", 0xa9a9a9},       {"darkkhaki", 0xbdb76b},
+    {"darkmagenta", 0x8b008b},    {"darkolivegreen", 0x556b2f},
+    {"darkorange", 0xff8c00},     {"darkorchid", 0x9932cc},
+    {"darkred", 0x8b0000},        {"darksalmon", 0xe9967a},
+    {"darkseagreen", 0x8fbc8f},   {"darkslateblue", 0x483d8b},
+    {"darkslategray", 0x2f4f4f},  {"darkslategrey", 0x2f4f4f},
+    {"darkturquoise", 0x00ced1},  {"darkviolet", 0x9400d3},
+    {"deeppink", 0xff1493},       {"deepskyblue", 0x00bfff},
+    {"dimgray", 0x696969},        {"dimgrey", 0x696969},
+    {"dodgerblue", 0x1e90ff},     {"firebrick", 0xb22222},
+    {"floralwhite", 0xfffaf0},    {"forestgreen", 0x228b22},
+    {"fuchsia", 0xff00ff},        {"gainsboro", 0xdcdcdc},
+    {"ghostwhite", 0xf8f8ff},     {"gold", 0xffd700},
+    {"goldenrod", 0xdaa520},      {"gray", 0x808080},
+    {"green", 0x008000},          {"greenyellow", 0xadff2f},
+    {"grey", 0x808080},           {"honeydew", 0xf0fff0},
+    {"hotpink", 0xff69b4},        {"indianred", 0xcd5c5c},
+    {"indigo", 0x4b0082},         {"ivory", 0xfffff0},
+    {"khaki", 0xf0e68c},          {"lavender", 0xe6e6fa},
+    {"lavenderblush", 0xfff0f5},  {"lawngreen", 0x7cfc00},
+    {"lemonchiffon", 0xfffacd},   {"lightblue", 0xadd8e6},
+    {"lightcoral", 0xf08080},     {"lightcyan", 0xe0ffff},
+    {"lightgoldenrodyellow", 0xfafad2}, {"lightgray", 0xd3d3d3},
+    {"lightgreen", 0x90ee90},     {"lightgrey", 0xd3d3d3},
+    {"lightpink", 0xffb6c1},      {"lightsalmon", 0xffa07a},
+    {"lightseagreen", 0x20b2aa},  {"lightskyblue", 0x87cefa},
+    {"lightslategray", 0x778899}, {"lightslategrey", 0x778899},
+    {"lightsteelblue", 0xb0c4de}, {"lightyellow", 0xffffe0},
+    {"lime", 0x00ff00},           {"limegreen", 0x32cd32},
+    {"linen", 0xfaf0e6},          {"magenta", 0xff00ff},
+    {"maroon", 0x800000},         {"mediumaquamarine", 0x66cdaa},
+    {"mediumblue", 0x0000cd},     {"mediumorchid", 0xba55d3},
+    {"mediumpurple", 0x9370db},   {"mediumseagreen", 0x3cb371},
+    {"mediumslateblue", 0x7b68ee}, {"mediumspringgreen", 0x00fa9a},
+    {"mediumturquoise", 0x48d1cc}, {"mediumvioletred", 0xc71585},
+    {"midnightblue", 0x191970},   {"mintcream", 0xf5fffa},
+    {"mistyrose", 0xffe4e1},      {"moccasin", 0xffe4b5},
+    {"navajowhite", 0xffdead},    {"navy", 0x000080},
+    {"oldlace", 0xfdf5e6},        {"olive", 0x808000},
+    {"olivedrab", 0x6b8e23},      {"orange", 0xffa500},
+    {"orangered", 0xff4500},      {"orchid", 0xda70d6},
+    {"palegoldenrod", 0xeee8aa},  {"palegreen", 0x98fb98},
+    {"paleturquoise", 0xafeeee},  {"palevioletred", 0xdb7093},
+    {"papayawhip", 0xffefd5},     {"peachpuff", 0xffdab9},
+    {"peru", 0xcd853f},           {"pink", 0xffc0cb},
+    {"plum", 0xdda0dd},           {"powderblue", 0xb0e0e6},
+    {"purple", 0x800080},         {"rebeccapurple", 0x663399},
+    {"red", 0xff0000},            {"rosybrown", 0xbc8f8f},
+    {"royalblue", 0x4169e1},      {"saddlebrown", 0x8b4513},
+    {"salmon", 0xfa8072},         {"sandybrown", 0xf4a460},
+    {"seagreen", 0x2e8b57},       {"seashell", 0xfff5ee},
+    {"sienna", 0xa0522d},         {"silver", 0xc0c0c0},
+    {"skyblue", 0x87ceeb},        {"slateblue", 0x6a5acd},
+    {"slategray", 0x708090},      {"slategrey", 0x708090},
+    {"snow", 0xfffafa},           {"springgreen", 0x00ff7f},
+    {"steelblue", 0x4682b4},      {"tan", 0xd2b48c},
+    {"teal", 0x008080},           {"thistle", 0xd8bfd8},
+    {"tomato", 0xff6347},         {"turquoise", 0x40e0d0},
+    {"violet", 0xee82ee},         {"wheat", 0xf5deb3},
+    {"white", 0xffffff},          {"whitesmoke", 0xf5f5f5},
+    {"yellow", 0xffff00},         {"yellowgreen", 0x9acd32},
+});
+
+auto is_space(char ch) -> bool {
+  return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '\f';
+}
+
+auto trim(std::string_view text) -> std::string_view {
+  while (!text.empty() && is_space(text.front()))
+    text.remove_prefix(1);
+  while (!text.empty() && is_space(text.back()))
+    text.remove_suffix(1);
+  return text;
+}
+
+auto lower(char ch) -> char {
+  return ch >= 'A' && ch <= 'Z' ? static_cast<char>(ch - 'A' + 'a') : ch;
+}
+
+auto iequals(std::string_view a, std::string_view b) -> bool {
+  return std::ranges::equal(a, b, {}, lower, lower);
+}
+
+auto hex_digit(char ch) -> int {
+  if (ch >= '0' && ch <= '9')
+    return ch - '0';
+  ch = lower(ch);
+  return ch >= 'a' && ch <= 'f' ? ch - 'a' + 10 : -1;
+}
+
+auto to_byte(double value) -> std::uint8_t {
+  return static_cast<std::uint8_t>(std::lround(std::clamp(value, 0.0, 255.0)));
+}
+
+// Opacity as a fraction (number or percentage), fallback if invalid
+auto fraction(std::string_view text, double fallback = 1.0) -> double {
+  auto length = NumberUtils::parse_length(text);
+  if (!length)
+    return fallback;
+  const double value = length->unit == svg_core::Unit::Percent
+                           ? length->value / 100.0
+                           : length->value;
+  return std::clamp(value, 0.0, 1.0);
+}
+
+// Numbers of a list ("0 0 100 50", "1,2 3,4")
+void parse_numbers(std::string_view text, std::vector<double> &out) {
+  out.clear();
+  std::size_t pos = 0;
+  while (true) {
+    while (pos < text.size() && (is_space(text[pos]) || text[pos] == ','))
+      ++pos;
+    double value{0.0};
+    const auto used = PathUtils::parse_number(text.substr(pos), value);
+    if (used == 0)
+      return;
+    out.push_back(value);
+    pos += used;
+  }
+}
+
+auto is_not_rendered(std::string_view tag) -> bool {
+  static constexpr std::array<std::string_view, 17> tags{
+      "clipPath", "defs",           "desc",     "filter",   "foreignObject",
+      "image",    "linearGradient", "marker",   "mask",     "metadata",
+      "pattern",  "radialGradient", "script",   "style",    "symbol",
+      "text",     "title"};
+  return std::ranges::find(tags, tag) != tags.end();
+}
+
+struct Point {
+  double x;
+  double y;
+};
+
+// Subpaths of a shape in device coordinates
+struct Outline {
+  std::vector<Point> points;
+  std::vector<std::size_t> starts; // first point of each subpath
+  std::vector<bool> closed;
+
+  void clear() {
+    points.clear();
+    starts.clear();
+    closed.clear();
+  }
+  void move(Point p) {
+    starts.push_back(points.size());
+    closed.push_back(false);
+    points.push_back(p);
+  }
+  void line(Point p) {
+    if (starts.empty()) {
+      move(p);
+    } else if (closed.back()) {
+      // Drawing on after Z starts again from the subpath's first point
+      const Point start = points[starts.back()];
+      move(start);
+      points.push_back(p);
+    } else {
+      points.push_back(p);
+    }
+  }
+  void close() {
+    if (!closed.empty())
+      closed.back() = true;
+  }
+  auto subpath(std::size_t i) const -> std::span<const Point> {
+    const auto end = i + 1 < starts.size() ? starts[i + 1] : points.size();
+    return std::span{points}.subspan(starts[i], end - starts[i]);
+  }
+};
+
+auto apply(const Matrix &m, double x, double y) -> Point {
+  return {m.x(x, y), m.y(x, y)};
+}
+
+// Device length of a user unit, for stroke widths and arc flattening
+auto scale_of(const Matrix &m) -> double {
+  return std::sqrt(std::abs(m.a * m.d - m.b * m.c));
+}
+
+// Segments so that a circle of radius r deviates by at most flatness
+auto arc_segments(double radius, double angle) -> int {
+  if (radius <= flatness)
+    return std::max(1, static_cast<int>(std::ceil(std::abs(angle) / 1.5)));
+  const double step = 2.0 * std::acos(1.0 - flatness / radius);
+  return std::clamp(static_cast<int>(std::ceil(std::abs(angle) / step)), 1,
+                    4096);
+}
+
+// Points of an ellipse arc (user space) from angle t0 over dt, first excluded
+void ellipse_arc(Outline &out, const Matrix &m, double cx, double cy,
+                 double rx, double ry, double rotation, double t0, double dt) {
+  const double cos_r = std::cos(rotation), sin_r = std::sin(rotation);
+  const int n = arc_segments(std::max(rx, ry) * std::max(std::hypot(m.a, m.b),
+                                                         std::hypot(m.c, m.d)),
+                             dt);
+  for (int i = 1; i <= n; ++i) {
+    const double t = t0 + dt * i / n;
+    const double ux = rx * std::cos(t), uy = ry * std::sin(t);
+    out.line(apply(m, cx + cos_r * ux - sin_r * uy,
+                   cy + sin_r * ux + cos_r * uy));
+  }
+}
+
+void cubic(Outline &out, Point p0, Point p1, Point p2, Point p3) {
+  const double dd = std::max(
+      std::hypot(p0.x - 2 * p1.x + p2.x, p0.y - 2 * p1.y + p2.y),
+      std::hypot(p1.x - 2 * p2.x + p3.x, p1.y - 2 * p2.y + p3.y));
+  const int n = std::clamp(
+      static_cast<int>(std::ceil(std::sqrt(0.75 * dd / flatness))), 1, 1024);
+  for (int i = 1; i <= n; ++i) {
+    const double t = static_cast<double>(i) / n, s = 1.0 - t;
+    const double a = s * s * s, b = 3 * s * s * t, c = 3 * s * t * t,
+                 d = t * t * t;
+    out.line({a * p0.x + b * p1.x + c * p2.x + d * p3.x,
+              a * p0.y + b * p1.y + c * p2.y + d * p3.y});
+  }
+}
+
+void quadratic(Outline &out, Point p0, Point p1, Point p2) {
+  const double dd = std::hypot(p0.x - 2 * p1.x + p2.x, p0.y - 2 * p1.y + p2.y);
+  const int n = std::clamp(
+      static_cast<int>(std::ceil(std::sqrt(0.25 * dd / flatness))), 1, 1024);
+  for (int i = 1; i <= n; ++i) {
+    const double t = static_cast<double>(i) / n, s = 1.0 - t;
+    out.line({s * s * p0.x + 2 * s * t * p1.x + t * t * p2.x,
+              s * s * p0.y + 2 * s * t * p1.y + t * t * p2.y});
+  }
+}
+
+// Endpoint arc (SVG implementation notes, F.6.5) from (x0, y0)
+void arc(Outline &out, const Matrix &m, double x0, double y0, const double *a) {
+  double rx = std::abs(a[0]), ry = std::abs(a[1]);
+  const double x = a[5], y = a[6];
+  if (rx == 0.0 || ry == 0.0) {
+    out.line(apply(m, x, y));
+    return;
+  }
+  const double phi = a[2] * std::numbers::pi / 180.0;
+  const double cos_p = std::cos(phi), sin_p = std::sin(phi);
+  const double dx2 = (x0 - x) / 2, dy2 = (y0 - y) / 2;
+  const double x1p = cos_p * dx2 + sin_p * dy2;
+  const double y1p = -sin_p * dx2 + cos_p * dy2;
+  if (x1p == 0.0 && y1p == 0.0)
+    return; // same endpoints: no arc
+
+  const double lambda = x1p * x1p / (rx * rx) + y1p * y1p / (ry * ry);
+  if (lambda > 1.0) {
+    rx *= std::sqrt(lambda);
+    ry *= std::sqrt(lambda);
+  }
+  const double num =
+      rx * rx * ry * ry - rx * rx * y1p * y1p - ry * ry * x1p * x1p;
+  const double den = rx * rx * y1p * y1p + ry * ry * x1p * x1p;
+  const bool large = a[3] != 0.0, sweep = a[4] != 0.0;
+  const double coef =
+      std::sqrt(std::max(0.0, num / den)) * (large == sweep ? -1.0 : 1.0);
+  const double cxp = coef * rx * y1p / ry, cyp = -coef * ry * x1p / rx;
+  const double cx = cos_p * cxp - sin_p * cyp + (x0 + x) / 2;
+  const double cy = sin_p * cxp + cos_p * cyp + (y0 + y) / 2;
+
+  auto angle = [](double ux, double uy, double vx, double vy) {
+    return std::atan2(ux * vy - uy * vx, ux * vx + uy * vy);
+  };
+  const double ux = (x1p - cxp) / rx, uy = (y1p - cyp) / ry;
+  const double t0 = angle(1.0, 0.0, ux, uy);
+  double dt = angle(ux, uy, (-x1p - cxp) / rx, (-y1p - cyp) / ry);
+  if (!sweep && dt > 0)
+    dt -= 2 * std::numbers::pi;
+  else if (sweep && dt < 0)
+    dt += 2 * std::numbers::pi;
+  ellipse_arc(out, m, cx, cy, rx, ry, phi, t0, dt);
+  out.points.back() = apply(m, x, y); // exact end point
+}
+
+// Absolute path (see PathUtils::absolute) into device space
+void flatten_path(const PathUtils::PathData &path, const Matrix &m,
+                  Outline &out) {
+  // Current point and subpath start, in user space
+  double cx = 0, cy = 0, sx = 0, sy = 0;
+  std::size_t arg = 0;
+  for (char command : path.commands) {
+    const double *a = path.args.data() + arg;
+    arg += static_cast<std::size_t>(std::max(0, PathUtils::arity(command)));
+    switch (command) {
+    case 'M':
+      out.move(apply(m, a[0], a[1]));
+      cx = sx = a[0];
+      cy = sy = a[1];
+      break;
+    case 'L':
+      out.line(apply(m, a[0], a[1]));
+      cx = a[0];
+      cy = a[1];
+      break;
+    case 'C':
+      if (out.starts.empty())
+        out.move(apply(m, cx, cy));
+      // From the current point: after Z, not the last point drawn
+      cubic(out, apply(m, cx, cy), apply(m, a[0], a[1]), apply(m, a[2], a[3]),
+            apply(m, a[4], a[5]));
+      cx = a[4];
+      cy = a[5];
+      break;
+    case 'Q':
+      if (out.starts.empty())
+        out.move(apply(m, cx, cy));
+      quadratic(out, apply(m, cx, cy), apply(m, a[0], a[1]),
+                apply(m, a[2], a[3]));
+      cx = a[2];
+      cy = a[3];
+      break;
+    case 'A':
+      if (out.starts.empty())
+        out.move(apply(m, cx, cy));
+      arc(out, m, cx, cy, a);
+      cx = a[5];
+      cy = a[6];
+      break;
+    case 'Z':
+    case 'z':
+      out.close();
+      cx = sx;
+      cy = sy;
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+// Edge of a polygon, top to bottom
+struct Edge {
+  float x0;   // x at y0
+  float y0;
+  float y1;
+  float dxdy; // x step per unit of y
+  int winding;
+};
+
+struct Shape {
+  std::size_t first{0}; // edges
+  std::size_t count{0};
+  std::array<float, 4> color{}; // premultiplied RGBA in [0, 1]
+  bool even_odd{false};
+  int x0{0}, y0{0}, x1{0}, y1{0}; // pixels covered, clipped to the image
+};
+
+struct Scene {
+  int width{0};
+  int height{0};
+  std::vector<Edge> edges;
+  std::vector<Shape> shapes;
+  svg_core::BBox box; // of the shape being built
+
+  // Closed polygon; positive: oriented so that it only adds winding
+  void polygon(std::span<const Point> points, bool positive) {
+    if (points.size() < 3)
+      return;
+    int sign = 1;
+    if (positive) {
+      double area = 0.0;
+      for (std::size_t i = 0, j = points.size() - 1; i < points.size(); j = i++)
+        area += (points[j].x - points[i].x) * (points[j].y + points[i].y);
+      sign = area < 0 ? -1 : 1;
+    }
+    for (std::size_t i = 0; i < points.size(); ++i) {
+      const auto &a = points[i];
+      const auto &b = points[(i + 1) % points.size()];
+      box.expand(a.x, a.y);
+      const bool down = a.y < b.y;
+      const auto &top = down ? a : b;
+      const auto &bottom = down ? b : a;
+      Edge edge{static_cast<float>(top.x), static_cast<float>(top.y),
+                static_cast<float>(bottom.y), 0.0f, down ? sign : -sign};
+      if (!(edge.y0 < edge.y1) || !std::isfinite(edge.x0) ||
+          !std::isfinite(bottom.x))
+        continue;
+      edge.dxdy = static_cast<float>((bottom.x - top.x) / (bottom.y - top.y));
+      edges.push_back(edge);
+    }
+  }
+
+  void begin() { box = {}; }
+
+  // Keep the edges added since begin() as a shape, if it shows
+  void end(std::size_t first, const std::array<float, 4> &color,
+           bool even_odd) {
+    Shape shape{first, edges.size() - first, color, even_odd};
+    if (shape.count > 0 && !box.empty()) {
+      shape.x0 = static_cast<int>(
+          std::clamp(std::floor(box.min_x), 0.0, double(width)));
+      shape.y0 = static_cast<int>(
+          std::clamp(std::floor(box.min_y), 0.0, double(height)));
+      shape.x1 = static_cast<int>(
+          std::clamp(std::floor(box.max_x) + 1, 0.0, double(width)));
+      shape.y1 = static_cast<int>(
+          std::clamp(std::floor(box.max_y) + 1, 0.0, double(height)));
+      if (shape.x0 < shape.x1 && shape.y0 < shape.y1) {
+        shapes.push_back(shape);
+        return;
+      }
+    }
+    edges.resize(first);
+  }
+};
+
+enum class Cap { Butt, Round, Square };
+enum class Join { Miter, Round, Bevel };
+
+// Stroke outline as positive polygons (their union is the stroke)
+class Stroker {
+public:
+  Stroker(Scene &scene, double half, Cap cap, Join join, double miterlimit)
+      : scene_(scene), half_(half), cap_(cap), join_(join),
+        miterlimit_(miterlimit) {}
+
+  void subpath(std::span<const Point> points, bool closed) {
+    q_.clear();
+    for (const auto &p : points) {
+      if (q_.empty() || std::hypot(p.x - q_.back().x, p.y - q_.back().y) > 1e-9)
+        q_.push_back(p);
+    }
+    if (closed && q_.size() > 1 &&
+        std::hypot(q_.front().x - q_.back().x, q_.front().y - q_.back().y) <=
+            1e-9)
+      q_.pop_back();
+    const auto n = q_.size();
+    if (n == 0)
+      return;
+    if (n == 1) {
+      // Zero length: only round and square caps show
+      if (cap_ == Cap::Round)
+        circle(q_[0]);
+      else if (cap_ == Cap::Square)
+        square_cap(q_[0], {1.0, 0.0});
+      return;
+    }
+
+    const auto segments = closed ? n : n - 1;
+    for (std::size_t i = 0; i < segments; ++i) {
+      const auto &a = q_[i];
+      const auto &b = q_[(i + 1) % n];
+      const auto d = direction(a, b);
+      const Point normal{-d.y * half_, d.x * half_};
+      quad({a.x + normal.x, a.y + normal.y}, {b.x + normal.x, b.y + normal.y},
+           {b.x - normal.x, b.y - normal.y}, {a.x - normal.x, a.y - normal.y});
+    }
+    for (std::size_t j = closed ? 0 : 1; j < (closed ? n : n - 1); ++j) {
+      const auto &v = q_[j];
+      join(v, direction(q_[(j + n - 1) % n], v), direction(v, q_[(j + 1) % n]));
+    }
+    if (!closed) {
+      const auto start = direction(q_[1], q_[0]);
+      const auto end = direction(q_[n - 2], q_[n - 1]);
+      if (cap_ == Cap::Round) {
+        circle(q_[0]);
+        circle(q_[n - 1]);
+      } else if (cap_ == Cap::Square) {
+        square_cap(q_[0], start);
+        square_cap(q_[n - 1], end);
+      }
+    }
+  }
+
+private:
+  Scene &scene_;
+  double half_;
+  Cap cap_;
+  Join join_;
+  double miterlimit_;
+  std::vector<Point> q_;
+  std::vector<Point> polygon_;
+
+  static auto direction(const Point &a, const Point &b) -> Point {
+    const double length = std::hypot(b.x - a.x, b.y - a.y);
+    return {(b.x - a.x) / length, (b.y - a.y) / length};
+  }
+
+  void quad(Point a, Point b, Point c, Point d) {
+    const std::array<Point, 4> points{a, b, c, d};
+    scene_.polygon(points, true);
+  }
+
+  void circle(const Point &c) {
+    const int n = std::max(8, arc_segments(half_, 2 * std::numbers::pi));
+    polygon_.clear();
+    for (int i = 0; i < n; ++i) {
+      const double t = 2 * std::numbers::pi * i / n;
+      polygon_.push_back(
+          {c.x + half_ * std::cos(t), c.y + half_ * std::sin(t)});
+    }
+    scene_.polygon(polygon_, true);
+  }
+
+  // Square cap at p, extending along the direction d
+  void square_cap(const Point &p, const Point &d) {
+    const Point normal{-d.y * half_, d.x * half_};
+    const Point out{p.x + d.x * half_, p.y + d.y * half_};
+    quad({p.x + normal.x, p.y + normal.y},
+         {out.x + normal.x, out.y + normal.y},
+         {out.x - normal.x, out.y - normal.y},
+         {p.x - normal.x, p.y - normal.y});
+  }
+
+  void join(const Point &v, const Point &d1, const Point &d2) {
+    const double cross = d1.x * d2.y - d1.y * d2.x;
+    const double dot = d1.x * d2.x + d1.y * d2.y;
+    if (std::abs(cross) < 1e-12 && dot > 0)
+      return; // straight on
+    if (join_ == Join::Round) {
+      circle(v);
+      return;
+    }
+    // Outer side of the turn
+    const double side = cross > 0 ? -half_ : half_;
+    const Point n1{-d1.y * side, d1.x * side}, n2{-d2.y * side, d2.x * side};
+    const Point p1{v.x + n1.x, v.y + n1.y}, p2{v.x + n2.x, v.y + n2.y};
+    if (join_ == Join::Miter) {
+      // Miter length / stroke width = 1 / sin(angle / 2) = 1 / cos_half
+      const double cos_half = std::sqrt(std::max(0.0, (1.0 + dot) / 2.0));
+      if (cos_half > 1e-9 && 1.0 / cos_half <= miterlimit_) {
+        const double mx = n1.x + n2.x, my = n1.y + n2.y;
+        const double length = std::hypot(mx, my);
+        const double reach = half_ / cos_half;
+        quad(v, p1, {v.x + mx / length * reach, v.y + my / length * reach}, p2);
+        return;
+      }
+    }
+    const std::array<Point, 3> bevel{v, p1, p2};
+    scene_.polygon(bevel, true);
+  }
+};
+
+// Paint of a fill or stroke value; gradients paint the average of their stops
+auto paint(const TreeUtils::Tree &tree, std::string_view value,
+           std::string_view current, int depth = 0) -> std::optional<Color> {
+  value = trim(value);
+  if (iequals(value, "currentColor"))
+    return RasterUtils::parse_color(current);
+  if (!value.starts_with("url("))
+    return RasterUtils::parse_color(value);
+
+  const auto close = value.find(')');
+  if (close == std::string_view::npos)
+    return std::nullopt;
+  auto id = trim(value.substr(4, close - 4));
+  if (id.size() >= 2 && (id.front() == '"' || id.front() == '\''))
+    id = id.substr(1, id.size() - 2);
+  if (id.starts_with('#'))
+    id.remove_prefix(1);
+  const auto fallback = trim(value.substr(close + 1));
+
+  const auto &index = tree.index;
+  for (auto found = index.ids.find(id);
+       found != index.ids.end() && depth < 4;) {
+    const auto &server = *index.nodes[found->second.front()];
+    if (server.tag != "linearGradient" && server.tag != "radialGradient")
+      break;
+    double sum[4]{};
+    int stops = 0;
+    for (const auto &child : server.children) {
+      if (child->tag != "stop" || !child->style)
+        continue;
+      const auto &style = *child->style;
+      auto color =
+          paint(tree, style[StopColor], style[CurrentColor], depth + 1);
+      if (!color)
+        continue;
+      const double alpha = (*color)[3] / 255.0 * fraction(style[StopOpacity]);
+      for (int c = 0; c < 3; ++c)
+        sum[c] += (*color)[c] * alpha;
+      sum[3] += alpha;
+      ++stops;
+    }
+    if (stops > 0) {
+      if (sum[3] <= 0.0)
+        return Color{0, 0, 0, 0};
+      return Color{to_byte(sum[0] / sum[3]), to_byte(sum[1] / sum[3]),
+                   to_byte(sum[2] / sum[3]), to_byte(sum[3] / stops * 255.0)};
+    }
+    // Stops inherited from the referenced gradient
+    const auto *href = server.attribute("href");
+    if (!href)
+      href = server.attribute("xlink:href");
+    if (!href || !href->starts_with('#'))
+      break;
+    found = index.ids.find(std::string_view{*href}.substr(1));
+    ++depth;
+  }
+  if (fallback.empty())
+    return std::nullopt;
+  return paint(tree, fallback, current, depth + 1);
+}
+
+// Outline of a basic shape or path in device space (false if none)
+auto outline(const TreeUtils::Node &node, const Matrix &m,
+             std::pair<double, double> viewport, Outline &out,
+             PathUtils::PathData &path, std::vector<double> &numbers) -> bool {
+  const auto [vw, vh] = viewport;
+  const double vd = std::sqrt((vw * vw + vh * vh) / 2);
+  auto get = [&node](std::string_view name, double reference) {
+    return node.px(name, reference).value_or(0.0);
+  };
+  const auto &tag = node.tag;
+  out.clear();
+
+  if (tag == "rect") {
+    const double x = get("x", vw), y = get("y", vh);
+    const double w = get("width", vw), h = get("height", vh);
+    if (w <= 0.0 || h <= 0.0)
+      return false;
+    auto rx_attr = node.px("rx", vw), ry_attr = node.px("ry", vh);
+    double rx = std::max(0.0, rx_attr.value_or(ry_attr.value_or(0.0)));
+    double ry = std::max(0.0, ry_attr.value_or(rx_attr.value_or(0.0)));
+    rx = std::min(rx, w / 2);
+    ry = std::min(ry, h / 2);
+    if (rx <= 0.0 || ry <= 0.0) {
+      out.move(apply(m, x, y));
+      out.line(apply(m, x + w, y));
+      out.line(apply(m, x + w, y + h));
+      out.line(apply(m, x, y + h));
+    } else {
+      constexpr double quarter = std::numbers::pi / 2;
+      out.move(apply(m, x + rx, y));
+      out.line(apply(m, x + w - rx, y));
+      ellipse_arc(out, m, x + w - rx, y + ry, rx, ry, 0, -quarter, quarter);
+      out.line(apply(m, x + w, y + h - ry));
+      ellipse_arc(out, m, x + w - rx, y + h - ry, rx, ry, 0, 0, quarter);
+      out.line(apply(m, x + rx, y + h));
+      ellipse_arc(out, m, x + rx, y + h - ry, rx, ry, 0, quarter, quarter);
+      out.line(apply(m, x, y + ry));
+      ellipse_arc(out, m, x + rx, y + ry, rx, ry, 0, 2 * quarter, quarter);
+    }
+    out.close();
+  } else if (tag == "circle" || tag == "ellipse") {
+    const double cx = get("cx", vw), cy = get("cy", vh);
+    double rx{0.0}, ry{0.0};
+    if (tag == "circle") {
+      rx = ry = get("r", vd);
+    } else {
+      auto rx_attr = node.px("rx", vw), ry_attr = node.px("ry", vh);
+      rx = rx_attr.value_or(ry_attr.value_or(0.0));
+      ry = ry_attr.value_or(rx_attr.value_or(0.0));
+    }
+    if (rx <= 0.0 || ry <= 0.0)
+      return false;
+    out.move(apply(m, cx + rx, cy));
+    ellipse_arc(out, m, cx, cy, rx, ry, 0, 0, 2 * std::numbers::pi);
+    out.points.pop_back(); // back at the start
+    out.close();
+  } else if (tag == "line") {
+    out.move(apply(m, get("x1", vw), get("y1", vh)));
+    out.line(apply(m, get("x2", vw), get("y2", vh)));
+  } else if (tag == "polyline" || tag == "polygon") {
+    const auto *value = node.attribute("points");
+    if (!value)
+      return false;
+    parse_numbers(*value, numbers);
+    for (std::size_t i = 0; i + 1 < numbers.size(); i += 2) {
+      if (i == 0)
+        out.move(apply(m, numbers[0], numbers[1]));
+      else
+        out.line(apply(m, numbers[i], numbers[i + 1]));
+    }
+    if (tag == "polygon")
+      out.close();
+  } else if (tag == "path") {
+    const auto *value = node.attribute("d");
+    if (!value || !PathUtils::parse(*value, path))
+      return false;
+    flatten_path(PathUtils::absolute(path), m, out);
+  } else {
+    return false;
+  }
+  return !out.points.empty();
+}
+
+auto premultiply(const Color &color, double alpha) -> std::array<float, 4> {
+  const auto a = static_cast<float>(color[3] / 255.0 * alpha);
+  return {color[0] / 255.0f * a, color[1] / 255.0f * a, color[2] / 255.0f * a,
+          a};
+}
+
+// Per thread buffers of the tile renderer
+struct Scratch {
+  std::vector<float> rgba;  // tile pixels, premultiplied
+  std::vector<float> cover; // coverage of one pixel row
+  std::vector<const Edge *> tile_edges;
+  std::vector<const Edge *> row_edges;
+  std::vector<std::pair<float, int>> crossings;
+};
+
+// Coverage of [xa, xb) added to the pixels of cover, clamped to [lo, hi)
+void add_span(std::vector<float> &cover, float xa, float xb, float weight,
+              int lo, int hi) {
+  xa = std::clamp(xa, static_cast<float>(lo), static_cast<float>(hi));
+  xb = std::clamp(xb, static_cast<float>(lo), static_cast<float>(hi));
+  if (!(xa < xb))
+    return;
+  const int ia = static_cast<int>(xa);
+  const int ib = static_cast<int>(xb);
+  if (ia == ib) {
+    cover[ia] += (xb - xa) * weight;
+    return;
+  }
+  cover[ia] += (static_cast<float>(ia + 1) - xa) * weight;
+  for (int i = ia + 1; i < ib; ++i)
+    cover[i] += weight;
+  if (ib < hi)
+    cover[ib] += (xb - static_cast<float>(ib)) * weight;
+}
+
+void render_tile(const Scene &scene, const std::vector<std::uint32_t> &bin,
+                 int tx, int ty, const std::array<float, 4> &background,
+                 Image &image, Scratch &scratch) {
+  const int x0 = tx * tile_size, y0 = ty * tile_size;
+  const int x1 = std::min(scene.width, x0 + tile_size);
+  const int y1 = std::min(scene.height, y0 + tile_size);
+  const int tw = x1 - x0;
+
+  auto &rgba = scratch.rgba;
+  rgba.resize(static_cast<std::size_t>(tile_size * tile_size * 4));
+  for (std::size_t i = 0; i < rgba.size(); i += 4)
+    std::copy(background.begin(), background.end(), rgba.begin() + i);
+  scratch.cover.resize(tile_size + 1);
+  constexpr float weight = 1.0f / samples;
+
+  for (auto index : bin) {
+    const auto &shape = scene.shapes[index];
+    const int ry0 = std::max(y0, shape.y0), ry1 = std::min(y1, shape.y1);
+    const int lo = std::max(x0, shape.x0) - x0;
+    const int hi = std::min(x1, shape.x1) - x0;
+
+    scratch.tile_edges.clear();
+    for (std::size_t e = shape.first; e < shape.first + shape.count; ++e) {
+      const auto &edge = scene.edges[e];
+      if (edge.y1 > static_cast<float>(ry0) &&
+          edge.y0 < static_cast<float>(ry1))
+        scratch.tile_edges.push_back(&edge);
+    }
+
+    for (int y = ry0; y < ry1; ++y) {
+      scratch.row_edges.clear();
+      for (const auto *edge : scratch.tile_edges) {
+        if (edge->y1 > static_cast<float>(y) &&
+            edge->y0 < static_cast<float>(y + 1))
+          scratch.row_edges.push_back(edge);
+      }
+      if (scratch.row_edges.empty())
+        continue;
+
+      auto &cover = scratch.cover;
+      std::fill(cover.begin() + lo, cover.begin() + hi, 0.0f);
+      for (int s = 0; s < samples; ++s) {
+        const float sy =
+            static_cast<float>(y) + (static_cast<float>(s) + 0.5f) * weight;
+        auto &crossings = scratch.crossings;
+        crossings.clear();
+        for (const auto *edge : scratch.row_edges) {
+          if (edge->y0 <= sy && sy < edge->y1)
+            crossings.emplace_back(edge->x0 + (sy - edge->y0) * edge->dxdy -
+                                       static_cast<float>(x0),
+                                   edge->winding);
+        }
+        std::ranges::sort(crossings, {}, &std::pair<float, int>::first);
+        int winding = 0;
+        for (std::size_t k = 0; k + 1 < crossings.size(); ++k) {
+          winding += crossings[k].second;
+          if (shape.even_odd ? (winding & 1) != 0 : winding != 0)
+            add_span(cover, crossings[k].first, crossings[k + 1].first, weight,
+                     lo, hi);
+        }
+      }
+
+      // Source over
+      float *row =
+          rgba.data() + static_cast<std::size_t>((y - y0) * tile_size) * 4;
+      for (int x = lo; x < hi; ++x) {
+        const float c = std::min(cover[x], 1.0f);
+        if (c <= 0.0f)
+          continue;
+        float *px = row + x * 4;
+        const float keep = 1.0f - shape.color[3] * c;
+        for (int k = 0; k < 4; ++k)
+          px[k] = shape.color[k] * c + px[k] * keep;
+      }
+    }
+  }
+
+  for (int y = y0; y < y1; ++y) {
+    const float *row =
+        rgba.data() + static_cast<std::size_t>((y - y0) * tile_size) * 4;
+    auto *out = image.pixels.data() +
+                (static_cast<std::size_t>(y) * scene.width + x0) * 4;
+    for (int x = 0; x < tw; ++x) {
+      const float *px = row + x * 4;
+      const float a = std::min(px[3], 1.0f);
+      if (a <= 0.0f) {
+        std::fill(out + x * 4, out + x * 4 + 4, 0);
+        continue;
+      }
+      for (int k = 0; k < 3; ++k)
+        out[x * 4 + k] = to_byte(px[k] / a * 255.0);
+      out[x * 4 + 3] = to_byte(a * 255.0);
+    }
+  }
+}
+
+// CRC-32 of PNG chunks
+auto crc32(std::string_view bytes, std::uint32_t crc = 0) -> std::uint32_t {
+  static const auto table = [] {
+    std::array<std::uint32_t, 256> t{};
+    for (std::uint32_t n = 0; n < 256; ++n) {
+      std::uint32_t c = n;
+      for (int k = 0; k < 8; ++k)
+        c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+      t[n] = c;
+    }
+    return t;
+  }();
+  crc = ~crc;
+  for (unsigned char byte : bytes)
+    crc = table[(crc ^ byte) & 0xff] ^ (crc >> 8);
+  return ~crc;
+}
+
+auto adler32(std::string_view bytes) -> std::uint32_t {
+  std::uint32_t a = 1, b = 0;
+  for (std::size_t i = 0; i < bytes.size();) {
+    // Largest run before the sums may overflow
+    const auto end = std::min(bytes.size(), i + 5552);
+    for (; i < end; ++i) {
+      a += static_cast<unsigned char>(bytes[i]);
+      b += a;
+    }
+    a %= 65521;
+    b %= 65521;
+  }
+  return b << 16 | a;
+}
+
+void append_be32(std::string &out, std::uint32_t value) {
+  for (int shift = 24; shift >= 0; shift -= 8)
+    out += static_cast<char>(value >> shift & 0xff);
+}
+
+// Bits written least significant first (deflate order)
+class BitWriter {
+public:
+  explicit BitWriter(std::string &out) : out_(out) {}
+
+  void put(std::uint32_t value, int count) {
+    bits_ |= static_cast<std::uint64_t>(value) << count_;
+    count_ += count;
+    while (count_ >= 8) {
+      out_ += static_cast<char>(bits_ & 0xff);
+      bits_ >>= 8;
+      count_ -= 8;
+    }
+  }
+
+  // Huffman codes are packed most significant bit first
+  void code(std::uint32_t code, int length) {
+    std::uint32_t reversed = 0;
+    for (int i = 0; i < length; ++i)
+      reversed |= (code >> i & 1) << (length - 1 - i);
+    put(reversed, length);
+  }
+
+  void flush() {
+    if (count_ > 0)
+      out_ += static_cast<char>(bits_ & 0xff);
+    bits_ = 0;
+    count_ = 0;
+  }
+
+private:
+  std::string &out_;
+  std::uint64_t bits_{0};
+  int count_{0};
+};
+
+constexpr std::array<int, 29> length_base{
+    3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+    31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr std::array<int, 29> length_extra{0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                           1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                           4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr std::array<int, 30> distance_base{
+    1,    2,    3,    4,    5,    7,    9,    13,    17,    25,
+    33,   49,   65,   97,   129,  193,  257,  385,   513,   769,
+    1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+constexpr std::array<int, 30> distance_extra{
+    0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+    6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// Literal/length symbol with the fixed Huffman code (RFC 1951, 3.2.6)
+void fixed_symbol(BitWriter &bits, int symbol) {
+  if (symbol < 144)
+    bits.code(0x30 + symbol, 8);
+  else if (symbol < 256)
+    bits.code(0x190 + symbol - 144, 9);
+  else if (symbol < 280)
+    bits.code(symbol - 256, 7);
+  else
+    bits.code(0xc0 + symbol - 280, 8);
+}
+
+// zlib stream: one deflate block with fixed codes, greedy LZ77 matches
+void deflate(std::string_view data, std::string &out) {
+  constexpr int window = 32768;
+  constexpr int max_match = 258;
+  constexpr int hash_bits = 15;
+
+  out += '\x78';
+  out += '\x01';
+  BitWriter bits(out);
+  bits.put(1, 1); // final block
+  bits.put(1, 2); // fixed Huffman codes
+
+  std::vector<int> head(1 << hash_bits, -1);
+  auto hash = [&data](std::size_t i) {
+    const std::uint32_t v = static_cast<unsigned char>(data[i]) |
+                            static_cast<unsigned char>(data[i + 1]) << 8 |
+                            static_cast<unsigned char>(data[i + 2]) << 16;
+    return (v * 2654435761u) >> (32 - hash_bits);
+  };
+
+  const auto n = data.size();
+  std::size_t i = 0;
+  while (i < n) {
+    int length = 0;
+    std::size_t distance = 0;
+    if (i + 3 <= n) {
+      const auto h = hash(i);
+      const int candidate = head[h];
+      head[h] = static_cast<int>(i);
+      if (candidate >= 0 && i - candidate <= window) {
+        const auto limit = std::min<std::size_t>(max_match, n - i);
+        std::size_t k = 0;
+        while (k < limit && data[candidate + k] == data[i + k])
+          ++k;
+        if (k >= 3) {
+          length = static_cast<int>(k);
+          distance = i - candidate;
+        }
+      }
+    }
+    if (length == 0) {
+      fixed_symbol(bits, static_cast<unsigned char>(data[i++]));
+      continue;
+    }
+
+    int code = 28;
+    while (length_base[code] > length)
+      --code;
+    fixed_symbol(bits, 257 + code);
+    bits.put(length - length_base[code], length_extra[code]);
+    int dcode = 29;
+    while (distance_base[dcode] > static_cast<int>(distance))
+      --dcode;
+    bits.code(dcode, 5);
+    bits.put(static_cast<std::uint32_t>(distance) - distance_base[dcode],
+             distance_extra[dcode]);
+
+    // Positions inside the match are candidates for later ones
+    for (std::size_t j = i + 1; j < i + length && j + 3 <= n; ++j)
+      head[hash(j)] = static_cast<int>(j);
+    i += length;
+  }
+  fixed_symbol(bits, 256); // end of block
+  bits.flush();
+  append_be32(out, adler32(data));
+}
+
+void append_chunk(std::string &png, std::string_view type,
+                  std::string_view data) {
+  append_be32(png, static_cast<std::uint32_t>(data.size()));
+  const auto start = png.size();
+  png += type;
+  png += data;
+  append_be32(png, crc32(std::string_view{png}.substr(start)));
+}
+
+} // namespace
+
+auto RasterUtils::parse_color(std::string_view text) -> std::optional<Color> {
+  text = trim(text);
+  if (text.empty())
+    return std::nullopt;
+
+  if (text.front() == '#') {
+    const auto hex = text.substr(1);
+    if (std::ranges::any_of(hex, [](char ch) { return hex_digit(ch) < 0; }))
+      return std::nullopt;
+    Color color{0, 0, 0, 255};
+    if (hex.size() == 3 || hex.size() == 4) {
+      for (std::size_t i = 0; i < hex.size(); ++i)
+        color[i] = static_cast<std::uint8_t>(hex_digit(hex[i]) * 17);
+    } else if (hex.size() == 6 || hex.size() == 8) {
+      for (std::size_t i = 0; i < hex.size() / 2; ++i)
+        color[i] = static_cast<std::uint8_t>(hex_digit(hex[2 * i]) * 16 +
+                                             hex_digit(hex[2 * i + 1]));
+    } else {
+      return std::nullopt;
+    }
+    return color;
+  }
+
+  const auto open = text.find('(');
+  if (open != std::string_view::npos) {
+    const auto name = trim(text.substr(0, open));
+    if (!(iequals(name, "rgb") || iequals(name, "rgba")) ||
+        !text.ends_with(')'))
+      return std::nullopt;
+    // "r, g, b[, a]" or "r g b[ / a]"
+    std::array<std::string_view, 4> parts{};
+    std::size_t count = 0;
+    auto args = text.substr(open + 1, text.size() - open - 2);
+    while (true) {
+      const auto end = args.find_first_of(", /");
+      const auto part = trim(args.substr(0, end));
+      if (!part.empty()) {
+        if (count == parts.size())
+          return std::nullopt;
+        parts[count++] = part;
+      }
+      if (end == std::string_view::npos)
+        break;
+      args.remove_prefix(end + 1);
+    }
+    if (count < 3)
+      return std::nullopt;
+    Color color{0, 0, 0, 255};
+    for (std::size_t i = 0; i < count; ++i) {
+      auto length = NumberUtils::parse_length(parts[i]);
+      if (!length)
+        return std::nullopt;
+      const bool percent = length->unit == svg_core::Unit::Percent;
+      if (i < 3)
+        color[i] =
+            to_byte(percent ? length->value / 100.0 * 255.0 : length->value);
+      else
+        color[i] = to_byte(
+            (percent ? length->value / 100.0 : length->value) * 255.0);
+    }
+    return color;
+  }
+
+  if (iequals(text, "transparent"))
+    return Color{0, 0, 0, 0};
+  std::string name(text.size(), '\0');
+  std::ranges::transform(text, name.begin(), lower);
+  auto it = std::ranges::lower_bound(named_colors, std::string_view{name}, {},
+                                     &NamedColor::name);
+  if (it == named_colors.end() || it->name != name)
+    return std::nullopt;
+  return Color{static_cast<std::uint8_t>(it->rgb >> 16),
+               static_cast<std::uint8_t>(it->rgb >> 8 & 0xff),
+               static_cast<std::uint8_t>(it->rgb & 0xff), 255};
+}
+
+auto RasterUtils::render(TreeUtils::Tree &tree, const Options &options)
+    -> Expected<Image> {
+  if (options.size <= 0 || options.size > max_size) {
+    return std::unexpected(make_error(
+        Status::InvalidOption,
+        std::format("Invalid image size {} (1 to {}).", options.size,
+                    max_size)));
+  }
+  std::array<float, 4> background{};
+  if (!options.background.empty()) {
+    auto color = parse_color(options.background);
+    if (!color) {
+      return std::unexpected(make_error(
+          Status::InvalidOption,
+          std::format("Invalid background color '{}'.", options.background)));
+    }
+    background = premultiply(*color, 1.0);
+  }
+  if (!tree.root || tree.index.nodes.empty())
+    return std::unexpected(
+        make_error(Status::EmptyInput, "Nothing to render (empty tree)."));
+
+  const auto &root = *tree.root;
+  if (!root.ctm)
+    GeometryUtils::flatten(tree);
+
+  // Document box and its mapping to the image
+  std::vector<double> numbers;
+  double width = root.px("width").value_or(0.0);
+  double height = root.px("height").value_or(0.0);
+  Matrix view;
+  if (const auto *view_box = root.attribute("viewBox")) {
+    parse_numbers(*view_box, numbers);
+    if (numbers.size() == 4 && numbers[2] > 0.0 && numbers[3] > 0.0) {
+      if (width <= 0.0)
+        width = height > 0.0 ? height * numbers[2] / numbers[3] : numbers[2];
+      if (height <= 0.0)
+        height = width * numbers[3] / numbers[2];
+      // preserveAspectRatio="xMidYMid meet"
+      const double s = std::min(width / numbers[2], height / numbers[3]);
+      view = {s, 0.0, 0.0, s, (width - numbers[2] * s) / 2 - numbers[0] * s,
+              (height - numbers[3] * s) / 2 - numbers[1] * s};
+    }
+  }
+  const std::pair<double, double> viewport{
+      width > 0.0 ? width : 0.0, height > 0.0 ? height : 0.0};
+  if (width <= 0.0 || height <= 0.0) {
+    // No size given: the bounds of the content
+    GeometryUtils::compute(tree);
+    if (!root.bbox || root.bbox->empty()) {
+      return std::unexpected(make_error(
+          Status::EmptyInput, "Nothing to render (no size and no content)."));
+    }
+    const auto &box = *root.bbox;
+    width = std::max(box.max_x - box.min_x, 1e-9);
+    height = std::max(box.max_y - box.min_y, 1e-9);
+    view = {1.0, 0.0, 0.0, 1.0, -box.min_x, -box.min_y};
+  }
+  const double scale = options.size / std::max(width, height);
+  Scene scene;
+  scene.width =
+      std::clamp(static_cast<int>(std::lround(width * scale)), 1, max_size);
+  scene.height =
+      std::clamp(static_cast<int>(std::lround(height * scale)), 1, max_size);
+  const Matrix device = Matrix{scale, 0.0, 0.0, scale, 0.0, 0.0} * view;
+
+  // Cascade (Node::style), then one shape per fill and per stroke
+  const std::vector<std::string> properties(style_properties.begin(),
+                                            style_properties.end());
+  StyleUtils::compute(tree, properties);
+
+  const auto &index = tree.index;
+  const auto count = index.nodes.size();
+  std::vector<double> opacities(count, 1.0);
+  Outline shape_outline;
+  PathUtils::PathData path;
+  const double diagonal = std::sqrt((viewport.first * viewport.first +
+                                     viewport.second * viewport.second) / 2);
+
+  for (std::size_t position = 0; position < count;) {
+    const auto &node = *index.nodes[position];
+    const auto &style = *node.style;
+    const auto parent = index.parents[position];
+    const double opacity =
+        (parent == std::string_view::npos ? 1.0 : opacities[parent]) *
+        fraction(style[Opacity]);
+    opacities[position] = opacity;
+    if (style[Display] == "none" || is_not_rendered(node.tag) ||
+        opacity <= 0.0) {
+      position += index.sizes[position];
+      continue;
+    }
+    ++position;
+
+    if (style[Visibility] == "hidden" || style[Visibility] == "collapse")
+      continue;
+    const Matrix m = device * node.ctm.value_or(Matrix{});
+    if (!outline(node, m, viewport, shape_outline, path, numbers))
+      continue;
+
+    if (node.tag != "line") {
+      if (auto color = paint(tree, style[Fill], style[CurrentColor])) {
+        const auto first = scene.edges.size();
+        scene.begin();
+        for (std::size_t i = 0; i < shape_outline.starts.size(); ++i)
+          scene.polygon(shape_outline.subpath(i), false);
+        scene.end(first,
+                  premultiply(*color, opacity * fraction(style[FillOpacity])),
+                  style[FillRule] == "evenodd");
+      }
+    }
+
+    if (auto color = paint(tree, style[Stroke], style[CurrentColor])) {
+      auto length = NumberUtils::parse_length(style[StrokeWidth]);
+      const double stroke_width =
+          length ? NumberUtils::to_px(*length, diagonal) * scale_of(m) : 0.0;
+      if (stroke_width <= 0.0)
+        continue;
+      const auto &cap = style[StrokeLinecap];
+      const auto &join = style[StrokeLinejoin];
+      Stroker stroker(scene, stroke_width / 2,
+                      cap == "round"    ? Cap::Round
+                      : cap == "square" ? Cap::Square
+                                        : Cap::Butt,
+                      join == "round"   ? Join::Round
+                      : join == "bevel" ? Join::Bevel
+                                        : Join::Miter,
+                      std::max(1.0, NumberUtils::parse_number(
+                                        style[StrokeMiterlimit])
+                                        .value_or(4.0)));
+      const auto first = scene.edges.size();
+      scene.begin();
+      for (std::size_t i = 0; i < shape_outline.starts.size(); ++i)
+        stroker.subpath(shape_outline.subpath(i), shape_outline.closed[i]);
+      scene.end(first,
+                premultiply(*color, opacity * fraction(style[StrokeOpacity])),
+                false);
+    }
+  }
+
+  // Shapes over each tile, in document order
+  const int tiles_x = (scene.width + tile_size - 1) / tile_size;
+  const int tiles_y = (scene.height + tile_size - 1) / tile_size;
+  std::vector<std::vector<std::uint32_t>> bins(
+      static_cast<std::size_t>(tiles_x * tiles_y));
+  for (std::size_t s = 0; s < scene.shapes.size(); ++s) {
+    const auto &shape = scene.shapes[s];
+    const int last_x = (shape.x1 - 1) / tile_size;
+    const int last_y = (shape.y1 - 1) / tile_size;
+    for (int ty = shape.y0 / tile_size; ty <= last_y; ++ty) {
+      for (int tx = shape.x0 / tile_size; tx <= last_x; ++tx)
+        bins[static_cast<std::size_t>(ty * tiles_x + tx)].push_back(
+            static_cast<std::uint32_t>(s));
+    }
+  }
+
+  Image image;
+  image.width = scene.width;
+  image.height = scene.height;
+  image.pixels.resize(static_cast<std::size_t>(scene.width) * scene.height * 4);
+
+  const auto tiles = bins.size();
+  const auto hardware = std::max(1u, std::thread::hardware_concurrency());
+  const auto threads =
+      std::min<std::size_t>(options.threads ? options.threads : hardware,
+                            tiles);
+
+  // Tiles are independent: each worker takes the next one
+  std::atomic<std::size_t> next{0};
+  std::vector<Scratch> scratches(threads);
+  auto work = [&](Scratch &scratch) {
+    for (auto tile = next++; tile < tiles; tile = next++) {
+      const int tx = static_cast<int>(tile % tiles_x);
+      const int ty = static_cast<int>(tile / tiles_x);
+      render_tile(scene, bins[tile], tx, ty, background, image, scratch);
+    }
+  };
+
+  {
+    std::vector<std::jthread> workers;
+    for (std::size_t t = 1; t < threads; ++t)
+      workers.emplace_back(work, std::ref(scratches[t]));
+    work(scratches[0]);
+  }
+  return image;
+}
+
+void RasterUtils::write_png(std::ostream &out, const Image &image) {
+  // Rows filtered with the cheapest of None, Sub, Up and Paeth
+  const auto stride = static_cast<std::size_t>(image.width) * 4;
+  std::string filtered;
+  filtered.reserve((stride + 1) * image.height);
+  std::array<std::string, 4> candidates;
+  constexpr std::array<char, 4> types{0, 1, 2, 4};
+  for (int y = 0; y < image.height; ++y) {
+    const auto *row = image.pixels.data() + y * stride;
+    const auto *above = y > 0 ? row - stride : nullptr;
+    std::size_t best = 0;
+    std::uint64_t best_cost = UINT64_MAX;
+    for (std::size_t f = 0; f < types.size(); ++f) {
+      auto &line = candidates[f];
+      line.resize(stride);
+      std::uint64_t cost = 0;
+      for (std::size_t i = 0; i < stride; ++i) {
+        const int left = i >= 4 ? row[i - 4] : 0;
+        const int up = above ? above[i] : 0;
+        const int corner = above && i >= 4 ? above[i - 4] : 0;
+        int predictor = 0;
+        if (types[f] == 1) {
+          predictor = left;
+        } else if (types[f] == 2) {
+          predictor = up;
+        } else if (types[f] == 4) {
+          const int p = left + up - corner;
+          const int pa = std::abs(p - left), pb = std::abs(p - up),
+                    pc = std::abs(p - corner);
+          predictor = pa <= pb && pa <= pc ? left : pb <= pc ? up : corner;
+        }
+        const auto value = static_cast<std::uint8_t>(row[i] - predictor);
+        line[i] = static_cast<char>(value);
+        cost += value < 128 ? value : 256 - value;
+      }
+      if (cost < best_cost) {
+        best_cost = cost;
+        best = f;
+      }
+    }
+    filtered += types[best];
+    filtered += candidates[best];
+  }
+
+  std::string header;
+  append_be32(header, static_cast<std::uint32_t>(image.width));
+  append_be32(header, static_cast<std::uint32_t>(image.height));
+  header += std::string_view{"\x08\x06\x00\x00\x00", 5}; // 8-bit RGBA
+  std::string compressed;
+  deflate(filtered, compressed);
+
+  std::string png{"\x89PNG\r\n\x1a\n"};
+  append_chunk(png, "IHDR", header);
+  append_chunk(png, "IDAT", compressed);
+  append_chunk(png, "IEND", {});
+  out.write(png.data(), static_cast<std::streamsize>(png.size()));
+}
+
+void RasterUtils::write_ppm(std::ostream &out, const Image &image) {
+  std::string ppm = std::format("P6\n{} {}\n255\n", image.width, image.height);
+  ppm.reserve(ppm.size() + image.pixels.size() / 4 * 3);
+  for (std::size_t i = 0; i < image.pixels.size(); i += 4) {
+    const int alpha = image.pixels[i + 3];
+    for (int c = 0; c < 3; ++c)
+      ppm += static_cast<char>(
+          (image.pixels[i + c] * alpha + 255 * (255 - alpha) + 127) / 255);
+  }
+  out.write(ppm.data(), static_cast<std::streamsize>(ppm.size()));
+}
+
+auto RasterUtils::save(std::string_view path, const Image &image)
+    -> Expected<void> {
+  if (path.empty()) {
+    return std::unexpected(
+        make_error(Status::InvalidPath, "Invalid image path (empty)."));
+  }
+  const bool ppm = path.ends_with(".ppm");
+  if (!ppm && !path.ends_with(".png")) {
+    return std::unexpected(make_error(
+        Status::InvalidExtension,
+        std::format("Unsupported image extension: '{}' (.png or .ppm).",
+                    path)));
+  }
+
+  std::ofstream file(std::string{path}, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    return std::unexpected(make_error(
+        Status::FileError,
+        std::format("Failed to open image file '{}'.", path)));
+  }
+  if (ppm)
+    write_ppm(file, image);
+  else
+    write_png(file, image);
+  if (!file.good()) {
+    return std::unexpected(make_error(
+        Status::FileError,
+        std::format("Writing error occurred for '{}'.", path)));
+  }
+  return {};
+}
+
+void test_raster_utils() {
+
+  using RasterUtils::parse_color;
+  using RasterUtils::render;
+  using TreeUtils::TagTuple;
+  using TreeUtils::TagType;
+
+  // Colors
+  assert(std::ranges::is_sorted(named_colors, {}, &NamedColor::name));
+  assert(parse_color("red") == (Color{255, 0, 0, 255}));
+  assert(parse_color(" CornflowerBlue ") == (Color{100, 149, 237, 255}));
+  assert(parse_color("#0f08") == (Color{0, 255, 0, 0x88}));
+  assert(parse_color("#102030") == (Color{16, 32, 48, 255}));
+  assert(parse_color("rgb(0, 50%, 100%)") == (Color{0, 128, 255, 255}));
+  assert(parse_color("rgba(1 2 3 / 0.5)") == (Color{1, 2, 3, 128}));
+  assert(parse_color("transparent") == (Color{0, 0, 0, 0}));
+  assert(!parse_color("none") && !parse_color("#12") &&
+         !parse_color("url(#a)"));
+  assert(!parse_color("rgb(1,2)") && !parse_color("bluish"));
+
+  auto draw = [](std::vector<TagTuple> tags,
+                 RasterUtils::Options options = {}) {
+    auto tree = TreeUtils::process(tags);
+    auto image = render(tree, options);
+    assert(image);
+    return *image;
+  };
+  const Color clear{0, 0, 0, 0};
+
+  // Fill, anti-aliased edges, transforms and the viewBox
+  auto image = draw({{"svg", {{"viewBox", "0 0 40 20"}}, TagType::Open},
+                     {"rect",
+                      {{"width", "10"}, {"height", "20"}, {"fill", "red"}},
+                      TagType::SelfClose},
+                     {"rect",
+                      {{"x", "11"}, {"width", "3"}, {"height", "20"},
+                       {"transform", "translate(10)"}, {"fill", "#00f"}},
+                      TagType::SelfClose},
+                     {"svg", {}, TagType::Close}},
+                    {.size = 20});
+  assert(image.width == 20 && image.height == 10);
+  assert(image.pixel(2, 5) == (Color{255, 0, 0, 255}));
+  assert(image.pixel(7, 5) == clear);
+  // x 21..24 in the viewBox: half of pixel 10, all of 11
+  assert(image.pixel(10, 5) == (Color{0, 0, 255, 128}));
+  assert(image.pixel(11, 5) == (Color{0, 0, 255, 255}));
+
+  // Strokes, even-odd holes, group opacity, currentColor and a background
+  image = draw({{"svg", {{"width", "32"}, {"height", "32"}}, TagType::Open},
+                {"rect",
+                 {{"x", "2"}, {"y", "2"}, {"width", "12"}, {"height", "12"},
+                  {"fill", "none"}, {"stroke", "black"}, {"stroke-width", "2"}},
+                 TagType::SelfClose},
+                {"path",
+                 {{"d", "M16 0h16v16h-16z M20 4v8h8v-8z"},
+                  {"fill-rule", "evenodd"},
+                  {"fill", "lime"}},
+                 TagType::SelfClose},
+                {"g", {{"opacity", "0.5"}, {"color", "#f00"}}, TagType::Open},
+                {"circle", {{"cx", "8"}, {"cy", "24"}, {"r", "6"},
+                            {"fill", "currentColor"}},
+                 TagType::SelfClose},
+                {"g", {}, TagType::Close},
+                {"line",
+                 {{"x1", "18"}, {"y1", "24"}, {"x2", "30"}, {"y2", "24"},
+                  {"stroke", "blue"}, {"stroke-width", "4"}, {"fill", "red"}},
+                 TagType::SelfClose},
+                {"svg", {}, TagType::Close}},
+               {.size = 32, .background = "white"});
+  assert(image.pixel(1, 8) == (Color{0, 0, 0, 255}));
+  assert(image.pixel(8, 8) == (Color{255, 255, 255, 255}));
+  assert(image.pixel(17, 8) == (Color{0, 255, 0, 255}));
+  assert(image.pixel(24, 8) == (Color{255, 255, 255, 255})); // hole
+  assert(image.pixel(8, 24) == (Color{255, 128, 128, 255}));
+  assert(image.pixel(24, 23) == (Color{0, 0, 255, 255}));
+  assert(image.pixel(24, 27) == (Color{255, 255, 255, 255}));
+  assert(image.pixel(17, 24) == (Color{255, 255, 255, 255})); // butt cap
+
+  // A curve right after Z starts from the subpath start
+  auto curve = [&draw](std::string d) {
+    return draw({{"svg", {{"width", "20"}, {"height", "20"}}, TagType::Open},
+                 {"path", {{"d", d}}, TagType::SelfClose},
+                 {"svg", {}, TagType::Close}},
+                {.size = 20})
+        .pixels;
+  };
+  assert(curve("M0 0H4V4Z C20 0 20 20 0 20Q10 10 0 0") ==
+         curve("M0 0H4V4Z M0 0C20 0 20 20 0 20Q10 10 0 0"));
+
+  // Same pixels whatever the number of threads
+  std::vector<TagTuple> many{
+      {"svg", {{"width", "300"}, {"height", "200"}}, TagType::Open}};
+  for (int i = 0; i < 50; ++i) {
+    many.push_back({"circle",
+                    {{"cx", std::to_string(i * 6)},
+                     {"cy", std::to_string(i * 4)},
+                     {"r", "30"}, {"fill", i % 2 ? "teal" : "orange"},
+                     {"fill-opacity", "0.7"}, {"stroke", "#333"},
+                     {"stroke-linejoin", "round"}},
+                    TagType::SelfClose});
+  }
+  many.push_back({"svg", {}, TagType::Close});
+  const auto single = draw(many, {.size = 300, .threads = 1});
+  const auto parallel = draw(many, {.size = 300, .threads = 4});
+  assert(single.width == 300 && single.height == 200);
+  assert(single.pixels == parallel.pixels);
+
+  // Encoders
+  std::ostringstream png;
+  RasterUtils::write_png(png, image);
+  const auto bytes = png.str();
+  assert(bytes.starts_with("\x89PNG\r\n\x1a\n"));
+  assert(bytes.substr(12, 4) == "IHDR" &&
+         bytes.ends_with("IEND\xae\x42\x60\x82"));
+  assert(bytes.size() < image.pixels.size() / 4); // flat colors compress
+  std::ostringstream ppm;
+  RasterUtils::write_ppm(ppm, image);
+  assert(ppm.str().starts_with("P6\n32 32\n255\n"));
+  assert(ppm.str().size() == 13 + 32 * 32 * 3);
+  assert(crc32("123456789") == 0xcbf43926u);
+  assert(adler32("Wikipedia") == 0x11e60398u);
+
+  // Errors
+  TreeUtils::Tree empty;
+  assert(render(empty).error().status == Status::EmptyInput);
+  auto tree = TreeUtils::process(std::vector<TagTuple>{
+      {"svg", {}, TagType::Open}, {"svg", {}, TagType::Close}});
+  assert(render(tree).error().status == Status::EmptyInput);
+  assert(render(tree, {.size = 0}).error().status == Status::InvalidOption);
+  assert(render(tree, {.background = "nope"}).error().status ==
+         Status::InvalidOption);
+  assert(RasterUtils::save("a.gif", image).error().status ==
+         Status::InvalidExtension);
+  assert(RasterUtils::save("", image).error().status == Status::InvalidPath);
+
+  std::println("{}[TEST]{} : {} : test completed", color::green, color::reset,
+               __PRETTY_FUNCTION__);
+}
+
+#ifdef BUILD_TEST_EXE
+auto main() -> int {
+
+  test_raster_utils();
+
+  return 0;
+}
+#endif
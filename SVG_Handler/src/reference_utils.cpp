@@ -0,0 +1,343 @@
+#include "reference_utils.hpp"
+
+#include <array>
+#include <cassert>
+#include <format>
+#include <memory>
+#include <print>
+#include <unordered_map>
+
+using ReferenceUtils::Link;
+using TreeUtils::Node;
+
+namespace {
+
+constexpr auto none = std::string_view::npos;
+
+// Attributes that may hold url(#id)
+constexpr std::array<std::string_view, 8> url_attributes{
+    "fill",   "stroke",       "clip-path",  "mask",
+    "filter", "marker-start", "marker-mid", "marker-end"};
+
+auto trim(std::string_view str) -> std::string_view {
+  const auto first = str.find_first_not_of(" \t\n\r\f");
+  if (first == std::string_view::npos)
+    return {};
+  const auto last = str.find_last_not_of(" \t\n\r\f");
+  return str.substr(first, last - first + 1);
+}
+
+auto href(const Node &node) -> const std::string * {
+  if (const auto *value = node.attribute("href"))
+    return value;
+  return node.attribute("xlink:href");
+}
+
+// Deep copy without ids; symbol is instantiated as svg.
+auto copy(const Node &node) -> std::unique_ptr<Node> {
+  auto result = std::make_unique<Node>(node.tag == "symbol" ? "svg" : node.tag,
+                                       node.attributes);
+  std::erase_if(result->attributes,
+                [](const auto &attribute) { return attribute.first == "id"; });
+  result->contents = node.contents;
+  result->children.reserve(node.children.size());
+  for (const auto &child : node.children)
+    result->children.push_back(copy(*child));
+  return result;
+}
+
+} // namespace
+
+auto ReferenceUtils::parse_reference(std::string_view value)
+    -> std::optional<std::string_view> {
+  value = trim(value);
+  if (value.starts_with("url(")) {
+    const auto close = value.find(')');
+    if (close == std::string_view::npos)
+      return std::nullopt;
+    value = trim(value.substr(4, close - 4));
+    if (value.size() >= 2 && (value.front() == '"' || value.front() == '\'') &&
+        value.back() == value.front())
+      value = trim(value.substr(1, value.size() - 2));
+  }
+
+  if (value.size() < 2 || value.front() != '#')
+    return std::nullopt;
+  return value.substr(1);
+}
+
+ReferenceUtils::Resolver::Resolver(const TreeUtils::Tree &tree)
+    : tree_(tree), targets_(tree.index.nodes.size(), none),
+      target_state_(tree.index.nodes.size(), State::Unknown),
+      bases_(tree.index.nodes.size(), none),
+      base_state_(tree.index.nodes.size(), State::Unknown) {}
+
+auto ReferenceUtils::Resolver::target(std::size_t position) -> std::size_t {
+  if (position >= targets_.size())
+    return none;
+
+  if (target_state_[position] == State::Unknown) {
+    target_state_[position] = State::Done;
+    if (const auto *value = href(*tree_.index.nodes[position])) {
+      if (auto id = parse_reference(*value))
+        targets_[position] = TreeUtils::find_id(tree_, *id);
+    }
+  }
+  return targets_[position];
+}
+
+auto ReferenceUtils::Resolver::base(std::size_t position) -> std::size_t {
+  if (position >= bases_.size())
+    return none;
+
+  switch (base_state_[position]) {
+  case State::Done:
+    return bases_[position];
+  case State::Visiting:
+    return none; // cycle
+  case State::Unknown:
+    break;
+  }
+
+  base_state_[position] = State::Visiting;
+  const auto *value = href(*tree_.index.nodes[position]);
+  std::size_t result = position;
+  if (value) {
+    const auto next = target(position);
+    result = (next == none) ? none : base(next);
+  }
+
+  base_state_[position] = State::Done;
+  bases_[position] = result;
+  return result;
+}
+
+auto ReferenceUtils::Resolver::links() -> std::vector<Link> {
+  std::vector<Link> result;
+  const auto &nodes = tree_.index.nodes;
+
+  for (std::size_t position = 0; position < nodes.size(); ++position) {
+    for (const auto &[name, value] : nodes[position]->attributes) {
+      const bool href_attribute = name == "href" || name == "xlink:href";
+      if (!href_attribute && std::ranges::find(url_attributes, name) ==
+                                 url_attributes.end())
+        continue;
+
+      auto id = parse_reference(value);
+      if (!id || (!href_attribute && !trim(value).starts_with("url(")))
+        continue;
+      result.push_back(
+          {position, name, *id, TreeUtils::find_id(tree_, *id)});
+    }
+  }
+  return result;
+}
+
+auto ReferenceUtils::expand(TreeUtils::Tree &tree, std::size_t limit)
+    -> Expansion {
+  Expansion result;
+  const auto uses = tree.index.tags.find("use");
+  if (uses == tree.index.tags.end())
+    return result;
+
+  auto target_of = [&tree](const Node &node) -> std::size_t {
+    const auto *value = href(node);
+    auto id = value ? parse_reference(*value) : std::nullopt;
+    return id ? TreeUtils::find_id(tree, *id) : none;
+  };
+
+  enum class State : unsigned char { Unknown, Visiting, Done };
+  std::unordered_map<std::size_t, State> states;
+  std::unordered_map<std::size_t, std::unique_ptr<Node>> instances;
+  std::unordered_map<std::size_t, std::size_t> sizes; // elements per instance
+
+  // Reserve count copied elements; false from the first one over the limit
+  std::size_t copied = 0;
+  auto fits = [&](std::size_t count) {
+    if (result.limited > 0 || count > limit - copied) {
+      ++result.limited;
+      return false;
+    }
+    copied += count;
+    return true;
+  };
+
+  // Copy of the element at position with its nested <use> expanded.
+  // Built once per element; nullptr while being built (reference cycle).
+  auto instance = [&](auto &self, std::size_t position) -> const Node * {
+    auto &state = states[position];
+    if (state == State::Visiting)
+      return nullptr;
+    if (state == State::Done)
+      return instances[position].get();
+    state = State::Visiting;
+
+    auto &size = sizes[position];
+    size = tree.index.sizes[position];
+    if (!fits(size)) {
+      state = State::Done;
+      return nullptr;
+    }
+    auto content = copy(*tree.index.nodes[position]);
+
+    // Walk the original and its copy together
+    auto fill = [&](auto &fill_self, const Node &original,
+                    Node &clone) -> void {
+      for (std::size_t i = 0; i < original.children.size(); ++i)
+        fill_self(fill_self, *original.children[i], *clone.children[i]);
+      if (original.tag != "use")
+        return;
+      const auto target = target_of(original);
+      if (target == none)
+        return;
+      const auto *inner = self(self, target);
+      if (inner && fits(sizes[target])) {
+        clone.children.push_back(copy(*inner));
+        size += sizes[target];
+      }
+    };
+    fill(fill, *tree.index.nodes[position], *content);
+
+    states[position] = State::Done;
+    return (instances[position] = std::move(content)).get();
+  };
+
+  auto is_ancestor = [&tree](std::size_t ancestor, std::size_t position) {
+    for (; position != none; position = tree.index.parents[position])
+      if (position == ancestor)
+        return true;
+    return false;
+  };
+
+  // Build every copy first, attach afterwards (copies read the original tree)
+  Resolver resolver(tree);
+  std::vector<std::pair<Node *, std::unique_ptr<Node>>> attachments;
+  for (auto use : uses->second) {
+    const auto target = resolver.target(use);
+    if (target == none) {
+      ++result.unresolved;
+      continue;
+    }
+    if (is_ancestor(target, use)) {
+      ++result.cycles;
+      continue;
+    }
+    const auto *content = instance(instance, target);
+    if (content && fits(sizes[target]))
+      attachments.emplace_back(tree.index.nodes[use], copy(*content));
+  }
+
+  for (auto &[use, content] : attachments) {
+    use->children.push_back(std::move(content));
+    ++result.expanded;
+  }
+
+  TreeUtils::reindex(tree);
+  return result;
+}
+
+void test_reference_utils() {
+
+  using ReferenceUtils::expand;
+  using ReferenceUtils::parse_reference;
+  using ReferenceUtils::Resolver;
+  using TreeUtils::TagType;
+
+  // Reference syntax
+  assert(parse_reference("#a") == "a");
+  assert(parse_reference(" url( '#grad' ) ") == "grad");
+  assert(parse_reference("url(#b)") == "b");
+  assert(!parse_reference("red"));
+  assert(!parse_reference("#"));
+  assert(!parse_reference("other.svg#a"));
+
+  auto tree = TreeUtils::process(std::vector<TreeUtils::TagTuple>{
+      {"svg", {}, TagType::Open},                                          // 0
+      {"defs", {}, TagType::Open},                                         // 1
+      {"linearGradient", {{"id", "base"}}, TagType::Open},                 // 2
+      {"stop", {}, TagType::SelfClose},                                    // 3
+      {"linearGradient", {}, TagType::Close},                              //
+      {"linearGradient",                                                   // 4
+       {{"id", "grad"}, {"href", "#base"}},
+       TagType::SelfClose},
+      {"g", {{"id", "pair"}}, TagType::Open},                              // 5
+      {"rect", {{"width", "1"}, {"height", "1"}}, TagType::SelfClose},     // 6
+      {"use", {{"xlink:href", "#dot"}, {"x", "5"}}, TagType::SelfClose},   // 7
+      {"g", {}, TagType::Close},                                           //
+      {"circle", {{"id", "dot"}, {"r", "1"}}, TagType::SelfClose},         // 8
+      {"g", {{"id", "loop"}}, TagType::Open},                              // 9
+      {"use", {{"href", "#loop"}}, TagType::SelfClose},                    // 10
+      {"g", {}, TagType::Close},                                           //
+      {"defs", {}, TagType::Close},                                        //
+      {"use",                                                              // 11
+       {{"href", "#pair"}, {"fill", "url(#grad)"}},
+       TagType::SelfClose},
+      {"use", {{"href", "#pair"}, {"y", "10"}}, TagType::SelfClose},       // 12
+      {"use", {{"href", "#missing"}}, TagType::SelfClose},                 // 13
+      {"svg", {}, TagType::Close}});
+
+  // Memoized resolution
+  Resolver resolver(tree);
+  assert(resolver.target(4) == 2 && resolver.base(4) == 2);
+  assert(resolver.base(2) == 2);
+  assert(resolver.target(11) == 5 &&
+         resolver.target(13) == std::string_view::npos);
+  assert(resolver.base(13) == std::string_view::npos);
+
+  auto links = resolver.links();
+  assert(links.size() == 7);
+  assert(links[0].source == 4 && links[0].attribute == "href" &&
+         links[0].target == 2);
+  assert(links[4].source == 11 && links[4].attribute == "fill" &&
+         links[4].id == "grad" && links[4].target == 4);
+
+  // Expansion
+  auto result = expand(tree);
+  assert(result.expanded == 3 && result.unresolved == 1 && result.cycles == 1);
+
+  const auto &uses = tree.root->children;
+  const auto &first = *uses[1]->children[0];
+  assert(first.tag == "g" && !first.attribute("id"));
+  assert(first.children.size() == 2 && first.children[1]->tag == "use");
+  assert(first.children[1]->children[0]->tag == "circle"); // nested use
+  assert(uses[2]->children[0]->children.size() == 2);
+  assert(uses[3]->children.empty());
+
+  // Ids stay unique and the index sees the copies
+  assert(tree.index.ids.at("dot").size() == 1 &&
+         tree.index.ids.at("pair").size() == 1);
+  assert(tree.index.tags.at("circle").size() == 1 + 1 + 2);
+
+  // Nested <use> bomb: 10 levels of 10 uses each would copy 10^10 elements
+  std::vector<TreeUtils::TagTuple> bomb{
+      {"svg", {}, TagType::Open},
+      {"circle", {{"id", "l0"}}, TagType::SelfClose}};
+  for (int level = 1; level <= 10; ++level) {
+    bomb.push_back({"g", {{"id", std::format("l{}", level)}}, TagType::Open});
+    for (int i = 0; i < 10; ++i)
+      bomb.push_back({"use", {{"href", std::format("#l{}", level - 1)}},
+                      TagType::SelfClose});
+    bomb.push_back({"g", {}, TagType::Close});
+  }
+  bomb.push_back({"use", {{"href", "#l10"}}, TagType::SelfClose});
+  bomb.push_back({"svg", {}, TagType::Close});
+  auto bombed = TreeUtils::process(bomb);
+  const auto before = bombed.index.nodes.size();
+  result = expand(bombed, 10000);
+  assert(result.limited > 0 && result.cycles == 0 && result.unresolved == 0);
+  assert(bombed.index.nodes.size() <= before + 10000);
+  // Below the limit, the first levels are expanded in full
+  assert(bombed.index.tags.at("circle").size() > 100);
+
+  std::println("{}[TEST]{} : {} : test completed", color::green, color::reset,
+               __PRETTY_FUNCTION__);
+}
+
+#ifdef BUILD_TEST_EXE
+auto main() -> int {
+
+  test_reference_utils();
+
+  return 0;
+}
+#endif
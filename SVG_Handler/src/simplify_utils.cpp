@@ -0,0 +1,475 @@
+#include "simplify_utils.hpp"
+#include "number_utils.hpp"
+#include "path_utils.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <charconv>
+#include <cmath>
+#include <format>
+#include <print>
+#include <string>
+#include <thread>
+
+using SimplifyUtils::Options;
+using SimplifyUtils::Stats;
+
+namespace {
+
+// Elements handed to a thread at a time
+constexpr std::size_t chunk_size = 256;
+
+// Points closer than this to the line are on it (tolerance 0)
+constexpr double collinear_epsilon = 1e-9;
+
+// Coordinate attributes rounded with a precision (sorted)
+constexpr std::array<std::string_view, 13> coordinates{
+    "cx", "cy", "height", "r", "rx", "ry", "width",
+    "x",  "x1", "x2",     "y", "y1", "y2"};
+
+// Distance from p to the segment [a, b]
+auto distance(double px, double py, double ax, double ay, double bx,
+              double by) -> double {
+  const double dx = bx - ax;
+  const double dy = by - ay;
+  const double length = dx * dx + dy * dy;
+  if (length == 0.0)
+    return std::hypot(px - ax, py - ay);
+  const double t =
+      std::clamp(((px - ax) * dx + (py - ay) * dy) / length, 0.0, 1.0);
+  return std::hypot(px - (ax + t * dx), py - (ay + t * dy));
+}
+
+void append_number(std::string &out, double number) {
+  std::array<char, 32> buffer{};
+  auto [end, ec] =
+      std::to_chars(buffer.data(), buffer.data() + buffer.size(), number);
+  out.append(buffer.data(), end);
+}
+
+// Buffers of one worker, reused from element to element
+struct Scratch {
+  PathUtils::PathData path;
+  PathUtils::PathData simplified;
+  std::vector<double> xs, ys;
+  std::vector<std::size_t> kept;
+  std::string text;
+  std::string rounded;
+  Stats stats;
+};
+
+// Simplify the polyline in xs/ys; false if no point was dropped
+auto reduce(Scratch &scratch, double tolerance) -> bool {
+  SimplifyUtils::simplify_line(scratch.xs, scratch.ys, tolerance, scratch.kept);
+  scratch.stats.before += scratch.xs.size();
+  scratch.stats.after += scratch.kept.size();
+  return scratch.kept.size() < scratch.xs.size();
+}
+
+// Path with its straight runs simplified; false if nothing changed
+auto reduce_path(std::string_view d, Scratch &scratch, double tolerance)
+    -> bool {
+  if (!PathUtils::parse(d, scratch.path))
+    return false;
+  const auto path = PathUtils::absolute(scratch.path);
+
+  auto &out = scratch.simplified;
+  out.commands.clear();
+  out.args.clear();
+  scratch.xs.clear();
+  scratch.ys.clear();
+  bool changed = false;
+
+  // Lines from the current point, written once the run ends
+  auto flush = [&] {
+    if (scratch.xs.size() > 2 && reduce(scratch, tolerance)) {
+      changed = true;
+      for (std::size_t k = 1; k < scratch.kept.size(); ++k) {
+        out.commands.push_back('L');
+        out.args.push_back(scratch.xs[scratch.kept[k]]);
+        out.args.push_back(scratch.ys[scratch.kept[k]]);
+      }
+    } else {
+      for (std::size_t k = 1; k < scratch.xs.size(); ++k) {
+        out.commands.push_back('L');
+        out.args.push_back(scratch.xs[k]);
+        out.args.push_back(scratch.ys[k]);
+      }
+    }
+    scratch.xs.clear();
+    scratch.ys.clear();
+  };
+
+  double cx{0.0}, cy{0.0}; // current point
+  double sx{0.0}, sy{0.0}; // subpath start
+  std::size_t a{0};
+  for (char command : path.commands) {
+    const auto count = static_cast<std::size_t>(PathUtils::arity(command));
+    const double *v = path.args.data() + a;
+    a += count;
+
+    if (command == 'L') {
+      if (scratch.xs.empty()) {
+        scratch.xs.push_back(cx);
+        scratch.ys.push_back(cy);
+      }
+      scratch.xs.push_back(v[0]);
+      scratch.ys.push_back(v[1]);
+      cx = v[0];
+      cy = v[1];
+      continue;
+    }
+
+    flush();
+    out.commands.push_back(command);
+    out.args.insert(out.args.end(), v, v + count);
+    if (command == 'Z') {
+      cx = sx;
+      cy = sy;
+    } else if (count >= 2) {
+      cx = v[count - 2];
+      cy = v[count - 1];
+      if (command == 'M') {
+        sx = cx;
+        sy = cy;
+      }
+    }
+  }
+  flush();
+
+  if (changed)
+    PathUtils::serialize(out, scratch.text);
+  return changed;
+}
+
+// Path data rounded at absolute positions. Relative offsets are derived
+// from the rounded positions so that rounding errors do not add up along
+// the path; false if d has no relative segment, is not path data or needs
+// no rounding (its form is then kept).
+auto round_path(std::string_view d, int decimals, Scratch &scratch) -> bool {
+  if (!PathUtils::parse(d, scratch.path) ||
+      std::ranges::none_of(scratch.path.commands,
+                           [](char c) { return c >= 'a' && c != 'z'; }))
+    return false;
+
+  const double scale = std::pow(10.0, decimals);
+  auto round = [scale](double value) {
+    const double rounded = std::round(value * scale) / scale;
+    return rounded == 0.0 ? 0.0 : rounded; // no "-0"
+  };
+
+  double cx{0.0}, cy{0.0}; // current point
+  double sx{0.0}, sy{0.0}; // subpath start
+  double rx{0.0}, ry{0.0}; // ... both rounded
+  double rsx{0.0}, rsy{0.0};
+  bool moved = false;
+  std::size_t a{0};
+  for (char command : scratch.path.commands) {
+    const auto count = static_cast<std::size_t>(PathUtils::arity(command));
+    double *v = scratch.path.args.data() + a;
+    a += count;
+
+    const bool relative = command >= 'a';
+    const char upper = relative ? static_cast<char>(command - 'a' + 'A')
+                                : command;
+    if (upper == 'Z') {
+      cx = sx, cy = sy, rx = rsx, ry = rsy;
+      continue;
+    }
+
+    // x: true for x, false for y
+    auto position = [&](double &arg, bool x, double &exact, double &rounded) {
+      exact = (relative ? (x ? cx : cy) : 0.0) + arg;
+      rounded = round(exact);
+      const double before = arg;
+      arg = relative ? round(rounded - (x ? rx : ry)) : rounded;
+      moved = moved || arg != before;
+    };
+    double ex{cx}, ey{cy}, erx{rx}, ery{ry};
+    if (upper == 'H') {
+      position(v[0], true, ex, erx);
+    } else if (upper == 'V') {
+      position(v[0], false, ey, ery);
+    } else {
+      std::size_t first = 0;
+      if (upper == 'A') { // radii and rotation, flags kept
+        for (std::size_t k = 0; k < 3; ++k) {
+          moved = moved || round(v[k]) != v[k];
+          v[k] = round(v[k]);
+        }
+        first = 5;
+      }
+      for (std::size_t k = first; k + 1 < count; k += 2) {
+        position(v[k], true, ex, erx);
+        position(v[k + 1], false, ey, ery);
+      }
+    }
+    cx = ex, cy = ey, rx = erx, ry = ery;
+    if (upper == 'M')
+      sx = cx, sy = cy, rsx = rx, rsy = ry;
+  }
+
+  if (!moved)
+    return false;
+  PathUtils::serialize(scratch.path, scratch.rounded);
+  return true;
+}
+
+// Polyline points simplified; false if nothing changed or not a list
+auto reduce_points(std::string_view points, Scratch &scratch,
+                   double tolerance) -> bool {
+  scratch.xs.clear();
+  scratch.ys.clear();
+  bool x = true;
+  while (!points.empty()) {
+    const char ch = points.front();
+    if (ch == ',' || ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r') {
+      points.remove_prefix(1);
+      continue;
+    }
+    double value{0.0};
+    const auto used = PathUtils::parse_number(points, value);
+    if (used == 0)
+      return false;
+    (x ? scratch.xs : scratch.ys).push_back(value);
+    x = !x;
+    points.remove_prefix(used);
+  }
+  if (!x || scratch.xs.size() < 3 || !reduce(scratch, tolerance))
+    return false;
+
+  scratch.text.clear();
+  for (auto k : scratch.kept) {
+    if (!scratch.text.empty())
+      scratch.text += ' ';
+    append_number(scratch.text, scratch.xs[k]);
+    scratch.text += ',';
+    append_number(scratch.text, scratch.ys[k]);
+  }
+  return true;
+}
+
+void reduce_node(TreeUtils::Node &node, const Options &options,
+                 Scratch &scratch) {
+  bool changed = false;
+  for (auto &[name, value] : node.attributes) {
+    bool rewritten = false;
+    if (options.tolerance >= 0.0) {
+      if (name == "d" && node.tag == "path")
+        rewritten = reduce_path(value, scratch, options.tolerance);
+      else if (name == "points" &&
+               (node.tag == "polyline" || node.tag == "polygon"))
+        rewritten = reduce_points(value, scratch, options.tolerance);
+    }
+    const bool round =
+        options.precision >= 0 &&
+        (name == "d" || name == "points" ||
+         std::ranges::binary_search(coordinates, std::string_view{name}));
+    if (!rewritten && !round)
+      continue;
+
+    const std::string_view text = rewritten ? scratch.text : value;
+    if (round) {
+      // A rewritten path is absolute, its numbers can be rounded one by one
+      if (rewritten || name != "d" ||
+          !round_path(text, options.precision, scratch))
+        NumberUtils::round_numbers(text, options.precision, scratch.rounded);
+      rewritten = rewritten || scratch.rounded != value;
+      if (rewritten)
+        value.assign(scratch.rounded);
+    } else {
+      value.assign(text);
+    }
+    changed = changed || rewritten;
+  }
+
+  if (changed) {
+    node.invalidate();
+    ++scratch.stats.elements;
+  }
+}
+
+} // namespace
+
+void SimplifyUtils::simplify_line(std::span<const double> xs,
+                                  std::span<const double> ys, double tolerance,
+                                  std::vector<std::size_t> &kept) {
+  kept.clear();
+  const auto count = std::min(xs.size(), ys.size());
+  if (count <= 2) {
+    for (std::size_t k = 0; k < count; ++k)
+      kept.push_back(k);
+    return;
+  }
+
+  const double limit = std::max(tolerance, collinear_epsilon);
+  thread_local std::vector<char> keep;
+  thread_local std::vector<std::pair<std::size_t, std::size_t>> ranges;
+  keep.assign(count, 0);
+  keep.front() = keep.back() = 1;
+  ranges.clear();
+  ranges.emplace_back(0, count - 1);
+
+  while (!ranges.empty()) {
+    const auto [first, last] = ranges.back();
+    ranges.pop_back();
+
+    double farthest = 0.0;
+    std::size_t split = first;
+    for (auto k = first + 1; k < last; ++k) {
+      const auto d =
+          distance(xs[k], ys[k], xs[first], ys[first], xs[last], ys[last]);
+      if (d > farthest) {
+        farthest = d;
+        split = k;
+      }
+    }
+    if (farthest <= limit)
+      continue;
+
+    keep[split] = 1;
+    if (split - first > 1)
+      ranges.emplace_back(first, split);
+    if (last - split > 1)
+      ranges.emplace_back(split, last);
+  }
+
+  for (std::size_t k = 0; k < count; ++k) {
+    if (keep[k])
+      kept.push_back(k);
+  }
+}
+
+auto SimplifyUtils::simplify(TreeUtils::Tree &tree, const Options &options)
+    -> Stats {
+  auto &nodes = tree.index.nodes;
+  if (nodes.empty() || (options.precision < 0 && options.tolerance < 0.0))
+    return {};
+
+  const auto chunks = (nodes.size() + chunk_size - 1) / chunk_size;
+  const auto hardware = std::max(1u, std::thread::hardware_concurrency());
+  const auto threads = std::min<std::size_t>(
+      options.threads ? options.threads : hardware, chunks);
+
+  // Elements are independent: each worker takes the next chunk
+  std::atomic<std::size_t> next{0};
+  std::vector<Scratch> scratches(threads);
+  auto work = [&](Scratch &scratch) {
+    for (auto chunk = next++; chunk < chunks; chunk = next++) {
+      const auto end = std::min(nodes.size(), (chunk + 1) * chunk_size);
+      for (auto position = chunk * chunk_size; position < end; ++position)
+        reduce_node(*nodes[position], options, scratch);
+    }
+  };
+
+  {
+    std::vector<std::jthread> workers;
+    for (std::size_t t = 1; t < threads; ++t)
+      workers.emplace_back(work, std::ref(scratches[t]));
+    work(scratches[0]);
+  }
+
+  Stats stats;
+  for (const auto &scratch : scratches) {
+    stats.elements += scratch.stats.elements;
+    stats.before += scratch.stats.before;
+    stats.after += scratch.stats.after;
+  }
+  if (stats.elements > 0)
+    TreeUtils::reindex(tree);
+  return stats;
+}
+
+void test_simplify_utils() {
+
+  using TreeUtils::TagTuple;
+  using TreeUtils::TagType;
+
+  // Douglas-Peucker
+  std::vector<std::size_t> kept;
+  const std::vector<double> xs{0, 1, 2, 3, 4, 5};
+  const std::vector<double> ys{0, 0.1, 0, 2, 2, 2};
+  SimplifyUtils::simplify_line(xs, ys, 0.0, kept);
+  assert((kept == std::vector<std::size_t>{0, 1, 2, 3, 5}));
+  SimplifyUtils::simplify_line(xs, ys, 0.5, kept);
+  assert((kept == std::vector<std::size_t>{0, 2, 3, 5}));
+  SimplifyUtils::simplify_line(xs, ys, 10.0, kept);
+  assert((kept == std::vector<std::size_t>{0, 5}));
+
+  auto tree = TreeUtils::process(std::vector<TagTuple>{
+      {"svg", {{"width", "10.5"}}, TagType::Open},
+      {"path", {{"d", "M0 0 1 0 2 0C3 0 3 1 4 1h1 1z"}}, TagType::SelfClose},
+      {"path", {{"d", "M0 0c1 1 2 2 3 3"}}, TagType::SelfClose},
+      {"polyline", {{"points", "0,0 1,1 2,2 2,5"}}, TagType::SelfClose},
+      {"circle", {{"cx", "1.23456"}, {"id", "c1.5"}}, TagType::SelfClose},
+      {"path", {{"d", "M0,0L1,1"}}, TagType::SelfClose},
+      {"svg", {}, TagType::Close}});
+  const auto hash = tree.index.hashes[0];
+
+  // Collinear points only
+  auto stats = SimplifyUtils::simplify(tree, {.tolerance = 0.0});
+  const auto &nodes = tree.index.nodes;
+  assert(nodes[1]->attributes[0].second == "M0,0L2,0C3,0,3,1,4,1L6,1Z");
+  assert(nodes[2]->attributes[0].second == "M0 0c1 1 2 2 3 3"); // form kept
+  assert(nodes[3]->attributes[0].second == "0,0 2,2 2,5");
+  assert(nodes[5]->attributes[0].second == "M0,0L1,1");
+  assert(stats.elements == 2 && stats.before == 10 && stats.after == 7);
+  assert(tree.index.hashes[0] != hash);
+
+  // Coordinates rounded, not names or transforms
+  stats = SimplifyUtils::simplify(tree, {.precision = 1});
+  assert(nodes[4]->attributes[0].second == "1.2");
+  assert(nodes[4]->attributes[1].second == "c1.5");
+  assert(nodes[0]->attributes[0].second == "10.5");
+
+  // Relative offsets follow the rounded positions: no drift along the path
+  std::string drift = "m0 0";
+  for (int i = 0; i < 100; ++i)
+    drift += " l.004 0";
+  auto relative = TreeUtils::process(std::vector<TagTuple>{
+      {"svg", {}, TagType::Open},
+      {"path", {{"d", drift}}, TagType::SelfClose},
+      {"path", {{"d", "m.004.006h.004v-.004a1.04 1.04 0 0 1 .004 .006z"}},
+       TagType::SelfClose},
+      {"svg", {}, TagType::Close}});
+  SimplifyUtils::simplify(relative, {.precision = 2});
+  const auto &rounded = relative.index.nodes;
+  auto parsed = PathUtils::parse(rounded[1]->attributes[0].second);
+  assert(parsed);
+  auto path = PathUtils::absolute(*parsed);
+  assert(std::abs(path.args[path.args.size() - 2] - 0.4) < 1e-9);
+  assert(std::ranges::count(rounded[1]->attributes[0].second, 'l') == 100);
+  assert(rounded[2]->attributes[0].second ==
+         "m0,0.01h0.01v-0.01a1.04,1.04,0,0,1,0,0.01z");
+
+  // Same result on several threads
+  std::vector<TagTuple> many{{"svg", {}, TagType::Open}};
+  for (int i = 0; i < 2000; ++i) {
+    const auto points = std::format("0,0 {0}.001,{0} {0}.25,{0}.5 9,9", i % 9);
+    many.push_back({"polyline", {{"points", points}}, TagType::SelfClose});
+  }
+  many.push_back({"svg", {}, TagType::Close});
+  auto serial = TreeUtils::process(many);
+  auto parallel = TreeUtils::process(many);
+  auto one = SimplifyUtils::simplify(
+      serial, {.precision = 2, .tolerance = 0.1, .threads = 1});
+  auto four = SimplifyUtils::simplify(
+      parallel, {.precision = 2, .tolerance = 0.1, .threads = 4});
+  assert(one.elements == four.elements && one.after == four.after);
+  assert(serial.index.hashes == parallel.index.hashes);
+  assert(SimplifyUtils::simplify(serial, {}).elements == 0);
+
+  std::println("{}[TEST]{} : {} : test completed", color::green, color::reset,
+               __PRETTY_FUNCTION__);
+}
+
+#ifdef BUILD_TEST_EXE
+auto main() -> int {
+
+  test_simplify_utils();
+
+  return 0;
+}
+#endif
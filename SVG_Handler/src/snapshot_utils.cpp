@@ -0,0 +1,451 @@
+#include "snapshot_utils.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <print>
+#include <unordered_map>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SNAPSHOT_MMAP 1
+#endif
+
+using SnapshotUtils::AttributeRecord;
+using SnapshotUtils::Header;
+using SnapshotUtils::NodeRecord;
+using SnapshotUtils::Snapshot;
+using svg_core::make_error;
+using svg_core::Status;
+
+namespace {
+
+constexpr std::uint32_t no_parent = std::numeric_limits<std::uint32_t>::max();
+
+constexpr auto align(std::uint64_t offset) -> std::uint64_t {
+  return (offset + 7) & ~std::uint64_t{7};
+}
+
+// Byte offsets of the sections after the header
+struct Sections {
+  std::uint64_t nodes{0};
+  std::uint64_t attributes{0};
+  std::uint64_t offsets{0};
+  std::uint64_t strings{0};
+  std::uint64_t end{0};
+};
+
+auto sections(const Header &header) -> Sections {
+  Sections result;
+  result.nodes = align(sizeof(Header));
+  result.attributes = align(result.nodes + std::uint64_t{header.node_count} *
+                                               sizeof(NodeRecord));
+  result.offsets =
+      align(result.attributes +
+            std::uint64_t{header.attribute_count} * sizeof(AttributeRecord));
+  result.strings =
+      align(result.offsets +
+            (std::uint64_t{header.string_count} + 1) * sizeof(std::uint32_t));
+  result.end = result.strings + header.string_bytes;
+  return result;
+}
+
+template <typename T>
+void put(std::string &bytes, std::uint64_t at, const T &value) {
+  std::memcpy(bytes.data() + at, &value, sizeof(T));
+}
+
+auto invalid(std::string message) -> svg_core::Error {
+  return make_error(Status::InvalidSnapshot, std::move(message));
+}
+
+} // namespace
+
+void SnapshotUtils::encode(const TreeUtils::Tree &tree, std::string &bytes) {
+  const auto &index = tree.index;
+
+  // Distinct strings, numbered in order of first use
+  std::unordered_map<std::string_view, std::uint32_t> ids;
+  std::vector<std::string_view> strings;
+  std::uint64_t string_bytes = 0;
+  auto intern = [&](std::string_view str) -> std::uint32_t {
+    auto [it, inserted] =
+        ids.try_emplace(str, static_cast<std::uint32_t>(strings.size()));
+    if (inserted) {
+      strings.push_back(str);
+      string_bytes += str.size();
+    }
+    return it->second;
+  };
+
+  std::vector<NodeRecord> nodes;
+  std::vector<AttributeRecord> attributes;
+  nodes.reserve(index.nodes.size());
+  for (std::size_t position = 0; position < index.nodes.size(); ++position) {
+    const auto &node = *index.nodes[position];
+    const auto parent = index.parents[position];
+    nodes.push_back(
+        {.tag = intern(node.tag),
+         .parent = parent == std::string_view::npos
+                       ? no_parent
+                       : static_cast<std::uint32_t>(parent),
+         .depth = static_cast<std::uint32_t>(index.depths[position]),
+         .size = static_cast<std::uint32_t>(index.sizes[position]),
+         .first_attribute = static_cast<std::uint32_t>(attributes.size()),
+         .attribute_count =
+             static_cast<std::uint32_t>(node.attributes.size())});
+    for (const auto &[name, value] : node.attributes)
+      attributes.push_back({intern(name), intern(value)});
+  }
+
+  Header header;
+  header.node_count = static_cast<std::uint32_t>(nodes.size());
+  header.attribute_count = static_cast<std::uint32_t>(attributes.size());
+  header.string_count = static_cast<std::uint32_t>(strings.size());
+  header.string_bytes = string_bytes;
+  const auto layout = sections(header);
+
+  bytes.assign(layout.end, '\0');
+  put(bytes, 0, header);
+  if (!nodes.empty())
+    std::memcpy(bytes.data() + layout.nodes, nodes.data(),
+                nodes.size() * sizeof(NodeRecord));
+  if (!attributes.empty())
+    std::memcpy(bytes.data() + layout.attributes, attributes.data(),
+                attributes.size() * sizeof(AttributeRecord));
+
+  std::uint64_t offset = 0;
+  for (std::size_t i = 0; i < strings.size(); ++i) {
+    put(bytes, layout.offsets + i * sizeof(std::uint32_t),
+        static_cast<std::uint32_t>(offset));
+    std::memcpy(bytes.data() + layout.strings + offset, strings[i].data(),
+                strings[i].size());
+    offset += strings[i].size();
+  }
+  put(bytes, layout.offsets + strings.size() * sizeof(std::uint32_t),
+      static_cast<std::uint32_t>(offset));
+}
+
+auto SnapshotUtils::write(const TreeUtils::Tree &tree, std::string_view path)
+    -> Expected<void> {
+  if (path.empty()) {
+    return std::unexpected(
+        make_error(Status::InvalidPath, "Invalid path! Path cannot be empty."));
+  }
+
+  std::string bytes;
+  SnapshotUtils::encode(tree, bytes);
+
+  std::ofstream file(std::string{path}, std::ios::binary | std::ios::trunc);
+  if (!file.is_open() ||
+      !file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()))) {
+    return std::unexpected(
+        make_error(Status::FileError,
+                   std::format("Failed to write snapshot '{}'.", path)));
+  }
+  return {};
+}
+
+auto Snapshot::bind(std::shared_ptr<const void> storage, const std::byte *data,
+                    std::size_t size) -> Expected<Snapshot> {
+  if (size < sizeof(Header))
+    return std::unexpected(invalid("Snapshot is too small."));
+  if (reinterpret_cast<std::uintptr_t>(data) % alignof(Header) != 0)
+    return std::unexpected(invalid("Snapshot data is not aligned."));
+
+  Snapshot snapshot;
+  snapshot.header_ = reinterpret_cast<const Header *>(data);
+  const auto &header = *snapshot.header_;
+  if (header.magic != magic)
+    return std::unexpected(
+        invalid("Not a snapshot (or written with another byte order)."));
+  if (header.version != version) {
+    return std::unexpected(invalid(
+        std::format("Snapshot version {} is not supported (expected {}).",
+                    header.version, version)));
+  }
+
+  const auto layout = sections(header);
+  if (header.string_bytes > std::numeric_limits<std::uint32_t>::max() ||
+      layout.end > size)
+    return std::unexpected(invalid("Snapshot is truncated."));
+
+  snapshot.nodes_ = reinterpret_cast<const NodeRecord *>(data + layout.nodes);
+  snapshot.attributes_ =
+      reinterpret_cast<const AttributeRecord *>(data + layout.attributes);
+  snapshot.offsets_ =
+      reinterpret_cast<const std::uint32_t *>(data + layout.offsets);
+  snapshot.strings_ = reinterpret_cast<const char *>(data + layout.strings);
+
+  // Bounds only (a linear scan of integers): accessors can then trust indices
+  for (std::uint32_t i = 0; i < header.string_count; ++i) {
+    if (snapshot.offsets_[i] > snapshot.offsets_[i + 1])
+      return std::unexpected(invalid("Corrupt string table."));
+  }
+  if (snapshot.offsets_[header.string_count] != header.string_bytes)
+    return std::unexpected(invalid("Corrupt string table."));
+
+  for (std::uint32_t i = 0; i < header.node_count; ++i) {
+    const auto &node = snapshot.nodes_[i];
+    const bool parent_ok =
+        (i == 0) ? node.parent == no_parent : node.parent < i;
+    if (!parent_ok || node.tag >= header.string_count || node.size == 0 ||
+        node.size > header.node_count - i ||
+        std::uint64_t{node.first_attribute} + node.attribute_count >
+            header.attribute_count)
+      return std::unexpected(invalid(std::format("Corrupt node {}.", i)));
+  }
+  for (std::uint32_t i = 0; i < header.attribute_count; ++i) {
+    const auto &attribute = snapshot.attributes_[i];
+    if (attribute.name >= header.string_count ||
+        attribute.value >= header.string_count)
+      return std::unexpected(invalid(std::format("Corrupt attribute {}.", i)));
+  }
+
+  snapshot.storage_ = std::move(storage);
+  return snapshot;
+}
+
+auto Snapshot::open(std::string_view path) -> Expected<Snapshot> {
+  if (path.empty()) {
+    return std::unexpected(
+        make_error(Status::InvalidPath, "Invalid path! Path cannot be empty."));
+  }
+  const std::string file_path{path};
+  auto failed = [&path]() {
+    return std::unexpected(make_error(
+        Status::FileError, std::format("Failed to open snapshot '{}'.", path)));
+  };
+
+#ifdef SNAPSHOT_MMAP
+  const int fd = ::open(file_path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return failed();
+  struct stat info {};
+  if (::fstat(fd, &info) != 0) {
+    ::close(fd);
+    return failed();
+  }
+  if (info.st_size == 0) {
+    ::close(fd);
+    return std::unexpected(invalid("Snapshot is empty."));
+  }
+
+  const auto size = static_cast<std::size_t>(info.st_size);
+  void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd); // the mapping stays valid
+  if (data == MAP_FAILED)
+    return failed();
+
+  std::shared_ptr<const void> storage(data, [size](const void *mapped) {
+    ::munmap(const_cast<void *>(mapped), size);
+  });
+  return bind(std::move(storage), static_cast<const std::byte *>(data), size);
+#else
+  std::ifstream file(file_path, std::ios::binary);
+  if (!file.is_open())
+    return failed();
+  std::string bytes{std::istreambuf_iterator<char>(file), {}};
+  return from_bytes(std::move(bytes));
+#endif
+}
+
+auto Snapshot::from_bytes(std::string bytes) -> Expected<Snapshot> {
+  auto storage = std::make_shared<const std::string>(std::move(bytes));
+  const auto *data = reinterpret_cast<const std::byte *>(storage->data());
+  const auto size = storage->size();
+  return bind(std::move(storage), data, size);
+}
+
+auto Snapshot::string(std::uint32_t index) const -> std::string_view {
+  return {strings_ + offsets_[index], offsets_[index + 1] - offsets_[index]};
+}
+
+auto Snapshot::tag(std::size_t position) const -> std::string_view {
+  return string(nodes_[position].tag);
+}
+
+auto Snapshot::parent(std::size_t position) const -> std::size_t {
+  const auto parent = nodes_[position].parent;
+  return parent == no_parent ? std::string_view::npos : parent;
+}
+
+auto Snapshot::depth(std::size_t position) const -> int {
+  return static_cast<int>(nodes_[position].depth);
+}
+
+auto Snapshot::subtree_size(std::size_t position) const -> std::size_t {
+  return nodes_[position].size;
+}
+
+auto Snapshot::attribute_count(std::size_t position) const -> std::size_t {
+  return nodes_[position].attribute_count;
+}
+
+auto Snapshot::attribute(std::size_t position, std::size_t k) const
+    -> std::pair<std::string_view, std::string_view> {
+  const auto &attribute = attributes_[nodes_[position].first_attribute + k];
+  return {string(attribute.name), string(attribute.value)};
+}
+
+auto Snapshot::tree() const -> TreeUtils::Tree {
+  TreeUtils::Tree tree;
+  TreeUtils::NodePool pool;
+  this->tree(tree, pool);
+  return tree;
+}
+
+void Snapshot::tree(TreeUtils::Tree &tree, TreeUtils::NodePool &pool) const {
+  TreeUtils::release(tree, pool);
+
+  // Released nodes keep their string capacity
+  auto acquire = [&pool] {
+    if (pool.nodes.empty())
+      return std::make_unique<TreeUtils::Node>(std::string{});
+    auto node = std::move(pool.nodes.back());
+    pool.nodes.pop_back();
+    node->contents.clear();
+    node->invalidate();
+    return node;
+  };
+
+  auto &nodes = pool.stack; // by position
+  nodes.resize(size());
+  for (std::size_t position = 0; position < size(); ++position) {
+    auto node = acquire();
+    node->tag.assign(tag(position));
+    node->attributes.resize(attribute_count(position));
+    for (std::size_t k = 0; k < node->attributes.size(); ++k) {
+      auto [name, value] = attribute(position, k);
+      node->attributes[k].first.assign(name);
+      node->attributes[k].second.assign(value);
+    }
+
+    nodes[position] = node.get();
+    if (position == 0)
+      tree.root = std::move(node);
+    else
+      nodes[parent(position)]->children.push_back(std::move(node));
+  }
+  nodes.clear();
+
+  TreeUtils::reindex(tree);
+}
+
+void SnapshotUtils::table(const Snapshot &snapshot, CsvTable &csvTable) {
+  csvTable.clear();
+  if (snapshot.empty())
+    return;
+
+  csvTable.push_back({"ID", "ParentID", "Depth", "Tag", "Attribute", "Value"});
+  for (std::size_t position = 0; position < snapshot.size(); ++position) {
+    const auto parent = snapshot.parent(position);
+    auto push = [&](std::string_view name, std::string_view value) {
+      csvTable.push_back(
+          {std::to_string(position),
+           parent == std::string_view::npos ? "-1" : std::to_string(parent),
+           std::to_string(snapshot.depth(position)),
+           std::string{snapshot.tag(position)}, std::string{name},
+           std::string{value}});
+    };
+
+    if (snapshot.attribute_count(position) == 0)
+      push("", "");
+    for (std::size_t k = 0; k < snapshot.attribute_count(position); ++k) {
+      auto [name, value] = snapshot.attribute(position, k);
+      push(name, value);
+    }
+  }
+}
+
+void test_snapshot_utils() {
+
+  using TreeUtils::TagTuple;
+  using TreeUtils::TagType;
+
+  auto tree = TreeUtils::process(std::vector<TagTuple>{
+      {"svg", {{"width", "100"}}, TagType::Open},
+      {"g", {{"fill", "red"}}, TagType::Open},
+      {"rect", {{"width", "100"}, {"fill", "red"}}, TagType::SelfClose},
+      {"circle", {}, TagType::SelfClose},
+      {"g", {}, TagType::Close},
+      {"path", {{"d", "M0,0L1,1"}}, TagType::SelfClose},
+      {"svg", {}, TagType::Close}});
+
+  std::string bytes;
+  SnapshotUtils::encode(tree, bytes);
+
+  // Repeated strings are stored once
+  Header header;
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  assert(header.node_count == 5 && header.attribute_count == 5);
+  // svg width 100 g fill red rect circle path d M0,0L1,1
+  assert(header.string_count == 11);
+  assert(bytes.size() == sections(header).end);
+
+  // Views and round trip
+  auto snapshot = Snapshot::from_bytes(bytes);
+  assert(snapshot && snapshot->size() == 5);
+  assert(snapshot->tag(2) == "rect" && snapshot->parent(2) == 1);
+  assert(snapshot->parent(0) == std::string_view::npos);
+  assert(snapshot->depth(2) == 2 && snapshot->subtree_size(1) == 3);
+  assert(snapshot->attribute(2, 1) ==
+         (std::pair<std::string_view, std::string_view>{"fill", "red"}));
+
+  auto copy = snapshot->tree();
+  assert(TreeUtils::same(*copy.root, *tree.root));
+  assert(copy.index.hashes == tree.index.hashes);
+
+  SnapshotUtils::CsvTable csvTable;
+  SnapshotUtils::table(*snapshot, csvTable);
+  assert(csvTable == TreeUtils::table(tree));
+
+  // Mapped file
+  assert(SnapshotUtils::write(tree, "resources/snapshot.snap"));
+  auto mapped = Snapshot::open("resources/snapshot.snap");
+  assert(mapped && mapped->tag(4) == "path");
+  assert(mapped->attribute(4, 0).second == "M0,0L1,1");
+
+  // Errors
+  assert(Snapshot::open("resources/missing.snap").error().status ==
+         Status::FileError);
+  assert(Snapshot::from_bytes("SVGS").error().status ==
+         Status::InvalidSnapshot);
+
+  auto versioned = bytes;
+  put(versioned, offsetof(Header, version), SnapshotUtils::version + 1);
+  assert(Snapshot::from_bytes(versioned).error().status ==
+         Status::InvalidSnapshot);
+
+  auto truncated = bytes.substr(0, bytes.size() - 1);
+  assert(!Snapshot::from_bytes(truncated));
+
+  auto corrupt = bytes;
+  put(corrupt, sections(header).nodes + offsetof(NodeRecord, tag),
+      std::uint32_t{99});
+  assert(!Snapshot::from_bytes(corrupt));
+
+  std::string empty;
+  SnapshotUtils::encode({}, empty);
+  assert(Snapshot::from_bytes(empty)->empty());
+  assert(Snapshot::from_bytes(empty)->tree().root == nullptr);
+
+  std::println("{}[TEST]{} : {} : test completed", color::green, color::reset,
+               __PRETTY_FUNCTION__);
+}
+
+#ifdef BUILD_TEST_EXE
+auto main() -> int {
+
+  test_snapshot_utils();
+
+  return 0;
+}
+#endif
@@ -0,0 +1,312 @@
+#include "spatial_index.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <charconv>
+#include <cmath>
+#include <print>
+#include <queue>
+#include <random>
+#include <span>
+
+using SpatialIndex::BBox;
+using SpatialIndex::Entry;
+
+namespace {
+
+auto center_x(const BBox &box) -> double { return box.min_x + box.max_x; }
+auto center_y(const BBox &box) -> double { return box.min_y + box.max_y; }
+
+// Sort-Tile-Recursive order: vertical slices by x, each slice by y.
+// Consecutive runs of `fanout` items then form the nodes of one level.
+template <typename T, typename BoxOf>
+void str_sort(std::span<T> items, std::size_t fanout, BoxOf box_of) {
+  const std::size_t n = items.size();
+  const std::size_t groups = (n + fanout - 1) / fanout;
+  const auto slices = static_cast<std::size_t>(
+      std::ceil(std::sqrt(static_cast<double>(groups))));
+  const std::size_t slice_size = slices * fanout;
+
+  std::ranges::sort(items, [&box_of](const T &a, const T &b) {
+    return center_x(box_of(a)) < center_x(box_of(b));
+  });
+  for (std::size_t s = 0; s < n; s += slice_size) {
+    auto slice = items.subspan(s, std::min(slice_size, n - s));
+    std::ranges::sort(slice, [&box_of](const T &a, const T &b) {
+      return center_y(box_of(a)) < center_y(box_of(b));
+    });
+  }
+}
+
+// Squared distance from a point to a box (0 inside).
+auto distance2(const BBox &box, double x, double y) -> double {
+  const double dx = std::max({box.min_x - x, 0.0, x - box.max_x});
+  const double dy = std::max({box.min_y - y, 0.0, y - box.max_y});
+  return dx * dx + dy * dy;
+}
+
+template <typename Number>
+void assign_number(std::string &cell, Number number) {
+  std::array<char, 32> buffer{};
+  auto [end, ec] =
+      std::to_chars(buffer.data(), buffer.data() + buffer.size(), number);
+  cell.assign(buffer.data(), end);
+}
+
+} // namespace
+
+SpatialIndex::RTree::RTree(const TreeUtils::Tree &tree) { build(tree); }
+
+void SpatialIndex::RTree::build(const TreeUtils::Tree &tree) {
+  std::vector<Entry> entries;
+  long long current_id = 0;
+
+  // Pre-order numbering, as in TreeUtils::table
+  auto traverse = [&](auto &self, const TreeUtils::Node &node) -> void {
+    const long long id = current_id++;
+
+    bool drawn = node.bbox.has_value();
+    for (const auto &child : node.children) {
+      if (child->bbox)
+        drawn = false;
+      self(self, *child);
+    }
+    if (drawn)
+      entries.push_back({*node.bbox, &node, id});
+  };
+
+  if (tree.root)
+    traverse(traverse, *tree.root);
+  build(std::move(entries));
+}
+
+void SpatialIndex::RTree::build(std::vector<Entry> entries) {
+  std::erase_if(entries, [](const Entry &e) { return e.box.empty(); });
+  entries_ = std::move(entries);
+  nodes_.clear();
+  if (entries_.empty())
+    return;
+
+  // Leaves
+  str_sort(std::span(entries_), fanout,
+           [](const Entry &e) -> const BBox & { return e.box; });
+  for (std::size_t i = 0; i < entries_.size(); i += fanout) {
+    Branch leaf{.box = {},
+                .first = i,
+                .count = std::min(fanout, entries_.size() - i),
+                .leaf = true};
+    for (std::size_t j = 0; j < leaf.count; ++j)
+      leaf.box.expand(entries_[i + j].box);
+    nodes_.push_back(leaf);
+  }
+
+  // Upper levels until a single root remains
+  std::size_t level = 0;
+  while (nodes_.size() - level > 1) {
+    const std::size_t end = nodes_.size();
+    str_sort(std::span(nodes_).subspan(level, end - level), fanout,
+             [](const Branch &b) -> const BBox & { return b.box; });
+    for (std::size_t i = level; i < end; i += fanout) {
+      Branch parent{
+          .box = {}, .first = i, .count = std::min(fanout, end - i)};
+      for (std::size_t j = 0; j < parent.count; ++j)
+        parent.box.expand(nodes_[i + j].box);
+      nodes_.push_back(parent);
+    }
+    level = end;
+  }
+}
+
+auto SpatialIndex::RTree::query(const BBox &region) const
+    -> std::vector<const Entry *> {
+  std::vector<const Entry *> hits;
+  query(region, hits);
+  return hits;
+}
+
+void SpatialIndex::RTree::query(const BBox &region,
+                                std::vector<const Entry *> &hits) const {
+  hits.clear();
+  if (nodes_.empty() || region.empty())
+    return;
+
+  auto visit = [&](auto &self, const Branch &branch) -> void {
+    for (std::size_t i = branch.first; i < branch.first + branch.count; ++i) {
+      if (branch.leaf) {
+        if (entries_[i].box.intersects(region))
+          hits.push_back(&entries_[i]);
+      } else if (nodes_[i].box.intersects(region)) {
+        self(self, nodes_[i]);
+      }
+    }
+  };
+
+  if (nodes_.back().box.intersects(region))
+    visit(visit, nodes_.back());
+}
+
+auto SpatialIndex::RTree::nearest(double x, double y, std::size_t count) const
+    -> std::vector<const Entry *> {
+  std::vector<const Entry *> result;
+  if (nodes_.empty() || count == 0)
+    return result;
+
+  // Best-first search: boxes and entries ordered by distance
+  struct Candidate {
+    double distance;
+    std::size_t index;
+    bool entry;
+
+    auto operator>(const Candidate &o) const -> bool {
+      return distance > o.distance;
+    }
+  };
+  std::priority_queue<Candidate, std::vector<Candidate>, std::greater<>> queue;
+  queue.push({distance2(nodes_.back().box, x, y), nodes_.size() - 1, false});
+
+  while (!queue.empty() && result.size() < count) {
+    const auto candidate = queue.top();
+    queue.pop();
+
+    if (candidate.entry) {
+      result.push_back(&entries_[candidate.index]);
+      continue;
+    }
+
+    const auto &branch = nodes_[candidate.index];
+    for (std::size_t i = branch.first; i < branch.first + branch.count; ++i) {
+      const auto &box = branch.leaf ? entries_[i].box : nodes_[i].box;
+      queue.push({distance2(box, x, y), i, branch.leaf});
+    }
+  }
+
+  return result;
+}
+
+auto SpatialIndex::RTree::bounds() const -> BBox {
+  return nodes_.empty() ? BBox{} : nodes_.back().box;
+}
+
+auto SpatialIndex::table(const std::vector<const Entry *> &entries)
+    -> CsvTable {
+  std::vector<const Entry *> sorted(entries);
+  std::ranges::sort(sorted, {}, &Entry::id);
+
+  CsvTable csvTable;
+  csvTable.reserve(sorted.size() + 1);
+  csvTable.push_back({"ID", "Tag", "MinX", "MinY", "MaxX", "MaxY"});
+
+  for (const auto *entry : sorted) {
+    auto &row = csvTable.emplace_back(6);
+    assign_number(row[0], entry->id);
+    if (entry->node)
+      row[1] = entry->node->tag;
+    assign_number(row[2], entry->box.min_x);
+    assign_number(row[3], entry->box.min_y);
+    assign_number(row[4], entry->box.max_x);
+    assign_number(row[5], entry->box.max_y);
+  }
+
+  return csvTable;
+}
+
+void test_spatial_index() {
+
+  using SpatialIndex::RTree;
+
+  auto ids = [](std::vector<const Entry *> hits) {
+    std::vector<long long> result;
+    for (const auto *hit : hits)
+      result.push_back(hit->id);
+    std::ranges::sort(result);
+    return result;
+  };
+
+  // Empty index
+  RTree empty;
+  assert(empty.empty() && empty.query(BBox{0, 0, 10, 10}).empty());
+  assert(empty.nearest(0, 0).empty());
+
+  // Random boxes against a linear scan
+  std::mt19937 random(42);
+  std::uniform_real_distribution<double> position(0.0, 1000.0);
+  std::uniform_real_distribution<double> extent(0.0, 20.0);
+
+  std::vector<Entry> entries;
+  for (long long id = 0; id < 5000; ++id) {
+    const double x = position(random), y = position(random);
+    entries.push_back({BBox{x, y, x + extent(random), y + extent(random)},
+                       nullptr, id});
+  }
+  entries.push_back({BBox{}, nullptr, -1}); // empty: not indexed
+
+  RTree index;
+  index.build(entries);
+  assert(index.size() == 5000);
+
+  std::vector<const Entry *> hits;
+  for (int q = 0; q < 200; ++q) {
+    const double x = position(random), y = position(random);
+    const BBox region{x, y, x + 5 * extent(random), y + 5 * extent(random)};
+
+    std::vector<long long> expected;
+    for (const auto &entry : entries)
+      if (!entry.box.empty() && entry.box.intersects(region))
+        expected.push_back(entry.id);
+
+    index.query(region, hits);
+    assert(ids(hits) == expected);
+  }
+
+  // Nearest against a linear scan
+  for (int q = 0; q < 50; ++q) {
+    const double x = position(random), y = position(random);
+    auto near = index.nearest(x, y, 3);
+    assert(near.size() == 3);
+
+    std::vector<double> distances;
+    for (const auto &entry : entries)
+      if (!entry.box.empty())
+        distances.push_back(distance2(entry.box, x, y));
+    std::ranges::sort(distances);
+    for (std::size_t i = 0; i < near.size(); ++i)
+      assert(distance2(near[i]->box, x, y) == distances[i]);
+  }
+
+  // Tree: groups are not indexed, IDs follow TreeUtils::table
+  auto tree = TreeUtils::process(std::vector<TreeUtils::TagTuple>{
+      {"svg", {}, TreeUtils::TagType::Open},
+      {"g", {}, TreeUtils::TagType::Open},
+      {"rect", {}, TreeUtils::TagType::SelfClose},
+      {"circle", {}, TreeUtils::TagType::SelfClose},
+      {"g", {}, TreeUtils::TagType::Close},
+      {"svg", {}, TreeUtils::TagType::Close}});
+  auto &g = *tree.root->children[0];
+  g.children[0]->bbox = BBox{0, 0, 10, 10};
+  g.children[1]->bbox = BBox{20, 20, 30, 30};
+  g.bbox = tree.root->bbox = BBox{0, 0, 30, 30};
+
+  RTree shapes(tree);
+  assert(shapes.size() == 2);
+  assert(shapes.bounds() == (BBox{0, 0, 30, 30}));
+  auto region = shapes.query(BBox{5, 5, 25, 25});
+  assert(ids(region) == (std::vector<long long>{2, 3}));
+  assert(shapes.nearest(29, 15).front()->node->tag == "circle");
+
+  auto csv = SpatialIndex::table(shapes.query(BBox{0, 0, 1, 1}));
+  assert(csv.size() == 2);
+  assert(csv[1] == (svg_core::CsvRow{"2", "rect", "0", "0", "10", "10"}));
+
+  std::println("{}[TEST]{} : {} : test completed", color::green, color::reset,
+               __PRETTY_FUNCTION__);
+}
+
+#ifdef BUILD_TEST_EXE
+auto main() -> int {
+
+  test_spatial_index();
+
+  return 0;
+}
+#endif
@@ -3,33 +3,109 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
 #include <print>
-#include <ranges>
 #include <string>
 
 using namespace svg_core;
 
+namespace {
+
+// Non-printable/Control Characters
+constexpr std::array invisible{
+    '\n', // Line Feed
+    '\r', // Carriage Return
+    '\t', // Horizontal Tab
+    '\v', // Vertical Tab
+    '\f', // Form Feed
+    '\0', // NULL
+    '\b', // Backspace
+};
+
+auto is_invisible(char ch) -> bool {
+  return std::find(invisible.begin(), invisible.end(), ch) != invisible.end();
+}
+
+auto is_space(char ch) -> bool {
+  return std::isspace(static_cast<unsigned char>(ch)) != 0;
+}
+
+// Control characters read as a space: line breaks and tabs separate
+// attributes and, inside values, are normalized to spaces as in XML
+auto is_blank(char ch) -> bool {
+  return ch == '\n' || ch == '\r' || ch == '\t';
+}
+
+// Copy of str with line breaks and tabs as spaces, other controls removed
+void normalize(std::string_view str, std::string &out) {
+  out.clear();
+  for (char ch : str) {
+    if (is_blank(ch))
+      out += ' ';
+    else if (!is_invisible(ch))
+      out += ch;
+  }
+}
+
+auto trim(std::string_view str) -> std::string_view {
+  while (!str.empty() && is_space(str.front()))
+    str.remove_prefix(1);
+  while (!str.empty() && is_space(str.back()))
+    str.remove_suffix(1);
+  return str;
+}
+
+// Reuse slot 'index' of a vector, growing it only when needed.
+template <typename Vector>
+auto slot(Vector &vec, std::size_t index) -> typename Vector::value_type & {
+  if (index >= vec.size())
+    vec.emplace_back();
+  return vec[index];
+}
+
+// End of the tag whose '<' is at begin: position of its '>', of an
+// unexpected '<' before it, or npos if unclosed. Quoted values may hold
+// '<' and '>'; comments, CDATA sections and processing instructions end
+// at their own delimiter.
+auto tag_end(std::string_view svg, std::size_t begin) -> std::size_t {
+  constexpr auto npos = std::string_view::npos;
+  const auto rest = svg.substr(begin);
+  auto after = [&](std::string_view delimiter) {
+    const auto at = svg.find(delimiter, begin + 2);
+    return at == npos ? npos : at + delimiter.size() - 1;
+  };
+  if (rest.starts_with("<!--"))
+    return after("-->");
+  if (rest.starts_with("<![CDATA["))
+    return after("]]>");
+  if (rest.starts_with("<?"))
+    return after("?>");
+
+  for (auto i = svg.find_first_of("<>\"'", begin + 1); i != npos;
+       i = svg.find_first_of("<>\"'", i + 1)) {
+    if (svg[i] != '"' && svg[i] != '\'')
+      return i;
+    i = svg.find(svg[i], i + 1); // closing quote
+    if (i == npos)
+      return npos;
+  }
+  return npos;
+}
+
+auto split(std::string_view svg, std::vector<std::string> &tags,
+           std::vector<StringUtils::Span> *spans) -> Expected<void>;
+
+} // namespace
+
 auto StringUtils::sanitize(std::string_view str) -> std::string {
 
   // Backup
   std::string bkp(str);
 
   // Remove Non-printable/Control Characters
-  std::array invisible{
-      '\n', // Line Feed
-      '\r', // Carriage Return
-      '\t', // Horizontal Tab
-      '\v', // Vertical Tab
-      '\f', // Form Feed
-      '\0', // NULL
-      '\b', // Backspace
-  };
-
-  auto isInvisible = [&invisible](char ch) {
-    return std::find(invisible.begin(), invisible.end(), ch) != invisible.end();
-  };
-
-  bkp.erase(std::remove_if(bkp.begin(), bkp.end(), isInvisible), bkp.end());
+  bkp.erase(std::remove_if(bkp.begin(), bkp.end(), is_invisible), bkp.end());
 
   // Return sanitized string
   return bkp;
@@ -37,156 +113,341 @@ auto StringUtils::sanitize(std::string_view str) -> std::string {
 
 auto StringUtils::validate(std::string_view svg) -> bool {
 
-  // Sanitize
-  std::string bkp{StringUtils::sanitize(svg)};
+  // Every '<' closed by a '>' (quotes, comments and CDATA aware) and at
+  // least one tag; a '>' outside tags is text
+  std::size_t tags{0};
+  std::size_t position{0};
+  while (position < svg.size()) {
+    const auto open_at = svg.find('<', position);
+    if (open_at == std::string_view::npos)
+      break;
+    const auto end = tag_end(svg, open_at);
+    if (end == std::string_view::npos || svg[end] != '>')
+      return false;
+    ++tags;
+    position = end + 1;
+  }
+  return tags > 0;
+}
+
+auto StringUtils::prepare(std::string_view svg)
+    -> Expected<std::vector<std::string>> {
+  std::vector<std::string> result{};
+  auto prepared = StringUtils::prepare(svg, result);
+  if (!prepared)
+    return std::unexpected(prepared.error());
+  return result;
+}
+
+auto StringUtils::prepare(std::string_view svg, std::vector<std::string> &tags)
+    -> Expected<void> {
+  return split(svg, tags, nullptr);
+}
+
+auto StringUtils::prepare(std::string_view svg, std::vector<std::string> &tags,
+                          std::vector<Span> &spans) -> Expected<void> {
+  spans.clear();
+  return split(svg, tags, &spans);
+}
 
-  // Remove all spaces.
-  bkp.erase(std::remove_if(bkp.begin(), bkp.end(), ::isspace), bkp.end());
+namespace {
 
-  // Count < and >
-  auto count_greater = std::count(bkp.begin(), bkp.end(), '>');
-  auto count_smaller = std::count(bkp.begin(), bkp.end(), '<');
+auto split(std::string_view svg, std::vector<std::string> &tags,
+           std::vector<StringUtils::Span> *spans) -> Expected<void> {
 
-  if (count_smaller < 1 || count_greater < 1) {
-    return false;
+  using svg_core::make_error;
+
+  constexpr auto npos = std::string_view::npos;
+
+  // Prepare output
+  // A '>' between tags is character data (legal XML)
+  std::size_t count{0};
+  std::size_t position{0};
+  while (position < svg.size()) {
+    const auto open_at = svg.find('<', position);
+    if (open_at == npos)
+      break;
+
+    const auto end = tag_end(svg, open_at);
+    if (end == npos) {
+      tags.resize(count);
+      return std::unexpected(
+          make_error(Status::MalformedTag, "Unclosed tag.", svg, open_at));
+    }
+    if (svg[end] == '<') {
+      tags.resize(count);
+      return std::unexpected(make_error(
+          Status::MalformedTag, "Unexpected '<' inside tag.", svg, end));
+    }
+
+    auto &str = slot(tags, count++);
+    const auto content = svg.substr(open_at, end - open_at + 1);
+    if (std::any_of(content.begin(), content.end(), is_invisible))
+      normalize(content, str);
+    else
+      str.assign(content);
+    if (spans)
+      spans->emplace_back(open_at, end + 1);
+    position = end + 1;
   }
+  tags.resize(count);
 
-  if (count_smaller != count_greater) {
-    return false;
+  if (tags.empty()) {
+    return std::unexpected(
+        make_error(Status::EmptyInput, "No tags found in SVG text."));
   }
 
-  // Validate if not empty.
-  return !bkp.empty();
+  return {};
 }
 
-auto StringUtils::prepare(std::string_view svg) -> std::vector<std::string> {
-
-  if (!StringUtils::validate(svg)) {
-    std::println("{}[ERROR]{} : SVG structure is broken or invalid!",
-                 color::red, color::reset);
+} // namespace
+
+auto StringUtils::tag_offset(std::string_view svg, std::size_t index)
+    -> std::size_t {
+  constexpr auto npos = std::string_view::npos;
+  for (auto i = svg.find('<'); i != npos; i = svg.find('<', i + 1)) {
+    if (index-- == 0)
+      return i;
+    i = tag_end(svg, i);
+    if (i == npos)
+      break;
   }
+  return npos;
+}
 
-  // Sanitize
-  std::string bkp{StringUtils::sanitize(svg)};
+void StringUtils::contents(std::string_view svg, const std::vector<Span> &spans,
+                           std::vector<Content> &contents) {
+  using Kind = Content::Kind;
+  constexpr auto npos = std::string_view::npos;
 
-  // Prepare output
-  std::vector<std::string> result{};
-  std::string str{};
-  bool flag{false};
-  for (const auto &ch : bkp) {
-    if (ch == '<') {
-      flag = true;
+  contents.clear();
+
+  // Open elements: {pre-order position, child elements seen so far}
+  std::vector<std::pair<std::size_t, std::size_t>> open;
+  std::size_t position{0};
+
+  auto add = [&](Kind kind, std::size_t begin, std::size_t end) {
+    // Outside the root: before it (0) or after it (npos)
+    const auto element = open.empty() ? npos : open.back().first;
+    const auto after = !open.empty() ? open.back().second
+                       : position == 0 ? 0
+                                       : npos;
+    contents.push_back({kind, begin, end, element, after});
+  };
+
+  std::size_t previous{0};
+  for (const auto &[begin, end] : spans) {
+    const auto text = svg.substr(previous, begin - previous);
+    if (!std::all_of(text.begin(), text.end(), is_space))
+      add(Kind::Text, previous, begin);
+    previous = end;
+
+    const auto tag = svg.substr(begin, end - begin);
+    if (tag.starts_with("<!--")) {
+      add(Kind::Comment, begin + 4, end - 3);
+    } else if (tag.starts_with("<![CDATA[")) {
+      add(Kind::CData, begin + 9, end - 3);
+    } else if (tag.starts_with("<?")) {
+      add(Kind::Instruction, begin + 2, end - 2);
+    } else if (tag.starts_with("<!")) {
+      continue;
+    } else if (trim(tag.substr(1)).starts_with("/")) {
+      if (!open.empty())
+        open.pop_back();
+    } else {
+      if (!open.empty())
+        ++open.back().second;
+      if (!trim(tag.substr(0, tag.size() - 1)).ends_with("/"))
+        open.emplace_back(position, 0);
+      ++position;
     }
-    if (flag) {
-      str.push_back(ch);
+  }
+  const auto text = svg.substr(previous);
+  if (!std::all_of(text.begin(), text.end(), is_space))
+    add(Kind::Text, previous, svg.size());
+}
+
+void StringUtils::decode(std::string_view text, std::string &out) {
+  constexpr auto npos = std::string_view::npos;
+  // Longest reference between '&' and ';' ("#x10FFFF")
+  constexpr std::size_t longest = 8;
+
+  out.clear();
+  std::size_t start{0};
+  for (auto amp = text.find('&'); amp != npos; amp = text.find('&', amp + 1)) {
+    const auto semicolon = text.substr(amp + 1, longest + 1).find(';');
+    if (semicolon == npos)
+      continue;
+    const auto name = text.substr(amp + 1, semicolon);
+
+    char32_t code{0};
+    if (name == "amp")
+      code = '&';
+    else if (name == "lt")
+      code = '<';
+    else if (name == "gt")
+      code = '>';
+    else if (name == "quot")
+      code = '"';
+    else if (name == "apos")
+      code = '\'';
+    else if (name.size() > 1 && name.front() == '#') {
+      const bool hex = name[1] == 'x' || name[1] == 'X';
+      const auto digits = name.substr(hex ? 2 : 1);
+      std::uint32_t value{0};
+      auto [end, ec] = std::from_chars(digits.data(),
+                                       digits.data() + digits.size(), value,
+                                       hex ? 16 : 10);
+      const bool valid = !digits.empty() && ec == std::errc{} &&
+                         end == digits.data() + digits.size() && value > 0 &&
+                         value <= 0x10FFFF &&
+                         (value < 0xD800 || value > 0xDFFF);
+      if (valid)
+        code = value;
     }
-    if (ch == '>') {
-      flag = false;
-      result.push_back(str);
-      str.clear();
+    if (code == 0)
+      continue;
+
+    out.append(text.data() + start, amp - start);
+    // UTF-8
+    if (code < 0x80) {
+      out += static_cast<char>(code);
+    } else if (code < 0x800) {
+      out += static_cast<char>(0xC0 | (code >> 6));
+      out += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+      out += static_cast<char>(0xE0 | (code >> 12));
+      out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+      out += static_cast<char>(0xF0 | (code >> 18));
+      out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+      out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (code & 0x3F));
     }
+    amp += semicolon + 1;
+    start = amp + 1;
   }
-
-  // Return prepared structure
-  return result;
+  out.append(text.data() + start, text.size() - start);
 }
 
-auto StringUtils::process(std::string_view svg) -> TagTuple {
-  if (!StringUtils::validate(svg)) {
-    std::println("{}[ERROR]{} : SVG structure is broken or invalid!",
-                 color::red, color::reset);
-    return {/* empty */};
-  }
+auto StringUtils::process(std::string_view svg) -> Expected<TagTuple> {
+  TagTuple token{};
+  auto processed = StringUtils::process(svg, token);
+  if (!processed)
+    return std::unexpected(processed.error());
+  return token;
+}
 
-  // Trim
-  auto trim = [](std::string &str) {
-    auto start = std::find_if_not(str.begin(), str.end(), ::isspace);
-    auto end = std::find_if_not(str.rbegin(), str.rend(), ::isspace).base();
-    return (start < end) ? std::string(start, end) : "";
-  };
+auto StringUtils::process(std::string_view svg, TagTuple &token)
+    -> Expected<void> {
 
-  // Split
-  auto split = [](std::string &str, char ch) {
-    auto vec = str | std::ranges::views::split(ch) |
-               std::ranges::views::transform([](auto const &sr) {
-                 return std::string_view(sr.begin(), sr.end());
-               }) |
-               std::ranges::to<std::vector<std::string>>();
-    return vec;
-  };
+  using svg_core::make_error;
 
-  // Sanitize
-  std::string bkp{StringUtils::sanitize(svg)};
-  bkp = trim(bkp);
+  auto &[tag, attributes, tag_type] = token;
 
-  // Count < and >
-  auto count_greater = std::count(bkp.begin(), bkp.end(), '>');
-  auto count_smaller = std::count(bkp.begin(), bkp.end(), '<');
+  auto malformed = [&svg]() {
+    return std::unexpected(make_error(
+        Status::MalformedTag, "SVG structure is broken or invalid!", svg, 0));
+  };
 
-  if (count_smaller != 1 || count_greater != 1) {
-    std::println("{}[ERROR]{} : SVG structure is broken or invalid!",
-                 color::red, color::reset);
-    return {/* empty */};
+  // Normalize (only unprepared input contains control characters)
+  if (std::any_of(svg.begin(), svg.end(), is_invisible)) {
+    std::string normalized;
+    normalize(svg, normalized);
+    return StringUtils::process(normalized, token);
   }
 
-  // Check position of < and >
-  if (!bkp.starts_with("<") || !bkp.ends_with(">")) {
-    std::println("{}[ERROR]{} : SVG structure is broken or invalid!",
-                 color::red, color::reset);
-    return {/* empty */};
+  std::string_view bkp = trim(svg);
+
+  // One tag: '<' ... '>' with nothing after its end
+  if (!bkp.starts_with("<") || tag_end(bkp, 0) != bkp.size() - 1) {
+    return malformed();
   }
 
   // Ignore
-  if (bkp.starts_with("<?") || bkp.starts_with("<!--")) {
-    // std::println("Ignore input!");
-    return {/* empty */};
+  if (bkp.starts_with("<?") || bkp.starts_with("<!")) {
+    tag.clear();
+    attributes.clear();
+    tag_type = TagType::Unknown;
+    return {};
   }
 
   // Remove < and >
-  bkp = bkp.substr(1, bkp.size() - 2);
-  bkp = trim(bkp);
+  bkp = trim(bkp.substr(1, bkp.size() - 2));
 
   // Tag Type
   // <g>        -> Open
   // <circle /> -> Self-closing
   // </g>       -> Close
-  auto tag_type{TagType::Open};
+  tag_type = TagType::Open;
 
   if (bkp.ends_with("/")) {
-    bkp.pop_back();
+    bkp.remove_suffix(1);
     tag_type = TagType::SelfClose;
   }
 
-  // Split
-  auto elements = split(bkp, ' ');
+  auto skip_spaces = [&bkp]() {
+    while (!bkp.empty() && bkp.front() == ' ')
+      bkp.remove_prefix(1);
+  };
+  // Characters up to a space or one of stops
+  auto take = [&bkp](std::string_view stops) {
+    auto element = bkp.substr(0, bkp.find_first_of(stops));
+    bkp.remove_prefix(element.size());
+    return element;
+  };
 
   // Tag name
-  std::string tag = elements.front();
-  if (tag.starts_with("/")) {
-    tag = tag.substr(1, tag.size() - 1);
+  auto name = take(" ");
+  if (name.starts_with("/")) {
+    name.remove_prefix(1);
     tag_type = TagType::Close;
   }
-
-  Attributes attributes;
-  for (size_t i = 1; i < elements.size(); ++i) {
-    auto e = elements.at(i);
-    if (e.contains("=")) {
-      auto arr = split(e, '=');
-      if (arr.size() == 2) {
-        auto attr = trim(arr.front());
-        auto value = arr.back();
-        if (value.starts_with("\"")) {
-          value = value.substr(1, value.size() - 1);
-        }
-        if (value.ends_with("\"")) {
-          value = value.substr(0, value.size() - 1);
-        }
-        attributes.emplace_back(attr, value);
-      }
+  tag.assign(name);
+
+  // Attributes: name, optional spaces around '=', then a value in single
+  // or double quotes (kept as written, '>' and '=' included) or unquoted
+  // up to the next space. Names without a value are skipped.
+  std::size_t count{0};
+  skip_spaces();
+  while (!bkp.empty()) {
+    auto attr = take(" =");
+    skip_spaces();
+    if (!bkp.starts_with("=")) {
+      if (attr.empty()) // stray quote or value
+        take(" ");
+      skip_spaces();
+      continue;
     }
+    bkp.remove_prefix(1);
+    skip_spaces();
+
+    std::string_view value;
+    if (bkp.starts_with("\"") || bkp.starts_with("'")) {
+      const auto close = bkp.find(bkp.front(), 1);
+      if (close == std::string_view::npos)
+        return malformed();
+      value = bkp.substr(1, close - 1);
+      bkp.remove_prefix(close + 1);
+    } else {
+      value = take(" ");
+    }
+    skip_spaces();
+    if (attr.empty())
+      continue;
+
+    // Found while scanning: only values with a reference are decoded
+    auto &attribute = slot(attributes, count++);
+    attribute.first.assign(attr);
+    if (value.find('&') == std::string_view::npos)
+      attribute.second.assign(value);
+    else
+      decode(value, attribute.second);
   }
+  attributes.resize(count);
 
-  return {tag, attributes, tag_type};
+  return {};
 }
 
 void test_string_utils() {
@@ -195,6 +456,7 @@ void test_string_utils() {
   using StringUtils::prepare;
   using StringUtils::process;
   using StringUtils::sanitize;
+  using StringUtils::tag_offset;
   using StringUtils::TagTuple;
   using StringUtils::TagType;
   using StringUtils::validate;
@@ -246,22 +508,140 @@ void test_string_utils() {
 
   // Identify < content >
   auto result1 = prepare(svg);
-  assert(result1 == vec1);
+  assert(result1 && *result1 == vec1);
 
   // Process simple string
   std::string str = "< tag attr1=\"1\" attr2=\"2\" />";
   TagTuple tp{"tag", {{"attr1", "1"}, {"attr2", "2"}}, TagType::SelfClose};
   auto result2 = process(str);
-  assert(result2 == tp);
+  assert(result2 && *result2 == tp);
 
   // Process svg
-  if (vec2.size() == result1.size()) {
-    for (size_t i = 0; i < result1.size(); ++i) {
-      auto result3 = process(result1.at(i));
-      assert(result3 == vec2.at(i));
+  if (vec2.size() == result1->size()) {
+    for (size_t i = 0; i < result1->size(); ++i) {
+      auto result3 = process(result1->at(i));
+      assert(result3 && *result3 == vec2.at(i));
     }
   }
 
+  // Errors : status, offset, line and column
+  assert(prepare(string_view{}).error().status == svg_core::Status::EmptyInput);
+
+  auto err1 = prepare(string_view{"<svg>\n  <g <rect/></g></svg>"});
+  assert(!err1 && err1.error().status == svg_core::Status::MalformedTag);
+  assert(err1.error().offset == 11);
+  assert(err1.error().line == 2 && err1.error().column == 6);
+
+  auto err2 = prepare(string_view{"<svg>\n<g>\n<rect/"});
+  assert(!err2 && err2.error().offset == 10);
+  assert(err2.error().line == 3 && err2.error().column == 1);
+
+  assert(!process(string_view{"tag>"}));
+  assert(process(string_view{"<!-- comment -->"}) == TagTuple{});
+
+  // Quoted values: spaces, '=', '>' and single quotes
+  auto quoted = process(string_view{
+      "<path d=\"M 0 0 L 10 10\" style = 'fill: red; stroke: blue' "
+      "href=\"a?b=c\" title=\"1 < 2 > 0\" hidden width=5/>"});
+  assert(quoted && *quoted == (TagTuple{"path",
+                                        {{"d", "M 0 0 L 10 10"},
+                                         {"style", "fill: red; stroke: blue"},
+                                         {"href", "a?b=c"},
+                                         {"title", "1 < 2 > 0"},
+                                         {"width", "5"}},
+                                        TagType::SelfClose}));
+  assert(!process(string_view{"<g id=\"a>"}));
+  assert(!process(string_view{"<g id=\"a\"><g>"}));
+
+  // Prepare: quotes, comments and line breaks
+  auto quoted_tags = prepare(string_view{
+      "<svg><!-- don't > stop --><text title=\"a > b\">1</text>"
+      "<rect\n  x=\"1\"\n\ty=\"2\"/></svg>"});
+  assert(quoted_tags && quoted_tags->size() == 6);
+  assert(quoted_tags->at(1) == "<!-- don't > stop -->");
+  assert(quoted_tags->at(2) == "<text title=\"a > b\">");
+  assert(quoted_tags->at(4) == "<rect   x=\"1\"  y=\"2\"/>");
+  assert(process(quoted_tags->at(4)) ==
+         (TagTuple{"rect", {{"x", "1"}, {"y", "2"}}, TagType::SelfClose}));
+  auto unclosed = prepare(string_view{"<svg><g id=\"a></g></svg>"});
+  assert(!unclosed && unclosed.error().offset == 5);
+  assert(validate(string_view{"<a title=\">\"/>"}));
+  assert(!validate(string_view{"<a title=\">/>"}));
+  assert(tag_offset(string_view{"<a t='<'/><b/>"}, 1) == 10);
+  assert(validate(string_view{"<svg><style>g > a {}</style></svg>"}));
+  assert(prepare(string_view{"<svg><style>g>a{}</style></svg>"})->size() == 4);
+  assert(validate(string_view{"<svg><text>a > b</text></svg>"}));
+  assert(prepare(string_view{"<svg><g>a > b</g></svg>"})->size() == 4);
+
+  // Reused buffers
+  std::vector<std::string> tags;
+  assert(prepare(svg, tags) && tags == vec1);
+  TagTuple token;
+  for (size_t i = 0; i < tags.size(); ++i) {
+    assert(process(tags[i], token) && token == vec2.at(i));
+  }
+  assert(prepare(string_view{"<svg><g/></svg>"}, tags) && tags.size() == 3);
+  assert(tags[1] == "<g/>");
+
+  // Tag spans
+  std::vector<StringUtils::Span> spans;
+  assert(prepare(string_view{"<svg>\n <g/></svg>"}, tags, spans));
+  assert((spans == std::vector<StringUtils::Span>{{0, 5}, {7, 11}, {11, 17}}));
+
+  // Contents: text, CDATA, comments and instructions
+  string_view doc{"<?xml version=\"1.0\"?>\n<svg><title>A &amp; B</title>"
+                  "<g/><text>x<tspan>y</tspan> z</text>"
+                  "<style><![CDATA[rect{fill:red}]]></style><!-- c --></svg>"};
+  std::vector<svg_core::Content> found;
+  assert(prepare(doc, tags, spans));
+  StringUtils::contents(doc, spans, found);
+  using Kind = svg_core::Content::Kind;
+  auto text = [&doc](const svg_core::Content &content) {
+    return doc.substr(content.begin, content.end - content.begin);
+  };
+  assert(found.size() == 7);
+  assert(found[0].kind == Kind::Instruction &&
+         text(found[0]) == "xml version=\"1.0\"");
+  assert(found[0].element == string_view::npos);
+  assert(text(found[1]) == "A &amp; B" && found[1].element == 1);
+  assert(text(found[2]) == "x" && found[2].element == 3 && found[2].after == 0);
+  assert(text(found[3]) == "y" && found[3].element == 4);
+  assert(text(found[4]) == " z" && found[4].element == 3 &&
+         found[4].after == 1);
+  assert(found[5].kind == Kind::CData && text(found[5]) == "rect{fill:red}");
+  assert(found[5].element == 5);
+  assert(found[6].kind == Kind::Comment && text(found[6]) == " c ");
+  assert(found[6].element == 0 && found[6].after == 4);
+  const string_view greater{"<svg><text>a > b</text></svg>"};
+  assert(prepare(greater, tags, spans));
+  StringUtils::contents(greater, spans, found);
+  assert(found.size() == 1 && found[0].element == 1);
+  assert(greater.substr(found[0].begin, found[0].end - found[0].begin) ==
+         "a > b");
+
+  // References decoded, unknown or broken ones kept
+  std::string decoded;
+  StringUtils::decode("a &amp; b &lt;&gt; &quot;&apos;", decoded);
+  assert(decoded == "a & b <> \"'");
+  StringUtils::decode("&#65;&#x42;&#X43;&#xe9;&#x20AC;&#x1F600;", decoded);
+  assert(decoded == "ABC\u00e9\u20ac\U0001F600");
+  const string_view kept{"&nbsp; &#0; &#xD800; &#x110000; &amp &; &#x; a&b"};
+  StringUtils::decode(kept, decoded);
+  assert(decoded == kept);
+  StringUtils::decode("&&amp;;", decoded);
+  assert(decoded == "&&;");
+  auto entities =
+      process(string_view{"<a title=\"R&amp;D &#x3C;1&#62;\" id='x&apos;'/>"});
+  assert(entities &&
+         std::get<1>(*entities) ==
+             (svg_core::Attributes{{"title", "R&D <1>"}, {"id", "x'"}}));
+
+  // Tag offsets
+  assert(tag_offset(svg, 0) == 0);
+  assert(tag_offset(svg, 1) == svg.find("<g"));
+  assert(tag_offset(svg, 4) == svg.rfind("</svg>"));
+  assert(tag_offset(svg, 5) == string_view::npos);
+
   std::println("{}[TEST]{} : {} : test completed", color::green, color::reset,
                __PRETTY_FUNCTION__);
 }
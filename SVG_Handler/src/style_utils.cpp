@@ -0,0 +1,511 @@
+#include "style_utils.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <limits>
+#include <memory>
+#include <print>
+#include <ranges>
+#include <tuple>
+#include <unordered_map>
+
+using StyleUtils::Declaration;
+using StyleUtils::Rule;
+
+namespace {
+
+struct Property {
+  std::string_view name;
+  std::string_view initial;
+  bool inherited;
+};
+
+// Sorted by name, for binary search
+constexpr std::array<Property, 29> properties_table{{
+    {"clip-path", "none", false},
+    {"clip-rule", "nonzero", true},
+    {"color", "black", true},
+    {"display", "inline", false},
+    {"fill", "black", true},
+    {"fill-opacity", "1", true},
+    {"fill-rule", "nonzero", true},
+    {"filter", "none", false},
+    {"font-family", "serif", true},
+    {"font-size", "medium", true},
+    {"font-style", "normal", true},
+    {"font-weight", "normal", true},
+    {"marker-end", "none", true},
+    {"marker-mid", "none", true},
+    {"marker-start", "none", true},
+    {"mask", "none", false},
+    {"opacity", "1", false},
+    {"stop-color", "black", false},
+    {"stop-opacity", "1", false},
+    {"stroke", "none", true},
+    {"stroke-dasharray", "none", true},
+    {"stroke-dashoffset", "0", true},
+    {"stroke-linecap", "butt", true},
+    {"stroke-linejoin", "miter", true},
+    {"stroke-miterlimit", "4", true},
+    {"stroke-opacity", "1", true},
+    {"stroke-width", "1", true},
+    {"text-anchor", "start", true},
+    {"visibility", "visible", true},
+}};
+
+constexpr std::array<std::string_view, 17> defaults{
+    "fill",           "fill-opacity",     "fill-rule",       "stroke",
+    "stroke-width",   "stroke-opacity",   "stroke-linecap",  "stroke-linejoin",
+    "stroke-dasharray", "opacity",        "display",         "visibility",
+    "font-family",    "font-size",        "font-weight",     "font-style",
+    "text-anchor"};
+
+auto find_property(std::string_view name) -> const Property * {
+  auto it = std::ranges::lower_bound(properties_table, name, {},
+                                     &Property::name);
+  return it != properties_table.end() && it->name == name ? &*it : nullptr;
+}
+
+auto is_space(char ch) -> bool {
+  return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '\f';
+}
+
+auto trim(std::string_view text) -> std::string_view {
+  while (!text.empty() && is_space(text.front()))
+    text.remove_prefix(1);
+  while (!text.empty() && is_space(text.back()))
+    text.remove_suffix(1);
+  return text;
+}
+
+auto lower(char ch) -> char {
+  return ch >= 'A' && ch <= 'Z' ? static_cast<char>(ch - 'A' + 'a') : ch;
+}
+
+auto iequals(std::string_view a, std::string_view b) -> bool {
+  return std::ranges::equal(a, b, {}, lower, lower);
+}
+
+// End of the text up to a separator outside quotes and parentheses
+auto find_outside(std::string_view text, std::size_t pos, char separator)
+    -> std::size_t {
+  char quote = 0;
+  int depth = 0;
+  for (; pos < text.size(); ++pos) {
+    const char ch = text[pos];
+    if (quote) {
+      if (ch == quote)
+        quote = 0;
+    } else if (ch == '"' || ch == '\'') {
+      quote = ch;
+    } else if (ch == '(') {
+      ++depth;
+    } else if (ch == ')') {
+      depth = std::max(0, depth - 1);
+    } else if (ch == separator && depth == 0) {
+      return pos;
+    }
+  }
+  return text.size();
+}
+
+// Position after the '}' closing the block opened at open (or the end)
+auto block_end(std::string_view css, std::size_t open) -> std::size_t {
+  char quote = 0;
+  int depth = 0;
+  for (auto pos = open; pos < css.size(); ++pos) {
+    const char ch = css[pos];
+    if (quote) {
+      if (ch == quote)
+        quote = 0;
+    } else if (ch == '"' || ch == '\'') {
+      quote = ch;
+    } else if (ch == '{') {
+      ++depth;
+    } else if (ch == '}' && --depth == 0) {
+      return pos + 1;
+    }
+  }
+  return css.size();
+}
+
+// CSS without comments and the legacy "<!--" / "-->" markers
+void strip_comments(std::string_view css, std::string &out) {
+  out.clear();
+  out.reserve(css.size());
+  for (std::size_t pos = 0; pos < css.size();) {
+    if (css.substr(pos, 2) == "/*") {
+      auto end = css.find("*/", pos + 2);
+      pos = end == std::string_view::npos ? css.size() : end + 2;
+      out += ' ';
+    } else if (css.substr(pos, 4) == "<!--") {
+      pos += 4;
+    } else if (css.substr(pos, 3) == "-->") {
+      pos += 3;
+    } else {
+      out += css[pos++];
+    }
+  }
+}
+
+void append_raw(std::string &key, std::size_t value) {
+  key.append(reinterpret_cast<const char *>(&value), sizeof value);
+}
+
+} // namespace
+
+void StyleUtils::parse_declarations(std::string_view text,
+                                    std::vector<Declaration> &declarations) {
+  std::size_t pos = 0;
+  while (pos < text.size()) {
+    const auto end = find_outside(text, pos, ';');
+    const auto declaration = text.substr(pos, end - pos);
+    pos = end + 1;
+
+    const auto colon = declaration.find(':');
+    if (colon == std::string_view::npos)
+      continue;
+    const auto property = trim(declaration.substr(0, colon));
+    auto value = trim(declaration.substr(colon + 1));
+
+    bool important = false;
+    const auto bang = value.rfind('!');
+    if (bang != std::string_view::npos &&
+        iequals(trim(value.substr(bang + 1)), "important")) {
+      important = true;
+      value = trim(value.substr(0, bang));
+    }
+    if (property.empty() || value.empty())
+      continue;
+
+    auto &added = declarations.emplace_back();
+    added.property.resize(property.size());
+    std::ranges::transform(property, added.property.begin(), lower);
+    added.value.assign(value);
+    added.important = important;
+  }
+}
+
+void StyleUtils::parse_sheet(std::string_view css, std::vector<Rule> &rules) {
+  std::string text;
+  strip_comments(css, text);
+  const std::string_view sheet{text};
+
+  std::size_t pos = 0;
+  std::vector<Declaration> declarations;
+  while (pos < sheet.size()) {
+    while (pos < sheet.size() && is_space(sheet[pos]))
+      ++pos;
+    if (pos >= sheet.size())
+      return;
+
+    if (sheet[pos] == '@') {
+      // Statement (@import ...;) or block (@media ... { ... })
+      const auto end = sheet.find_first_of(";{", pos);
+      if (end == std::string_view::npos)
+        return;
+      pos = sheet[end] == ';' ? end + 1 : block_end(sheet, end);
+      continue;
+    }
+
+    const auto open = sheet.find('{', pos);
+    if (open == std::string_view::npos)
+      return;
+    const auto close = block_end(sheet, open);
+    const auto selector = trim(sheet.substr(pos, open - pos));
+    const auto body = sheet.substr(open + 1, close - open - 1);
+    pos = close;
+
+    if (selector.empty() || selector.front() == '/')
+      continue; // XPath is not CSS
+    auto query = QueryUtils::parse(selector);
+    if (!query)
+      continue;
+    declarations.clear();
+    parse_declarations(body.ends_with('}') ? body.substr(0, body.size() - 1)
+                                           : body,
+                       declarations);
+    if (declarations.empty())
+      continue;
+    for (auto &alternative : *query) {
+      auto &rule = rules.emplace_back();
+      rule.specificity = specificity(alternative);
+      rule.selector = std::move(alternative);
+      rule.declarations = declarations;
+    }
+  }
+}
+
+auto StyleUtils::specificity(const QueryUtils::Selector &selector)
+    -> unsigned {
+  using Kind = QueryUtils::Condition::Kind;
+  unsigned ids = 0;
+  unsigned classes = 0;
+  unsigned tags = 0;
+  for (const auto &step : selector.steps) {
+    if (!step.tag.empty())
+      ++tags;
+    for (const auto &condition : step.conditions)
+      ++(condition.kind == Kind::Id ? ids : classes);
+  }
+  auto byte = [](unsigned count) { return std::min(count, 255u); };
+  return byte(ids) << 16 | byte(classes) << 8 | byte(tags);
+}
+
+auto StyleUtils::default_properties() -> std::span<const std::string_view> {
+  return defaults;
+}
+
+void StyleUtils::parse_properties(std::string_view list,
+                                  std::vector<std::string> &properties) {
+  for (auto name : std::views::split(list, ',')) {
+    const std::string_view property{name};
+    if (property == "default")
+      properties.insert(properties.end(), defaults.begin(), defaults.end());
+    else if (!property.empty())
+      properties.emplace_back(property);
+  }
+}
+
+auto StyleUtils::inherited(std::string_view property) -> bool {
+  const auto *found = find_property(property);
+  return found && found->inherited;
+}
+
+auto StyleUtils::initial(std::string_view property) -> std::string_view {
+  const auto *found = find_property(property);
+  return found ? found->initial : std::string_view{};
+}
+
+auto StyleUtils::compute(TreeUtils::Tree &tree,
+                         const std::vector<std::string> &properties)
+    -> Stats {
+  using Style = std::vector<std::string>;
+  constexpr auto none = std::numeric_limits<std::size_t>::max();
+
+  Stats stats;
+  const auto &index = tree.index;
+  const auto count = index.nodes.size();
+  stats.elements = count;
+
+  // Rules of the <style> elements, in document order
+  std::vector<Rule> rules;
+  if (auto styles = index.tags.find("style"); styles != index.tags.end()) {
+    std::string sheet;
+    for (auto position : styles->second) {
+      sheet.clear();
+      for (const auto &content : index.nodes[position]->contents) {
+        if (content.kind == svg_core::Content::Kind::Text ||
+            content.kind == svg_core::Content::Kind::CData)
+          sheet += TreeUtils::text(tree, content);
+      }
+      parse_sheet(sheet, rules);
+    }
+  }
+  stats.rules = rules.size();
+
+  // (position, rule) pairs, each element's rules in cascade order
+  std::vector<std::pair<std::size_t, std::size_t>> matches;
+  std::vector<std::size_t> positions;
+  QueryUtils::Query query(1);
+  for (std::size_t rule = 0; rule < rules.size(); ++rule) {
+    query.front() = rules[rule].selector;
+    QueryUtils::select(tree, query, positions);
+    for (auto position : positions)
+      matches.emplace_back(position, rule);
+  }
+  std::ranges::sort(matches, {}, [&rules](const auto &match) {
+    return std::tuple{match.first, rules[match.second].specificity,
+                      match.second};
+  });
+
+  std::unordered_map<std::string_view, std::size_t> slots;
+  for (std::size_t slot = 0; slot < properties.size(); ++slot)
+    slots.emplace(properties[slot], slot);
+
+  std::vector<std::shared_ptr<const Style>> computed; // distinct styles
+  std::unordered_map<std::string, std::size_t> cache; // inputs -> computed
+  std::vector<std::size_t> ids(count, none);          // position -> computed
+
+  std::string key;
+  std::vector<Declaration> inline_style;
+  std::vector<std::string_view> specified(properties.size());
+  auto match = matches.begin();
+
+  for (std::size_t position = 0; position < count; ++position) {
+    auto &node = *index.nodes[position];
+    const auto parent = index.parents[position];
+    const auto parent_id =
+        parent == std::string_view::npos ? none : ids[parent];
+    const auto first = match;
+    while (match != matches.end() && match->first == position)
+      ++match;
+
+    // Everything the computed style depends on
+    key.clear();
+    append_raw(key, parent_id);
+    for (const auto &[name, value] : node.attributes) {
+      if (name == "style" || slots.contains(name)) {
+        key += name;
+        key += '\0';
+        key += value;
+        key += '\0';
+      }
+    }
+    key += '\0';
+    for (auto it = first; it != match; ++it)
+      append_raw(key, it->second);
+
+    if (auto cached = cache.find(key); cached != cache.end()) {
+      ids[position] = cached->second;
+      node.style = computed[cached->second];
+      ++stats.hits;
+      continue;
+    }
+
+    // Cascade, lowest priority first
+    std::ranges::fill(specified, std::string_view{});
+    auto set = [&](std::string_view property, std::string_view value) {
+      if (auto slot = slots.find(property); slot != slots.end())
+        specified[slot->second] = value;
+    };
+    inline_style.clear();
+    for (const auto &[name, value] : node.attributes) {
+      if (name == "style")
+        parse_declarations(value, inline_style);
+      else
+        set(name, trim(value));
+    }
+    for (bool important : {false, true}) {
+      for (auto it = first; it != match; ++it) {
+        for (const auto &declaration : rules[it->second].declarations) {
+          if (declaration.important == important)
+            set(declaration.property, declaration.value);
+        }
+      }
+      for (const auto &declaration : inline_style) {
+        if (declaration.important == important)
+          set(declaration.property, declaration.value);
+      }
+    }
+
+    const Style *inherited_style =
+        parent_id == none ? nullptr : computed[parent_id].get();
+    auto style = std::make_shared<Style>(properties.size());
+    for (std::size_t slot = 0; slot < properties.size(); ++slot) {
+      const auto value = specified[slot];
+      const bool inherit =
+          value == "inherit" ||
+          (value.empty() && StyleUtils::inherited(properties[slot]));
+      if (!value.empty() && !inherit)
+        (*style)[slot].assign(value);
+      else if (inherit && inherited_style)
+        (*style)[slot] = (*inherited_style)[slot];
+      else
+        (*style)[slot].assign(StyleUtils::initial(properties[slot]));
+    }
+
+    ids[position] = computed.size();
+    cache.emplace(key, computed.size());
+    node.style = computed.emplace_back(std::move(style));
+  }
+
+  stats.styles = computed.size();
+  return stats;
+}
+
+void test_style_utils() {
+
+  using StyleUtils::compute;
+  using StyleUtils::parse_declarations;
+  using StyleUtils::parse_sheet;
+  using TreeUtils::TagTuple;
+  using TreeUtils::TagType;
+
+  assert(std::ranges::is_sorted(properties_table, {}, &Property::name));
+  assert(StyleUtils::inherited("fill") && !StyleUtils::inherited("opacity"));
+  assert(!StyleUtils::inherited("x") && StyleUtils::initial("x").empty());
+  assert(StyleUtils::initial("stroke") == "none");
+  for (auto property : StyleUtils::default_properties())
+    assert(find_property(property));
+  std::vector<std::string> listed{"x"};
+  StyleUtils::parse_properties("opacity,,default", listed);
+  assert(listed.size() == 2 + defaults.size() && listed[1] == "opacity");
+  assert(listed.back() == defaults.back());
+
+  // Declarations
+  std::vector<Declaration> declarations;
+  parse_declarations(" FILL : red ;stroke:url('a;b') ! Important;;bad;x:",
+                     declarations);
+  assert((declarations == std::vector<Declaration>{
+                              {"fill", "red", false},
+                              {"stroke", "url('a;b')", true}}));
+
+  // Sheets: comments, at-rules, lists and unsupported selectors
+  std::vector<Rule> rules;
+  parse_sheet("/* c */ @import 'x.css'; @media print { rect { fill: red } }\n"
+              "rect, g > .a { fill: blue } a ~ b { fill: red }\n"
+              "#b.a[x] { stroke: green !important }",
+              rules);
+  assert(rules.size() == 3);
+  assert(rules[0].specificity == 1 && rules[1].specificity == 0x101);
+  assert(rules[2].specificity == 0x10200);
+  assert(rules[2].declarations.front().important);
+  assert(StyleUtils::specificity(rules[1].selector) == 0x101);
+
+  // Cascade and inheritance
+  auto tree = TreeUtils::process(std::vector<TagTuple>{
+      {"svg", {}, TagType::Open},
+      {"style", {}, TagType::Open},
+      {"style", {}, TagType::Close},
+      {"g", {{"fill", "red"}, {"stroke-width", "2"}}, TagType::Open},
+      {"rect", {{"class", "a"}}, TagType::SelfClose},
+      {"rect", {{"class", "a"}}, TagType::SelfClose},
+      {"rect", {{"id", "b"}, {"class", "a"}, {"x", "1"}, {"stroke", "blue"}},
+       TagType::SelfClose},
+      {"circle", {{"fill", "green"}, {"style", "fill: yellow; opacity: .5"}},
+       TagType::SelfClose},
+      {"circle", {{"style", "stroke-width: inherit; opacity: inherit"}},
+       TagType::SelfClose},
+      {"g", {}, TagType::Close},
+      {"svg", {}, TagType::Close}});
+  const std::string_view css = "g > .a { fill: blue; stroke: black }\n"
+                               "#b { stroke: green !important }";
+  TreeUtils::attach(tree, css,
+                    {{svg_core::Content::Kind::Text, 0, css.size(), 1,
+                      std::string_view::npos}});
+
+  const std::vector<std::string> properties{"fill", "stroke", "stroke-width",
+                                            "opacity"};
+  auto stats = compute(tree, properties);
+  const auto &nodes = tree.index.nodes;
+  using Style = std::vector<std::string>;
+  assert(stats.elements == 8 && stats.rules == 2);
+  assert((*nodes[0]->style == Style{"black", "none", "1", "1"}));
+  assert((*nodes[2]->style == Style{"red", "none", "2", "1"}));
+  assert((*nodes[3]->style == Style{"blue", "black", "2", "1"}));
+  // Same inputs: one shared style
+  assert(nodes[3]->style == nodes[4]->style);
+  assert((*nodes[5]->style == Style{"blue", "green", "2", "1"}));
+  assert((*nodes[6]->style == Style{"yellow", "none", "2", ".5"}));
+  assert((*nodes[7]->style == Style{"red", "none", "2", "1"}));
+  assert(stats.hits == 1 && stats.styles == 7);
+
+  // Unknown properties: empty unless set
+  compute(tree, {"x", "color"});
+  assert((*nodes[5]->style == Style{"1", "black"}));
+  assert((*nodes[4]->style == Style{"", "black"}));
+
+  std::println("{}[TEST]{} : {} : test completed", color::green, color::reset,
+               __PRETTY_FUNCTION__);
+}
+
+#ifdef BUILD_TEST_EXE
+auto main() -> int {
+
+  test_style_utils();
+
+  return 0;
+}
+#endif
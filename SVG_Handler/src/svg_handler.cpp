@@ -1,59 +1,432 @@
 #include "svg_handler.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
 #include <print>
+#include <span>
+#include <utility>
 
 using namespace SVG_HANDLER;
 
+namespace {
+
+// Readable snapshot stored under key
+auto find_snapshot(CacheUtils::Cache &cache, const std::string &key)
+    -> std::optional<SnapshotUtils::Snapshot> {
+  auto entry = cache.lookup(key, ".snap");
+  if (!entry)
+    return std::nullopt;
+  auto snapshot = SnapshotUtils::Snapshot::open(entry->string());
+  if (!snapshot)
+    return std::nullopt;
+  return std::move(*snapshot);
+}
+
+} // namespace
+
 SVG_HANDLER::SVG::SVG(std::string_view file_path_svg,
                       std::string_view file_path_csv)
     : file_path_svg_(std::move(file_path_svg)),
       file_path_csv_(std::move(file_path_csv)) {}
 
-auto SVG_HANDLER::SVG::load() -> std::string {
-  return SvgReader::load(file_path_svg_);
+void SVG_HANDLER::SVG::reset(std::string_view file_path_svg,
+                             std::string_view file_path_csv) {
+  file_path_svg_.assign(file_path_svg);
+  file_path_csv_.assign(file_path_csv);
+  TreeUtils::release(tree_, pool_);
+  editable_ = false;
+}
+
+void SVG_HANDLER::SVG::set_table_options(
+    const TreeUtils::TableOptions &options) {
+  table_options_ = options;
+}
+
+void SVG_HANDLER::SVG::set_cache(std::string_view directory,
+                                 std::uintmax_t budget) {
+  if (directory.empty())
+    cache_.reset();
+  else
+    cache_.emplace(directory, budget);
+}
+
+auto SVG_HANDLER::SVG::cache_key(bool columns) const -> std::string {
+  const auto &options = table_options_;
+  auto settings = std::format("expand={},bake={},precision={},tolerance={}",
+                              options.expand, options.bake, options.precision,
+                              options.tolerance);
+  if (columns) {
+    settings += std::format(",bbox={},shared={},wide={},content={}",
+                            options.bbox, options.shared, options.wide,
+                            options.content);
+    for (const auto &name : options.columns)
+      settings += std::format(",column={}", name);
+    for (const auto &property : options.styles)
+      settings += std::format(",style={}", property);
+  }
+  return CacheUtils::key(source_, settings);
+}
+
+auto SVG_HANDLER::SVG::load() -> Expected<std::string_view> {
+  auto loaded = SvgReader::load(file_path_svg_, source_);
+  if (!loaded)
+    return std::unexpected(loaded.error());
+  return std::string_view{source_};
 }
 
 auto SVG_HANDLER::SVG::prepare(std::string_view svg)
-    -> std::vector<std::string> {
+    -> Expected<std::vector<std::string>> {
   return StringUtils::prepare(svg);
 }
 
 auto SVG_HANDLER::SVG::tokenize(const std::vector<std::string> &tags)
-    -> std::vector<StringUtils::TagTuple> {
+    -> Expected<std::vector<StringUtils::TagTuple>> {
   std::vector<StringUtils::TagTuple> tokens;
-  tokens.reserve(tags.size());
-  for (const auto &tag : tags)
-    tokens.push_back(StringUtils::process(tag));
+  auto tokenized = tokenize(tags, tokens);
+  if (!tokenized)
+    return std::unexpected(tokenized.error());
   return tokens;
 }
 
+auto SVG_HANDLER::SVG::tokenize(const std::vector<std::string> &tags,
+                                std::vector<StringUtils::TagTuple> &tokens)
+    -> Expected<void> {
+  tokens.resize(tags.size());
+  for (std::size_t i = 0; i < tags.size(); ++i) {
+    auto token = StringUtils::process(tags[i], tokens[i]);
+    if (!token)
+      return std::unexpected(locate(token.error(), i));
+  }
+  return {};
+}
+
+auto SVG_HANDLER::SVG::verify(
+    const std::vector<StringUtils::TagTuple> &svg_tagTuple) -> Expected<void> {
+  auto verified = TreeUtils::verify(svg_tagTuple);
+  if (!verified) {
+    // verify() reports the index of the offending tag
+    auto error = verified.error();
+    auto index = error.offset;
+    error.offset = 0;
+    return std::unexpected(
+        index == std::string_view::npos ? error : locate(error, index));
+  }
+  return {};
+}
+
 auto SVG_HANDLER::SVG::build(
-    const std::vector<StringUtils::TagTuple> &svg_tagTuple) -> TreeUtils::Tree {
-  assert(TreeUtils::validate(svg_tagTuple) == TreeUtils::Status::Success);
+    const std::vector<StringUtils::TagTuple> &svg_tagTuple)
+    -> Expected<TreeUtils::Tree> {
+  auto verified = verify(svg_tagTuple);
+  if (!verified)
+    return std::unexpected(verified.error());
   return TreeUtils::process(svg_tagTuple);
 }
 
 auto SVG_HANDLER::SVG::to_csv(const TreeUtils::Tree &tree)
     -> TreeUtils::CsvTable {
-  return TreeUtils::table(tree);
+  return TreeUtils::table(tree, table_options_);
+}
+
+auto SVG_HANDLER::SVG::query(std::string_view query)
+    -> Expected<TreeUtils::CsvTable> {
+  auto tree = parse();
+  if (!tree)
+    return std::unexpected(tree.error());
+
+  auto positions = QueryUtils::select(**tree, query);
+  if (!positions)
+    return std::unexpected(positions.error());
+
+  TreeUtils::CsvTable csvTable;
+  TreeUtils::table(**tree, *positions, csvTable, table_options_);
+  return csvTable;
+}
+
+auto SVG_HANDLER::SVG::render(const RasterUtils::Options &options)
+    -> Expected<RasterUtils::Image> {
+  // Copies under <use> are drawn; sheets need the captured contents
+  const auto table_options = std::exchange(
+      table_options_, TreeUtils::TableOptions{.expand = true, .content = true});
+  auto tree = parse();
+  table_options_ = table_options;
+  if (!tree)
+    return std::unexpected(tree.error());
+  return RasterUtils::render(tree_, options);
+}
+
+auto SVG_HANDLER::SVG::export_csv(const TreeUtils::CsvTable &csvTable,
+                                  std::string_view path) -> Expected<void> {
+  return CsvExporter::save(path, csvTable);
+}
+
+auto SVG_HANDLER::SVG::parse() -> Expected<const TreeUtils::Tree *> {
+  auto content = load();
+  if (!content)
+    return std::unexpected(content.error());
+  return build();
+}
+
+auto SVG_HANDLER::SVG::build() -> Expected<const TreeUtils::Tree *> {
+  editable_ = false;
+  std::string key;
+  // Contents (and the sheets styles need) refer to the source text: not
+  // part of snapshots
+  const bool snapshots =
+      cache_ && !table_options_.content && table_options_.styles.empty();
+  if (snapshots) {
+    key = cache_key(false);
+    if (auto snapshot = find_snapshot(*cache_, key)) {
+      // Stored after expand/bake: only the derived values are recomputed
+      snapshot->tree(tree_, pool_);
+      GeometryUtils::flatten(tree_);
+      if (table_options_.bbox)
+        GeometryUtils::compute(tree_);
+      return &tree_;
+    }
+  }
+
+  auto prepared = StringUtils::prepare(source_, tags_, spans_);
+  if (!prepared)
+    return std::unexpected(prepared.error());
+
+  auto tokens = tokenize(tags_, tokens_);
+  if (!tokens)
+    return std::unexpected(tokens.error());
+
+  auto verified = verify(tokens_);
+  if (!verified)
+    return std::unexpected(verified.error());
+
+  TreeUtils::process(tokens_, tree_, pool_);
+
+  // Element opened by each tag, in pre-order (as TreeUtils::process)
+  token_nodes_.resize(tokens_.size());
+  std::size_t position{0};
+  for (std::size_t i = 0; i < tokens_.size(); ++i) {
+    const auto &[tag, attributes, type] = tokens_[i];
+    const bool opens =
+        !tag.empty() && (type == StringUtils::TagType::Open ||
+                         type == StringUtils::TagType::SelfClose);
+    token_nodes_[i] = opens ? position++ : std::string_view::npos;
+  }
+  const auto &options = table_options_;
+  const bool simplify = options.precision >= 0 || options.tolerance >= 0.0;
+  // Expanded, baked or simplified trees no longer match the tags one to
+  // one; edits would shift the spans of captured contents
+  const bool contents = options.content || !options.styles.empty();
+  editable_ = !options.expand && !options.bake && !simplify && !contents;
+
+  // Before expand, which copies them with the referenced elements
+  if (contents) {
+    StringUtils::contents(source_, spans_, contents_);
+    TreeUtils::attach(tree_, source_, contents_);
+  }
+
+  if (options.expand)
+    ReferenceUtils::expand(tree_);
+  if (options.bake)
+    GeometryUtils::bake(tree_);
+  // After baking, so the tolerance is in root user units
+  if (simplify)
+    SimplifyUtils::simplify(tree_, {.precision = options.precision,
+                                    .tolerance = options.tolerance});
+  // Rewritten elements dropped their ctm
+  if (!options.bake || simplify)
+    GeometryUtils::flatten(tree_);
+  // Last: copies under <use> inherit from their new parents
+  if (!options.styles.empty())
+    StyleUtils::compute(tree_, options.styles);
+
+  if (snapshots) {
+    // Best effort: a failed store only costs the next run a reparse
+    std::string bytes;
+    SnapshotUtils::encode(tree_, bytes);
+    (void)cache_->store(key, ".snap", bytes);
+  }
+
+  if (table_options_.bbox)
+    GeometryUtils::compute(tree_);
+  return &tree_;
+}
+
+auto SVG_HANDLER::SVG::relex(std::size_t begin, std::size_t end,
+                             std::size_t first, std::size_t last) -> bool {
+  const std::string_view region{source_.data() + begin, end - begin};
+  auto prepared = StringUtils::prepare(region, edit_tags_, edit_spans_);
+  if (!prepared && prepared.error().status != svg_core::Status::EmptyInput)
+    return false;
+  if (edit_tags_.size() != last - first)
+    return false;
+
+  edit_tokens_.resize(edit_tags_.size());
+  for (std::size_t k = 0; k < edit_tags_.size(); ++k) {
+    if (!StringUtils::process(edit_tags_[k], edit_tokens_[k]))
+      return false;
+    const auto &[tag, attributes, type] = edit_tokens_[k];
+    const auto &[old_tag, old_attributes, old_type] = tokens_[first + k];
+    if (tag != old_tag || type != old_type)
+      return false;
+  }
+  return true;
+}
+
+auto SVG_HANDLER::SVG::edit(std::size_t offset, std::size_t length,
+                            std::string_view text) -> Expected<Edit> {
+  using StringUtils::Span;
+
+  if (offset > source_.size() || length > source_.size() - offset) {
+    return std::unexpected(svg_core::make_error(
+        svg_core::Status::InvalidEdit,
+        std::format("Edit of [{}, {}) is outside the text ({} bytes).", offset,
+                    offset + length, source_.size())));
+  }
+
+  // Tags overlapping [offset, stop): spans_ are sorted and disjoint
+  const auto stop = offset + length;
+  const auto first = static_cast<std::size_t>(
+      std::ranges::partition_point(
+          spans_, [&](const Span &span) { return span.second <= offset; }) -
+      spans_.begin());
+  const auto last = static_cast<std::size_t>(
+      std::ranges::partition_point(
+          spans_, [&](const Span &span) { return span.first < stop; }) -
+      spans_.begin());
+  const bool touched = editable_ && first < last;
+  const auto begin = touched ? std::min(offset, spans_[first].first) : offset;
+  const auto end = touched ? std::max(stop, spans_[last - 1].second) : stop;
+
+  source_.replace(offset, length, text);
+  const auto delta = static_cast<std::ptrdiff_t>(text.size()) -
+                     static_cast<std::ptrdiff_t>(length);
+
+  if (!editable_ || !relex(begin, end + delta, first, last)) {
+    auto tree = build();
+    if (!tree)
+      return std::unexpected(tree.error());
+    return Edit{*tree, true, tags_.size()};
+  }
+
+  // Same tag structure: patch the spans and the edited elements only
+  for (auto i = last; i < spans_.size(); ++i) {
+    spans_[i].first += delta;
+    spans_[i].second += delta;
+  }
+  for (std::size_t k = 0; k < edit_tokens_.size(); ++k) {
+    const auto i = first + k;
+    spans_[i] = {begin + edit_spans_[k].first, begin + edit_spans_[k].second};
+    tags_[i].swap(edit_tags_[k]);
+    tokens_[i].swap(edit_tokens_[k]);
+
+    const auto position = token_nodes_[i];
+    if (position == std::string_view::npos)
+      continue;
+    TreeUtils::update(tree_, position, std::get<1>(tokens_[i]));
+    GeometryUtils::refresh(tree_, position, table_options_.bbox);
+  }
+  return Edit{&tree_, false, last - first};
 }
 
-void SVG_HANDLER::SVG::export_csv(const TreeUtils::CsvTable &csvTable,
-                                  std::string_view path) {
-  CsvExporter::save(path, csvTable);
+auto SVG_HANDLER::SVG::format() const -> Format {
+  if (format_ != Format::Auto)
+    return format_;
+  const auto extension = std::filesystem::path(file_path_csv_).extension();
+  if (extension == ".arrow")
+    return Format::Arrow;
+  if (extension == ".json")
+    return Format::Json;
+  if (extension == ".ndjson" || extension == ".jsonl")
+    return Format::Ndjson;
+  return Format::Csv;
 }
 
-void SVG_HANDLER::SVG::execute() {
+auto SVG_HANDLER::SVG::execute() -> Expected<void> {
   auto content = load();
-  auto prepared = prepare(content);
-  auto tokens = tokenize(prepared);
-  auto tree = build(tokens);
-  auto table = to_csv(tree);
-  export_csv(table, file_path_csv_);
+  const auto format = this->format();
+  const std::string_view extension = format == Format::Arrow    ? ".arrow"
+                                     : format == Format::Json   ? ".json"
+                                     : format == Format::Ndjson ? ".ndjson"
+                                                                : ".csv";
+  std::string key;
+  if (content && cache_) {
+    key = cache_key(true);
+    if (auto entry = cache_->lookup(key, extension)) {
+      std::error_code ec;
+      std::filesystem::copy_file(
+          *entry, file_path_csv_,
+          std::filesystem::copy_options::overwrite_existing, ec);
+      if (!ec) {
+        std::println("{}[PIPELINE]{} : Cache hit, output copied from '{}'.",
+                     color::blue, color::reset, entry->string());
+        return {};
+      }
+    }
+  }
+
+  // Rows that need no tree are read straight from a cached snapshot
+  const auto &options = table_options_;
+  const bool plain = format == Format::Csv && !options.bbox &&
+                     !options.shared && !options.wide && !options.content &&
+                     options.styles.empty();
+  std::optional<SnapshotUtils::Snapshot> snapshot;
+  if (content && cache_ && plain)
+    snapshot = find_snapshot(*cache_, cache_key(false));
+
+  auto tree = snapshot  ? Expected<const TreeUtils::Tree *>{nullptr}
+              : content ? build()
+                        : Expected<const TreeUtils::Tree *>{std::unexpect,
+                                                            content.error()};
+  auto result = Expected<void>{};
+  if (snapshot) {
+    SnapshotUtils::table(*snapshot, table_);
+    result = export_csv(table_, file_path_csv_);
+  } else if (!tree) {
+    result = std::unexpected(tree.error());
+  } else {
+    switch (format) {
+    case Format::Arrow:
+      result = ArrowExporter::save(file_path_csv_, **tree, table_options_);
+      break;
+    case Format::Json:
+    case Format::Ndjson:
+      result = JsonExporter::save(file_path_csv_, **tree,
+                                  format == Format::Json
+                                      ? JsonExporter::Format::Tree
+                                      : JsonExporter::Format::Lines,
+                                  table_options_);
+      break;
+    default:
+      TreeUtils::table(**tree, table_, table_options_);
+      result = export_csv(table_, file_path_csv_);
+    }
+  }
+  if (result && cache_)
+    (void)cache_->store_file(key, extension, file_path_csv_);
+
+  if (!result) {
+    std::println("{}[PIPELINE]{} : {} : {}", color::red, color::reset,
+                 file_path_svg_, svg_core::describe(result.error()));
+    return result;
+  }
+
   std::println("{}[PIPELINE]{} : SVG processing completed successfully.",
                color::blue, color::reset);
+  return result;
+}
+
+auto SVG_HANDLER::SVG::locate(const Error &error, std::size_t tag_index) const
+    -> Error {
+  auto base = StringUtils::tag_offset(source_, tag_index);
+  if (base == std::string_view::npos)
+    return error;
+
+  auto offset =
+      base + (error.offset == std::string_view::npos ? 0 : error.offset);
+  return svg_core::make_error(error.status, error.message, source_, offset);
 }
 
 void test_svg_handler() {
@@ -63,7 +436,216 @@ void test_svg_handler() {
 
   // Integrated pipeline test
   SVG_HANDLER::SVG handler("resources/sample.svg", "sample.csv");
-  handler.execute();
+  auto result = handler.execute();
+  assert(result);
+
+  // Fail fast on the first stage
+  SVG_HANDLER::SVG missing("resources/missing.svg", "missing.csv");
+  assert(missing.execute().error().status == svg_core::Status::FileError);
+  assert(!std::filesystem::exists("missing.csv"));
+
+  // Positions of errors found after loading
+  {
+    std::ofstream broken("resources/broken.svg");
+    broken << "<svg>\n  <g>\n    <rect />\n  </svg>\n</g>\n";
+  }
+  SVG_HANDLER::SVG unbalanced("resources/broken.svg", "broken.csv");
+  auto tree = unbalanced.parse();
+  assert(!tree);
+  assert(tree.error().status == svg_core::Status::UnbalancedTags);
+  assert(tree.error().line == 4 && tree.error().column == 3);
+  assert(tree.error().offset == 27);
+
+  // Reused handler
+  {
+    std::ofstream small("resources/small.svg");
+    small << "<svg><g><circle r=\"1\"/></g></svg>";
+  }
+  SVG_HANDLER::SVG reused("resources/sample.svg", "sample.csv");
+  auto first = reused.parse();
+  assert(first);
+  auto sample_table = reused.to_csv(**first);
+
+  reused.reset("resources/small.svg", "small.csv");
+  auto second = reused.parse();
+  assert(second && reused.to_csv(**second).size() == 4);
+
+  reused.reset("resources/broken.svg", "broken.csv");
+  assert(!reused.parse());
+
+  reused.reset("resources/sample.svg", "sample.csv");
+  auto third = reused.parse();
+  assert(third && reused.to_csv(**third) == sample_table);
+  assert(reused.execute());
+
+  // Bounding box columns
+  reused.set_table_options({.bbox = true});
+  auto boxed = reused.parse();
+  assert(boxed);
+  auto boxed_table = reused.to_csv(**boxed);
+  assert(boxed_table[0].size() == sample_table[0].size() + 4);
+  auto shapes = std::ranges::find_if(boxed_table, [](const auto &row) {
+    return row[3] == "rect" && row[4] == "x" && row[5] == "10";
+  });
+  assert(shapes != boxed_table.end());
+  assert(std::ranges::equal(std::span(*shapes).last(4),
+                            std::vector<std::string>{"30", "30", "110", "80"}));
+
+  // Queries
+  auto circles = reused.query("#shapes > circle, line[stroke=green]");
+  assert(circles && circles->size() == 1 + 6 + 6);
+  assert((*circles)[1][0] == "5" && (*circles)[1][3] == "circle");
+  assert((*circles)[7][3] == "line");
+  assert(reused.query("//g[@id='shapes']/rect")->size() == 1 + 7);
+  assert(reused.query("rect[").error().status ==
+         svg_core::Status::InvalidQuery);
+
+  // Expanded references
+  {
+    std::ofstream uses("resources/uses.svg");
+    uses << "<svg><defs><rect id=\"r\" width=\"10\" height=\"5\"/></defs>"
+            "<use href=\"#r\" x=\"20\" transform=\"scale(2)\"/></svg>";
+  }
+  reused.reset("resources/uses.svg", "uses.csv");
+  reused.set_table_options({.bbox = true, .expand = true});
+  auto expanded = reused.parse();
+  assert(expanded);
+  const auto &use = *(*expanded)->root->children[1];
+  assert(use.children.size() == 1 && use.children[0]->tag == "rect");
+  assert(use.bbox == (svg_core::BBox{40, 0, 60, 10}));
+
+  // Captured contents, copied with the referenced content
+  {
+    std::ofstream texts("resources/texts.svg");
+    texts << "<?xml version=\"1.0\"?><svg><defs><text id=\"t\">Hi</text>"
+             "</defs><use href=\"#t\"/></svg>";
+  }
+  reused.reset("resources/texts.svg", "texts.csv");
+  reused.set_table_options({.expand = true, .content = true});
+  auto texts = reused.parse();
+  assert(texts && (*texts)->root->contents.size() == 1);
+  const auto &copied = *(*texts)->root->children[1]->children[0];
+  assert(copied.contents.size() == 1);
+  assert(TreeUtils::text(**texts, copied.contents[0]) == "Hi");
+  assert(TreeUtils::text(**texts, (*texts)->root->contents[0]) ==
+         "xml version=\"1.0\"");
+
+  // Computed styles, <style> sheet included, inherited by copies under <use>
+  {
+    std::ofstream styled("resources/styled.svg");
+    styled << "<svg><style><![CDATA[ .a { fill: blue } ]]></style>"
+              "<defs><rect id=\"r\" class=\"a\"/>"
+              "<circle id=\"c\" cx=\"4\" cy=\"4\" r=\"4\"/></defs>"
+              "<g stroke=\"red\"><use href=\"#c\"/></g></svg>";
+  }
+  reused.reset("resources/styled.svg", "styled.csv");
+  reused.set_table_options({.expand = true, .styles = {"fill", "stroke"}});
+  auto styled = reused.parse();
+  assert(styled);
+  const auto &nodes = (*styled)->index.nodes;
+  assert((*nodes[3]->style == std::vector<std::string>{"blue", "none"}));
+  assert(nodes[7]->tag == "circle");
+  assert((*nodes[7]->style == std::vector<std::string>{"black", "red"}));
+  assert(reused.to_csv(**styled)[0][6] == "fill");
+
+  // Thumbnail: the styled circle under <use> is black, options unchanged
+  auto thumbnail = reused.render({.size = 16, .threads = 2});
+  assert(thumbnail && thumbnail->width == 16 && thumbnail->height == 16);
+  assert(thumbnail->pixel(8, 8) == (RasterUtils::Color{0, 0, 0, 255}));
+  assert(thumbnail->pixel(0, 0) == (RasterUtils::Color{0, 0, 0, 0}));
+  assert(reused.table_options().styles.size() == 2);
+  reused.reset("resources/sample.svg", "sample.csv");
+
+  // Baked coordinates
+  reused.set_table_options({.bbox = true, .bake = true});
+  auto baked = reused.parse();
+  assert(baked);
+  const auto &baked_rect = *(*baked)->root->children[1]->children[0];
+  assert(*baked_rect.attribute("x") == "30" &&
+         *baked_rect.attribute("y") == "30");
+  assert(!(*baked)->root->children[1]->attribute("transform"));
+  assert(baked_rect.bbox == (svg_core::BBox{30, 30, 110, 80}));
+
+  // Arrow output, chosen by extension
+  SVG_HANDLER::SVG columnar("resources/sample.svg", "sample.arrow");
+  assert(columnar.execute());
+  {
+    std::ifstream file("sample.arrow", std::ios::binary);
+    std::string bytes(std::istreambuf_iterator<char>(file), {});
+    assert(bytes.starts_with("ARROW1") && bytes.ends_with("ARROW1"));
+  }
+
+  // Cached results
+  std::filesystem::remove_all("resources/cache_handler");
+  SVG_HANDLER::SVG cached("resources/sample.svg", "cached.csv");
+  cached.set_cache("resources/cache_handler");
+  assert(cached.execute() && cached.cache()->hits() == 0);
+  assert(cached.execute() && cached.cache()->hits() == 1);
+  {
+    std::ifstream expected("sample.csv"), copy("cached.csv");
+    assert(std::string(std::istreambuf_iterator<char>(expected), {}) ==
+           std::string(std::istreambuf_iterator<char>(copy), {}));
+  }
+  cached.set_table_options({.bbox = true}); // other CSV, same snapshot
+  auto from_snapshot = cached.parse();
+  assert(from_snapshot && cached.cache()->hits() == 2);
+  assert((*from_snapshot)->root->children.size() == 2);
+  assert((*from_snapshot)->index.nodes.size() == 7);
+  assert((*from_snapshot)->root->children[1]->children[0]->bbox);
+  const auto boxed_rows = cached.to_csv(**from_snapshot);
+  from_snapshot = cached.parse(); // nodes recycled through the pool
+  assert(from_snapshot && cached.to_csv(**from_snapshot) == boxed_rows);
+  // Plain CSV rows read from the mapped snapshot: same file as a parse
+  for (const auto &entry :
+       std::filesystem::directory_iterator("resources/cache_handler")) {
+    if (entry.path().extension() == ".csv")
+      std::filesystem::remove(entry.path());
+  }
+  cached.set_table_options({});
+  cached.reset("resources/sample.svg", "snapshot.csv");
+  assert(cached.execute() && cached.cache()->hits() == 4);
+  {
+    std::ifstream expected("sample.csv"), copy("snapshot.csv");
+    assert(std::string(std::istreambuf_iterator<char>(expected), {}) ==
+           std::string(std::istreambuf_iterator<char>(copy), {}));
+  }
+  std::filesystem::remove("snapshot.csv");
+  std::filesystem::remove_all("resources/cache_handler");
+
+  // Incremental edits
+  SVG_HANDLER::SVG edited("resources/small.svg", "small.csv");
+  edited.set_table_options({.bbox = true});
+  auto before = edited.parse();
+  assert(before);
+  const std::string small = "<svg><g><circle r=\"1\"/></g></svg>";
+  auto patched = edited.edit(small.find('1'), 1, "25");
+  assert(patched && !patched->rebuilt && patched->retokenized == 1);
+  const auto &circle = *patched->tree->root->children[0]->children[0];
+  assert(*circle.attribute("r") == "25");
+  assert(patched->tree->root->bbox == (svg_core::BBox{-25, -25, 25, 25}));
+
+  auto spaced = edited.edit(small.find("<g>"), 0, "\n  ");
+  assert(spaced && !spaced->rebuilt && spaced->retokenized == 0);
+  auto named = edited.edit(10, 1, " id=\"a\">"); // '>' of "<svg>\n  <g>"
+  assert(named && !named->rebuilt);
+  assert(TreeUtils::find_id(*named->tree, "a") == 1);
+  {
+    std::ofstream result("resources/edited.svg");
+    result << "<svg>\n  <g id=\"a\"><circle r=\"25\"/></g></svg>";
+  }
+  SVG_HANDLER::SVG fresh("resources/edited.svg", "edited.csv");
+  fresh.set_table_options({.bbox = true});
+  assert(edited.to_csv(*named->tree) == fresh.to_csv(**fresh.parse()));
+
+  auto grown = edited.edit(0, 0, "<!-- new -->"); // a tag without element
+  assert(grown && grown->rebuilt && grown->tree->index.nodes.size() == 3);
+  auto split = edited.edit(17, 0, "<g/>"); // after "<!-- new --><svg>"
+  assert(split && split->rebuilt && split->tree->index.nodes.size() == 4);
+  assert(edited.edit(1000, 0, "").error().status ==
+         svg_core::Status::InvalidEdit);
+  auto broken_edit = edited.edit(0, 0, "<");
+  assert(!broken_edit &&
+         broken_edit.error().status == svg_core::Status::MalformedTag);
 
   std::println("{}[TEST]{} : {} : test completed", color::green, color::reset,
                __PRETTY_FUNCTION__);
@@ -77,10 +659,78 @@ SvgHandlerPtr svg_handler_create(const char *input_svg,
   return new SVG(input_svg, output_csv);
 }
 
-void svg_handler_execute(SvgHandlerPtr handler) {
+int svg_handler_reset(SvgHandlerPtr handler, const char *input_svg,
+                      const char *output_csv) {
+  if (!handler || !input_svg || !output_csv)
+    return static_cast<int>(svg_core::Status::InvalidPath);
+  static_cast<SVG *>(handler)->reset(input_svg, output_csv);
+  return static_cast<int>(svg_core::Status::Success);
+}
+
+int svg_handler_set_cache(SvgHandlerPtr handler, const char *directory,
+                          unsigned long long budget) {
   if (!handler)
-    return;
-  static_cast<SVG *>(handler)->execute();
+    return static_cast<int>(svg_core::Status::EmptyInput);
+  static_cast<SVG *>(handler)->set_cache(
+      directory ? directory : "",
+      budget ? budget : CacheUtils::Cache::default_budget);
+  return static_cast<int>(svg_core::Status::Success);
+}
+
+int svg_handler_set_option(SvgHandlerPtr handler, const char *name,
+                           int enabled) {
+  if (!handler || !name)
+    return static_cast<int>(svg_core::Status::EmptyInput);
+  auto *svg = static_cast<SVG *>(handler);
+  auto options = svg->table_options();
+  const std::string_view option{name};
+  if (option == "bbox")
+    options.bbox = enabled != 0;
+  else if (option == "bake")
+    options.bake = enabled != 0;
+  else if (option == "expand")
+    options.expand = enabled != 0;
+  else if (option == "shared")
+    options.shared = enabled != 0;
+  else if (option == "wide")
+    options.wide = enabled != 0;
+  else if (option == "content")
+    options.content = enabled != 0;
+  else
+    return static_cast<int>(svg_core::Status::InvalidOption);
+  svg->set_table_options(options);
+  return static_cast<int>(svg_core::Status::Success);
+}
+
+int svg_handler_set_simplify(SvgHandlerPtr handler, int precision,
+                             double tolerance) {
+  if (!handler)
+    return static_cast<int>(svg_core::Status::EmptyInput);
+  auto *svg = static_cast<SVG *>(handler);
+  auto options = svg->table_options();
+  options.precision = precision;
+  options.tolerance = tolerance;
+  svg->set_table_options(options);
+  return static_cast<int>(svg_core::Status::Success);
+}
+
+int svg_handler_set_styles(SvgHandlerPtr handler, const char *properties) {
+  if (!handler)
+    return static_cast<int>(svg_core::Status::EmptyInput);
+  auto *svg = static_cast<SVG *>(handler);
+  auto options = svg->table_options();
+  options.styles.clear();
+  StyleUtils::parse_properties(properties ? properties : "", options.styles);
+  svg->set_table_options(options);
+  return static_cast<int>(svg_core::Status::Success);
+}
+
+int svg_handler_execute(SvgHandlerPtr handler) {
+  if (!handler)
+    return static_cast<int>(svg_core::Status::EmptyInput);
+  auto result = static_cast<SVG *>(handler)->execute();
+  return static_cast<int>(result ? svg_core::Status::Success
+                                 : result.error().status);
 }
 
 void svg_handler_destroy(SvgHandlerPtr handler) {
@@ -88,13 +738,10 @@ void svg_handler_destroy(SvgHandlerPtr handler) {
     delete static_cast<SVG *>(handler);
 }
 
-char ***svg_handler_to_csv(SvgHandlerPtr handler, int *rows, int *cols) {
-  if (!handler || !rows || !cols)
-    return nullptr;
-
-  auto *h = static_cast<SVG *>(handler);
-  auto table = h->to_csv(h->build(h->tokenize(h->prepare(h->load()))));
+namespace {
 
+// Copy a table into a 2D C array (released by svg_handler_free_csv)
+char ***to_c_table(const TreeUtils::CsvTable &table, int *rows, int *cols) {
   *rows = static_cast<int>(table.size());
   *cols = table.empty() ? 0 : static_cast<int>(table[0].size());
 
@@ -111,6 +758,61 @@ char ***svg_handler_to_csv(SvgHandlerPtr handler, int *rows, int *cols) {
   return data;
 }
 
+} // namespace
+
+char ***svg_handler_to_csv(SvgHandlerPtr handler, int *rows, int *cols) {
+  if (!handler || !rows || !cols)
+    return nullptr;
+
+  auto *h = static_cast<SVG *>(handler);
+  auto tree = h->parse();
+  if (!tree) {
+    *rows = *cols = 0;
+    return nullptr;
+  }
+  return to_c_table(h->to_csv(**tree), rows, cols);
+}
+
+char ***svg_handler_query(SvgHandlerPtr handler, const char *query, int *rows,
+                          int *cols) {
+  if (!handler || !query || !rows || !cols)
+    return nullptr;
+
+  auto table = static_cast<SVG *>(handler)->query(query);
+  if (!table) {
+    *rows = *cols = 0;
+    return nullptr;
+  }
+  return to_c_table(*table, rows, cols);
+}
+
+int svg_handler_to_arrow(SvgHandlerPtr handler, ArrowArray *array,
+                         ArrowSchema *schema) {
+  if (!handler || !array || !schema)
+    return static_cast<int>(svg_core::Status::EmptyInput);
+
+  auto *h = static_cast<SVG *>(handler);
+  auto tree = h->parse();
+  if (!tree)
+    return static_cast<int>(tree.error().status);
+  ArrowExporter::export_c(ArrowExporter::columns(**tree, h->table_options()),
+                          array, schema);
+  return static_cast<int>(svg_core::Status::Success);
+}
+
+int svg_handler_render(SvgHandlerPtr handler, const char *output, int size) {
+  if (!handler)
+    return static_cast<int>(svg_core::Status::EmptyInput);
+  if (!output)
+    return static_cast<int>(svg_core::Status::InvalidPath);
+  auto image = static_cast<SVG *>(handler)->render({.size = size ? size : 256});
+  if (!image)
+    return static_cast<int>(image.error().status);
+  auto saved = RasterUtils::save(output, *image);
+  return static_cast<int>(saved ? svg_core::Status::Success
+                                : saved.error().status);
+}
+
 void svg_handler_free_csv(char ***data, int rows, int cols) {
   if (!data)
     return;
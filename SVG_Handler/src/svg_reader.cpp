@@ -1,5 +1,6 @@
 #include "svg_reader.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <expected>
 #include <filesystem>
@@ -22,12 +23,25 @@ auto SvgReader::check(const std::filesystem::path &path) -> ExpectedFile {
   }
 }
 
-auto SvgReader::load(std::string_view path) -> std::string {
+auto SvgReader::load(std::string_view path) -> Expected<std::string> {
+  std::string content;
+  auto loaded = SvgReader::load(path, content);
+  if (!loaded)
+    return std::unexpected(loaded.error());
+  return content;
+}
+
+auto SvgReader::load(std::string_view path, std::string &content)
+    -> Expected<void> {
+
+  using svg_core::make_error;
+  using svg_core::Status;
+
+  content.clear();
 
   if (path.empty()) {
-    std::println("{}[ERROR]{} : Invalid path! Path cannot be empty.",
-                 color::red, color::reset);
-    return {/* empty */};
+    return std::unexpected(
+        make_error(Status::InvalidPath, "Invalid path! Path cannot be empty."));
   }
 
   std::filesystem::path fpath(path);
@@ -37,46 +51,66 @@ auto SvgReader::load(std::string_view path) -> std::string {
                  [](unsigned char c) { return std::tolower(c); });
 
   if (ext != ".svg") {
-    std::println(
-        "{}[ERROR]{} : Invalid file extension! Expected .svg, got '{}'.",
-        color::red, color::reset, ext);
-    return {/* empty */};
+    return std::unexpected(make_error(
+        Status::InvalidExtension,
+        std::format("Invalid file extension! Expected .svg, got '{}'.", ext)));
   }
 
   auto file_expected = SvgReader::check(fpath);
-  if (file_expected.has_value()) {
-    std::ifstream &file = *file_expected.value();
-    std::string content((std::istreambuf_iterator<char>(file)),
-                        std::istreambuf_iterator<char>());
-    file.close();
-
-    if (content.empty()) {
-      std::println("{}[WARNING]{} : File is empty: '{}'.", color::yellow,
-                   color::reset, path);
-    }
-
-    return content;
+  if (!file_expected.has_value()) {
+    std::error_code ec = file_expected.error();
+    return std::unexpected(make_error(
+        Status::FileError,
+        std::format("Failed to open or read file '{}' . Error: {} ({}).", path,
+                    ec.message(), ec.value())));
   }
 
-  std::error_code ec = file_expected.error();
-  std::println(
-      "{}[ERROR]{} : Failed to open or read file '{}' . Error: {} ({}).",
-      color::red, color::reset, path, ec.message(), ec.value());
+  // Read the whole file into the (possibly recycled) buffer
+  std::ifstream &file = *file_expected.value();
+  file.seekg(0, std::ios::end);
+  auto size = static_cast<std::streamoff>(file.tellg());
+  file.seekg(0, std::ios::beg);
+  if (size > 0) {
+    content.resize(static_cast<std::size_t>(size));
+    file.read(content.data(), size);
+    content.resize(static_cast<std::size_t>(file.gcount()));
+  }
+  file.close();
 
-  return {/* empty */};
+  if (content.empty()) {
+    return std::unexpected(make_error(
+        Status::EmptyInput, std::format("File is empty: '{}'.", path)));
+  }
+
+  return {};
 }
 
 void test_svg_reader() {
 
-  std::string svg = SvgReader::load("resources/sample.svg");
-  assert(!svg.empty());
+  auto svg = SvgReader::load("resources/sample.svg");
+  assert(svg.has_value() && !svg->empty());
 
-  if (svg.empty()) {
+  if (!svg) {
     std::println(
         "{}[INFO]{} : Empty or invalid file! Check SVG file path and name.",
         color::blue, color::reset);
   }
 
+  // Reused buffer
+  std::string buffer;
+  assert(SvgReader::load("resources/sample.svg", buffer));
+  assert(buffer == *svg);
+  auto capacity = buffer.capacity();
+  assert(SvgReader::load("resources/sample.svg", buffer));
+  assert(buffer == *svg && buffer.capacity() == capacity);
+
+  // Errors
+  assert(SvgReader::load("").error().status == svg_core::Status::InvalidPath);
+  assert(SvgReader::load("resources/sample.txt").error().status ==
+         svg_core::Status::InvalidExtension);
+  assert(SvgReader::load("resources/missing.svg").error().status ==
+         svg_core::Status::FileError);
+
   std::println("{}[TEST]{} : {} : test completed", color::green, color::reset,
                __PRETTY_FUNCTION__);
 }
@@ -0,0 +1,444 @@
+#include "svg_writer.hpp"
+#include "number_utils.hpp"
+#include "string_utils.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <format>
+#include <fstream>
+#include <print>
+#include <sstream>
+#include <vector>
+
+using svg_core::make_error;
+using svg_core::Status;
+
+namespace {
+
+// Bytes gathered before each write to the stream
+constexpr std::size_t buffer_size = 1 << 16;
+
+// Attributes made of numbers only (sorted, for binary search)
+constexpr std::array<std::string_view, 44> numeric_attributes{
+    "cx", "cy", "d", "dx", "dy", "fill-opacity", "font-size", "fr", "fx", "fy",
+    "gradientTransform", "height", "k1", "k2", "k3", "k4", "offset", "opacity",
+    "pathLength", "patternTransform", "points", "r", "refX", "refY", "rotate",
+    "rx", "ry", "stdDeviation", "stop-opacity", "stroke-dasharray",
+    "stroke-dashoffset", "stroke-miterlimit", "stroke-opacity", "stroke-width",
+    "transform", "viewBox", "width", "x", "x1", "x2", "y", "y1", "y2", "z"};
+
+// Initial values; tag empty for every element. Inherited properties are
+// only redundant where no ancestor may set them.
+struct Default {
+  std::string_view tag;
+  std::string_view attribute;
+  std::string_view value;
+  bool inherited;
+};
+
+constexpr std::array<Default, 37> defaults{{
+    {"", "opacity", "1", false},
+    {"", "display", "inline", false},
+    {"", "stop-opacity", "1", false},
+    {"rect", "x", "0", false},
+    {"rect", "y", "0", false},
+    {"use", "x", "0", false},
+    {"use", "y", "0", false},
+    {"image", "x", "0", false},
+    {"image", "y", "0", false},
+    {"circle", "cx", "0", false},
+    {"circle", "cy", "0", false},
+    {"ellipse", "cx", "0", false},
+    {"ellipse", "cy", "0", false},
+    {"line", "x1", "0", false},
+    {"line", "y1", "0", false},
+    {"line", "x2", "0", false},
+    {"line", "y2", "0", false},
+    {"", "fill", "black", true},
+    {"", "fill", "#000", true},
+    {"", "fill", "#000000", true},
+    {"", "fill-opacity", "1", true},
+    {"", "fill-rule", "nonzero", true},
+    {"", "clip-rule", "nonzero", true},
+    {"", "stroke", "none", true},
+    {"", "stroke-width", "1", true},
+    {"", "stroke-opacity", "1", true},
+    {"", "stroke-linecap", "butt", true},
+    {"", "stroke-linejoin", "miter", true},
+    {"", "stroke-miterlimit", "4", true},
+    {"", "stroke-dasharray", "none", true},
+    {"", "stroke-dashoffset", "0", true},
+    {"", "visibility", "visible", true},
+    {"", "font-style", "normal", true},
+    {"", "font-weight", "normal", true},
+    {"", "text-anchor", "start", true},
+    {"", "color-interpolation-filters", "linearRGB", true},
+    {"", "shape-rendering", "auto", true},
+}};
+
+auto same_value(std::string_view value, std::string_view initial) -> bool {
+  if (value == initial)
+    return true;
+  auto number = NumberUtils::parse_number(initial);
+  return number && NumberUtils::parse_number(value) == number;
+}
+
+// Whether the attribute of the element at position can be dropped
+auto redundant(const TreeUtils::Tree &tree, std::size_t position,
+               const svg_core::Attribute &attribute, bool inherited) -> bool {
+  const auto &index = tree.index;
+  const auto &tag = index.nodes[position]->tag;
+  for (const auto &initial : defaults) {
+    if (initial.attribute != attribute.first ||
+        (!initial.tag.empty() && initial.tag != tag) ||
+        !same_value(attribute.second, initial.value))
+      continue;
+    if (!initial.inherited)
+      return true;
+    if (!inherited)
+      return false;
+    for (auto parent = index.parents[position];
+         parent != std::string_view::npos; parent = index.parents[parent]) {
+      const auto &ancestor = *index.nodes[parent];
+      if (ancestor.attribute(attribute.first) || ancestor.attribute("style"))
+        return false;
+    }
+    return true;
+  }
+  return false;
+}
+
+void append_attribute(std::string &out, std::string_view name,
+                      std::string_view value) {
+  // Values are stored decoded: '&', '<' and the quote are encoded again
+  const bool double_quote = value.find('"') == std::string_view::npos;
+  const bool single_quote = value.find('\'') == std::string_view::npos;
+  const char quote = double_quote || !single_quote ? '"' : '\'';
+
+  out += ' ';
+  out += name;
+  out += '=';
+  out += quote;
+  if (value.find_first_of("&<\"") == std::string_view::npos) {
+    out += value;
+  } else {
+    for (char ch : value) {
+      if (ch == '&')
+        out += "&amp;";
+      else if (ch == '<')
+        out += "&lt;";
+      else if (ch == '"' && quote == '"')
+        out += "&quot;";
+      else
+        out += ch;
+    }
+  }
+  out += quote;
+}
+
+// Text and CDATA are written inline: indentation would change the text
+auto has_text(const TreeUtils::Node &node) -> bool {
+  return std::ranges::any_of(node.contents, [](const svg_core::Content &c) {
+    return c.kind == svg_core::Content::Kind::Text ||
+           c.kind == svg_core::Content::Kind::CData;
+  });
+}
+
+void append_content(std::string &out, const svg_core::Content &content,
+                    std::string_view text, std::string &decoded) {
+  using Kind = svg_core::Content::Kind;
+  switch (content.kind) {
+  case Kind::Text:
+    // Kept as written: decoded, then '&' and '<' encoded again
+    StringUtils::decode(text, decoded);
+    for (char ch : decoded) {
+      if (ch == '&')
+        out += "&amp;";
+      else if (ch == '<')
+        out += "&lt;";
+      else
+        out += ch;
+    }
+    break;
+  case Kind::CData:
+    out += "<![CDATA[";
+    out += text;
+    out += "]]>";
+    break;
+  case Kind::Comment:
+    out += "<!--";
+    out += text;
+    out += "-->";
+    break;
+  case Kind::Instruction:
+    out += "<?";
+    out += text;
+    out += "?>";
+    break;
+  }
+}
+
+} // namespace
+
+auto SvgWriter::numeric(std::string_view attribute) -> bool {
+  return std::ranges::binary_search(numeric_attributes, attribute);
+}
+
+void SvgWriter::write(std::ostream &out, const TreeUtils::Tree &tree,
+                      const Options &options) {
+  const auto &index = tree.index;
+  if (index.nodes.empty())
+    return;
+
+  std::string buffer;
+  buffer.reserve(buffer_size);
+  std::string rounded;
+  std::string decoded;
+  std::vector<const svg_core::Attribute *> attributes;
+
+  // Elements waiting for their closing tag, with the contents written so
+  // far and the child elements seen so far
+  struct Open {
+    std::size_t position;
+    std::size_t contents;
+    std::size_t children;
+  };
+  std::vector<Open> open;
+  // Open element written inline
+  std::size_t inline_depth = std::string_view::npos;
+
+  const bool inherited = options.strip_defaults &&
+                         !index.tags.contains("style") &&
+                         !index.tags.contains("use");
+
+  auto start_line = [&](std::size_t depth) {
+    if (!options.minify && inline_depth == std::string_view::npos)
+      buffer.append(depth * 2, ' ');
+  };
+  auto end_line = [&] {
+    if (!options.minify && inline_depth == std::string_view::npos)
+      buffer += '\n';
+  };
+  auto skipped = [&](const svg_core::Content &content) {
+    return options.strip_comments &&
+           content.kind == svg_core::Content::Kind::Comment;
+  };
+  // Contents of the innermost open element placed before its next child
+  auto flush_contents = [&](std::size_t children) {
+    auto &element = open.back();
+    const auto &contents = index.nodes[element.position]->contents;
+    for (; element.contents < contents.size() &&
+           contents[element.contents].after <= children;
+         ++element.contents) {
+      const auto &content = contents[element.contents];
+      if (content.element == std::string_view::npos || skipped(content))
+        continue; // before the root, written first
+      start_line(open.size());
+      append_content(buffer, content, TreeUtils::text(tree, content), decoded);
+      end_line();
+    }
+  };
+  auto close = [&] {
+    flush_contents(std::string_view::npos);
+    const auto &node = *index.nodes[open.back().position];
+    open.pop_back();
+    start_line(open.size());
+    buffer += "</";
+    buffer += node.tag;
+    buffer += '>';
+    if (inline_depth == open.size())
+      inline_depth = std::string_view::npos;
+    end_line();
+  };
+
+  // Prolog: XML declaration, comments before the root
+  for (const auto &content : index.nodes.front()->contents) {
+    if (content.element != std::string_view::npos || skipped(content))
+      continue;
+    append_content(buffer, content, TreeUtils::text(tree, content), decoded);
+    end_line();
+  }
+
+  for (std::size_t position = 0; position < index.nodes.size(); ++position) {
+    const auto &node = *index.nodes[position];
+    const auto depth = static_cast<std::size_t>(index.depths[position]);
+    while (open.size() > depth)
+      close();
+    if (!open.empty()) {
+      flush_contents(open.back().children);
+      ++open.back().children;
+    }
+
+    start_line(depth);
+    buffer += '<';
+    buffer += node.tag;
+
+    attributes.clear();
+    for (const auto &attribute : node.attributes) {
+      if (!options.strip_defaults ||
+          !redundant(tree, position, attribute, inherited))
+        attributes.push_back(&attribute);
+    }
+    if (options.sort_attributes) {
+      std::ranges::stable_sort(attributes, {}, [](const auto *attribute) {
+        return std::string_view{attribute->first};
+      });
+    }
+    for (const auto *attribute : attributes) {
+      std::string_view value = attribute->second;
+      if (options.precision >= 0 && SvgWriter::numeric(attribute->first)) {
+        NumberUtils::round_numbers(value, options.precision, rounded);
+        value = rounded;
+      }
+      append_attribute(buffer, attribute->first, value);
+    }
+
+    const bool content = std::ranges::any_of(
+        node.contents, [&](const svg_core::Content &c) {
+          return c.element != std::string_view::npos && !skipped(c);
+        });
+    if (index.sizes[position] > 1 || content) {
+      buffer += '>';
+      open.push_back({position, 0, 0});
+      if (inline_depth == std::string_view::npos && has_text(node))
+        inline_depth = depth;
+      else
+        end_line();
+    } else {
+      buffer += "/>";
+      end_line();
+    }
+
+    if (buffer.size() >= buffer_size) {
+      out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+      buffer.clear();
+    }
+  }
+  while (!open.empty())
+    close();
+
+  out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+auto SvgWriter::save(std::string_view path, const TreeUtils::Tree &tree,
+                     const Options &options) -> Expected<void> {
+  if (path.empty()) {
+    return std::unexpected(
+        make_error(Status::InvalidPath, "Invalid SVG path (empty)."));
+  }
+
+  std::ofstream file(std::string{path}, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    return std::unexpected(make_error(
+        Status::FileError, std::format("Failed to open SVG file '{}'.", path)));
+  }
+
+  SvgWriter::write(file, tree, options);
+  if (!file.good()) {
+    return std::unexpected(make_error(
+        Status::FileError,
+        std::format("Writing error occurred for '{}'.", path)));
+  }
+  return {};
+}
+
+void test_svg_writer() {
+
+  using TreeUtils::TagTuple;
+  using TreeUtils::TagType;
+
+  assert(std::ranges::is_sorted(numeric_attributes));
+  assert(SvgWriter::numeric("d") && !SvgWriter::numeric("id"));
+
+  auto tree = TreeUtils::process(std::vector<TagTuple>{
+      {"svg", {{"width", "10.126"}, {"height", "5"}}, TagType::Open},
+      {"g", {{"stroke", "none"}, {"fill", "red"}}, TagType::Open},
+      {"rect", {{"y", "0"}, {"x", "1"}, {"fill", "#000"}, {"opacity", "1.0"}},
+       TagType::SelfClose},
+      {"g", {}, TagType::Close},
+      {"path", {{"d", "M0.3333,1L2.6666.5"}, {"title", "a \"b\""}},
+       TagType::SelfClose},
+      {"svg", {}, TagType::Close}});
+
+  auto write = [&tree](const SvgWriter::Options &options) {
+    std::ostringstream out;
+    SvgWriter::write(out, tree, options);
+    return out.str();
+  };
+
+  // As parsed, one element per line
+  assert(write({}) ==
+         "<svg width=\"10.126\" height=\"5\">\n"
+         "  <g stroke=\"none\" fill=\"red\">\n"
+         "    <rect y=\"0\" x=\"1\" fill=\"#000\" opacity=\"1.0\"/>\n"
+         "  </g>\n"
+         "  <path d=\"M0.3333,1L2.6666.5\" title='a \"b\"'/>\n"
+         "</svg>\n");
+
+  // Minified: fill="#000" stays (the parent sets fill), stroke="none" goes
+  assert(write({.minify = true,
+                .sort_attributes = true,
+                .precision = 2,
+                .strip_defaults = true}) ==
+         "<svg height=\"5\" width=\"10.13\">"
+         "<g fill=\"red\"><rect fill=\"#000\" x=\"1\"/></g>"
+         "<path d=\"M0.33,1L2.67.5\" title='a \"b\"'/></svg>");
+
+  // Both quotes in a value
+  tree.root->children[1]->attributes[1].second = "'\"";
+  assert(write({.minify = true}).ends_with("title=\"'&quot;\"/></svg>"));
+  tree.root->children[1]->attributes[1].second = "R&D <1>";
+  assert(write({.minify = true}).ends_with("title=\"R&amp;D &lt;1>\"/></svg>"));
+
+  // Contents round trip: text, <style> sheets, CDATA, comments, prolog
+  const std::string_view source =
+      "<?xml version=\"1.0\"?><svg><style>rect > a { fill: red }</style>"
+      "<!-- note --><text x=\"1\">R&amp;D <tspan>&lt;1</tspan> ok</text>"
+      "<g><![CDATA[ a<b ]]><rect/></g></svg>";
+  std::vector<std::string> tags;
+  std::vector<StringUtils::Span> spans;
+  assert(StringUtils::prepare(source, tags, spans));
+  std::vector<TagTuple> tokens(tags.size());
+  for (std::size_t i = 0; i < tags.size(); ++i)
+    assert(StringUtils::process(tags[i], tokens[i]));
+  auto texts = TreeUtils::process(tokens);
+  std::vector<svg_core::Content> contents;
+  StringUtils::contents(source, spans, contents);
+  TreeUtils::attach(texts, source, contents);
+  auto write_texts = [&texts](const SvgWriter::Options &options) {
+    std::ostringstream out;
+    SvgWriter::write(out, texts, options);
+    return out.str();
+  };
+  assert(write_texts({.minify = true}) == source);
+  assert(write_texts({}) ==
+         "<?xml version=\"1.0\"?>\n"
+         "<svg>\n"
+         "  <style>rect > a { fill: red }</style>\n"
+         "  <!-- note -->\n"
+         "  <text x=\"1\">R&amp;D <tspan>&lt;1</tspan> ok</text>\n"
+         "  <g><![CDATA[ a<b ]]><rect/></g>\n"
+         "</svg>\n");
+  assert(write_texts({.minify = true, .strip_comments = true}) ==
+         "<?xml version=\"1.0\"?><svg><style>rect > a { fill: red }</style>"
+         "<text x=\"1\">R&amp;D <tspan>&lt;1</tspan> ok</text>"
+         "<g><![CDATA[ a<b ]]><rect/></g></svg>");
+
+  std::ostringstream empty;
+  SvgWriter::write(empty, {});
+  assert(empty.str().empty());
+  assert(SvgWriter::save("", tree).error().status == Status::InvalidPath);
+
+  std::println("{}[TEST]{} : {} : test completed", color::green, color::reset,
+               __PRETTY_FUNCTION__);
+}
+
+#ifdef BUILD_TEST_EXE
+auto main() -> int {
+
+  test_svg_writer();
+
+  return 0;
+}
+#endif
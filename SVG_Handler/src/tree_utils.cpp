@@ -1,23 +1,387 @@
 #include "tree_utils.hpp"
+#include "number_utils.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <charconv>
 #include <functional>
 #include <print>
-#include <stack>
 
 using namespace TreeUtils;
 
-auto TreeUtils::validate(const std::vector<TagTuple> &svg_tagTuple) -> Status {
+namespace {
+
+void assign_number(std::string &cell, long long number) {
+  std::array<char, 24> buffer{};
+  auto [end, ec] =
+      std::to_chars(buffer.data(), buffer.data() + buffer.size(), number);
+  cell.assign(buffer.data(), end);
+}
+
+void assign_real(std::string &cell, double number) {
+  std::array<char, 32> buffer{};
+  auto [end, ec] =
+      std::to_chars(buffer.data(), buffer.data() + buffer.size(), number);
+  cell.assign(buffer.data(), end);
+}
+
+// FNV-1a, continued from hash
+auto fnv1a(std::uint64_t hash, std::string_view bytes) -> std::uint64_t {
+  for (unsigned char byte : bytes) {
+    hash ^= byte;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+// Order-dependent combination of a child hash
+auto combine(std::uint64_t hash, std::uint64_t child) -> std::uint64_t {
+  return (hash ^ (child + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2))) *
+         0x100000001b3ULL;
+}
+
+auto node_hash(const Node &node) -> std::uint64_t {
+  // Separators keep ("ab","c") and ("a","bc") apart
+  auto hash = fnv1a(0xcbf29ce484222325ULL, node.tag);
+  for (const auto &[name, value] : node.attributes) {
+    hash = fnv1a(hash, std::string_view{"\0", 1});
+    hash = fnv1a(hash, name);
+    hash = fnv1a(hash, "=");
+    hash = fnv1a(hash, value);
+  }
+  return fnv1a(hash, std::string_view{"\1", 1});
+}
+
+// Calls visit(name) for each name of a class attribute ("a b" -> a, b)
+template <typename Visit>
+void for_each_class(std::string_view rest, Visit visit) {
+  while (!rest.empty()) {
+    auto start = rest.find_first_not_of(" \t\n\r\f");
+    if (start == std::string_view::npos)
+      break;
+    rest.remove_prefix(start);
+    auto name = rest.substr(0, rest.find_first_of(" \t\n\r\f"));
+    rest.remove_prefix(name.size());
+    visit(name);
+  }
+}
+
+using Table = TreeIndex::Table;
+
+// Positions under key, in a spare entry when the key is new
+auto entry(Table &table, std::vector<Table::node_type> &spare,
+           std::string_view key) -> std::vector<std::size_t> & {
+  if (auto it = table.find(key); it != table.end())
+    return it->second;
+  if (spare.empty())
+    return table[key];
+  auto handle = std::move(spare.back());
+  spare.pop_back();
+  handle.key() = key;
+  handle.mapped().clear();
+  return table.insert(std::move(handle)).position->second;
+}
+
+// Remove position under key. Keys view the strings of one of their nodes:
+// if that string is about to change, point the key at another node's copy.
+void unlink(Table &table, std::string_view key, std::size_t position,
+            const TreeIndex &index, const std::string *(*text)(const Node &)) {
+  auto it = table.find(key);
+  if (it == table.end())
+    return;
+  auto &positions = it->second;
+  std::erase(positions, position);
+  if (positions.empty()) {
+    table.erase(it);
+    return;
+  }
+
+  const auto *other = text(*index.nodes[positions.front()]);
+  const auto at = other ? other->find(key) : std::string::npos;
+  if (at == std::string::npos)
+    return;
+  auto handle = table.extract(it);
+  handle.key() = std::string_view{*other}.substr(at, key.size());
+  table.insert(std::move(handle));
+}
+
+void link(Table &table, std::string_view key, std::size_t position) {
+  auto &positions = table[key];
+  auto at = std::ranges::lower_bound(positions, position);
+  if (at == positions.end() || *at != position)
+    positions.insert(at, position);
+}
+
+// Text of a content in source (empty if out of range)
+auto content_text(std::string_view source, const Content &content)
+    -> std::string_view {
+  if (content.begin > content.end || content.end > source.size())
+    return {};
+  return source.substr(content.begin, content.end - content.begin);
+}
+
+// Hash of an element without its children: tag, attributes and contents
+// (kind, place among the children and text)
+auto own_hash(const Tree &tree, const Node &node) -> std::uint64_t {
+  auto hash = node_hash(node);
+  for (const auto &content : node.contents) {
+    const char header[] = {'\2', static_cast<char>(content.kind)};
+    hash = fnv1a(hash, std::string_view{header, 2});
+    hash = combine(hash, content.after);
+    hash = fnv1a(hash, content_text(tree.source, content));
+  }
+  return hash;
+}
+
+// Same contents, text compared through the source
+auto same_contents(const Tree &tree, const Node &a, const Node &b) -> bool {
+  return std::ranges::equal(
+      a.contents, b.contents, [&tree](const Content &x, const Content &y) {
+        return x.kind == y.kind && x.after == y.after &&
+               content_text(tree.source, x) == content_text(tree.source, y);
+      });
+}
+
+// Writes CSV rows, reusing the rows (and cells) already in csvTable.
+// Long layout: one row per attribute. Wide layout: one row per element,
+// attribute values in the columns of names (call attributes() first).
+// With options.content, contents follow as "#text", ... attributes.
+// Computed styles (options.styles) follow the box and Shared cells.
+struct RowWriter {
+  CsvTable &csvTable;
+  const TableOptions &options;
+  std::string_view source; // text of the contents
+  std::size_t rows{0};
+  std::vector<std::string_view> names;
+  std::unordered_map<std::string_view, std::size_t> slots; // name -> column
+
+  // Wide layout columns, from options.columns or in order of appearance
+  template <typename Nodes> void attributes(const Nodes &nodes) {
+    names.clear();
+    slots.clear();
+    auto add = [this](std::string_view name) {
+      if (slots.emplace(name, fixed() + names.size()).second)
+        names.push_back(name);
+    };
+    if (!options.columns.empty()) {
+      for (const auto &name : options.columns)
+        add(name);
+      return;
+    }
+    for (const Node *node : nodes) {
+      for (const auto &attribute : node->attributes)
+        add(attribute.first);
+      if (options.content) {
+        for (const auto &content : node->contents)
+          add(svg_core::to_string(content.kind));
+      }
+    }
+  }
+
+  // Columns before the attribute columns of the wide layout
+  auto fixed() const -> std::size_t {
+    return 4 + (options.bbox ? 4 : 0) + (options.shared ? 1 : 0) +
+           options.styles.size();
+  }
+
+  auto columns() const -> std::size_t {
+    return options.wide ? fixed() + names.size() : fixed() + 2;
+  }
+
+  auto next_row() -> CsvRow & {
+    if (rows >= csvTable.size())
+      csvTable.emplace_back();
+    auto &row = csvTable[rows++];
+    row.resize(columns());
+    return row;
+  }
+
+  void header() {
+    auto &header = next_row();
+    header[0] = "ID";
+    header[1] = "ParentID";
+    header[2] = "Depth";
+    header[3] = "Tag";
+    std::size_t column = 4;
+    if (!options.wide) {
+      header[column++] = "Attribute";
+      header[column++] = "Value";
+    }
+    if (options.bbox) {
+      header[column++] = "MinX";
+      header[column++] = "MinY";
+      header[column++] = "MaxX";
+      header[column++] = "MaxY";
+    }
+    if (options.shared)
+      header[column++] = "Shared";
+    for (const auto &property : options.styles)
+      header[column++] = property;
+    for (auto name : names)
+      header[column++].assign(name);
+  }
+
+  // ID, ParentID, Depth, Tag and, from column, the box, Shared and style
+  // cells
+  void element(CsvRow &row, const Node &node, long long id,
+               long long parent_id, int depth, long long first_copy,
+               std::size_t column) {
+    assign_number(row[0], id);
+    assign_number(row[1], parent_id);
+    assign_number(row[2], depth);
+    row[3].assign(node.tag);
+    if (options.bbox) {
+      const bool known = node.bbox && !node.bbox->empty();
+      for (std::size_t i = column; i < column + 4; ++i)
+        row[i].clear();
+      if (known) {
+        assign_real(row[column], node.bbox->min_x);
+        assign_real(row[column + 1], node.bbox->min_y);
+        assign_real(row[column + 2], node.bbox->max_x);
+        assign_real(row[column + 3], node.bbox->max_y);
+      }
+      column += 4;
+    }
+    if (options.shared) {
+      if (first_copy >= 0)
+        assign_number(row[column], first_copy);
+      else
+        row[column].clear();
+      ++column;
+    }
+    for (std::size_t i = 0; i < options.styles.size(); ++i) {
+      if (node.style && i < node.style->size())
+        row[column + i] = (*node.style)[i];
+      else
+        row[column + i].clear();
+    }
+  }
+
+  // Long layout: one row per attribute (one empty row if there are none).
+  // A copy (first_copy >= 0) gets a single row pointing to the first one.
+  void node(const Node &node, long long id, long long parent_id, int depth,
+            long long first_copy = -1) {
+    if (options.wide) {
+      auto &row = next_row();
+      element(row, node, id, parent_id, depth, first_copy, 4);
+      for (std::size_t i = fixed(); i < row.size(); ++i)
+        row[i].clear();
+      if (first_copy >= 0)
+        return;
+      for (const auto &[name, value] : node.attributes) {
+        auto slot = slots.find(name);
+        if (slot != slots.end())
+          row[slot->second].assign(value);
+      }
+      if (options.content) {
+        // Contents of a kind joined, as they read in the document
+        for (const auto &content : node.contents) {
+          auto slot = slots.find(svg_core::to_string(content.kind));
+          if (slot != slots.end())
+            row[slot->second].append(content_text(source, content));
+        }
+      }
+      return;
+    }
+
+    auto push = [&](std::string_view name, std::string_view value) {
+      auto &row = next_row();
+      element(row, node, id, parent_id, depth, first_copy, 6);
+      row[4].assign(name);
+      row[5].assign(value);
+    };
+
+    const bool contents =
+        options.content && first_copy < 0 && !node.contents.empty();
+    if ((node.attributes.empty() && !contents) || first_copy >= 0) {
+      push("", "");
+      return;
+    }
+    for (const auto &[name, value] : node.attributes)
+      push(name, value);
+    if (contents) {
+      for (const auto &content : node.contents)
+        push(svg_core::to_string(content.kind), content_text(source, content));
+    }
+  }
+
+  void finish() { csvTable.resize(rows); }
+};
+
+} // namespace
+
+auto TreeUtils::Node::attribute(std::string_view name) const
+    -> const std::string * {
+  for (const auto &[key, value] : attributes) {
+    if (key == name)
+      return &value;
+  }
+  return nullptr;
+}
+
+auto TreeUtils::Node::length(std::string_view name) const
+    -> std::optional<Length> {
+  for (std::size_t i = 0; i < attributes.size(); ++i) {
+    if (attributes[i].first != name)
+      continue;
+
+    if (typed.size() != attributes.size())
+      typed.assign(attributes.size(), TypedValue{});
+
+    auto &cached = typed[i];
+    if (cached.state == TypedValue::State::Unparsed) {
+      auto parsed = NumberUtils::parse_length(attributes[i].second);
+      cached.state =
+          parsed ? TypedValue::State::Valid : TypedValue::State::Invalid;
+      cached.length = parsed.value_or(Length{});
+    }
+
+    if (cached.state == TypedValue::State::Invalid)
+      return std::nullopt;
+    return cached.length;
+  }
+  return std::nullopt;
+}
+
+auto TreeUtils::Node::number(std::string_view name) const
+    -> std::optional<double> {
+  auto value = length(name);
+  if (!value || value->unit != svg_core::Unit::None)
+    return std::nullopt;
+  return value->value;
+}
+
+auto TreeUtils::Node::px(std::string_view name, double reference) const
+    -> std::optional<double> {
+  auto value = length(name);
+  if (!value)
+    return std::nullopt;
+  return NumberUtils::to_px(*value, reference);
+}
+
+auto TreeUtils::verify(const std::vector<TagTuple> &svg_tagTuple)
+    -> Expected<void> {
+
+  using svg_core::make_error;
+
+  auto fail = [](Status status, std::string message, std::size_t index) {
+    auto error = make_error(status, std::move(message));
+    error.offset = index;
+    return std::unexpected(error);
+  };
+
   if (svg_tagTuple.empty()) {
-    std::println("{}[ERROR]{} : Empty SVG tag sequence.", color::red,
-                 color::reset);
-    return Status::EmptyInput;
+    return std::unexpected(
+        make_error(Status::EmptyInput, "Empty SVG tag sequence."));
   }
 
-  std::stack<std::string> tag_stack;
+  // Indices of the open tags
+  std::vector<std::size_t> tag_stack;
   bool has_root{false};
 
-  for (const auto &[tag, attrs, tag_type] : svg_tagTuple) {
+  for (std::size_t i = 0; i < svg_tagTuple.size(); ++i) {
+    const auto &[tag, attrs, tag_type] = svg_tagTuple[i];
     if (tag.empty())
       continue;
 
@@ -26,44 +390,56 @@ auto TreeUtils::validate(const std::vector<TagTuple> &svg_tagTuple) -> Status {
       // Open tag (e.g. <tag>)
       if (tag_stack.empty()) {
         if (has_root) {
-          std::println("{}[ERROR]{} : Multiple root elements detected.",
-                       color::red, color::reset);
-          return Status::InvalidRoot;
+          return fail(Status::InvalidRoot, "Multiple root elements detected.",
+                      i);
         }
         has_root = true;
       }
-      tag_stack.push(tag);
+      tag_stack.push_back(i);
       break;
 
     case TagType::SelfClose:
       // Self-closing tag (e.g. <tag />)
       break;
 
-    case TagType::Close:
+    case TagType::Close: {
       // Closed tag (e.g. </tag>)
       if (tag_stack.empty()) {
-        std::println("{}[ERROR]{} : Closing tag </{}> without opening.",
-                     color::red, color::reset, tag);
-        return Status::UnbalancedTags;
+        return fail(Status::UnbalancedTags,
+                    std::format("Closing tag </{}> without opening.", tag), i);
       }
 
-      if (tag_stack.top() != tag) {
-        std::println(
-            "{}[ERROR]{} : Tag mismatch: opened <{}> but closed </{}>.",
-            color::red, color::reset, tag_stack.top(), tag);
-        return Status::UnbalancedTags;
+      const auto &open_tag = std::get<0>(svg_tagTuple[tag_stack.back()]);
+      if (open_tag != tag) {
+        return fail(Status::UnbalancedTags,
+                    std::format("Tag mismatch: opened <{}> but closed </{}>.",
+                                open_tag, tag),
+                    i);
       }
-      tag_stack.pop();
+      tag_stack.pop_back();
       break;
+    }
     case TagType::Unknown:
       break;
     }
   }
 
   if (!tag_stack.empty()) {
-    std::println("{}[ERROR]{} : Unclosed tag(s) detected at end of file.",
-                 color::red, color::reset);
-    return Status::UnbalancedTags;
+    return fail(Status::UnbalancedTags,
+                std::format("Unclosed tag <{}> detected at end of file.",
+                            std::get<0>(svg_tagTuple[tag_stack.back()])),
+                tag_stack.back());
+  }
+
+  return {};
+}
+
+auto TreeUtils::validate(const std::vector<TagTuple> &svg_tagTuple) -> Status {
+  auto result = TreeUtils::verify(svg_tagTuple);
+  if (!result) {
+    std::println("{}[ERROR]{} : {}", color::red, color::reset,
+                 result.error().message);
+    return result.error().status;
   }
 
   std::println("{}[INFO]{} : SVG structure validated successfully.",
@@ -73,14 +449,204 @@ auto TreeUtils::validate(const std::vector<TagTuple> &svg_tagTuple) -> Status {
 
 auto TreeUtils::process(const std::vector<TagTuple> &svg_tagTuple) -> Tree {
   Tree tree;
+  NodePool pool;
+  TreeUtils::process(svg_tagTuple, tree, pool);
+  return tree;
+}
+
+void TreeUtils::release(Tree &tree, NodePool &pool) {
+  if (!tree.root)
+    return;
+
+  // Flatten the tree into the pool (iterative, children become siblings)
+  std::size_t first = pool.nodes.size();
+  pool.nodes.push_back(std::move(tree.root));
+  for (std::size_t i = first; i < pool.nodes.size(); ++i) {
+    auto &children = pool.nodes[i]->children;
+    for (auto &child : children)
+      pool.nodes.push_back(std::move(child));
+    children.clear();
+  }
+  tree.source = {};
+  TreeUtils::reindex(tree);
+}
+
+void TreeUtils::reindex(Tree &tree) {
+  auto &index = tree.index;
+  index.nodes.clear();
+  index.parents.clear();
+  index.depths.clear();
+  index.sizes.clear();
+  index.hashes.clear();
+  // Entries (not buckets) set aside: keys view the nodes being replaced
+  for (auto *table : {&index.tags, &index.ids, &index.classes}) {
+    while (!table->empty())
+      index.spare.push_back(table->extract(table->begin()));
+  }
+
+  auto traverse = [&tree, &index](auto &self, Node &node, std::size_t parent,
+                                  int depth) -> void {
+    const std::size_t position = index.nodes.size();
+    index.nodes.push_back(&node);
+    index.parents.push_back(parent);
+    index.depths.push_back(depth);
+    index.sizes.push_back(1);
+    index.hashes.push_back(own_hash(tree, node));
+
+    entry(index.tags, index.spare, node.tag).push_back(position);
+    if (const auto *id = node.attribute("id"))
+      entry(index.ids, index.spare, *id).push_back(position);
+
+    // class="a b": one entry per name
+    if (const auto *classes = node.attribute("class")) {
+      for_each_class(*classes, [&](std::string_view name) {
+        auto &positions = entry(index.classes, index.spare, name);
+        if (positions.empty() || positions.back() != position)
+          positions.push_back(position);
+      });
+    }
+
+    for (auto &child : node.children) {
+      const std::size_t child_position = index.nodes.size();
+      self(self, *child, position, depth + 1);
+      index.hashes[position] =
+          combine(index.hashes[position], index.hashes[child_position]);
+    }
+    index.sizes[position] = index.nodes.size() - position;
+  };
+
+  if (tree.root)
+    traverse(traverse, *tree.root, std::string_view::npos, 0);
+}
+
+void TreeUtils::update(Tree &tree, std::size_t position,
+                       Attributes attributes) {
+  auto &index = tree.index;
+  if (position >= index.nodes.size())
+    return;
+  Node &node = *index.nodes[position];
+
+  auto id_of = [](const Node &n) { return n.attribute("id"); };
+  auto class_of = [](const Node &n) { return n.attribute("class"); };
+
+  // Old keys may view this node's strings: drop them first
+  if (const auto *id = node.attribute("id"))
+    unlink(index.ids, *id, position, index, id_of);
+  if (const auto *classes = node.attribute("class")) {
+    for_each_class(*classes, [&](std::string_view name) {
+      unlink(index.classes, name, position, index, class_of);
+    });
+  }
+
+  node.attributes = std::move(attributes);
+  node.invalidate();
+
+  if (const auto *id = node.attribute("id"))
+    link(index.ids, *id, position);
+  if (const auto *classes = node.attribute("class")) {
+    for_each_class(*classes, [&](std::string_view name) {
+      link(index.classes, name, position);
+    });
+  }
+
+  // Hashes of the element and of its ancestors
+  for (auto at = position; at != std::string_view::npos;
+       at = index.parents[at]) {
+    auto hash = own_hash(tree, *index.nodes[at]);
+    for (std::size_t child = at + 1; child < at + index.sizes[at];
+         child += index.sizes[child])
+      hash = combine(hash, index.hashes[child]);
+    index.hashes[at] = hash;
+  }
+}
+
+auto TreeUtils::same(const Node &a, const Node &b) -> bool {
+  if (a.tag != b.tag || a.attributes != b.attributes ||
+      a.children.size() != b.children.size())
+    return false;
+  for (std::size_t i = 0; i < a.children.size(); ++i)
+    if (!same(*a.children[i], *b.children[i]))
+      return false;
+  return true;
+}
+
+auto TreeUtils::first_copies(const Tree &tree) -> std::vector<std::size_t> {
+  const auto &index = tree.index;
+  const auto count = index.nodes.size();
+  std::vector<std::size_t> result(count);
+
+  // Children are classified before their parent (reverse pre-order), so two
+  // subtrees are identical when their own tag and attributes match and
+  // their children belong to the same classes: no deep comparison needed.
+  std::unordered_map<std::uint64_t, std::vector<std::size_t>> classes;
+  for (std::size_t position = count; position-- > 0;) {
+    auto &candidates = classes[index.hashes[position]];
+    const Node &node = *index.nodes[position];
+
+    result[position] = position;
+    for (auto candidate : candidates) {
+      const Node &other = *index.nodes[candidate];
+      if (node.tag != other.tag || node.attributes != other.attributes ||
+          index.sizes[position] != index.sizes[candidate] ||
+          node.children.size() != other.children.size() ||
+          !same_contents(tree, node, other))
+        continue;
+
+      bool children_match = true;
+      for (std::size_t a = position + 1, b = candidate + 1;
+           a < position + index.sizes[position];
+           a += index.sizes[a], b += index.sizes[b]) {
+        if (result[a] != result[b]) {
+          children_match = false;
+          break;
+        }
+      }
+      if (children_match) {
+        result[position] = result[candidate];
+        break;
+      }
+    }
+    if (result[position] == position)
+      candidates.push_back(position);
+  }
+
+  // Representatives were the last copies; point every copy to the first one
+  std::vector<std::size_t> first(count, std::string_view::npos);
+  for (std::size_t position = 0; position < count; ++position) {
+    auto &target = first[result[position]];
+    if (target == std::string_view::npos)
+      target = position;
+    result[position] = target;
+  }
+  return result;
+}
+
+void TreeUtils::process(const std::vector<TagTuple> &svg_tagTuple, Tree &tree,
+                        NodePool &pool) {
+
+  TreeUtils::release(tree, pool);
 
   if (svg_tagTuple.empty()) {
     std::println("{}[ERROR]{} : Empty SVG tag sequence. Tree not created.",
                  color::red, color::reset);
-    return tree;
+    return;
   }
 
-  std::stack<Node *> node_stack;
+  // Reuse a released node when available
+  auto acquire = [&pool](const std::string &tag, const Attributes &attrs) {
+    if (pool.nodes.empty())
+      return std::make_unique<Node>(tag, attrs);
+    auto node = std::move(pool.nodes.back());
+    pool.nodes.pop_back();
+    node->tag = tag;
+    node->attributes = attrs;
+    node->contents.clear();
+    node->invalidate();
+    return node;
+  };
+
+  auto &node_stack = pool.stack;
+  node_stack.clear();
 
   for (const auto &[tag, attrs, tag_type] : svg_tagTuple) {
     if (tag.empty())
@@ -88,26 +654,26 @@ auto TreeUtils::process(const std::vector<TagTuple> &svg_tagTuple) -> Tree {
 
     switch (tag_type) {
     case TagType::Open: {
-      auto new_node = std::make_unique<Node>(tag, attrs);
+      auto new_node = acquire(tag, attrs);
 
       if (node_stack.empty()) {
         // Root
         tree.root = std::move(new_node);
-        node_stack.push(tree.root.get());
+        node_stack.push_back(tree.root.get());
       } else {
         // Children
-        Node *parent = node_stack.top();
+        Node *parent = node_stack.back();
         parent->children.push_back(std::move(new_node));
-        node_stack.push(parent->children.back().get());
+        node_stack.push_back(parent->children.back().get());
       }
       break;
     }
 
     case TagType::SelfClose: {
-      auto new_node = std::make_unique<Node>(tag, attrs);
+      auto new_node = acquire(tag, attrs);
 
       if (!node_stack.empty()) {
-        node_stack.top()->children.push_back(std::move(new_node));
+        node_stack.back()->children.push_back(std::move(new_node));
       } else {
         // Standalone tag outside the root (rare case, but allowed)
         tree.root = std::move(new_node);
@@ -117,7 +683,7 @@ auto TreeUtils::process(const std::vector<TagTuple> &svg_tagTuple) -> Tree {
 
     case TagType::Close: {
       if (!node_stack.empty())
-        node_stack.pop();
+        node_stack.pop_back();
       else
         std::println("{}[WARN]{} : Unmatched closing tag </{}> ignored.",
                      color::yellow, color::reset, tag);
@@ -134,52 +700,148 @@ auto TreeUtils::process(const std::vector<TagTuple> &svg_tagTuple) -> Tree {
                  color::yellow, color::reset, node_stack.size());
   }
 
-  return tree;
+  TreeUtils::reindex(tree);
+}
+
+void TreeUtils::attach(Tree &tree, std::string_view source,
+                       const std::vector<Content> &contents) {
+  const auto &nodes = tree.index.nodes;
+  for (auto *node : nodes)
+    node->contents.clear();
+  tree.source = source;
+  if (nodes.empty())
+    return;
+
+  for (const auto &content : contents) {
+    if (content.element < nodes.size()) {
+      nodes[content.element]->contents.push_back(content);
+    } else {
+      // Before the root element (element stays npos) or after it (last
+      // content of the root)
+      auto &root = *nodes.front();
+      auto &outside = root.contents.emplace_back(content);
+      if (content.after != 0)
+        outside.element = 0;
+      outside.after = std::min(content.after, root.children.size());
+    }
+  }
+
+  // Subtree hashes now cover the contents (children before parents)
+  auto &index = tree.index;
+  for (std::size_t position = nodes.size(); position-- > 0;) {
+    auto hash = own_hash(tree, *nodes[position]);
+    for (std::size_t child = position + 1;
+         child < position + index.sizes[position]; child += index.sizes[child])
+      hash = combine(hash, index.hashes[child]);
+    index.hashes[position] = hash;
+  }
+}
+
+auto TreeUtils::text(const Tree &tree, const Content &content)
+    -> std::string_view {
+  return content_text(tree.source, content);
 }
 
-auto TreeUtils::table(const Tree &tree) -> CsvTable {
+auto TreeUtils::find_id(const Tree &tree, std::string_view id)
+    -> std::size_t {
+  auto it = tree.index.ids.find(id);
+  return it == tree.index.ids.end() ? std::string_view::npos
+                                    : it->second.front();
+}
+
+auto TreeUtils::table(const Tree &tree, const TableOptions &options)
+    -> CsvTable {
+  CsvTable csvTable;
+  TreeUtils::table(tree, csvTable, options);
+  return csvTable;
+}
+
+void TreeUtils::table(const Tree &tree, CsvTable &csvTable,
+                      const TableOptions &options) {
 
   if (!tree.root) {
     std::println("{}[INFO]{} : Empty tree.", color::blue, color::reset);
-    return {};
+    csvTable.clear();
+    return;
   }
 
-  CsvTable table;
-  CsvRow header{"ID", "ParentID", "Depth", "Tag", "Attribute", "Value"};
-  table.push_back(header);
+  RowWriter writer{csvTable, options, tree.source};
+  if (options.wide)
+    writer.attributes(tree.index.nodes);
+  writer.header();
 
-  size_t current_id = 0;
+  std::vector<std::size_t> copies;
+  if (options.shared)
+    copies = TreeUtils::first_copies(tree);
 
-  std::function<void(const Node *, int, int)> traverse;
+  long long current_id = 0;
 
-  traverse = [&](const Node *node, int depth, int parent_id) {
+  auto traverse = [&](auto &self, const Node *node, int depth,
+                      long long parent_id) -> void {
     if (!node)
       return;
 
-    size_t node_id = current_id++;
-
-    if (node->attributes.empty()) {
-      table.push_back({std::to_string(node_id), std::to_string(parent_id),
-                       std::to_string(depth), node->tag, "", ""});
-    } else {
-      for (const auto &[name, value] : node->attributes) {
-        table.push_back({std::to_string(node_id), std::to_string(parent_id),
-                         std::to_string(depth), node->tag, name, value});
+    long long node_id = current_id++;
+    if (options.shared) {
+      const auto position = static_cast<std::size_t>(node_id);
+      if (copies[position] != position) {
+        // Repeated subtree: one row, descendants keep their IDs but no rows
+        writer.node(*node, node_id, parent_id, depth,
+                    static_cast<long long>(copies[position]));
+        current_id += static_cast<long long>(tree.index.sizes[position]) - 1;
+        return;
       }
     }
+    writer.node(*node, node_id, parent_id, depth);
 
     // Children
     for (const auto &child : node->children)
-      traverse(child.get(), depth + 1, static_cast<int>(node_id)); // recursion
+      self(self, child.get(), depth + 1, node_id); // recursion
   };
 
   // Initialize
-  traverse(tree.root.get(), 0, -1);
+  traverse(traverse, tree.root.get(), 0, -1);
+
+  writer.finish();
+}
 
-  return table;
+void TreeUtils::table(const Tree &tree,
+                      const std::vector<std::size_t> &positions,
+                      CsvTable &csvTable, const TableOptions &options) {
+  const auto &index = tree.index;
+
+  RowWriter writer{csvTable, options, tree.source};
+  if (options.wide) {
+    std::vector<const Node *> selected;
+    for (auto position : positions) {
+      if (position < index.nodes.size())
+        selected.push_back(index.nodes[position]);
+    }
+    writer.attributes(selected);
+  }
+  writer.header();
+
+  std::vector<std::size_t> copies;
+  if (options.shared)
+    copies = TreeUtils::first_copies(tree);
+
+  for (auto position : positions) {
+    if (position >= index.nodes.size())
+      continue;
+    const auto parent = index.parents[position];
+    const bool copy = options.shared && copies[position] != position;
+    writer.node(*index.nodes[position], static_cast<long long>(position),
+                parent == std::string_view::npos
+                    ? -1
+                    : static_cast<long long>(parent),
+                index.depths[position],
+                copy ? static_cast<long long>(copies[position]) : -1);
+  }
+
+  writer.finish();
 }
 
-auto TreeUtils::hierarchy(Tree &tree) -> std::string {
+auto TreeUtils::hierarchy(const Tree &tree) -> std::string {
 
   if (!tree.root) {
     std::println("{}[INFO]{} : Empty tree.", color::blue, color::reset);
@@ -223,7 +885,7 @@ auto TreeUtils::hierarchy(Tree &tree) -> std::string {
   return hierarchy_str;
 }
 
-void TreeUtils::view(Tree &tree) {
+void TreeUtils::view(const Tree &tree) {
 
   if (!tree.root) {
     std::println("{}[INFO]{} : Empty tree.", color::blue, color::reset);
@@ -271,6 +933,10 @@ void test_tree_utils() {
 
   assert(validate(bad_hierarchy) == Status::UnbalancedTags);
 
+  // Index of the offending tag
+  assert(TreeUtils::verify(bad_hierarchy).error().offset == 2);
+  assert(TreeUtils::verify(missing_close).error().offset == 3);
+
   // Valid structure.
   std::vector<TagTuple> valid_svg1{{"svg", {}, TagType::Open},
                                    {"g", {}, TagType::Open},
@@ -349,6 +1015,27 @@ void test_tree_utils() {
   assert(find_attr(c_attrs, "stroke-width") == "4");
   assert(find_attr(c_attrs, "fill") == "yellow");
 
+  // Typed attributes (lazy, cached)
+  assert(circle_node->typed.empty());
+  assert(circle_node->number("r") == 55.0);
+  assert(circle_node->typed.size() == c_attrs.size());
+  assert(circle_node->typed[2].state == TreeUtils::TypedValue::State::Valid);
+  assert(circle_node->typed[0].state == TreeUtils::TypedValue::State::Unparsed);
+  assert(!circle_node->number("fill"));
+  assert(circle_node->typed[5].state == TreeUtils::TypedValue::State::Invalid);
+  assert(!circle_node->number("missing"));
+  assert(*circle_node->attribute("stroke") == "red");
+  assert(tree.root->px("width") == 200.0);
+
+  Node sized("rect", {{"width", "50%"}, {"height", "1in"}});
+  assert(!sized.number("width"));
+  assert(sized.length("width")->unit == svg_core::Unit::Percent);
+  assert(sized.px("width", 300.0) == 150.0);
+  assert(sized.px("height") == 96.0);
+  sized.attributes[1].second = "2in";
+  sized.invalidate();
+  assert(sized.px("height") == 192.0);
+
   // Hierarchy View
   view(tree);
 
@@ -428,6 +1115,223 @@ void test_tree_utils() {
 
   assert_csv_eq(csvTable, csvTable_expected);
 
+  // Reused nodes and rows
+  TreeUtils::NodePool pool;
+  Tree reused;
+  TreeUtils::process(valid_svg2, reused, pool);
+  TreeUtils::process(valid_svg1, reused, pool);
+  assert(reused.root && reused.root->tag == "svg");
+  assert(reused.root->attributes.empty());
+  assert(reused.root->children[0]->children[0]->tag == "circle");
+  assert(pool.nodes.empty());
+
+  TreeUtils::table(reused, csvTable);
+  assert_csv_eq(csvTable, table(reused));
+
+  // Bounding box columns
+  reused.root->children[0]->bbox = svg_core::BBox{1.0, 2.0, 3.5, 4.0};
+  auto bbox_table = table(reused, {.bbox = true});
+  assert(bbox_table[0].size() == 10 && bbox_table[0][6] == "MinX");
+  assert(bbox_table[1][6].empty());
+  assert((CsvRow{bbox_table[2].begin() + 6, bbox_table[2].end()} ==
+          CsvRow{"1", "2", "3.5", "4"}));
+
+  // Index tables and partial table
+  const auto &index = reused.index;
+  assert(index.nodes.size() == 3 && index.nodes[2]->tag == "circle");
+  assert(index.parents[2] == 1 && index.depths[2] == 2);
+  assert(index.tags.at("circle") == std::vector<std::size_t>{2});
+
+  CsvTable partial;
+  TreeUtils::table(reused, {2}, partial);
+  assert_csv_eq(partial,
+                {csvTable_expected[0], {"2", "1", "2", "circle", "", ""}});
+
+  auto classed = TreeUtils::process(std::vector<TagTuple>{
+      {"svg", {}, TagType::Open},
+      {"rect", {{"id", "a"}, {"class", " big  red big"}}, TagType::SelfClose},
+      {"rect", {{"class", "red"}}, TagType::SelfClose},
+      {"svg", {}, TagType::Close}});
+  assert(classed.index.ids.at("a") == std::vector<std::size_t>{1});
+  assert(TreeUtils::find_id(classed, "a") == 1);
+  assert(TreeUtils::find_id(classed, "b") == std::string_view::npos);
+  assert(classed.index.classes.at("big") == std::vector<std::size_t>{1});
+  assert(classed.index.classes.at("red") == (std::vector<std::size_t>{1, 2}));
+
+  // Subtree hashes and shared rows
+  auto repeated = TreeUtils::process(std::vector<TagTuple>{
+      {"svg", {}, TagType::Open},                            // 0
+      {"g", {}, TagType::Open},                              // 1
+      {"circle", {{"r", "1"}}, TagType::SelfClose},          // 2
+      {"g", {}, TagType::Close},                             //
+      {"g", {}, TagType::Open},                              // 3
+      {"circle", {{"r", "1"}}, TagType::SelfClose},          // 4
+      {"g", {}, TagType::Close},                             //
+      {"g", {}, TagType::Open},                              // 5
+      {"circle", {{"r", "2"}}, TagType::SelfClose},          // 6
+      {"g", {}, TagType::Close},                             //
+      {"svg", {}, TagType::Close}});
+  const auto &hashes = repeated.index.hashes;
+  assert(repeated.index.sizes[0] == 7 && repeated.index.sizes[1] == 2);
+  assert(hashes[1] == hashes[3] && hashes[1] != hashes[5]);
+  assert(hashes[2] == hashes[4] && hashes[2] != hashes[6]);
+  assert(TreeUtils::same(*repeated.index.nodes[1], *repeated.index.nodes[3]));
+  assert(!TreeUtils::same(*repeated.index.nodes[1], *repeated.index.nodes[5]));
+  assert((TreeUtils::first_copies(repeated) ==
+          std::vector<std::size_t>{0, 1, 2, 1, 2, 5, 6}));
+
+  auto shared_table = table(repeated, {.shared = true});
+  assert_csv_eq(
+      shared_table,
+      {{"ID", "ParentID", "Depth", "Tag", "Attribute", "Value", "Shared"},
+       {"0", "-1", "0", "svg", "", "", ""},
+       {"1", "0", "1", "g", "", "", ""},
+       {"2", "1", "2", "circle", "r", "1", ""},
+       {"3", "0", "1", "g", "", "", "1"},
+       {"5", "0", "1", "g", "", "", ""},
+       {"6", "5", "2", "circle", "r", "2", ""}});
+
+  // Wide layout: one row per element, one column per attribute name
+  assert_csv_eq(table(classed, {.wide = true}),
+                {{"ID", "ParentID", "Depth", "Tag", "id", "class"},
+                 {"0", "-1", "0", "svg", "", ""},
+                 {"1", "0", "1", "rect", "a", " big  red big"},
+                 {"2", "0", "1", "rect", "", "red"}});
+  TreeUtils::table(repeated, {6, 1}, partial,
+                   {.shared = true, .wide = true, .columns = {"r", "fill"}});
+  assert_csv_eq(partial,
+                {{"ID", "ParentID", "Depth", "Tag", "Shared", "r", "fill"},
+                 {"6", "5", "2", "circle", "", "2", ""},
+                 {"1", "0", "1", "g", "", "", ""}});
+  assert(table(repeated, {.bbox = true, .wide = true})[0][8] == "r");
+
+  // Contents attached by offsets into the source
+  std::string_view source{"<svg><!--c--><text x=\"1\">a<tspan/>b</text></svg>"};
+  auto texts = TreeUtils::process(std::vector<TagTuple>{
+      {"svg", {}, TagType::Open},
+      {"text", {{"x", "1"}}, TagType::Open},
+      {"tspan", {}, TagType::SelfClose},
+      {"text", {}, TagType::Close},
+      {"svg", {}, TagType::Close}});
+  using Kind = Content::Kind;
+  TreeUtils::attach(texts, source,
+                    {{Kind::Comment, 9, 10, 0, 0},
+                     {Kind::Text, 25, 26, 1, 0},
+                     {Kind::Text, 34, 35, 1, 1},
+                     {Kind::Comment, 9, 10, std::string_view::npos,
+                      std::string_view::npos}});
+  assert(texts.root->contents.size() == 2);
+  assert(texts.root->contents[1].after == 1);
+  assert(TreeUtils::text(texts, texts.root->children[0]->contents[1]) == "b");
+  assert_csv_eq(table(texts, {.content = true}),
+                {{"ID", "ParentID", "Depth", "Tag", "Attribute", "Value"},
+                 {"0", "-1", "0", "svg", "#comment", "c"},
+                 {"0", "-1", "0", "svg", "#comment", "c"},
+                 {"1", "0", "1", "text", "x", "1"},
+                 {"1", "0", "1", "text", "#text", "a"},
+                 {"1", "0", "1", "text", "#text", "b"},
+                 {"2", "1", "2", "tspan", "", ""}});
+  // Texts are part of the subtree: only equal texts are copies
+  std::string_view labels{
+      "<svg><text>a</text><text>b</text><text>a</text></svg>"};
+  auto three = TreeUtils::process(std::vector<TagTuple>{
+      {"svg", {}, TagType::Open},
+      {"text", {}, TagType::Open}, {"text", {}, TagType::Close},
+      {"text", {}, TagType::Open}, {"text", {}, TagType::Close},
+      {"text", {}, TagType::Open}, {"text", {}, TagType::Close},
+      {"svg", {}, TagType::Close}});
+  assert(TreeUtils::first_copies(three)[2] == 1);
+  TreeUtils::attach(three, labels,
+                    {{Kind::Text, 11, 12, 1, 0},
+                     {Kind::Text, 25, 26, 2, 0},
+                     {Kind::Text, 39, 40, 3, 0}});
+  assert(three.index.hashes[1] != three.index.hashes[2]);
+  assert(three.index.hashes[1] == three.index.hashes[3]);
+  assert((TreeUtils::first_copies(three) ==
+          std::vector<std::size_t>{0, 1, 2, 1}));
+  assert_csv_eq(
+      table(three, {.shared = true, .content = true}),
+      {{"ID", "ParentID", "Depth", "Tag", "Attribute", "Value", "Shared"},
+       {"0", "-1", "0", "svg", "", "", ""},
+       {"1", "0", "1", "text", "#text", "a", ""},
+       {"2", "0", "1", "text", "#text", "b", ""},
+       {"3", "0", "1", "text", "", "", "1"}});
+
+  assert_csv_eq(table(texts, {.wide = true, .content = true}),
+                {{"ID", "ParentID", "Depth", "Tag", "#comment", "x", "#text"},
+                 {"0", "-1", "0", "svg", "cc", "", ""},
+                 {"1", "0", "1", "text", "", "1", "ab"},
+                 {"2", "1", "2", "tspan", "", "", ""}});
+  assert(table(texts).size() == 4); // not written by default
+
+  // Computed styles (StyleUtils::compute) after Shared, empty if not computed
+  texts.root->style = std::make_shared<const std::vector<std::string>>(
+      std::vector<std::string>{"black", "none"});
+  assert_csv_eq(
+      table(texts,
+            {.shared = true, .wide = true, .styles = {"fill", "stroke"}}),
+      {{"ID", "ParentID", "Depth", "Tag", "Shared", "fill", "stroke", "x"},
+       {"0", "-1", "0", "svg", "", "black", "none", ""},
+       {"1", "0", "1", "text", "", "", "", "1"},
+       {"2", "1", "2", "tspan", "", "", "", ""}});
+  assert(table(texts, {.styles = {"fill"}})[1] ==
+         (CsvRow{"0", "-1", "0", "svg", "", "", "black"}));
+  texts.root->invalidate();
+  assert(!texts.root->style);
+
+  // Attributes replaced in place, index patched
+  const auto unique_before = repeated.index.hashes;
+  TreeUtils::update(repeated, 4, {{"r", "2"}});
+  assert(hashes[4] == hashes[6] && hashes[3] == hashes[5]);
+  assert(hashes[3] != unique_before[3] && hashes[0] != unique_before[0]);
+  assert(hashes[1] == unique_before[1]);
+  assert(hashes == TreeUtils::process(std::vector<TagTuple>{
+                       {"svg", {}, TagType::Open},
+                       {"g", {}, TagType::Open},
+                       {"circle", {{"r", "1"}}, TagType::SelfClose},
+                       {"g", {}, TagType::Close},
+                       {"g", {}, TagType::Open},
+                       {"circle", {{"r", "2"}}, TagType::SelfClose},
+                       {"g", {}, TagType::Close},
+                       {"g", {}, TagType::Open},
+                       {"circle", {{"r", "2"}}, TagType::SelfClose},
+                       {"g", {}, TagType::Close},
+                       {"svg", {}, TagType::Close}})
+                       .index.hashes);
+  TreeUtils::update(repeated, 4, {{"r", "2"}, {"id", "c"}, {"class", "x"}});
+  assert(TreeUtils::find_id(repeated, "c") == 4);
+  assert(repeated.index.classes.at("x") == std::vector<std::size_t>{4});
+
+  TreeUtils::update(classed, 1, {{"class", "red"}});
+  assert(TreeUtils::find_id(classed, "a") == std::string_view::npos);
+  assert(!classed.index.classes.contains("big"));
+  assert(classed.index.classes.at("red") == (std::vector<std::size_t>{1, 2}));
+  TreeUtils::update(classed, 1, {});
+  assert(classed.index.classes.at("red") == std::vector<std::size_t>{2});
+  // The key now views the remaining element's string
+  assert(classed.index.classes.find("red")->first.data() ==
+         classed.index.nodes[2]->attribute("class")->data());
+
+  // Table entries recycled: same document again, same vectors
+  auto buffers = [&reused] {
+    std::vector<const std::size_t *> data;
+    for (const auto *table : {&reused.index.tags, &reused.index.ids,
+                              &reused.index.classes})
+      for (const auto &[key, positions] : *table)
+        data.push_back(positions.data());
+    std::ranges::sort(data);
+    return data;
+  };
+  const auto before = buffers();
+  TreeUtils::release(reused, pool);
+  assert(!reused.root && pool.nodes.size() == 3);
+  assert(reused.index.nodes.empty() && reused.index.tags.empty());
+  const auto spare = reused.index.spare.size();
+  assert(spare >= before.size());
+  TreeUtils::process(valid_svg1, reused, pool);
+  assert(reused.index.spare.size() == spare - before.size());
+  assert(buffers() == before);
+
   std::println("{}[TEST]{} : {} : test completed", color::green, color::reset,
                __PRETTY_FUNCTION__);
 }
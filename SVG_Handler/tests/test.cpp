@@ -9,10 +9,27 @@
  *   ./svg_handler_cli_test test=3   -> Run TreeUtils test
  *   ./svg_handler_cli_test test=4   -> Run CsvExporter test
  *   ./svg_handler_cli_test test=5   -> Run SVG_Handler pipeline test
+ *   ./svg_handler_cli_test test=6   -> Run NumberUtils test
+ *   ./svg_handler_cli_test test=7   -> Run PathUtils test
+ *   ./svg_handler_cli_test test=8   -> Run GeometryUtils test
+ *   ./svg_handler_cli_test test=9   -> Run SpatialIndex test
+ *   ./svg_handler_cli_test test=10   -> Run QueryUtils test
+ *   ./svg_handler_cli_test test=11   -> Run ReferenceUtils test
+ *   ./svg_handler_cli_test test=12   -> Run DAG Utils test
+ *   ./svg_handler_cli_test test=13   -> Run Snapshot Utils test
+ *   ./svg_handler_cli_test test=14   -> Run Cache Utils test
+ *   ./svg_handler_cli_test test=15   -> Run Diff Utils test
+ *   ./svg_handler_cli_test test=16   -> Run Arrow Exporter test
+ *   ./svg_handler_cli_test test=17   -> Run JSON Exporter test
+ *   ./svg_handler_cli_test test=18   -> Run SVG Writer test
+ *   ./svg_handler_cli_test test=19   -> Run Simplify Utils test
+ *   ./svg_handler_cli_test test=20   -> Run Style Utils test
+ *   ./svg_handler_cli_test test=21   -> Run Raster Utils test
  */
 
 #include "svg_handler.hpp"
 
+#include <charconv>
 #include <print>
 
 constexpr std::string_view USAGE =
@@ -22,30 +39,110 @@ constexpr std::string_view USAGE =
         test=2  StringUtils test
         test=3  TreeUtils test
         test=4  CsvExporter test
-        test=5  SVG_Handler pipeline test)";
+        test=5  SVG_Handler pipeline test
+        test=6  NumberUtils test
+        test=7  PathUtils test
+        test=8  GeometryUtils test
+        test=9  SpatialIndex test
+        test=10  QueryUtils test
+        test=11  ReferenceUtils test
+        test=12  DAG Utils test
+        test=13  Snapshot Utils test
+        test=14  Cache Utils test
+        test=15  Diff Utils test
+        test=16  Arrow Exporter test
+        test=17  JSON Exporter test
+        test=18  SVG Writer test
+        test=19  Simplify Utils test
+        test=20  Style Utils test
+        test=21  Raster Utils test)";
 
-void select_test(char option) {
+void select_test(int option) {
   switch (option) {
-  case '0':
+  case 0:
     [[fallthrough]];
-  case '1':
+  case 1:
     test_svg_reader();
-    if (option != '0')
+    if (option != 0)
       break;
-  case '2':
+  case 2:
     test_string_utils();
-    if (option != '0')
+    if (option != 0)
       break;
-  case '3':
+  case 3:
     test_tree_utils();
-    if (option != '0')
+    if (option != 0)
       break;
-  case '4':
+  case 4:
     test_csv_exporter();
-    if (option != '0')
+    if (option != 0)
       break;
-  case '5':
+  case 5:
     test_svg_handler();
+    if (option != 0)
+      break;
+  case 6:
+    test_number_utils();
+    if (option != 0)
+      break;
+  case 7:
+    test_path_utils();
+    if (option != 0)
+      break;
+  case 8:
+    test_geometry_utils();
+    if (option != 0)
+      break;
+  case 9:
+    test_spatial_index();
+    if (option != 0)
+      break;
+  case 10:
+    test_query_utils();
+    if (option != 0)
+      break;
+  case 11:
+    test_reference_utils();
+    if (option != 0)
+      break;
+  case 12:
+    test_dag_utils();
+    if (option != 0)
+      break;
+  case 13:
+    test_snapshot_utils();
+    if (option != 0)
+      break;
+  case 14:
+    test_cache_utils();
+    if (option != 0)
+      break;
+  case 15:
+    test_diff_utils();
+    if (option != 0)
+      break;
+  case 16:
+    test_arrow_exporter();
+    if (option != 0)
+      break;
+  case 17:
+    test_json_exporter();
+    if (option != 0)
+      break;
+  case 18:
+    test_svg_writer();
+    if (option != 0)
+      break;
+  case 19:
+    test_simplify_utils();
+    if (option != 0)
+      break;
+  case 20:
+    test_style_utils();
+    if (option != 0)
+      break;
+  case 21:
+    test_raster_utils();
     break;
   default:
     std::println("{}[ERROR]{} : Invalid option '{}'.", color::red, color::reset,
@@ -76,10 +173,14 @@ auto main(int argc, char *argv[]) -> int {
 
   std::string value = arg.substr(prefix.size());
 
-  if (value == "all" || value == "0")
-    select_test('0');
-  else if (value.size() == 1 && std::isdigit(value[0]))
-    select_test(value[0]);
+  int option{-1};
+  auto [ptr, ec] =
+      std::from_chars(value.data(), value.data() + value.size(), option);
+
+  if (value == "all")
+    select_test(0);
+  else if (ec == std::errc{} && ptr == value.data() + value.size())
+    select_test(option);
   else {
     std::println("{}[ERROR]{} : Unknown test option '{}'.", color::red,
                  color::reset, value);